@@ -12,6 +12,29 @@ fi
 
 g++ -g -Wno-switch -I vendor/SDL2/macos/include -L vendor/SDL2/macos/lib -o build/sdl_snake_game src/main.cpp -lSDL2 -lSDL2_ttf -lSDL2_mixer
 
+# Asset pack (the game falls back to the loose files if it's missing)
+g++ -O2 -o build/asset_packer tools/asset_packer.cpp
+build/asset_packer build/assets.pack \
+  fonts/Share_Tech_Mono/ShareTechMono-Regular.ttf \
+  music/mixkit-feast-from-the-east.mp3 \
+  sounds/beep.wav \
+  sounds/beep-2.mp3 \
+  sounds/boom.mp3
+
+# Batch environment for training bots, a shared library with a C API, and its benchmark
+g++ -O2 -shared -fPIC -fvisibility=hidden -install_name @rpath/libsnake_batch_env.dylib \
+  -o build/libsnake_batch_env.dylib src/snake_batch_env.cpp
+g++ -O2 -o build/snake_batch_bench tools/snake_batch_bench.cpp -L build -lsnake_batch_env -Wl,-rpath,@executable_path
+
+# Watches a game run with --spectators
+g++ -O2 -o build/spectator_client tools/spectator_client.cpp
+
+# Reads the flight recorder dumps (flight_*.bin)
+g++ -O2 -o build/flight_recorder_decoder tools/flight_recorder_decoder.cpp
+
+# Watches the frame stats a running game publishes to shared memory
+g++ -O2 -o build/metrics_top tools/metrics_top.cpp
+
 # SDL2
 install_name_tool -change /usr/local/opt/sdl2/lib/libSDL2-2.0.0.dylib @executable_path/libSDL2.dylib build/sdl_snake_game
 
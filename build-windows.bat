@@ -29,7 +29,7 @@ set INCLUDE_PATH=%~dp0vendor\SDL2\windows\visual_studio\x64\include
 set LIB_PATH=%~dp0vendor\SDL2\windows\visual_studio\x64\lib
 
 REM Compile main.cpp
-cl /Zi /W4 /WX /wd4100 /wd4189 /MD /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0src\main.cpp /I %INCLUDE_PATH% /link -PDB:%filename% /LIBPATH:%LIB_PATH% SDL2.lib SDL2main.lib SDL2_ttf.lib shell32.lib winmm.lib /SUBSYSTEM:CONSOLE
+cl /Zi /W4 /WX /wd4100 /wd4189 /MD /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0src\main.cpp /I %INCLUDE_PATH% /link -PDB:%filename% /LIBPATH:%LIB_PATH% SDL2.lib SDL2main.lib SDL2_ttf.lib shell32.lib winmm.lib ws2_32.lib /SUBSYSTEM:CONSOLE
 REM TODO: use /SUBSYSTEM:WINDOWS for release to avoid opening a console
 
 REM Check if compilation was successful
@@ -41,6 +41,40 @@ if %errorlevel% neq 0 (
 )
 popd
 
+REM Asset pack (the game falls back to the loose files if it's missing)
+pushd %BUILD_DIR%
+cl /nologo /O2 /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0tools\asset_packer.cpp
+popd
+pushd %~dp0
+build\asset_packer.exe build\assets.pack ^
+    fonts/Share_Tech_Mono/ShareTechMono-Regular.ttf ^
+    music/mixkit-feast-from-the-east.mp3 ^
+    sounds/beep.wav ^
+    sounds/beep-2.mp3 ^
+    sounds/boom.mp3
+popd
+
+REM Batch environment for training bots, a DLL with a C API, and its benchmark
+pushd %BUILD_DIR%
+cl /nologo /O2 /LD /EHsc /D_CRT_SECURE_NO_WARNINGS /DSNAKE_BATCH_ENV_EXPORTS %~dp0src\snake_batch_env.cpp /Fe:snake_batch_env.dll
+cl /nologo /O2 /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0tools\snake_batch_bench.cpp snake_batch_env.lib
+popd
+
+REM Watches a game run with --spectators
+pushd %BUILD_DIR%
+cl /nologo /O2 /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0tools\spectator_client.cpp ws2_32.lib
+popd
+
+REM Reads the flight recorder dumps (flight_*.bin)
+pushd %BUILD_DIR%
+cl /nologo /O2 /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0tools\flight_recorder_decoder.cpp
+popd
+
+REM Watches the frame stats a running game publishes to shared memory
+pushd %BUILD_DIR%
+cl /nologo /O2 /EHsc /D_CRT_SECURE_NO_WARNINGS %~dp0tools\metrics_top.cpp
+popd
+
 REM Only copy dlls if the build directory was just created
 if "%build_dir_created%"=="true" (
     echo Copying SDL2.dll to the build directory
@@ -0,0 +1,261 @@
+#include <SDL2/SDL.h>
+#include <new>
+#include <stdlib.h>
+
+// Counts heap allocations per frame and per frame phase. Both SDL's allocator (which SDL_ttf and SDL_mixer go through
+// too) and the C++ global allocator are hooked. Only the main thread is split into phases, everything else (audio,
+// capture writer, ...) is lumped together.
+
+typedef enum
+{
+    ALLOC_PHASE_INPUT,
+    ALLOC_PHASE_UPDATE,
+    ALLOC_PHASE_RENDER,
+    ALLOC_PHASE_DEBUG,  // Debug overlay and window title
+    ALLOC_PHASE_PRESENT,
+    ALLOC_PHASE_SLEEP,
+
+    ALLOC_PHASE_COUNT,  // Should be the last item
+} Alloc_Phase;
+
+local_internal const char* alloc_phase_names[ALLOC_PHASE_COUNT] = {
+    "input",
+    "update",
+    "render",
+    "debug",
+    "present",
+    "sleep",
+};
+
+// Assert as soon as gameplay allocates after warm-up. Only the update and render phases are checked.
+bool32 ALLOCATION_STRICT_MODE = 0;
+uint32 ALLOCATION_WARM_UP_FRAMES = 120;
+
+struct Alloc_Stats
+{
+    uint32 allocations;
+    uint32 frees;
+    uint64 bytes;
+};
+
+struct Alloc_Tracker
+{
+    SDL_threadID main_thread_id;
+    Alloc_Phase phase;
+    bool32 is_recording;
+    bool32 is_strict;
+
+    Alloc_Stats this_frame[ALLOC_PHASE_COUNT];
+    Alloc_Stats last_frame[ALLOC_PHASE_COUNT];
+    Alloc_Stats last_frame_total;
+
+    SDL_atomic_t other_thread_allocations;
+    uint32 last_frame_other_thread_allocations;
+
+    uint32 gameplay_frames;
+};
+
+Alloc_Tracker global_alloc_tracker;
+
+local_internal SDL_malloc_func original_sdl_malloc;
+local_internal SDL_calloc_func original_sdl_calloc;
+local_internal SDL_realloc_func original_sdl_realloc;
+local_internal SDL_free_func original_sdl_free;
+
+local_internal void alloc_tracker_record_allocation(size_t size)
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+    if (!tracker->is_recording)
+    {
+        return;
+    }
+
+    if (SDL_ThreadID() != tracker->main_thread_id)
+    {
+        SDL_AtomicIncRef(&tracker->other_thread_allocations);
+        return;
+    }
+
+    Alloc_Stats* stats = &tracker->this_frame[tracker->phase];
+    stats->allocations++;
+    stats->bytes += size;
+
+    if (tracker->is_strict && (tracker->phase == ALLOC_PHASE_UPDATE || tracker->phase == ALLOC_PHASE_RENDER))
+    {
+        // Stop recording so the assert machinery can allocate without coming back here
+        tracker->is_recording = false;
+        SDL_assert(!"Gameplay allocated after warm-up");
+        tracker->is_recording = true;
+    }
+}
+
+local_internal void alloc_tracker_record_free()
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+    if (tracker->is_recording && SDL_ThreadID() == tracker->main_thread_id)
+    {
+        tracker->this_frame[tracker->phase].frees++;
+    }
+}
+
+local_internal void* SDLCALL tracked_sdl_malloc(size_t size)
+{
+    alloc_tracker_record_allocation(size);
+    return original_sdl_malloc(size);
+}
+
+local_internal void* SDLCALL tracked_sdl_calloc(size_t count, size_t size)
+{
+    alloc_tracker_record_allocation(count * size);
+    return original_sdl_calloc(count, size);
+}
+
+local_internal void* SDLCALL tracked_sdl_realloc(void* pointer, size_t size)
+{
+    alloc_tracker_record_allocation(size);
+    return original_sdl_realloc(pointer, size);
+}
+
+local_internal void SDLCALL tracked_sdl_free(void* pointer)
+{
+    if (pointer)
+    {
+        alloc_tracker_record_free();
+    }
+    original_sdl_free(pointer);
+}
+
+// C++ global allocator
+void* operator new(size_t size)
+{
+    alloc_tracker_record_allocation(size);
+    void* result = malloc(size ? size : 1);
+    if (!result)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    alloc_tracker_record_allocation(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer)
+    {
+        alloc_tracker_record_free();
+    }
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t size) noexcept
+{
+    operator delete(pointer);
+}
+
+// Must be called before SDL_Init so every SDL allocation goes through the hooks
+void alloc_tracker_init()
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+    tracker->main_thread_id = SDL_ThreadID();
+
+    SDL_GetMemoryFunctions(&original_sdl_malloc, &original_sdl_calloc, &original_sdl_realloc, &original_sdl_free);
+    SDL_SetMemoryFunctions(tracked_sdl_malloc, tracked_sdl_calloc, tracked_sdl_realloc, tracked_sdl_free);
+
+    tracker->phase = ALLOC_PHASE_INPUT;
+    tracker->is_recording = true;
+}
+
+void alloc_tracker_set_phase(Alloc_Phase phase)
+{
+    global_alloc_tracker.phase = phase;
+}
+
+// in_gameplay should be set while a game is being played (i.e. the strict checks apply)
+void alloc_tracker_begin_frame(bool32 in_gameplay)
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+
+    if (in_gameplay)
+    {
+        tracker->gameplay_frames++;
+    }
+    else
+    {
+        tracker->gameplay_frames = 0;
+    }
+
+    tracker->is_strict = ALLOCATION_STRICT_MODE && tracker->gameplay_frames > ALLOCATION_WARM_UP_FRAMES;
+    tracker->phase = ALLOC_PHASE_INPUT;
+}
+
+void alloc_tracker_end_frame()
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+
+    tracker->last_frame_total = {};
+    for (uint32 i = 0; i < ALLOC_PHASE_COUNT; i++)
+    {
+        tracker->last_frame[i] = tracker->this_frame[i];
+        tracker->last_frame_total.allocations += tracker->this_frame[i].allocations;
+        tracker->last_frame_total.frees += tracker->this_frame[i].frees;
+        tracker->last_frame_total.bytes += tracker->this_frame[i].bytes;
+        tracker->this_frame[i] = {};
+    }
+
+    tracker->last_frame_other_thread_allocations = (uint32)SDL_AtomicSet(&tracker->other_thread_allocations, 0);
+}
+
+// Writes something like "update 0 (0 B), render 2 (1024 B)" for every phase that allocated last frame
+void alloc_tracker_format_phases(char* buffer, size_t buffer_size)
+{
+    Alloc_Tracker* tracker = &global_alloc_tracker;
+    size_t length = 0;
+    buffer[0] = '\0';
+
+    for (uint32 i = 0; i < ALLOC_PHASE_COUNT && length < buffer_size; i++)
+    {
+        Alloc_Stats* stats = &tracker->last_frame[i];
+        if (stats->allocations == 0)
+        {
+            continue;
+        }
+
+        length += snprintf(buffer + length,
+                           buffer_size - length,
+                           "%s%s %u (%llu B)",
+                           length ? ", " : "",
+                           alloc_phase_names[i],
+                           stats->allocations,
+                           (unsigned long long)stats->bytes);
+    }
+
+    if (length == 0)
+    {
+        snprintf(buffer, buffer_size, "none");
+    }
+}
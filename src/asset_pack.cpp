@@ -0,0 +1,224 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "asset_pack.h"
+
+// Every asset is opened through asset_open(). When assets.pack sits next to the executable it gets mapped once at
+// startup and assets are handed to SDL straight out of the mapping, so nothing is copied and nothing is read until SDL
+// actually looks at it. Without a pack we fall back to the loose files.
+
+// Check the content hash of pack assets whenever they get opened. This reads the whole asset, so it's off by default.
+bool32 ASSET_PACK_VERIFY_HASHES = 0;
+
+struct Asset_Pack
+{
+    uint8* base;
+    size_t size;
+    Asset_Pack_Entry* entries;
+    uint32 entry_count;
+
+#ifdef __WINDOWS__
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+Asset_Pack global_asset_pack;
+
+local_internal bool32 asset_pack_map_file(Asset_Pack* pack, const char* file_path)
+{
+#ifdef __WINDOWS__
+    pack->file = CreateFileA(
+        file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (pack->file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(pack->file, &file_size);
+    pack->size = (size_t)file_size.QuadPart;
+
+    pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    pack->base = pack->mapping ? (uint8*)MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!pack->base)
+    {
+        if (pack->mapping)
+        {
+            CloseHandle(pack->mapping);
+        }
+        CloseHandle(pack->file);
+        return false;
+    }
+#else
+    int file = open(file_path, O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    pack->size = (size_t)file_stat.st_size;
+
+    void* memory = mmap(NULL, pack->size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps the file alive
+    close(file);
+    if (memory == MAP_FAILED)
+    {
+        return false;
+    }
+    pack->base = (uint8*)memory;
+
+    // Stop the kernel from reading ahead into assets nobody asked for
+    madvise(pack->base, pack->size, MADV_RANDOM);
+#endif
+
+    return true;
+}
+
+local_internal void asset_pack_unmap_file(Asset_Pack* pack)
+{
+#ifdef __WINDOWS__
+    UnmapViewOfFile(pack->base);
+    CloseHandle(pack->mapping);
+    CloseHandle(pack->file);
+#else
+    munmap(pack->base, pack->size);
+#endif
+    *pack = {};
+}
+
+// Only looks at the header and the index, never at the asset data
+local_internal bool32 asset_pack_validate(Asset_Pack* pack)
+{
+    if (pack->size < sizeof(Asset_Pack_Header))
+    {
+        return false;
+    }
+
+    // Offsets and sizes come from the file, so compare them without adding them up, which could wrap around
+    Asset_Pack_Header* header = (Asset_Pack_Header*)pack->base;
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION ||
+        header->index_offset > pack->size ||
+        (uint64)header->entry_count * sizeof(Asset_Pack_Entry) > pack->size - header->index_offset)
+    {
+        return false;
+    }
+
+    Asset_Pack_Entry* entries = (Asset_Pack_Entry*)(pack->base + header->index_offset);
+    for (uint32 i = 0; i < header->entry_count; i++)
+    {
+        if (entries[i].offset > pack->size || entries[i].size > pack->size - entries[i].offset ||
+            entries[i].name[ASSET_PACK_MAX_NAME_LENGTH - 1] != '\0' ||
+            (i > 0 && entries[i - 1].name_hash > entries[i].name_hash))
+        {
+            return false;
+        }
+    }
+
+    pack->entries = entries;
+    pack->entry_count = header->entry_count;
+    return true;
+}
+
+// Looks for assets.pack next to the executable. Returns false (and everything loads from loose files) if there isn't
+// a usable one.
+bool32 asset_pack_open()
+{
+    Asset_Pack* pack = &global_asset_pack;
+
+    char pack_path[1024];
+    char* base_path = SDL_GetBasePath();
+    snprintf(pack_path, sizeof(pack_path), "%sassets.pack", base_path ? base_path : "");
+    SDL_free(base_path);
+
+    if (!asset_pack_map_file(pack, pack_path))
+    {
+        printf("No asset pack at %s, loading loose files\n", pack_path);
+        return false;
+    }
+
+    if (!asset_pack_validate(pack))
+    {
+        fprintf(stderr, "Asset pack %s is invalid or out of date, loading loose files\n", pack_path);
+        asset_pack_unmap_file(pack);
+        return false;
+    }
+
+    printf("Asset pack: %u assets (%zu KB) mapped from %s\n", pack->entry_count, pack->size / 1024, pack_path);
+    return true;
+}
+
+void asset_pack_close()
+{
+    if (global_asset_pack.base)
+    {
+        asset_pack_unmap_file(&global_asset_pack);
+    }
+}
+
+local_internal Asset_Pack_Entry* asset_pack_find(const char* name)
+{
+    Asset_Pack* pack = &global_asset_pack;
+    uint64 name_hash = asset_pack_hash_name(name);
+
+    uint32 low = 0;
+    uint32 high = pack->entry_count;
+    while (low < high)
+    {
+        uint32 middle = low + (high - low) / 2;
+        if (pack->entries[middle].name_hash < name_hash)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for (uint32 i = low; i < pack->entry_count && pack->entries[i].name_hash == name_hash; i++)
+    {
+        if (strcmp(pack->entries[i].name, name) == 0)
+        {
+            return &pack->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Opens an asset by its relative path (e.g. "sounds/boom.mp3"). Pack assets are read straight from the mapping, so
+// the RWops must not outlive asset_pack_close(). Returns NULL (with the SDL error set) if it can't be found.
+SDL_RWops* asset_open(const char* name)
+{
+    if (global_asset_pack.base)
+    {
+        Asset_Pack_Entry* entry = asset_pack_find(name);
+        if (entry)
+        {
+            const uint8* data = global_asset_pack.base + entry->offset;
+            if (ASSET_PACK_VERIFY_HASHES && asset_pack_hash(data, entry->size) != entry->content_hash)
+            {
+                SDL_SetError("Asset %s is corrupt", name);
+                return NULL;
+            }
+            return SDL_RWFromConstMem(data, (int)entry->size);
+        }
+    }
+
+    return SDL_RWFromFile(name, "rb");
+}
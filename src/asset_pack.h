@@ -0,0 +1,57 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+// The asset pack file format, shared by the game and tools/asset_packer.cpp
+//
+// [Asset_Pack_Header][Asset_Pack_Entry * entry_count][asset data...]
+//
+// The index is sorted by name_hash so lookups are a binary search. Every asset starts on its own page so touching one
+// asset never pages in part of another one.
+
+#define ASSET_PACK_MAGIC 0x4B504E53  // "SNPK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 4096
+#define ASSET_PACK_MAX_NAME_LENGTH 112
+
+struct Asset_Pack_Header
+{
+    uint32 magic;
+    uint32 version;
+    uint32 entry_count;
+    uint32 reserved;
+    uint64 index_offset;
+};
+
+struct Asset_Pack_Entry
+{
+    uint64 name_hash;
+    uint64 content_hash;
+    uint64 offset;  // From the start of the file
+    uint64 size;
+    char name[ASSET_PACK_MAX_NAME_LENGTH];  // The relative path the game asks for, e.g. "sounds/boom.mp3"
+};
+
+// 64-bit FNV-1a. Used for both the names and the contents.
+inline uint64 asset_pack_hash(const void* data, uint64 size)
+{
+    const uint8* bytes = (const uint8*)data;
+    uint64 hash = 0xcbf29ce484222325ull;
+    for (uint64 i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline uint64 asset_pack_hash_name(const char* name)
+{
+    uint64 length = 0;
+    while (name[length])
+    {
+        length++;
+    }
+    return asset_pack_hash(name, length);
+}
+
+#endif  // ASSET_PACK_H
@@ -1,39 +1,246 @@
 #include "audio.h"
 #include <stdio.h>
 
+Audio_Context global_audio_context;
+Audio_Latency_Stats global_audio_latency_stats;
+
+Audio_Post_Mix_Tap* global_audio_post_mix_tap;
+void* global_audio_post_mix_tap_udata;
+
+// Ignore the callbacks while the device is starting up, their timing is all over the place
+#define AUDIO_WARM_UP_CALLBACKS 50
+
+local_internal void audio_post_mix(void* udata, Uint8* stream, int len)
+{
+    Audio_Latency_Stats* stats = &global_audio_latency_stats;
+    Uint64 counter_now = SDL_GetPerformanceCounter();
+    real64 counter_frequency = (real64)SDL_GetPerformanceFrequency();
+
+    // 16-bit stereo
+    stats->buffer_samples = len / (2 * sizeof(int16));
+    real32 buffer_ms = stats->frequency > 0 ? 1000.0f * stats->buffer_samples / stats->frequency : 0.0f;
+
+    {  // Underruns
+        if (stats->callback_count > AUDIO_WARM_UP_CALLBACKS && stats->frequency > 0)
+        {
+            real32 interval_ms = (real32)(1000.0 * (counter_now - stats->last_callback_counter) / counter_frequency);
+            real32 lateness_ms = interval_ms - buffer_ms;
+            if (lateness_ms > stats->max_callback_lateness_ms)
+            {
+                stats->max_callback_lateness_ms = lateness_ms;
+            }
+
+            // The device has roughly one more buffer queued up, so being later than that means it ran dry
+            if (lateness_ms > buffer_ms)
+            {
+                stats->underruns++;
+            }
+        }
+        stats->last_callback_counter = counter_now;
+        stats->callback_count++;
+    }
+
+    // Effects go in first so the capture tap hears them too
+    Uint64 play_counter = 0;
+    if (stats->is_mixer_enabled)
+    {
+        play_counter = mixer_mix((int16*)stream, stats->buffer_samples);
+    }
+
+    {  // Latency
+        if (play_counter)
+        {
+            stats->last_latency_ms = (real32)(1000.0 * (counter_now - play_counter) / counter_frequency);
+            stats->average_latency_ms = stats->average_latency_ms
+                                            ? 0.9f * stats->average_latency_ms + 0.1f * stats->last_latency_ms
+                                            : stats->last_latency_ms;
+            if (stats->last_latency_ms > stats->max_latency_ms)
+            {
+                stats->max_latency_ms = stats->last_latency_ms;
+            }
+        }
+    }
+
+    if (global_audio_post_mix_tap)
+    {
+        global_audio_post_mix_tap(global_audio_post_mix_tap_udata, stream, len);
+    }
+}
+
+void audio_set_post_mix_tap(Audio_Post_Mix_Tap* tap, void* udata)
+{
+    // Mix_SetPostMix takes the audio lock, so unhooking first means the callback can't see a half-updated tap
+    Mix_SetPostMix(NULL, NULL);
+    global_audio_post_mix_tap = tap;
+    global_audio_post_mix_tap_udata = udata;
+    Mix_SetPostMix(audio_post_mix, NULL);
+}
+
+int32 audio_get_recommended_buffer_samples(void)
+{
+    Audio_Latency_Stats* stats = &global_audio_latency_stats;
+    if (stats->frequency <= 0)
+    {
+        // Audio never opened, nothing to recommend
+        return stats->buffer_samples;
+    }
+
+    // Give ourselves 50% headroom over the worst lateness we've seen
+    real32 needed_ms = 1.5f * stats->max_callback_lateness_ms;
+    int32 recommended = 64;
+    while (recommended < 8192 && 1000.0f * recommended / stats->frequency < needed_ms)
+    {
+        recommended *= 2;
+    }
+
+    if (stats->underruns && recommended <= stats->buffer_samples)
+    {
+        recommended = stats->buffer_samples * 2;
+    }
+    return recommended;
+}
+
+// Mix_LoadWAV_RW converts to the device format, so the effect can point straight at the chunk's samples
+local_internal Mix_Chunk* load_sound_effect(const char* file_path, Sound_Effect* effect)
+{
+    Mix_Chunk* chunk = Mix_LoadWAV_RW(asset_open(file_path), 1);
+    if (chunk)
+    {
+        effect->samples = (const int16*)chunk->abuf;
+        effect->frame_count = chunk->alen / (2 * sizeof(int16));
+    }
+    return chunk;
+}
+
+local_internal void synthesize_sound_effects(Audio_Context* ctx, Memory_Arena* arena)
+{
+    int32 frequency = global_audio_latency_stats.frequency;
+    synth_render(arena, &synth_patch_beep, frequency, &ctx->effect_beep);
+    synth_render(arena, &synth_patch_beep_2, frequency, &ctx->effect_beep_2);
+    synth_render(arena, &synth_patch_boom, frequency, &ctx->effect_boom);
+}
+
+// Times (best of a few runs) decoding the effects from sounds/ against synthesizing them, and how much memory each
+// way keeps around
+local_internal void benchmark_sound_effects()
+{
+    const char* file_paths[] = {"sounds/beep.wav", "sounds/beep-2.mp3", "sounds/boom.mp3"};
+    int32 run_count = 5;
+    real64 counter_frequency = (real64)SDL_GetPerformanceFrequency();
+
+    real64 decode_ms = 1e9;
+    size_t decode_bytes = 0;
+    for (int32 run = 0; run < run_count; run++)
+    {
+        decode_bytes = 0;
+        Uint64 start_counter = SDL_GetPerformanceCounter();
+        for (uint32 i = 0; i < SDL_arraysize(file_paths); i++)
+        {
+            Mix_Chunk* chunk = Mix_LoadWAV_RW(asset_open(file_paths[i]), 1);
+            if (chunk)
+            {
+                decode_bytes += chunk->alen;
+                Mix_FreeChunk(chunk);
+            }
+        }
+        decode_ms = SDL_min(decode_ms, 1000.0 * (SDL_GetPerformanceCounter() - start_counter) / counter_frequency);
+    }
+
+    real64 synth_ms = 1e9;
+    size_t synth_bytes = 0;
+    for (int32 run = 0; run < run_count; run++)
+    {
+        Audio_Context scratch = {};
+        Arena_Marker marker = arena_get_marker(&global_transient_arena);
+        Uint64 start_counter = SDL_GetPerformanceCounter();
+
+        synthesize_sound_effects(&scratch, &global_transient_arena);
+
+        synth_ms = SDL_min(synth_ms, 1000.0 * (SDL_GetPerformanceCounter() - start_counter) / counter_frequency);
+        synth_bytes = global_transient_arena.used - marker.used;
+        arena_reset_to_marker(marker);
+    }
+
+    printf("Sound effect benchmark: Mix_LoadWAV %.02f ms (%zu KB), synthesized %.02f ms (%zu KB)\n",
+           decode_ms,
+           decode_bytes / 1024,
+           synth_ms,
+           synth_bytes / 1024);
+}
+
 bool32 audio_init(Audio_Context* ctx)
 {
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0)
+    int32 buffer_samples = AUDIO_LOW_LATENCY_ENABLED ? AUDIO_LOW_LATENCY_BUFFER_SAMPLES : AUDIO_DEFAULT_BUFFER_SAMPLES;
+    if (Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, 2, buffer_samples) < 0)
     {
         fprintf(stderr, "SDL_mixer could not initialize! Mix_Error: %s\n", Mix_GetError());
         return false;
     }
 
+    {
+        Uint16 format = 0;
+        int channels = 0;
+        if (!Mix_QuerySpec(&global_audio_latency_stats.frequency, &format, &channels))
+        {
+            // Everything timed off the frequency would divide by zero, so assume we got what we asked for
+            fprintf(stderr, "Couldn't query the audio format! Mix_Error: %s\n", Mix_GetError());
+            global_audio_latency_stats.frequency = AUDIO_FREQUENCY;
+        }
+        global_audio_latency_stats.buffer_samples = buffer_samples;
+        global_audio_latency_stats.is_mixer_enabled = format == AUDIO_S16SYS && channels == 2;
+        if (!global_audio_latency_stats.is_mixer_enabled)
+        {
+            fprintf(stderr, "Audio device isn't 16-bit stereo, sound effects are disabled\n");
+        }
+
+        mixer_init();
+        audio_set_post_mix_tap(NULL, NULL);
+    }
+
     // Load audio files
-    ctx->background_music = Mix_LoadMUS("music/mixkit-feast-from-the-east.mp3");
+    ctx->background_music = Mix_LoadMUS_RW(asset_open("music/mixkit-feast-from-the-east.mp3"), 1);
     if (!ctx->background_music)
     {
         fprintf(stderr, "Failed to load background music! Mix_Error: %s\n", Mix_GetError());
     }
 
-    ctx->effect_beep = Mix_LoadWAV("sounds/beep.wav");
-    if (!ctx->effect_beep)
+    if (SYNTHESIZED_SOUND_EFFECTS_ENABLED)
     {
-        fprintf(stderr, "Failed to load beep sound effect! Mix_Error: %s\n", Mix_GetError());
-    }
+        size_t used_before = global_permanent_arena.used;
+        Uint64 start_counter = SDL_GetPerformanceCounter();
 
-    ctx->effect_beep_2 = Mix_LoadWAV("sounds/beep-2.mp3");
+        synthesize_sound_effects(ctx, &global_permanent_arena);
 
-    if (!ctx->effect_beep_2)
-    {
-        fprintf(stderr, "Failed to load beep 2 sound effect! Mix_Error: %s\n", Mix_GetError());
+        printf("Synthesized sound effects in %.02f ms (%zu KB)\n",
+               1000.0 * (SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency(),
+               (global_permanent_arena.used - used_before) / 1024);
     }
+    else
+    {
+        ctx->effect_beep_chunk = load_sound_effect("sounds/beep.wav", &ctx->effect_beep);
+        if (!ctx->effect_beep_chunk)
+        {
+            fprintf(stderr, "Failed to load beep sound effect! Mix_Error: %s\n", Mix_GetError());
+        }
+
+        ctx->effect_beep_2_chunk = load_sound_effect("sounds/beep-2.mp3", &ctx->effect_beep_2);
 
-    ctx->effect_boom = Mix_LoadWAV("sounds/boom.mp3");
+        if (!ctx->effect_beep_2_chunk)
+        {
+            fprintf(stderr, "Failed to load beep 2 sound effect! Mix_Error: %s\n", Mix_GetError());
+        }
 
-    if (!ctx->effect_beep_2)
+        ctx->effect_boom_chunk = load_sound_effect("sounds/boom.mp3", &ctx->effect_boom);
+
+        if (!ctx->effect_boom_chunk)
+        {
+            fprintf(stderr, "Failed to load boom sound effect! Mix_Error: %s\n", Mix_GetError());
+        }
+    }
+
+    if (SOUND_EFFECT_BENCHMARK_ENABLED)
     {
-        fprintf(stderr, "Failed to load boom sound effect! Mix_Error: %s\n", Mix_GetError());
+        benchmark_sound_effects();
     }
 
     return true;
@@ -41,17 +248,23 @@ bool32 audio_init(Audio_Context* ctx)
 
 void audio_cleanup(Audio_Context* ctx)
 {
+    Mix_SetPostMix(NULL, NULL);
+
     if (ctx->background_music)
     {
         Mix_FreeMusic(ctx->background_music);
     }
-    if (ctx->effect_beep)
+    if (ctx->effect_beep_chunk)
+    {
+        Mix_FreeChunk(ctx->effect_beep_chunk);
+    }
+    if (ctx->effect_beep_2_chunk)
     {
-        Mix_FreeChunk(ctx->effect_beep);
+        Mix_FreeChunk(ctx->effect_beep_2_chunk);
     }
-    if (ctx->effect_beep_2)
+    if (ctx->effect_boom_chunk)
     {
-        Mix_FreeChunk(ctx->effect_beep_2);
+        Mix_FreeChunk(ctx->effect_boom_chunk);
     }
     Mix_CloseAudio();
 }
@@ -76,10 +289,19 @@ void set_music_volume(real32 volume)
     Mix_VolumeMusic(MIX_MAX_VOLUME * percent);
 }
 
-void play_sound_effect(Mix_Chunk* effect)
+Voice_Id play_sound_effect(Sound_Effect* effect, real32 gain, real32 pitch)
 {
-    if (effect)
+    return mixer_play(effect, gain, pitch);
+}
+
+void play_sound_effect_stress_test(void)
+{
+    Sound_Effect* effects[] = {
+        &global_audio_context.effect_beep, &global_audio_context.effect_beep_2, &global_audio_context.effect_boom};
+
+    for (uint32 i = 0; i < AUDIO_STRESS_TEST_VOICES; i++)
     {
-        Mix_PlayChannel(-1, effect, 0);
+        // Quiet enough that the sum doesn't just clip the whole time
+        play_sound_effect(effects[i % SDL_arraysize(effects)], 4.0f / AUDIO_STRESS_TEST_VOICES);
     }
 }
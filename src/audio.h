@@ -3,18 +3,58 @@
 
 #include <SDL2/SDL_mixer.h>
 
+#include "mixer.h"
+
+#define AUDIO_FREQUENCY 44100
+
 // Audio_Context to store audio resources
 typedef struct
 {
     Mix_Music* background_music;
-    Mix_Chunk* effect_beep;
-    Mix_Chunk* effect_beep_2;
-    Mix_Chunk* effect_boom;
+
+    // Sound effects are played by our mixer. The chunks own the decoded samples when the effects aren't synthesized.
+    Mix_Chunk* effect_beep_chunk;
+    Mix_Chunk* effect_beep_2_chunk;
+    Mix_Chunk* effect_boom_chunk;
+    Sound_Effect effect_beep;
+    Sound_Effect effect_beep_2;
+    Sound_Effect effect_boom;
 } Audio_Context;
 
+// How many effects the stress test fires off at once
+#define AUDIO_STRESS_TEST_VOICES 200
+
+// Measures how long it takes from play_sound_effect until the effect is in a buffer the audio callback has mixed,
+// and watches the callback timing for underruns. Written by the audio thread, read for the debug overlay.
+typedef struct
+{
+    int32 frequency;
+    int32 buffer_samples;  // What the device actually gave us
+    bool32 is_mixer_enabled;  // Our mixer only handles 16-bit stereo
+
+    Uint64 last_callback_counter;
+    uint32 callback_count;
+
+    real32 last_latency_ms;
+    real32 average_latency_ms;
+    real32 max_latency_ms;
+
+    real32 max_callback_lateness_ms;  // How much later than expected the callback has run
+    uint32 underruns;
+} Audio_Latency_Stats;
+
+// Gets called with the final mix on the audio thread
+typedef void Audio_Post_Mix_Tap(void* udata, Uint8* stream, int len);
+
 // Initialize the audio system
 bool32 audio_init(Audio_Context* ctx);
 
+// Replaces the post-mix tap. Once this returns the old tap is guaranteed not to be running.
+void audio_set_post_mix_tap(Audio_Post_Mix_Tap* tap, void* udata);
+
+// Smallest buffer size (in samples) that should play without glitches given the callback timing seen so far
+int32 audio_get_recommended_buffer_samples(void);
+
 // Cleanup the audio system
 void audio_cleanup(Audio_Context* ctx);
 
@@ -26,7 +66,10 @@ void stop_music(void);
 
 void set_music_volume(real32 volume);
 
-// Play a sound effect
-void play_sound_effect(Mix_Chunk* effect);
+// Play a sound effect. Never blocks. A pitch of 2 is an octave up.
+Voice_Id play_sound_effect(Sound_Effect* effect, real32 gain = 1.0f, real32 pitch = 1.0f);
+
+// Plays AUDIO_STRESS_TEST_VOICES effects at once to see how the mixer holds up
+void play_sound_effect_stress_test(void);
 
 #endif  // AUDIO_H
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+// One bit per grid cell. Rows are padded out to whole words, so moving every cell of a board one step in any
+// direction is a couple of shifts per word, i.e. 64 cells at a time. The autoplayer's searches are built out of that.
+//
+// Every row ends in an extra word that's always zero, and there's an all zero row above and below the board, so the
+// neighbours of any cell can be read without checking for the edges.
+
+#define BITBOARD_MAX_WIDTH 4096
+
+struct Bitboard
+{
+    uint64* words;  // Row 0, word 0
+    uint64* next_words;  // bitboard_grow() writes here and then swaps
+    int32 width;
+    int32 height;
+    int32 words_per_row;  // Including the zero word on the end
+
+    // Every set bit is in these rows, which keeps growing a small region cheap on a big board. first > last when empty.
+    int32 first_row;
+    int32 last_row;
+};
+
+local_internal uint32 count_set_bits(uint64 value)
+{
+#if defined(_MSC_VER)
+    return (uint32)__popcnt64(value);
+#else
+    return (uint32)__builtin_popcountll(value);
+#endif
+}
+
+void bitboard_clear(Bitboard* board)
+{
+    size_t size = (size_t)board->words_per_row * (board->height + 2) * sizeof(uint64);
+    memset(board->words - board->words_per_row, 0, size);
+    memset(board->next_words - board->words_per_row, 0, size);
+    board->first_row = board->height;
+    board->last_row = -1;
+}
+
+Bitboard bitboard_make(Memory_Arena* arena, int32 width, int32 height)
+{
+    SDL_assert_release(width > 0 && width <= BITBOARD_MAX_WIDTH && height > 0);
+
+    Bitboard board = {};
+    board.width = width;
+    board.height = height;
+    board.words_per_row = (width + 63) / 64 + 1;
+
+    size_t word_count = (size_t)board.words_per_row * (height + 2);
+    board.words = push_array(arena, word_count, uint64) + board.words_per_row;
+    board.next_words = push_array(arena, word_count, uint64) + board.words_per_row;
+    bitboard_clear(&board);
+    return board;
+}
+
+// Sets every cell on the board (but none of the padding)
+void bitboard_fill(Bitboard* board)
+{
+    for (int32 row = 0; row < board->height; row++)
+    {
+        uint64* words = board->words + row * board->words_per_row;
+        for (int32 word = 0; word < board->words_per_row - 1; word++)
+        {
+            int32 cells_in_word = SDL_min(board->width - word * 64, 64);
+            words[word] = cells_in_word == 64 ? ~(uint64)0 : ((uint64)1 << cells_in_word) - 1;
+        }
+    }
+    board->first_row = 0;
+    board->last_row = board->height - 1;
+}
+
+inline bool32 bitboard_is_inside(Bitboard* board, int32 x, int32 y)
+{
+    return x >= 0 && x < board->width && y >= 0 && y < board->height;
+}
+
+inline bool32 bitboard_get(Bitboard* board, int32 x, int32 y)
+{
+    return (board->words[y * board->words_per_row + x / 64] >> (x % 64)) & 1;
+}
+
+inline void bitboard_set(Bitboard* board, int32 x, int32 y)
+{
+    board->words[y * board->words_per_row + x / 64] |= (uint64)1 << (x % 64);
+    board->first_row = SDL_min(board->first_row, y);
+    board->last_row = SDL_max(board->last_row, y);
+}
+
+// Doesn't shrink the row range, it only has to cover the set bits
+inline void bitboard_unset(Bitboard* board, int32 x, int32 y)
+{
+    board->words[y * board->words_per_row + x / 64] &= ~((uint64)1 << (x % 64));
+}
+
+uint32 bitboard_count(Bitboard* board)
+{
+    uint32 count = 0;
+    for (int32 row = board->first_row; row <= board->last_row; row++)
+    {
+        uint64* words = board->words + row * board->words_per_row;
+        for (int32 word = 0; word < board->words_per_row - 1; word++)
+        {
+            count += count_set_bits(words[word]);
+        }
+    }
+    return count;
+}
+
+// Adds every cell in mask that's next to (north, east, south or west of) a cell in the board, i.e. one BFS layer.
+// Returns false once nothing changes.
+//
+// Only the rows around the set ones get written to next_words before the swap. That works because the set cells only
+// ever grow between clears, so whatever the other rows hold from two layers ago is still all zero.
+bool32 bitboard_grow(Bitboard* board, Bitboard* mask)
+{
+    SDL_assert(board->words_per_row == mask->words_per_row && board->height == mask->height);
+
+    if (board->first_row > board->last_row)
+    {
+        return false;
+    }
+
+    int32 words_per_row = board->words_per_row;
+    int32 first_row = SDL_max(board->first_row - 1, 0);
+    int32 last_row = SDL_min(board->last_row + 1, board->height - 1);
+
+    bool32 has_grown = false;
+    for (int32 row = first_row; row <= last_row; row++)
+    {
+        uint64* words = board->words + row * words_per_row;
+        uint64* next_words = board->next_words + row * words_per_row;
+        uint64* mask_words = mask->words + row * words_per_row;
+
+        // No branches in here so the compiler can vectorize it. The zero word on the end of this row (and of the
+        // previous one) stops the carries between words from wrapping around.
+        uint64 changed = 0;
+        for (int32 word = 0; word < words_per_row - 1; word++)
+        {
+            uint64 cells = words[word];
+            uint64 from_west = (cells << 1) | (words[word - 1] >> 63);
+            uint64 from_east = (cells >> 1) | (words[word + 1] << 63);
+            uint64 from_south = words[word - words_per_row];
+            uint64 from_north = words[word + words_per_row];
+            uint64 grown = cells | ((from_west | from_east | from_south | from_north) & mask_words[word]);
+            changed |= grown ^ cells;
+            next_words[word] = grown;
+        }
+
+        if (changed)
+        {
+            has_grown = true;
+            board->first_row = SDL_min(board->first_row, row);
+            board->last_row = SDL_max(board->last_row, row);
+        }
+    }
+
+    uint64* words = board->words;
+    board->words = board->next_words;
+    board->next_words = words;
+
+    return has_grown;
+}
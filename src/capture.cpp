@@ -0,0 +1,511 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <stdio.h>
+
+#include "audio.h"
+#include <time.h>
+
+// Built-in gameplay capture. Every presented frame is read back into one of a pool of preallocated buffers and handed
+// to a writer thread which streams it to a Y4M file. The mixed audio goes through a ring buffer to a WAV file. The main
+// thread never touches the disk while capturing: if the writer falls behind, frames get dropped instead.
+
+#define CAPTURE_FRAME_POOL_SIZE 8
+#define CAPTURE_AUDIO_RING_SIZE (1 << 20)  // Must be a power of two
+#define CAPTURE_MAX_FRAME_SKIP 4
+
+// If reading back a frame costs more than this on average, only every Nth frame gets captured
+real32 CAPTURE_FRAME_BUDGET_MS = 2.0f;
+
+// The video is written at a fixed TARGET_SCREEN_FPS whatever rate the game presents at. Every present is timestamped
+// on the audio clock and the frame read back there gets repeated to fill every video frame up to it, so frames the
+// game was late with, skipped or dropped get made up for by the next one, and frames it was early with get left out.
+// That keeps the video as long as the audio.
+
+struct Capture_Frame
+{
+    uint8* pixels;  // RGBA32
+    int32 repeat_count;  // Video frames to write it for, can be more than one
+};
+
+struct Capture_Context
+{
+    bool32 is_capturing;
+
+    int32 x;
+    int32 y;
+    int32 width;
+    int32 height;
+
+    Capture_Frame frames[CAPTURE_FRAME_POOL_SIZE];
+    SDL_atomic_t frames_produced;  // Only written by the main thread
+    SDL_atomic_t frames_consumed;  // Only written by the writer thread
+
+    uint8* audio_ring;
+    SDL_atomic_t audio_bytes_produced;  // Only written by the audio thread
+    SDL_atomic_t audio_bytes_consumed;  // Only written by the writer thread
+    int32 audio_frequency;
+    int32 audio_channels;
+    bool32 has_audio;
+
+    SDL_Thread* writer_thread;
+    SDL_sem* work_available;
+    SDL_atomic_t stop_requested;
+
+    FILE* video_file;
+    FILE* audio_file;
+    uint32 audio_bytes_written;  // Writer thread only
+    uint8* yuv_buffer;           // Writer thread only
+
+    // Video clock (main thread)
+    Uint64 start_counter;
+    real64 audio_clock_offset__seconds;  // How far the audio clock is ahead of the performance counter, smoothed
+    uint32 last_audio_bytes_seen;
+    uint64 video_frames_assigned;   // To frames handed to the writer
+    int64 pending_repeat_count;     // Video frames that are due but no frame's been handed over for yet
+
+    // Stats (main thread)
+    uint32 frame_index;
+    uint32 frame_skip;
+    uint32 frames_captured;
+    uint32 frames_dropped;
+    SDL_atomic_t audio_bytes_dropped;
+    real32 last_frame_cost_ms;
+    real32 average_frame_cost_ms;
+    real32 max_frame_cost_ms;
+};
+
+Capture_Context global_capture_context;
+
+local_internal void capture_convert_to_yuv420(Capture_Context* ctx, uint8* rgba)
+{
+    int32 width = ctx->width;
+    int32 height = ctx->height;
+    uint8* y_plane = ctx->yuv_buffer;
+    uint8* u_plane = y_plane + width * height;
+    uint8* v_plane = u_plane + (width / 2) * (height / 2);
+
+    // BT.601 full range (C420jpeg) in 8.8 fixed point
+    for (int32 row = 0; row < height; row++)
+    {
+        uint8* pixel = rgba + row * width * 4;
+        uint8* y_row = y_plane + row * width;
+        for (int32 column = 0; column < width; column++)
+        {
+            int32 r = pixel[0];
+            int32 g = pixel[1];
+            int32 b = pixel[2];
+            y_row[column] = (uint8)((77 * r + 150 * g + 29 * b) >> 8);
+            pixel += 4;
+        }
+    }
+
+    for (int32 row = 0; row < height / 2; row++)
+    {
+        uint8* top = rgba + (2 * row) * width * 4;
+        uint8* bottom = top + width * 4;
+        for (int32 column = 0; column < width / 2; column++)
+        {
+            int32 r = (top[0] + top[4] + bottom[0] + bottom[4]) >> 2;
+            int32 g = (top[1] + top[5] + bottom[1] + bottom[5]) >> 2;
+            int32 b = (top[2] + top[6] + bottom[2] + bottom[6]) >> 2;
+            u_plane[row * (width / 2) + column] = (uint8)(128 + ((-43 * r - 85 * g + 128 * b) >> 8));
+            v_plane[row * (width / 2) + column] = (uint8)(128 + ((128 * r - 107 * g - 21 * b) >> 8));
+            top += 8;
+            bottom += 8;
+        }
+    }
+}
+
+local_internal void capture_write_wav_header(FILE* file, int32 frequency, int32 channels, uint32 data_bytes)
+{
+    uint16 bits_per_sample = 16;
+    uint16 block_align = (uint16)(channels * (bits_per_sample / 8));
+    uint32 byte_rate = frequency * block_align;
+    uint32 riff_size = 36 + data_bytes;
+    uint32 format_size = 16;
+    uint16 format_pcm = 1;
+    uint16 channel_count = (uint16)channels;
+    uint32 sample_rate = (uint32)frequency;
+
+    // NOTE: WAV is little-endian, same as every platform we ship on
+    fwrite("RIFF", 1, 4, file);
+    fwrite(&riff_size, 4, 1, file);
+    fwrite("WAVEfmt ", 1, 8, file);
+    fwrite(&format_size, 4, 1, file);
+    fwrite(&format_pcm, 2, 1, file);
+    fwrite(&channel_count, 2, 1, file);
+    fwrite(&sample_rate, 4, 1, file);
+    fwrite(&byte_rate, 4, 1, file);
+    fwrite(&block_align, 2, 1, file);
+    fwrite(&bits_per_sample, 2, 1, file);
+    fwrite("data", 1, 4, file);
+    fwrite(&data_bytes, 4, 1, file);
+}
+
+local_internal void capture_drain_audio(Capture_Context* ctx)
+{
+    uint32 produced = (uint32)SDL_AtomicGet(&ctx->audio_bytes_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&ctx->audio_bytes_consumed);
+    SDL_MemoryBarrierAcquire();
+
+    while (consumed != produced)
+    {
+        uint32 offset = consumed & (CAPTURE_AUDIO_RING_SIZE - 1);
+        uint32 bytes = produced - consumed;
+        if (bytes > CAPTURE_AUDIO_RING_SIZE - offset)
+        {
+            bytes = CAPTURE_AUDIO_RING_SIZE - offset;
+        }
+        fwrite(ctx->audio_ring + offset, 1, bytes, ctx->audio_file);
+        ctx->audio_bytes_written += bytes;
+        consumed += bytes;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&ctx->audio_bytes_consumed, (int)consumed);
+    }
+}
+
+local_internal int capture_writer_thread(void* data)
+{
+    Capture_Context* ctx = (Capture_Context*)data;
+    size_t y_size = (size_t)ctx->width * ctx->height;
+    size_t yuv_size = y_size + 2 * (y_size / 4);
+
+    for (;;)
+    {
+        SDL_SemWaitTimeout(ctx->work_available, 10);
+
+        bool32 stop = SDL_AtomicGet(&ctx->stop_requested);
+
+        uint32 produced = (uint32)SDL_AtomicGet(&ctx->frames_produced);
+        uint32 consumed = (uint32)SDL_AtomicGet(&ctx->frames_consumed);
+        SDL_MemoryBarrierAcquire();
+        while (consumed != produced)
+        {
+            Capture_Frame* frame = &ctx->frames[consumed % CAPTURE_FRAME_POOL_SIZE];
+            capture_convert_to_yuv420(ctx, frame->pixels);
+            for (int32 i = 0; i < frame->repeat_count; i++)
+            {
+                fwrite("FRAME\n", 1, 6, ctx->video_file);
+                fwrite(ctx->yuv_buffer, 1, yuv_size, ctx->video_file);
+            }
+            consumed++;
+            // Hand the buffer back to the main thread
+            SDL_MemoryBarrierRelease();
+            SDL_AtomicSet(&ctx->frames_consumed, (int)consumed);
+        }
+
+        if (ctx->has_audio)
+        {
+            capture_drain_audio(ctx);
+        }
+
+        if (stop)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// Runs on the audio thread with the final mix
+local_internal void capture_post_mix(void* udata, Uint8* stream, int len)
+{
+    Capture_Context* ctx = (Capture_Context*)udata;
+
+    uint32 produced = (uint32)SDL_AtomicGet(&ctx->audio_bytes_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&ctx->audio_bytes_consumed);
+    SDL_MemoryBarrierAcquire();
+    uint32 space = CAPTURE_AUDIO_RING_SIZE - (produced - consumed);
+    if ((uint32)len > space)
+    {
+        SDL_AtomicAdd(&ctx->audio_bytes_dropped, len);
+        return;
+    }
+
+    uint32 offset = produced & (CAPTURE_AUDIO_RING_SIZE - 1);
+    uint32 first_part = CAPTURE_AUDIO_RING_SIZE - offset;
+    if (first_part > (uint32)len)
+    {
+        first_part = (uint32)len;
+    }
+    SDL_memcpy(ctx->audio_ring + offset, stream, first_part);
+    SDL_memcpy(ctx->audio_ring, stream + first_part, len - first_part);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ctx->audio_bytes_produced, (int)(produced + len));
+}
+
+// Everything capture_start sets up, whichever of it got set up
+local_internal void capture_free(Capture_Context* ctx)
+{
+    for (uint32 i = 0; i < CAPTURE_FRAME_POOL_SIZE; i++)
+    {
+        SDL_free(ctx->frames[i].pixels);
+    }
+    SDL_free(ctx->audio_ring);
+    SDL_free(ctx->yuv_buffer);
+    if (ctx->work_available)
+    {
+        SDL_DestroySemaphore(ctx->work_available);
+    }
+    if (ctx->video_file)
+    {
+        fclose(ctx->video_file);
+    }
+    if (ctx->audio_file)
+    {
+        fclose(ctx->audio_file);
+    }
+}
+
+void capture_stop()
+{
+    Capture_Context* ctx = &global_capture_context;
+    if (!ctx->is_capturing)
+    {
+        return;
+    }
+
+    if (ctx->has_audio)
+    {
+        audio_set_post_mix_tap(NULL, NULL);
+    }
+
+    // NOTE: This waits for the writer to flush whatever is still queued
+    SDL_AtomicSet(&ctx->stop_requested, 1);
+    SDL_SemPost(ctx->work_available);
+    SDL_WaitThread(ctx->writer_thread, NULL);
+
+    if (ctx->has_audio)
+    {
+        // Now that we know how much audio there is, patch the sizes in the header
+        fseek(ctx->audio_file, 0, SEEK_SET);
+        capture_write_wav_header(ctx->audio_file, ctx->audio_frequency, ctx->audio_channels, ctx->audio_bytes_written);
+    }
+    capture_free(ctx);
+
+    log_info("Capture stopped: %u frames captured, %u dropped, %d audio bytes dropped, %.3f ms/frame average (max "
+             "%.3f)\n",
+             ctx->frames_captured,
+             ctx->frames_dropped,
+             SDL_AtomicGet(&ctx->audio_bytes_dropped),
+             ctx->average_frame_cost_ms,
+             ctx->max_frame_cost_ms);
+
+    *ctx = {};
+}
+
+bool32 capture_start()
+{
+    Capture_Context* ctx = &global_capture_context;
+    if (ctx->is_capturing)
+    {
+        return true;
+    }
+    *ctx = {};
+
+    {  // Work out which part of the window has the canvas on it
+        SDL_Rect viewport;
+        real32 scale_x, scale_y;
+        SDL_RenderGetViewport(global_renderer, &viewport);
+        SDL_RenderGetScale(global_renderer, &scale_x, &scale_y);
+        ctx->x = (int32)(viewport.x * scale_x);
+        ctx->y = (int32)(viewport.y * scale_y);
+        // 4:2:0 chroma needs even dimensions
+        ctx->width = ((int32)(viewport.w * scale_x)) & ~1;
+        ctx->height = ((int32)(viewport.h * scale_y)) & ~1;
+    }
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
+
+    char video_path[64];
+    snprintf(video_path, sizeof(video_path), "capture_%s.y4m", timestamp);
+    ctx->video_file = fopen(video_path, "wb");
+    if (!ctx->video_file)
+    {
+        log_error("Failed to open %s for capture\n", video_path);
+        return false;
+    }
+    // True whatever rate the game runs at, capture_read_frame places the frames on this clock
+    fprintf(ctx->video_file,
+            "YUV4MPEG2 W%d H%d F%d:100 Ip A1:1 C420jpeg\n",
+            ctx->width,
+            ctx->height,
+            (int32)(TARGET_SCREEN_FPS * 100));
+
+    {  // Audio
+        Uint16 format;
+        if (Mix_QuerySpec(&ctx->audio_frequency, &format, &ctx->audio_channels) && format == AUDIO_S16LSB)
+        {
+            char audio_path[64];
+            snprintf(audio_path, sizeof(audio_path), "capture_%s.wav", timestamp);
+            ctx->audio_file = fopen(audio_path, "wb");
+            if (ctx->audio_file)
+            {
+                // Sizes get patched when the capture stops
+                capture_write_wav_header(ctx->audio_file, ctx->audio_frequency, ctx->audio_channels, 0);
+                ctx->has_audio = true;
+            }
+        }
+
+        if (!ctx->has_audio)
+        {
+            log_info("Capturing without audio\n");
+        }
+    }
+
+    size_t frame_bytes = (size_t)ctx->width * ctx->height * 4;
+    bool32 is_allocated = true;
+    for (uint32 i = 0; i < CAPTURE_FRAME_POOL_SIZE; i++)
+    {
+        ctx->frames[i].pixels = (uint8*)SDL_malloc(frame_bytes);
+        is_allocated &= ctx->frames[i].pixels != NULL;
+    }
+    ctx->yuv_buffer = (uint8*)SDL_malloc(frame_bytes);
+    ctx->audio_ring = (uint8*)SDL_malloc(CAPTURE_AUDIO_RING_SIZE);
+    if (!is_allocated || !ctx->yuv_buffer || !ctx->audio_ring)
+    {
+        log_error("Failed to allocate %u capture buffers of %zu KB\n",
+                  CAPTURE_FRAME_POOL_SIZE + 1,
+                  frame_bytes / 1024);
+        capture_free(ctx);
+        *ctx = {};
+        return false;
+    }
+    ctx->frame_skip = 1;
+    ctx->start_counter = SDL_GetPerformanceCounter();
+
+    ctx->work_available = SDL_CreateSemaphore(0);
+    ctx->writer_thread =
+        ctx->work_available ? SDL_CreateThread(capture_writer_thread, "capture_writer", ctx) : NULL;
+    if (!ctx->writer_thread)
+    {
+        log_error("Failed to start the capture writer: %s\n", SDL_GetError());
+        capture_free(ctx);
+        *ctx = {};
+        return false;
+    }
+    ctx->is_capturing = true;
+
+    if (ctx->has_audio)
+    {
+        audio_set_post_mix_tap(capture_post_mix, ctx);
+    }
+
+    log_info("Capturing %dx%d to %s\n", ctx->width, ctx->height, video_path);
+    return true;
+}
+
+void capture_toggle()
+{
+    if (global_capture_context.is_capturing)
+    {
+        capture_stop();
+    }
+    else
+    {
+        capture_start();
+    }
+}
+
+// Call after the frame has been drawn but before it's presented
+void capture_read_frame()
+{
+    Capture_Context* ctx = &global_capture_context;
+    if (!ctx->is_capturing)
+    {
+        return;
+    }
+
+    Uint64 counter_start = SDL_GetPerformanceCounter();
+
+    {  // Where this present falls on the video clock
+        real64 frequency = (real64)SDL_GetPerformanceFrequency();
+        real64 seconds = (real64)(counter_start - ctx->start_counter) / frequency;
+        if (ctx->has_audio)
+        {
+            // Follow the audio clock, which is what the WAV plays at. It only moves when the mixer hands over a
+            // buffer, so compare it to the counter when it moves and smooth out the jitter.
+            uint32 audio_bytes = (uint32)SDL_AtomicGet(&ctx->audio_bytes_produced);
+            if (audio_bytes != ctx->last_audio_bytes_seen)
+            {
+                real64 bytes_per_second = (real64)ctx->audio_frequency * ctx->audio_channels * sizeof(int16);
+                real64 offset__seconds = (real64)audio_bytes / bytes_per_second - seconds;
+                if (ctx->last_audio_bytes_seen)
+                {
+                    offset__seconds = 0.95 * ctx->audio_clock_offset__seconds + 0.05 * offset__seconds;
+                }
+                ctx->audio_clock_offset__seconds = offset__seconds;
+                ctx->last_audio_bytes_seen = audio_bytes;
+            }
+            seconds = SDL_max(seconds + ctx->audio_clock_offset__seconds, 0.0);
+        }
+
+        // Every video frame up to and including the one this present lands in should be covered once it's written
+        uint64 video_frames_due = (uint64)(seconds * TARGET_SCREEN_FPS) + 1;
+        ctx->pending_repeat_count = (int64)video_frames_due - (int64)ctx->video_frames_assigned;
+    }
+
+    if ((ctx->frame_index++ % ctx->frame_skip) != 0)
+    {
+        return;
+    }
+    if (ctx->pending_repeat_count <= 0)
+    {
+        // Presenting faster than the video's frame rate, the last frame handed over already covers this one
+        return;
+    }
+
+    uint32 produced = (uint32)SDL_AtomicGet(&ctx->frames_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&ctx->frames_consumed);
+    SDL_MemoryBarrierAcquire();
+    if (produced - consumed >= CAPTURE_FRAME_POOL_SIZE)
+    {
+        // The writer can't keep up. Drop the frame rather than waiting on the disk.
+        ctx->frames_dropped++;
+        return;
+    }
+
+    Capture_Frame* frame = &ctx->frames[produced % CAPTURE_FRAME_POOL_SIZE];
+    SDL_Rect rect = {ctx->x, ctx->y, ctx->width, ctx->height};
+    if (SDL_RenderReadPixels(global_renderer, &rect, SDL_PIXELFORMAT_RGBA32, frame->pixels, ctx->width * 4) != 0)
+    {
+        log_error("Failed to read back frame: %s\n", SDL_GetError());
+        ctx->frames_dropped++;
+        return;
+    }
+    // Makes up for the presents since the last frame that got skipped or dropped too
+    frame->repeat_count = (int32)ctx->pending_repeat_count;
+    ctx->video_frames_assigned += ctx->pending_repeat_count;
+    ctx->pending_repeat_count = 0;
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&ctx->frames_produced, (int)(produced + 1));
+    SDL_SemPost(ctx->work_available);
+    ctx->frames_captured++;
+
+    {  // Keep the cost of capturing under budget
+        Uint64 counter_end = SDL_GetPerformanceCounter();
+        ctx->last_frame_cost_ms =
+            (real32)(1000.0 * (real64)(counter_end - counter_start) / (real64)SDL_GetPerformanceFrequency());
+        ctx->average_frame_cost_ms = 0.9f * ctx->average_frame_cost_ms + 0.1f * ctx->last_frame_cost_ms;
+        if (ctx->last_frame_cost_ms > ctx->max_frame_cost_ms)
+        {
+            ctx->max_frame_cost_ms = ctx->last_frame_cost_ms;
+        }
+
+        // Averaged over every frame (including the skipped ones) the cost is average / skip
+        real32 cost_per_frame_ms = ctx->average_frame_cost_ms / ctx->frame_skip;
+        if (cost_per_frame_ms > CAPTURE_FRAME_BUDGET_MS && ctx->frame_skip < CAPTURE_MAX_FRAME_SKIP)
+        {
+            ctx->frame_skip++;
+        }
+        else if (ctx->frame_skip > 1 &&
+                 ctx->average_frame_cost_ms / (ctx->frame_skip - 1) < 0.5f * CAPTURE_FRAME_BUDGET_MS)
+        {
+            ctx->frame_skip--;
+        }
+    }
+}
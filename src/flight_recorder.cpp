@@ -0,0 +1,390 @@
+#include <SDL2/SDL.h>
+#include <signal.h>
+#include <time.h>
+
+#include <fcntl.h>
+#ifdef __WINDOWS__
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "flight_recorder.h"
+#include "snake_sim.h"
+
+// Always-on black box: a ring of the last few thousand frames, snake moves, key presses and game events, dumped to
+// flight_<startup time>_<reason>.bin on a failed assertion, a crash, a game over or F7. Read dumps with
+// tools/flight_recorder_decoder.cpp.
+//
+// Recording is a handful of stores into the ring on the game thread. Records are stamped with the start of the frame
+// they belong to, so recording never reads the clock either. Dumping only uses async-signal-safe calls, as it can run
+// in a crash handler.
+
+#define FLIGHT_RECORDER_RECORD_COUNT 8192  // Must be a power of two. 256 KB, a minute or so of normal play.
+#define FLIGHT_RECORDER_PATH_LENGTH 128
+
+struct Flight_Recorder
+{
+    Flight_Record* records;  // Everything's a no-op until this is set up, so the benchmarks don't record
+    uint64 write_index;
+    uint32 frame_index;
+    uint64 frame_counter;  // When the current frame started
+    uint64 counter_frequency;
+
+    char path_prefix[64];  // Up to the reason's name
+    char last_dump_path[FLIGHT_RECORDER_PATH_LENGTH];
+    Flight_Recorder_Header header;  // Kept here so a crash handler doesn't need the stack space
+    bool32 has_assertion_dump;
+
+    // Stats
+    uint32 dump_count;
+    real32 last_dump__milliseconds;
+};
+
+Flight_Recorder global_flight_recorder;
+
+//=======================================================
+// RECORDING (game thread)
+//=======================================================
+
+inline Flight_Record* flight_recorder_push(Flight_Recorder* recorder, uint8 type, uint8 code, uint16 flags)
+{
+    Flight_Record* record = &recorder->records[recorder->write_index & (FLIGHT_RECORDER_RECORD_COUNT - 1)];
+    recorder->write_index++;
+    record->counter = recorder->frame_counter;
+    record->frame_index = recorder->frame_index;
+    record->type = type;
+    record->code = code;
+    record->flags = flags;
+    return record;
+}
+
+inline void flight_recorder_begin_frame(Flight_Recorder* recorder, uint64 counter_now)
+{
+    recorder->frame_counter = counter_now;
+    recorder->frame_index++;
+}
+
+// The counters Master_Timer takes at each phase boundary
+inline void flight_recorder_record_frame(Flight_Recorder* recorder,
+                                         uint64 counter_start,
+                                         uint64 counter_after_work,
+                                         uint64 counter_after_writing_buffer,
+                                         uint64 counter_after_render,
+                                         uint64 counter_after_sleep)
+{
+    if (!recorder->records)
+    {
+        return;
+    }
+
+    uint64 frequency = recorder->counter_frequency;
+    Flight_Record* record = flight_recorder_push(recorder, FLIGHT_RECORD_FRAME, 0, 0);
+    record->frame.work = (uint32)((counter_after_work - counter_start) * 1000000 / frequency);
+    record->frame.writing_buffer = (uint32)((counter_after_writing_buffer - counter_after_work) * 1000000 / frequency);
+    record->frame.render = (uint32)((counter_after_render - counter_after_writing_buffer) * 1000000 / frequency);
+    record->frame.sleep = (uint32)((counter_after_sleep - counter_after_render) * 1000000 / frequency);
+}
+
+inline void flight_recorder_record_cell(
+    Flight_Recorder* recorder, uint64 tick, Direction input, uint32 events, int32 head_x, int32 head_y, uint32 length)
+{
+    if (!recorder->records)
+    {
+        return;
+    }
+
+    Flight_Record* record = flight_recorder_push(recorder, FLIGHT_RECORD_CELL, (uint8)input, (uint16)events);
+    record->cell.tick = tick;
+    record->cell.head_x = (int16)head_x;
+    record->cell.head_y = (int16)head_y;
+    record->cell.length = length;
+}
+
+inline void flight_recorder_record_key(Flight_Recorder* recorder, uint32 button, bool32 is_down)
+{
+    if (!recorder->records)
+    {
+        return;
+    }
+
+    flight_recorder_push(recorder, FLIGHT_RECORD_KEY, (uint8)button, is_down ? 1 : 0);
+}
+
+inline void flight_recorder_record_marker(
+    Flight_Recorder* recorder, uint8 marker, uint32 value_0 = 0, uint32 value_1 = 0, uint32 value_2 = 0)
+{
+    if (!recorder->records)
+    {
+        return;
+    }
+
+    Flight_Record* record = flight_recorder_push(recorder, FLIGHT_RECORD_MARKER, marker, 0);
+    record->values[0] = value_0;
+    record->values[1] = value_1;
+    record->values[2] = value_2;
+    record->values[3] = 0;
+}
+
+//=======================================================
+// DUMPING
+//=======================================================
+
+local_internal char* flight_recorder_append(char* at, const char* end, const char* text)
+{
+    while (*text && at < end - 1)
+    {
+        *at++ = *text++;
+    }
+    *at = 0;
+    return at;
+}
+
+local_internal bool32 flight_recorder_write(int file, const void* data, size_t size)
+{
+    const uint8* bytes = (const uint8*)data;
+    while (size > 0)
+    {
+#ifdef __WINDOWS__
+        int written = _write(file, bytes, (unsigned int)size);
+#else
+        ssize_t written = write(file, bytes, size);
+#endif
+        if (written <= 0)
+        {
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+// Writes the ring oldest first. Safe to call from a signal handler, so no stdio, no allocations and no logging.
+bool32 flight_recorder_dump(Flight_Recorder* recorder, uint32 reason, int32 signal_number, const char* message)
+{
+    if (!recorder->records)
+    {
+        return false;
+    }
+    uint64 counter_start = SDL_GetPerformanceCounter();
+
+    char* path = recorder->last_dump_path;
+    const char* path_end = path + FLIGHT_RECORDER_PATH_LENGTH;
+    char* at = flight_recorder_append(path, path_end, recorder->path_prefix);
+    at = flight_recorder_append(at, path_end, flight_dump_reason_name(reason));
+    flight_recorder_append(at, path_end, ".bin");
+
+    uint64 record_count = SDL_min(recorder->write_index, (uint64)FLIGHT_RECORDER_RECORD_COUNT);
+    Flight_Recorder_Header* header = &recorder->header;
+    header->magic = FLIGHT_RECORDER_MAGIC;
+    header->version = FLIGHT_RECORDER_VERSION;
+    header->record_size = sizeof(Flight_Record);
+    header->record_count = (uint32)record_count;
+    header->records_recorded = recorder->write_index;
+    header->counter_frequency = recorder->counter_frequency;
+    header->dump_counter = counter_start;
+    header->reason = reason;
+    header->signal_number = signal_number;
+    header->target_frame__microseconds = (uint32)(TARGET_TIME_PER_FRAME_MS * 1000.0f);
+    header->simulation_ticks_per_second = SIMULATION_TICKS_PER_SECOND;
+    flight_recorder_append(header->message, header->message + FLIGHT_RECORDER_MESSAGE_LENGTH, message ? message : "");
+
+#ifdef __WINDOWS__
+    int file = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (file < 0)
+    {
+        return false;
+    }
+
+    // The oldest record is the one the next write goes over (or the first one, before the ring has wrapped)
+    uint32 oldest = (uint32)((recorder->write_index - record_count) & (FLIGHT_RECORDER_RECORD_COUNT - 1));
+    uint32 first_part = (uint32)SDL_min(record_count, (uint64)(FLIGHT_RECORDER_RECORD_COUNT - oldest));
+    uint32 second_part = (uint32)record_count - first_part;
+    bool32 is_written = flight_recorder_write(file, header, sizeof(*header)) &&
+                        flight_recorder_write(file, recorder->records + oldest, first_part * sizeof(Flight_Record)) &&
+                        flight_recorder_write(file, recorder->records, second_part * sizeof(Flight_Record));
+#ifdef __WINDOWS__
+    _close(file);
+#else
+    close(file);
+#endif
+
+    recorder->dump_count++;
+    recorder->has_assertion_dump |= reason == FLIGHT_DUMP_ASSERTION;
+    recorder->last_dump__milliseconds =
+        (real32)(SDL_GetPerformanceCounter() - counter_start) * 1000.0f / (real32)recorder->counter_frequency;
+    return is_written;
+}
+
+// For dumps from the game itself, which can say how it went
+void flight_recorder_dump_and_report(Flight_Recorder* recorder, uint32 reason, const char* message)
+{
+    if (!recorder->records)
+    {
+        return;
+    }
+
+    if (flight_recorder_dump(recorder, reason, 0, message))
+    {
+        log_info("Flight recorder: %s, dumped to %s\n", message, recorder->last_dump_path);
+    }
+    else
+    {
+        log_error("Flight recorder: failed to write %s\n", recorder->last_dump_path);
+    }
+}
+
+local_internal SDL_AssertState SDLCALL flight_recorder_assertion_handler(const SDL_AssertData* data, void* userdata)
+{
+    Flight_Recorder* recorder = (Flight_Recorder*)userdata;
+
+    // Only the first time round, or an ignored assertion in a loop would dump every frame
+    if (data->trigger_count <= 1)
+    {
+        char message[FLIGHT_RECORDER_MESSAGE_LENGTH];
+        snprintf(message, sizeof(message), "%s:%d: %s", data->filename, data->linenum, data->condition);
+        flight_recorder_dump(recorder, FLIGHT_DUMP_ASSERTION, 0, message);
+    }
+
+    // Then whatever SDL would have done (the default handler doesn't use its userdata)
+    return SDL_GetDefaultAssertionHandler()(data, NULL);
+}
+
+#ifdef __WINDOWS__
+local_internal LONG WINAPI flight_recorder_exception_filter(EXCEPTION_POINTERS* exception)
+{
+    flight_recorder_dump(&global_flight_recorder,
+                         FLIGHT_DUMP_CRASH,
+                         (int32)exception->ExceptionRecord->ExceptionCode,
+                         "Unhandled exception");
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#else
+local_internal void flight_recorder_signal_handler(int signal_number)
+{
+    // A failed release assertion aborts after its own dump
+    if (signal_number != SIGABRT || !global_flight_recorder.has_assertion_dump)
+    {
+        flight_recorder_dump(&global_flight_recorder, FLIGHT_DUMP_CRASH, signal_number, "Crash signal");
+    }
+
+    // SA_RESETHAND put the default action back, so this goes on to crash (or abort) for real
+    raise(signal_number);
+}
+#endif
+
+//=======================================================
+// SETUP
+//=======================================================
+
+// Also takes over the assertion handler and the crash signals
+bool32 flight_recorder_init(Flight_Recorder* recorder, Memory_Arena* arena)
+{
+    *recorder = {};
+    recorder->records = push_array(arena, FLIGHT_RECORDER_RECORD_COUNT, Flight_Record);
+    if (!recorder->records)
+    {
+        return false;
+    }
+    recorder->counter_frequency = SDL_GetPerformanceFrequency();
+
+    char timestamp[32];
+    time_t now = time(NULL);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
+    snprintf(recorder->path_prefix, sizeof(recorder->path_prefix), "flight_%s_", timestamp);
+
+    SDL_SetAssertionHandler(flight_recorder_assertion_handler, recorder);
+
+#ifdef __WINDOWS__
+    SetUnhandledExceptionFilter(flight_recorder_exception_filter);
+#else
+    struct sigaction action = {};
+    action.sa_handler = flight_recorder_signal_handler;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    int crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    for (uint32 i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); i++)
+    {
+        sigaction(crash_signals[i], &action, NULL);
+    }
+#endif
+
+    return true;
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// Records frames like the game does at a fast snake's pace (a few cells and the odd key press a frame) and times it
+// against the frame budget, then times a dump of the full ring
+int32 flight_recorder_run_benchmark(Memory_Arena* arena, uint32 frame_count)
+{
+    Flight_Recorder* recorder = &global_flight_recorder;
+    if (!flight_recorder_init(recorder, arena))
+    {
+        return -1;
+    }
+
+    uint32 cells_per_frame = 4;
+    printf("Flight recorder benchmark: %u frames with %u cells each, ring of %u records (%u KB)\n",
+           frame_count,
+           cells_per_frame,
+           FLIGHT_RECORDER_RECORD_COUNT,
+           (uint32)(FLIGHT_RECORDER_RECORD_COUNT * sizeof(Flight_Record) / 1024));
+
+    uint64 frequency = recorder->counter_frequency;
+    uint64 frame_ticks = (uint64)(TARGET_TIME_PER_FRAME_S * frequency);
+    uint64 tick = 0;
+    int32 head_x = 0;
+    // Made up frames that end about now, so the dump's timings make sense
+    uint64 counter = SDL_GetPerformanceCounter() - frame_count * frame_ticks;
+
+    Uint64 counter_start = SDL_GetPerformanceCounter();
+    for (uint32 frame = 0; frame < frame_count; frame++)
+    {
+        flight_recorder_begin_frame(recorder, counter);
+        if ((frame & 15) == 0)
+        {
+            flight_recorder_record_key(recorder, frame & 3, (frame & 16) != 0);
+        }
+        for (uint32 i = 0; i < cells_per_frame; i++)
+        {
+            head_x = (head_x + 1) & 63;
+            Direction input = (i & 1) ? DIRECTION_EAST : DIRECTION_NONE;
+            flight_recorder_record_cell(recorder, tick, input, 0, head_x, 18, frame / 64);
+        }
+        tick++;
+        flight_recorder_record_frame(recorder,
+                                     counter,
+                                     counter + frame_ticks / 8,
+                                     counter + frame_ticks / 4,
+                                     counter + frame_ticks / 2,
+                                     counter + frame_ticks);
+        counter += frame_ticks;
+    }
+    Uint64 recording_counter = SDL_GetPerformanceCounter() - counter_start;
+
+    real64 per_frame__nanoseconds = (real64)recording_counter * 1e9 / (real64)frequency / frame_count;
+    printf("  recording: %.1f ns per frame, %.2f ns per record, %.5f%% of a %.2f ms frame\n",
+           per_frame__nanoseconds,
+           per_frame__nanoseconds / (cells_per_frame + 2),
+           per_frame__nanoseconds / (TARGET_TIME_PER_FRAME_MS * 1e6) * 100.0,
+           TARGET_TIME_PER_FRAME_MS);
+
+    if (!flight_recorder_dump(recorder, FLIGHT_DUMP_BENCHMARK, 0, "Benchmark"))
+    {
+        fprintf(stderr, "Failed to write %s\n", recorder->last_dump_path);
+        return -1;
+    }
+    printf("  dump: %.2f ms for %u records, written to %s\n",
+           recorder->last_dump__milliseconds,
+           recorder->header.record_count,
+           recorder->last_dump_path);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+// What the flight recorder dumps, shared by the game and tools/flight_recorder_decoder.cpp.
+//
+// A dump is a Flight_Recorder_Header followed by record_count Flight_Records, oldest first. Everything is little
+// endian. Records are stamped with the performance counter; counter_frequency turns that into seconds.
+
+#include "common.h"
+
+#define FLIGHT_RECORDER_MAGIC 0x52464E53  // "SNFR"
+#define FLIGHT_RECORDER_VERSION 1
+#define FLIGHT_RECORDER_MESSAGE_LENGTH 128
+
+// Why the dump was written
+#define FLIGHT_DUMP_HOTKEY 0
+#define FLIGHT_DUMP_GAME_OVER 1
+#define FLIGHT_DUMP_ASSERTION 2
+#define FLIGHT_DUMP_CRASH 3
+#define FLIGHT_DUMP_BENCHMARK 4
+#define FLIGHT_DUMP_REASON_COUNT 5
+
+// Record types
+#define FLIGHT_RECORD_FRAME 1   // One per frame, the phases Master_Timer splits it into
+#define FLIGHT_RECORD_CELL 2    // Every cell the snake moved, with the input it moved on
+#define FLIGHT_RECORD_KEY 3     // A button going up or down
+#define FLIGHT_RECORD_MARKER 4  // Something happened, see FLIGHT_MARKER_
+
+#define FLIGHT_MARKER_GAME_START 1
+#define FLIGHT_MARKER_GAME_OVER 2  // values: score, length, cells advanced since startup
+#define FLIGHT_MARKER_SCENE_CHANGE 3
+
+struct Flight_Frame
+{
+    // Microseconds
+    uint32 work;
+    uint32 writing_buffer;
+    uint32 render;
+    uint32 sleep;
+};
+
+struct Flight_Cell
+{
+    uint64 tick;
+    int16 head_x;  // After the move
+    int16 head_y;
+    uint32 length;
+};
+
+struct Flight_Record
+{
+    uint64 counter;
+    uint32 frame_index;
+    uint8 type;    // FLIGHT_RECORD_
+    uint8 code;    // The Direction a cell moved on (DIRECTION_NONE when nothing was queued), the button or the marker
+    uint16 flags;  // SNAKE_SIM_ events for a cell, 1 for a key going down
+    union
+    {
+        Flight_Frame frame;
+        Flight_Cell cell;
+        uint32 values[4];
+    };
+};
+
+struct Flight_Recorder_Header
+{
+    uint32 magic;
+    uint32 version;
+    uint32 record_size;
+    uint32 record_count;
+    uint64 records_recorded;  // Since startup, the ones before the last record_count got overwritten
+    uint64 counter_frequency;
+    uint64 dump_counter;  // When the dump was written
+    uint32 reason;        // FLIGHT_DUMP_
+    int32 signal_number;  // For FLIGHT_DUMP_CRASH
+    uint32 target_frame__microseconds;
+    uint32 simulation_ticks_per_second;
+    char message[FLIGHT_RECORDER_MESSAGE_LENGTH];  // The assertion, or whatever else caused the dump
+};
+
+static_assert(sizeof(Flight_Record) == 32, "Flight records are written to disk as they are");
+
+inline const char* flight_dump_reason_name(uint32 reason)
+{
+    const char* names[FLIGHT_DUMP_REASON_COUNT] = {"hotkey", "game_over", "assertion", "crash", "benchmark"};
+    return reason < FLIGHT_DUMP_REASON_COUNT ? names[reason] : "unknown";
+}
+
+// Same order as the button enum in input.cpp
+inline const char* flight_button_name(uint32 button)
+{
+    const char* names[] = {"W", "A", "S", "D", "Up", "Down", "Left", "Right", "Enter", "Space", "Escape", "Tab"};
+    return button < sizeof(names) / sizeof(names[0]) ? names[button] : "?";
+}
+
+#define FLIGHT_BUTTON_NAME_COUNT 12
+
+#endif  // FLIGHT_RECORDER_H
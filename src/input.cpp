@@ -12,10 +12,14 @@ enum
 
     BUTTON_SPACE,
     BUTTON_ESCAPE,
+    BUTTON_TAB,
 
     BUTTON_COUNT,  // Should be the last item
 };
 
+// Flight recorder dumps name buttons with flight_button_name(), which has to keep up with this
+static_assert(BUTTON_COUNT == FLIGHT_BUTTON_NAME_COUNT, "Update flight_button_name() in flight_recorder.h");
+
 struct Button_State
 {
     bool32 is_down;
@@ -75,6 +79,7 @@ void handle_input(SDL_Event* event, Input* input)
                     process_input(BUTTON_SPACE, SDLK_SPACE);
                     process_input(BUTTON_ENTER, SDLK_RETURN);
                     process_input(BUTTON_ESCAPE, SDLK_ESCAPE);
+                    process_input(BUTTON_TAB, SDLK_TAB);
                 }
             }
             break;
@@ -90,6 +95,18 @@ void handle_input(SDL_Event* event, Input* input)
                     {
                         global_display_debug_info = !global_display_debug_info;
                     } break;
+                    case SDLK_F7:
+                    {
+                        flight_recorder_dump_and_report(&global_flight_recorder, FLIGHT_DUMP_HOTKEY, "F7 pressed");
+                    } break;
+                    case SDLK_F8:
+                    {
+                        play_sound_effect_stress_test();
+                    } break;
+                    case SDLK_F9:
+                    {
+                        capture_toggle();
+                    } break;
                     case SDLK_f:
                     {
                         int isFullScreen = SDL_GetWindowFlags(global_window) & SDL_WINDOW_FULLSCREEN_DESKTOP;
@@ -105,14 +122,14 @@ void handle_input(SDL_Event* event, Input* input)
                             SDL_DisplayMode desktop_mode;
                             if (SDL_GetDesktopDisplayMode(0, &desktop_mode) != 0)
                             {
-                                SDL_Log("Failed to get desktop display mode: %s", SDL_GetError());
+                                log_error("Failed to get desktop display mode: %s\n", SDL_GetError());
                                 return;
                             }
 
                             // Set the display mode to match the desktop (native) resolution and refresh rate
                             if (SDL_SetWindowDisplayMode(global_window, &desktop_mode) != 0)
                             {
-                                SDL_Log("Failed to set window display mode: %s", SDL_GetError());
+                                log_error("Failed to set window display mode: %s\n", SDL_GetError());
                             }
                             SDL_SetWindowFullscreen(global_window, SDL_WINDOW_FULLSCREEN_DESKTOP);
                             SDL_ShowCursor(SDL_DISABLE);
@@ -142,6 +159,18 @@ void handle_input(SDL_Event* event, Input* input)
                 global_running = 0;
             }
             break;
+
+            case SDL_RENDER_TARGETS_RESET:
+            {
+                texture_manager_on_render_targets_reset();
+            }
+            break;
+
+            case SDL_RENDER_DEVICE_RESET:
+            {
+                texture_manager_on_device_reset();
+            }
+            break;
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <SDL2/SDL.h>
+
+#ifndef __WINDOWS__
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "live_metrics.h"
+
+// Publishes the frame stats into shared memory (see live_metrics.h) for tools/metrics_top or anything else that wants
+// to watch a running game. Costs the game one small copy a frame, readers never make it wait.
+
+#define LIVE_METRICS_HITCH_FACTOR 1.5f
+
+struct Live_Metrics
+{
+    Live_Metrics_Shared* shared;  // NULL if the segment couldn't be set up, and publishing does nothing
+#ifdef __WINDOWS__
+    HANDLE mapping;
+#endif
+};
+
+Live_Metrics global_live_metrics;
+
+bool32 live_metrics_open(Live_Metrics* metrics)
+{
+    *metrics = {};
+    size_t size = sizeof(Live_Metrics_Shared);
+
+#ifdef __WINDOWS__
+    metrics->mapping =
+        CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, LIVE_METRICS_NAME);
+    if (!metrics->mapping)
+    {
+        log_error("Failed to create the live metrics mapping: %lu\n", GetLastError());
+        return false;
+    }
+    void* memory = MapViewOfFile(metrics->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!memory)
+    {
+        log_error("Failed to map the live metrics: %lu\n", GetLastError());
+        CloseHandle(metrics->mapping);
+        metrics->mapping = NULL;
+        return false;
+    }
+    int32 process_id = (int32)GetCurrentProcessId();
+#else
+    int file = shm_open(LIVE_METRICS_NAME, O_CREAT | O_RDWR, 0644);
+    if (file < 0)
+    {
+        log_error("Failed to open shared memory %s: %s\n", LIVE_METRICS_NAME, strerror(errno));
+        return false;
+    }
+
+    // macOS only lets a segment be sized once, so one left behind by a crash has to be reused as it is, or replaced if
+    // it's the wrong size
+    struct stat file_stat;
+    off_t existing_size = fstat(file, &file_stat) == 0 ? file_stat.st_size : 0;
+    if (existing_size != 0 && existing_size != (off_t)size)
+    {
+        close(file);
+        shm_unlink(LIVE_METRICS_NAME);
+        file = shm_open(LIVE_METRICS_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (file < 0)
+        {
+            log_error("Failed to recreate shared memory %s: %s\n", LIVE_METRICS_NAME, strerror(errno));
+            return false;
+        }
+        existing_size = 0;
+    }
+    if (existing_size == 0 && ftruncate(file, (off_t)size) != 0)
+    {
+        log_error("Failed to size shared memory %s: %s\n", LIVE_METRICS_NAME, strerror(errno));
+        close(file);
+        return false;
+    }
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (memory == MAP_FAILED)
+    {
+        log_error("Failed to map shared memory %s: %s\n", LIVE_METRICS_NAME, strerror(errno));
+        return false;
+    }
+    int32 process_id = (int32)getpid();
+#endif
+
+    // Could be left over from a game that crashed
+    Live_Metrics_Shared* shared = (Live_Metrics_Shared*)memory;
+    live_metrics_begin_write(shared);
+    uint32 sequence = shared->sequence;
+    memset((void*)shared, 0, sizeof(*shared));
+    shared->sequence = sequence;
+    shared->magic = LIVE_METRICS_MAGIC;
+    shared->version = LIVE_METRICS_VERSION;
+    shared->size = (uint32)size;
+    shared->process_id = process_id;
+    live_metrics_end_write(shared);
+
+    metrics->shared = shared;
+    return true;
+}
+
+void live_metrics_close(Live_Metrics* metrics)
+{
+    if (!metrics->shared)
+    {
+        return;
+    }
+
+#ifdef __WINDOWS__
+    UnmapViewOfFile(metrics->shared);
+    CloseHandle(metrics->mapping);
+#else
+    // Only take the name away if it's still ours
+    bool32 is_ours = metrics->shared->process_id == (int32)getpid();
+    munmap(metrics->shared, sizeof(Live_Metrics_Shared));
+    if (is_ours)
+    {
+        shm_unlink(LIVE_METRICS_NAME);
+    }
+#endif
+    *metrics = {};
+}
+
+void live_metrics_publish(Live_Metrics* metrics, const Live_Metrics_Frame* frame)
+{
+    Live_Metrics_Shared* shared = metrics->shared;
+    if (!shared)
+    {
+        return;
+    }
+
+    live_metrics_begin_write(shared);
+    shared->frame = *frame;
+    shared->max_frame__ms = SDL_max(shared->max_frame__ms, frame->frame__ms);
+    shared->hitch_count += frame->frame__ms > frame->target_frame__ms * LIVE_METRICS_HITCH_FACTOR;
+    shared->frame_history__ms[frame->frame_index % LIVE_METRICS_HISTORY_SIZE] = frame->frame__ms;
+    live_metrics_end_write(shared);
+}
@@ -0,0 +1,105 @@
+#ifndef LIVE_METRICS_H
+#define LIVE_METRICS_H
+
+// What the game publishes every frame into shared memory, shared by the game and tools/metrics_top.cpp.
+//
+// The segment is LIVE_METRICS_NAME (POSIX shm_open, a named file mapping on Windows) holding one
+// Live_Metrics_Shared. The game is the only writer and guards it with a seqlock: sequence is odd while a frame is
+// being written. Readers map it read only, copy it out and retry if sequence was odd or changed underneath them, so
+// they can poll at any rate without the game ever waiting on them.
+
+#include <atomic>
+#include <string.h>
+
+#include "common.h"
+
+#ifdef _WIN32
+#define LIVE_METRICS_NAME "Local\\sdl_snake_metrics"
+#else
+#define LIVE_METRICS_NAME "/sdl_snake_metrics"
+#endif
+
+#define LIVE_METRICS_MAGIC 0x4D4E5353  // "SSNM"
+#define LIVE_METRICS_VERSION 2
+#define LIVE_METRICS_HISTORY_SIZE 128  // Frame times, about two seconds of them
+
+// Hardware counters, indexed [phase][counter]: phases are work, writing buffer, render and sleep, counters are
+// instructions, cycles, cache misses and branch misses
+#define LIVE_METRICS_PHASE_COUNT 4
+#define LIVE_METRICS_COUNTER_COUNT 4
+
+struct Live_Metrics_Frame
+{
+    uint64 frame_index;
+    real32 frame__ms;
+    real32 work__ms;
+    real32 writing_buffer__ms;
+    real32 render__ms;
+    real32 sleep__ms;
+    real32 target_frame__ms;
+
+    uint64 simulation_tick;
+    uint32 simulation_steps;  // Ticks the simulation advanced this frame
+    int32 score;              // -1 when the scene doesn't have one
+
+    uint32 allocations;  // On the main thread, last frame
+    uint32 other_thread_allocations;
+    uint64 allocation_bytes;
+
+    uint32 hardware_counter_mask;  // Bit per counter that's being counted, 0 when none are (not Linux, no PMU)
+    bool32 is_hardware_counter_multiplexed;
+    uint64 hardware_counters[LIVE_METRICS_PHASE_COUNT][LIVE_METRICS_COUNTER_COUNT];  // The phases of this frame
+};
+
+struct Live_Metrics_Shared
+{
+    uint32 magic;
+    uint32 version;
+    uint32 size;
+    int32 process_id;
+
+    volatile uint32 sequence;
+    uint32 pad;
+
+    Live_Metrics_Frame frame;
+    real32 max_frame__ms;  // Since startup
+    uint32 hitch_count;    // Frames that took more than 1.5x the target
+    real32 frame_history__ms[LIVE_METRICS_HISTORY_SIZE];  // Indexed by frame_index % LIVE_METRICS_HISTORY_SIZE
+};
+
+inline void live_metrics_begin_write(Live_Metrics_Shared* shared)
+{
+    shared->sequence = shared->sequence + 1;
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void live_metrics_end_write(Live_Metrics_Shared* shared)
+{
+    std::atomic_thread_fence(std::memory_order_release);
+    shared->sequence = shared->sequence + 1;
+}
+
+// False if the game was in the middle of a frame every time, which a reader can just try again later
+inline bool32 live_metrics_read(const Live_Metrics_Shared* shared, Live_Metrics_Shared* copy)
+{
+    for (uint32 attempt = 0; attempt < 1000; attempt++)
+    {
+        uint32 sequence_before = shared->sequence;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_before & 1)
+        {
+            continue;
+        }
+
+        memcpy(copy, (const void*)shared, sizeof(*copy));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (shared->sequence == sequence_before)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif  // LIVE_METRICS_H
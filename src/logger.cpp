@@ -0,0 +1,612 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+// Logging that never touches the terminal from the game thread. A log call copies its format pointer and raw
+// arguments into a slot of a lock-free ring and returns; a background thread does the printf style formatting and
+// the blocking writes. The format has to outlive the call (string literals do), string arguments are copied.
+//
+// log_info and log_error take the same formats as printf and don't add a newline, so one line can be built from a few
+// calls on the same thread. Any thread can log. A full ring drops the record rather than waiting for the drain
+// thread. Before log_start and after log_stop, records are formatted and written straight away.
+
+#define LOG_RING_SIZE 1024  // Records, must be a power of two
+#define LOG_MAX_ARGUMENTS 16
+#define LOG_RECORD_STRING_BYTES 344  // Rounds a record up to 512 bytes with 64-bit pointers
+#define LOG_MAX_LINE_LENGTH 2048
+#define LOG_DRAIN_INTERVAL__MS 10
+#define LOG_TRUNCATED_STRING 0xFFFFFFFFFFFFFFFFull
+
+enum Log_Level : uint8
+{
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_ERROR,
+};
+
+enum Log_Argument_Type : uint8
+{
+    LOG_ARGUMENT_SIGNED,
+    LOG_ARGUMENT_UNSIGNED,
+    LOG_ARGUMENT_REAL,     // The bits of a double
+    LOG_ARGUMENT_POINTER,
+    LOG_ARGUMENT_STRING,   // Offset into strings, or LOG_TRUNCATED_STRING when there wasn't room
+    LOG_ARGUMENT_NULL_STRING,
+};
+
+struct Log_Record
+{
+    // The ring is a bounded queue: a free slot's sequence is the write index that can claim it, a written one is
+    // that index + 1, and draining moves it on to the index that claims it next time round
+    SDL_atomic_t sequence;
+    uint8 level;
+    uint8 argument_count;
+    uint16 string_bytes_used;
+    uint64 counter;  // SDL_GetPerformanceCounter when it was logged
+    const char* format;
+    uint8 argument_types[LOG_MAX_ARGUMENTS];
+    uint64 arguments[LOG_MAX_ARGUMENTS];
+    char strings[LOG_RECORD_STRING_BYTES];
+};
+
+struct Logger
+{
+    Log_Record* records;
+    SDL_atomic_t write_index;  // Next slot a producer claims
+    uint32 read_index;         // Drain thread only
+    SDL_atomic_t is_running;
+
+    SDL_Thread* drain_thread;
+    SDL_sem* wake;
+    SDL_atomic_t stop_requested;
+
+    FILE* file;  // NULL writes info to stdout and errors to stderr
+    bool32 is_at_line_start;
+    uint64 start_counter;
+    uint64 counter_frequency;
+
+    // Stats
+    SDL_atomic_t records_dropped;
+    uint32 records_written;  // Drain thread only
+    uint32 max_backlog;      // Most records waiting at the start of a drain
+    real32 last_drain__microseconds;
+    real32 max_drain__microseconds;
+};
+
+Logger global_logger;
+
+//=======================================================
+// FORMATTING (drain thread, or the caller before log_start)
+//=======================================================
+
+// The argument decides the length modifier rather than the format, so %d of an int64 and %u of a uint8 both work
+local_internal int32 log_format_record(const Log_Record* record, char* buffer, int32 buffer_size)
+{
+    const char* c = record->format;
+    uint32 argument = 0;
+    int32 used = 0;
+
+    while (*c && used < buffer_size - 1)
+    {
+        if (*c != '%')
+        {
+            buffer[used++] = *c++;
+            continue;
+        }
+        if (c[1] == '%')
+        {
+            buffer[used++] = '%';
+            c += 2;
+            continue;
+        }
+
+        char spec[32];
+        int32 spec_length = 0;
+        spec[spec_length++] = *c++;
+        while (*c && strchr("-+ #0123456789.", *c) && spec_length < 24)
+        {
+            spec[spec_length++] = *c++;
+        }
+        while (*c && strchr("hljztL", *c))
+        {
+            c++;
+        }
+        char conversion = *c;
+        if (!conversion)
+        {
+            break;
+        }
+        c++;
+
+        int32 remaining = buffer_size - used;
+        int32 written = 0;
+        if (argument >= record->argument_count)
+        {
+            written = snprintf(buffer + used, remaining, "<missing>");
+        }
+        else
+        {
+            uint8 type = record->argument_types[argument];
+            uint64 value = record->arguments[argument];
+            argument++;
+
+            real64 real;
+            memcpy(&real, &value, sizeof(real));
+            int64 integer = type == LOG_ARGUMENT_REAL ? (int64)real : (int64)value;
+
+            switch (conversion)
+            {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'x':
+                case 'X':
+                case 'o':
+                {
+                    spec[spec_length++] = 'l';
+                    spec[spec_length++] = 'l';
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = 0;
+                    written = snprintf(buffer + used, remaining, spec, (long long)integer);
+                    break;
+                }
+                case 'c':
+                {
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = 0;
+                    written = snprintf(buffer + used, remaining, spec, (int)integer);
+                    break;
+                }
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                {
+                    if (type != LOG_ARGUMENT_REAL)
+                    {
+                        real = type == LOG_ARGUMENT_SIGNED ? (real64)(int64)value : (real64)value;
+                    }
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = 0;
+                    written = snprintf(buffer + used, remaining, spec, real);
+                    break;
+                }
+                case 's':
+                {
+                    const char* string = "<not a string>";
+                    if (type == LOG_ARGUMENT_STRING)
+                    {
+                        string = value == LOG_TRUNCATED_STRING ? "..." : record->strings + value;
+                    }
+                    else if (type == LOG_ARGUMENT_NULL_STRING)
+                    {
+                        string = "(null)";
+                    }
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = 0;
+                    written = snprintf(buffer + used, remaining, spec, string);
+                    break;
+                }
+                case 'p':
+                {
+                    spec[spec_length++] = conversion;
+                    spec[spec_length] = 0;
+                    written = snprintf(buffer + used, remaining, spec, (void*)(uintptr_t)value);
+                    break;
+                }
+                default:
+                {
+                    written = snprintf(buffer + used, remaining, "<%%%c?>", conversion);
+                    break;
+                }
+            }
+        }
+        used += SDL_clamp(written, 0, remaining - 1);
+    }
+
+    buffer[used] = 0;
+    return used;
+}
+
+local_internal void log_write_record(Logger* logger, const Log_Record* record)
+{
+    char line[LOG_MAX_LINE_LENGTH];
+    int32 length = log_format_record(record, line, sizeof(line));
+    if (logger->file)
+    {
+        // Lines in the file start with when they were logged
+        if (logger->is_at_line_start)
+        {
+            real64 seconds = (real64)(record->counter - logger->start_counter) / (real64)logger->counter_frequency;
+            fprintf(logger->file, "[%10.4f]%s ", seconds, record->level == LOG_LEVEL_ERROR ? " ERROR:" : "");
+        }
+        if (length > 0)
+        {
+            fwrite(line, 1, length, logger->file);
+            logger->is_at_line_start = line[length - 1] == '\n';
+        }
+    }
+    else
+    {
+        fwrite(line, 1, length, record->level == LOG_LEVEL_ERROR ? stderr : stdout);
+    }
+}
+
+//=======================================================
+// DRAIN THREAD
+//=======================================================
+
+// Returns how many records it wrote
+local_internal uint32 log_drain(Logger* logger)
+{
+    Uint64 counter_start = SDL_GetPerformanceCounter();
+    uint32 backlog = (uint32)SDL_AtomicGet(&logger->write_index) - logger->read_index;
+    logger->max_backlog = SDL_max(logger->max_backlog, SDL_min(backlog, LOG_RING_SIZE));
+
+    uint32 drained_count = 0;
+    for (;;)
+    {
+        Log_Record* record = &logger->records[logger->read_index & (LOG_RING_SIZE - 1)];
+        if ((uint32)SDL_AtomicGet(&record->sequence) != logger->read_index + 1)
+        {
+            break;  // Empty, or the next one is still being written
+        }
+        SDL_MemoryBarrierAcquire();
+
+        log_write_record(logger, record);
+
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&record->sequence, (int)(logger->read_index + LOG_RING_SIZE));
+        logger->read_index++;
+        drained_count++;
+    }
+
+    if (drained_count > 0)
+    {
+        fflush(logger->file ? logger->file : stdout);
+        logger->records_written += drained_count;
+
+        real32 drain__microseconds =
+            (real32)(SDL_GetPerformanceCounter() - counter_start) * 1000000.0f / (real32)logger->counter_frequency;
+        logger->last_drain__microseconds = drain__microseconds;
+        logger->max_drain__microseconds = SDL_max(logger->max_drain__microseconds, drain__microseconds);
+    }
+    return drained_count;
+}
+
+local_internal int log_drain_thread(void* data)
+{
+    Logger* logger = (Logger*)data;
+
+    while (!SDL_AtomicGet(&logger->stop_requested))
+    {
+        SDL_SemWaitTimeout(logger->wake, LOG_DRAIN_INTERVAL__MS);
+        log_drain(logger);
+    }
+    // Whatever got logged before the stop
+    log_drain(logger);
+    return 0;
+}
+
+//=======================================================
+// LOGGING SIDE
+//=======================================================
+
+// Claims a ring slot, or returns scratch when the logger isn't running. NULL means the ring was full.
+Log_Record* log_begin(Logger* logger, Log_Level level, const char* format, Log_Record* scratch)
+{
+    Log_Record* record = scratch;
+    if (SDL_AtomicGet(&logger->is_running))
+    {
+        uint32 index = (uint32)SDL_AtomicGet(&logger->write_index);
+        for (;;)
+        {
+            Log_Record* slot = &logger->records[index & (LOG_RING_SIZE - 1)];
+            int32 difference = (int32)((uint32)SDL_AtomicGet(&slot->sequence) - index);
+            if (difference == 0)
+            {
+                if (SDL_AtomicCAS(&logger->write_index, (int)index, (int)(index + 1)))
+                {
+                    record = slot;
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Still holds a record from last time round
+                SDL_AtomicAdd(&logger->records_dropped, 1);
+                return NULL;
+            }
+            index = (uint32)SDL_AtomicGet(&logger->write_index);
+        }
+    }
+
+    record->level = level;
+    record->argument_count = 0;
+    record->string_bytes_used = 0;
+    record->counter = SDL_GetPerformanceCounter();
+    record->format = format;
+    return record;
+}
+
+void log_end(Logger* logger, Log_Record* record, Log_Record* scratch)
+{
+    if (record == scratch)
+    {
+        log_write_record(logger, record);
+        return;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&record->sequence, SDL_AtomicGet(&record->sequence) + 1);
+}
+
+inline void log_put_argument(Log_Record* record, Log_Argument_Type type, uint64 value)
+{
+    record->argument_types[record->argument_count] = type;
+    record->arguments[record->argument_count] = value;
+    record->argument_count++;
+}
+
+// Anything narrower than an int gets promoted to one, floats to doubles, like they would going through printf's ...
+inline void log_put(Log_Record* record, int value)
+{
+    log_put_argument(record, LOG_ARGUMENT_SIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, long value)
+{
+    log_put_argument(record, LOG_ARGUMENT_SIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, long long value)
+{
+    log_put_argument(record, LOG_ARGUMENT_SIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, unsigned value)
+{
+    log_put_argument(record, LOG_ARGUMENT_UNSIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, unsigned long value)
+{
+    log_put_argument(record, LOG_ARGUMENT_UNSIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, unsigned long long value)
+{
+    log_put_argument(record, LOG_ARGUMENT_UNSIGNED, (uint64)value);
+}
+
+inline void log_put(Log_Record* record, double value)
+{
+    uint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    log_put_argument(record, LOG_ARGUMENT_REAL, bits);
+}
+
+inline void log_put(Log_Record* record, const void* value)
+{
+    log_put_argument(record, LOG_ARGUMENT_POINTER, (uint64)(uintptr_t)value);
+}
+
+inline void log_put(Log_Record* record, const char* value)
+{
+    if (!value)
+    {
+        log_put_argument(record, LOG_ARGUMENT_NULL_STRING, 0);
+        return;
+    }
+
+    // Cut short to whatever room is left
+    uint32 offset = record->string_bytes_used;
+    uint32 available = LOG_RECORD_STRING_BYTES - offset;
+    if (available == 0)
+    {
+        log_put_argument(record, LOG_ARGUMENT_STRING, LOG_TRUNCATED_STRING);
+        return;
+    }
+    char* destination = record->strings + offset;
+    uint32 length = 0;
+    while (length + 1 < available && value[length])
+    {
+        destination[length] = value[length];
+        length++;
+    }
+    destination[length] = 0;
+    record->string_bytes_used = (uint16)(offset + length + 1);
+    log_put_argument(record, LOG_ARGUMENT_STRING, offset);
+}
+
+template <typename... Arguments>
+void log_write(Log_Level level, const char* format, Arguments... arguments)
+{
+    static_assert(sizeof...(Arguments) <= LOG_MAX_ARGUMENTS, "Too many arguments to log");
+
+    Log_Record scratch;  // Only used before log_start and after log_stop
+    Log_Record* record = log_begin(&global_logger, level, format, &scratch);
+    if (record)
+    {
+        int expand[] = { 0, (log_put(record, arguments), 0)... };
+        (void)expand;
+        log_end(&global_logger, record, &scratch);
+    }
+}
+
+template <typename... Arguments>
+void log_info(const char* format, Arguments... arguments)
+{
+    log_write(LOG_LEVEL_INFO, format, arguments...);
+}
+
+template <typename... Arguments>
+void log_error(const char* format, Arguments... arguments)
+{
+    log_write(LOG_LEVEL_ERROR, format, arguments...);
+}
+
+//=======================================================
+// SETUP
+//=======================================================
+
+// NULL file_path logs to the terminal. Falls back to logging straight away if the thread can't be started.
+bool32 log_start(Logger* logger, Memory_Arena* arena, const char* file_path)
+{
+    *logger = {};
+    logger->counter_frequency = SDL_GetPerformanceFrequency();
+    logger->start_counter = SDL_GetPerformanceCounter();
+    logger->is_at_line_start = true;
+    if (file_path)
+    {
+        logger->file = fopen(file_path, "w");
+        if (!logger->file)
+        {
+            fprintf(stderr, "Failed to open %s for logging, logging to the terminal\n", file_path);
+        }
+    }
+
+    logger->records = (Log_Record*)push_size(arena, LOG_RING_SIZE * sizeof(Log_Record), 64);
+    if (!logger->records)
+    {
+        return false;
+    }
+    for (uint32 i = 0; i < LOG_RING_SIZE; i++)
+    {
+        SDL_AtomicSet(&logger->records[i].sequence, (int)i);
+    }
+
+    logger->wake = SDL_CreateSemaphore(0);
+    logger->drain_thread = SDL_CreateThread(log_drain_thread, "logger", logger);
+    if (!logger->drain_thread)
+    {
+        fprintf(stderr, "Failed to create the logger thread: %s\n", SDL_GetError());
+        SDL_DestroySemaphore(logger->wake);
+        logger->wake = NULL;
+        return false;
+    }
+
+    SDL_AtomicSet(&logger->is_running, 1);
+    return true;
+}
+
+// Writes out everything logged so far and goes back to logging straight away
+void log_stop(Logger* logger)
+{
+    if (!SDL_AtomicGet(&logger->is_running))
+    {
+        return;
+    }
+
+    // Late records from other threads go straight out rather than into a ring nobody drains
+    SDL_AtomicSet(&logger->is_running, 0);
+    SDL_AtomicSet(&logger->stop_requested, 1);
+    SDL_SemPost(logger->wake);
+    SDL_WaitThread(logger->drain_thread, NULL);
+    SDL_DestroySemaphore(logger->wake);
+    logger->drain_thread = NULL;
+    logger->wake = NULL;
+
+    if (logger->file)
+    {
+        fclose(logger->file);
+        logger->file = NULL;
+    }
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+#ifdef _WIN32
+#define LOG_NULL_DEVICE "NUL"
+#else
+#define LOG_NULL_DEVICE "/dev/null"
+#endif
+
+// Times log calls on this thread against formatting them with snprintf, with the drain thread writing to the null
+// device so the terminal doesn't get flooded
+int32 log_run_benchmark(Memory_Arena* arena, uint32 call_count)
+{
+    printf("Logger benchmark: %u calls, ring of %u records\n", call_count, LOG_RING_SIZE);
+
+    if (!log_start(&global_logger, arena, LOG_NULL_DEVICE))
+    {
+        return -1;
+    }
+
+    // Log in bursts that fit in the ring with pauses for the drain thread, like a game logging every so often. The
+    // last burst is as fast as it can go, to see what happens when the drain thread can't keep up.
+    uint32 burst_size = LOG_RING_SIZE / 2;
+    Uint64 logging_counter = 0;
+    Uint64 max_call_counter = 0;
+    for (uint32 logged = 0; logged < call_count; logged += burst_size)
+    {
+        uint32 burst_end = SDL_min(logged + burst_size, call_count);
+        for (uint32 i = logged; i < burst_end; i++)
+        {
+            Uint64 counter_before = SDL_GetPerformanceCounter();
+            log_info("Frame %u, Ms/frame: %.04f (Target: %.04f), scene: %s, snake %d long at %p\n",
+                     i,
+                     16.9f + (real32)(i & 7) * 0.01f,
+                     16.97f,
+                     "gameplay",
+                     (int32)(i & 255),
+                     (void*)&global_logger);
+            Uint64 call_counter = SDL_GetPerformanceCounter() - counter_before;
+            logging_counter += call_counter;
+            max_call_counter = SDL_max(max_call_counter, call_counter);
+        }
+        SDL_Delay(2 * LOG_DRAIN_INTERVAL__MS);
+    }
+    int32 dropped_while_paced = SDL_AtomicGet(&global_logger.records_dropped);
+
+    Uint64 flood_start = SDL_GetPerformanceCounter();
+    for (uint32 i = 0; i < call_count; i++)
+    {
+        log_info("Flood %u: %.02f\n", i, (real64)i * 0.5);
+    }
+    Uint64 flood_counter = SDL_GetPerformanceCounter() - flood_start;
+    int32 dropped_while_flooding = SDL_AtomicGet(&global_logger.records_dropped) - dropped_while_paced;
+
+    log_stop(&global_logger);
+
+    // The old way, formatting on the calling thread (before it even gets to the write)
+    char line[LOG_MAX_LINE_LENGTH];
+    Uint64 formatting_start = SDL_GetPerformanceCounter();
+    uint32 checksum = 0;
+    for (uint32 i = 0; i < call_count; i++)
+    {
+        checksum += (uint32)snprintf(line,
+                                     sizeof(line),
+                                     "Frame %u, Ms/frame: %.04f (Target: %.04f), scene: %s, snake %d long at %p\n",
+                                     i,
+                                     16.9f + (real32)(i & 7) * 0.01f,
+                                     16.97f,
+                                     "gameplay",
+                                     (int32)(i & 255),
+                                     (void*)&global_logger);
+    }
+    Uint64 formatting_counter = SDL_GetPerformanceCounter() - formatting_start;
+
+    real64 frequency = (real64)SDL_GetPerformanceFrequency();
+    printf("  log call: %.1f ns on average, %.1f us max, %d dropped\n",
+           (real64)logging_counter * 1e9 / frequency / call_count,
+           (real64)max_call_counter * 1e6 / frequency,
+           dropped_while_paced);
+    printf("  snprintf on the calling thread: %.1f ns per call (%u bytes)\n",
+           (real64)formatting_counter * 1e9 / frequency / call_count,
+           checksum);
+    printf("  flooding: %.1f ns per call, %d of %u dropped\n",
+           (real64)flood_counter * 1e9 / frequency / call_count,
+           dropped_while_flooding,
+           call_count);
+    printf("  drain thread: %u records written, up to %.1f us per drain, backlog up to %u\n",
+           global_logger.records_written,
+           global_logger.max_drain__microseconds,
+           global_logger.max_backlog);
+    return 0;
+}
@@ -7,6 +7,7 @@
 #include <SDL2/SDL_mixer.h>
 
 #ifdef __WINDOWS__
+#include <winsock2.h>  // Has to come before windows.h
 #include <windows.h>
 #include <mmsystem.h>
 #endif
@@ -34,11 +35,85 @@ uint32 GRID_BLOCK_SIZE = 20;
 uint32 X_GRIDS = LOGICAL_WIDTH / GRID_BLOCK_SIZE;  // Should exactly divide into logical width
 uint32 Y_GRIDS = (int32)(X_GRIDS / ABSOLUTE_ASPECT_RATIO);
 
+// Draw the board into a small offscreen texture (a few pixels per grid cell) and upscale it once with nearest
+// filtering. This keeps the fill-rate cost of the board the same no matter how big the window is.
+bool32 LOW_RES_BOARD_ENABLED = 1;
+uint32 LOW_RES_PIXELS_PER_CELL = 4;  // Should exactly divide into GRID_BLOCK_SIZE
+
 int32 window_width = LOGICAL_WIDTH;
 int32 window_height = LOGICAL_HEIGHT;
 
-real32 SIMULATION_FPS = 100;
-real32 SIMULATION_DELTA_TIME_S = 1.f / SIMULATION_FPS;
+// The simulation clock counts whole ticks and gameplay timing is in integer microseconds, so the same inputs give
+// the same state whatever the frame rate, run speed or tick rate
+uint32 SIMULATION_TICKS_PER_SECOND = 100;
+// Fast-forward. Only ticks with an event on them cost anything, so this can go very high.
+uint32 SIMULATION_SPEED_MULTIPLIER = 1;
+// Non-zero starts every game at this many microseconds per cell. The snake can move many cells per tick, so this
+// doesn't depend on the tick rate (e.g. 250 is 4000 cells per second).
+uint32 TURBO_GRID_JUMP_INTERVAL__MICROSECONDS = 0;
+
+// The MCTS autopilot's rollouts for every cell, split over the worker threads (0 workers is one per core)
+uint32 MCTS_ROLLOUTS_PER_DECISION = 2048;
+uint32 MCTS_WORKER_COUNT = 0;
+// The BFS autopilot's searches for every cell stop after growing this many bitboard rows between them (a row of a 640
+// wide board is 11 words), so a decision stays well inside a tick even when turbo packs several cells into one
+uint32 AUTOPLAYER_ROWS_PER_DECISION = 50000;
+
+// Versus runs at a fixed speed, one cell per frame of the rollback netcode
+uint32 VERSUS_GRID_JUMP_INTERVAL__MICROSECONDS = 100000;
+
+// The arena: lots of AI snakes on one big board, started with --arena (see snake_arena.cpp). Its board is drawn a
+// pixel per cell and scaled to fit the window. 0 workers is one per core.
+int32 SNAKE_ARENA_COLUMNS = 320;
+int32 SNAKE_ARENA_ROWS = 180;
+uint32 SNAKE_ARENA_SNAKE_COUNT = 1000;
+uint32 SNAKE_ARENA_BLIP_COUNT = 1000;
+uint32 SNAKE_ARENA_TICK_INTERVAL__MICROSECONDS = 50000;
+uint32 SNAKE_ARENA_WORKER_COUNT = 0;
+
+// --world: one snake on a board much bigger than the screen, with the camera following the head (see world.cpp)
+int32 WORLD_COLUMNS = 10000;
+int32 WORLD_ROWS = 10000;
+uint32 WORLD_BLIP_RARITY = 64;  // One cell in this many starts with a blip
+uint32 WORLD_GRID_JUMP_INTERVAL__MICROSECONDS = 50000;
+
+// Sparks for blip pickups and game overs (see particles.cpp). Non-zero stress count keeps that many alive in gameplay.
+uint32 PARTICLE_CAPACITY = 128 * 1024;
+uint32 PARTICLE_STRESS_COUNT = 0;
+
+// Non-zero streams every game to spectators on 127.0.0.1 at this port (see spectator_server.cpp)
+uint16 SPECTATOR_SERVER_PORT = 0;
+
+// Scene state and text buffers come out of the permanent arena. The transient arena is cleared every frame.
+size_t PERMANENT_ARENA_SIZE = 16 * 1024 * 1024;
+size_t TRANSIENT_ARENA_SIZE = 4 * 1024 * 1024;
+bool32 ARENA_USE_HUGE_PAGES = 1;
+bool32 ARENA_PREFAULT = 1;  // Touch every page at startup so we don't page fault during a game
+
+// Keeps the last few thousand frames, moves and key presses for dumping on asserts, crashes and F7 (see
+// flight_recorder.cpp). Game overs can dump too, each one over the last.
+bool32 FLIGHT_RECORDER_DUMP_ON_GAME_OVER = 1;
+
+// Count instructions, cycles, cache misses and branch misses for each frame phase (see perf_counters.cpp, Linux only)
+bool32 PERF_COUNTERS_ENABLED = 1;
+
+// Publish the frame stats to shared memory every frame for tools/metrics_top (see live_metrics.cpp)
+bool32 LIVE_METRICS_ENABLED = 1;
+
+// Where the frame loop's logging ends up (see logger.cpp), NULL is the terminal
+const char* LOG_FILE_PATH = NULL;
+
+// Least recently used textures get evicted (and recreated when they're next drawn) to stay under this
+uint64 TEXTURE_MEMORY_BUDGET_BYTES = 64 * 1024 * 1024;
+
+// 2048 samples is ~46ms at 44.1kHz before the device adds its own latency. The low latency buffer is ~6ms.
+bool32 AUDIO_LOW_LATENCY_ENABLED = 1;
+int32 AUDIO_LOW_LATENCY_BUFFER_SAMPLES = 256;
+int32 AUDIO_DEFAULT_BUFFER_SAMPLES = 2048;
+
+// Generate the sound effects at startup instead of decoding them from sounds/. The benchmark times both ways.
+bool32 SYNTHESIZED_SOUND_EFFECTS_ENABLED = 1;
+bool32 SOUND_EFFECT_BENCHMARK_ENABLED = 0;
 
 real32 TARGET_TIME_PER_FRAME_S = 1.f / (real32)TARGET_SCREEN_FPS;
 real32 TARGET_TIME_PER_FRAME_MS = TARGET_TIME_PER_FRAME_S * 1000.0f;
@@ -64,8 +139,7 @@ struct Master_Timer
     real32 time_elapsed_for_render__seconds;          // How much time was needed for rendering?
     real32 time_elapsed_for_sleep__seconds;           // How much time was needed for sleeping?
     real32 total_frame_time_elapsed__seconds;         // How long did the whole dang frame take?
-    real64 physics_simulation_elapsed_time__seconds;  // This is the main counter for time. Everything will rely on what
-                                                      // the physics sees
+    Uint64 total_frame_counter_elapsed;               // Same in performance counter units, for the simulation clock
 };
 
 void set_dpi()
@@ -81,26 +155,43 @@ void set_dpi()
     global_text_dpi_scale_factor = dpi / base_DPI;
 }
 
-#ifdef __WIN32__
-uint64 global_last_cycle_count;
-uint64 global_cycles_elapsed_before_render;
-uint64 global_cycles_elapsed_after_render;
-uint64 global_total_cycles_elapsed;
-#endif
-
 #define DYNAMIC_SCORE_LENGTH 5
 
 // clang-format off
+#include "alloc_tracker.cpp"
+#include "memory_arena.cpp"
+#include "logger.cpp"
+#include "asset_pack.cpp"
+#include "texture_manager.cpp"
+#include "timer_wheel.cpp"
+#include "bitboard.cpp"
+#include "snake_sim.cpp"
+#include "worker_pool.cpp"
+#include "mcts.cpp"
+#include "snake_arena.cpp"
+#include "world.cpp"
+#include "udp_socket.cpp"
+#include "rollback.cpp"
+#include "spectator_server.cpp"
+#include "capture.cpp"
+#include "flight_recorder.cpp"
+#include "live_metrics.cpp"
+#include "perf_counters.cpp"
 #include "input.cpp"
 // #include "game.cpp"
 #include "render.cpp"
+#include "minimap.cpp"
+#include "particles.cpp"
+#include "mixer.cpp"
+#include "synth.cpp"
 #include "audio.cpp"
 
 typedef struct Scene
 {
     void (*reset_state)(struct Scene* scene);
     void (*handle_input)(struct Scene* scene, Input* input);
-    void (*update)(struct Scene* scene, real64 simulation_time_elapsed, real32 dt_s);
+    // Runs once per frame, after every simulation timer that came due this frame has fired
+    void (*update)(struct Scene* scene, uint64 simulation_tick);
     void (*render)(struct Scene* scene);
     void* state;  // Pointer to the scene-specific state
 } Scene;
@@ -109,11 +200,30 @@ Scene* global_next_scene;
 Scene* global_current_scene;
 Scene global_start_screen_scene;
 Scene global_gameplay_scene;
+Scene global_versus_scene;
+Scene global_snake_arena_scene;
+Scene global_world_scene;
+
+// Scenes schedule their simulation events here. Everything gets cancelled when the scene changes.
+Timer_Wheel global_simulation_timers;
+
+// The first tick at or after the given simulation time
+uint64 get_simulation_tick_at(uint64 time__microseconds)
+{
+    return (time__microseconds * SIMULATION_TICKS_PER_SECOND + 999999) / 1000000;
+}
+
+uint64 get_simulation_time__microseconds(uint64 tick)
+{
+    return tick * 1000000 / SIMULATION_TICKS_PER_SECOND;
+}
 
-Audio_Context global_audio_context;
 
 #include "scenes/start_screen.cpp"
 #include "scenes/gameplay.cpp"
+#include "scenes/versus.cpp"
+#include "scenes/snake_arena.cpp"
+#include "scenes/world.cpp"
 // clang-format on
 
 int32 filterEvent(void* userdata, SDL_Event* event)
@@ -137,8 +247,155 @@ int32 filterEvent(void* userdata, SDL_Event* event)
 
 int32 main(int32 argc, char* argv[])
 {
+    alloc_tracker_init();
+
+    if (!arena_init(&global_permanent_arena,
+                    "permanent",
+                    PERMANENT_ARENA_SIZE,
+                    ARENA_USE_HUGE_PAGES,
+                    ARENA_PREFAULT) ||
+        !arena_init(&global_transient_arena, "transient", TRANSIENT_ARENA_SIZE, ARENA_USE_HUGE_PAGES, ARENA_PREFAULT))
+    {
+        return -1;
+    }
+    printf("Arenas: permanent %zu KB (huge pages: %s), transient %zu KB (huge pages: %s)\n",
+           global_permanent_arena.size / 1024,
+           global_permanent_arena.has_huge_pages ? "yes" : "no",
+           global_transient_arena.size / 1024,
+           global_transient_arena.has_huge_pages ? "yes" : "no");
+
+    // Headless, so it runs before anything opens a window or an audio device
+    if (argc > 1 && strcmp(argv[1], "--bench-turbo") == 0)
+    {
+        uint32 cells_per_second = argc > 2 ? (uint32)atoi(argv[2]) : 5000;
+        return gameplay__run_turbo_benchmark(cells_per_second, 600);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-autoplay") == 0)
+    {
+        uint32 columns = argc > 3 ? (uint32)atoi(argv[2]) : 640;
+        uint32 rows = argc > 3 ? (uint32)atoi(argv[3]) : 360;
+        return gameplay__run_autoplay_benchmark(columns, rows, 600);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-mcts") == 0)
+    {
+        uint32 rollout_count = argc > 2 ? (uint32)atoi(argv[2]) : MCTS_ROLLOUTS_PER_DECISION;
+        mcts_init(&global_mcts, &global_permanent_arena, MCTS_WORKER_COUNT, X_GRIDS, Y_GRIDS);
+        int32 result = mcts_run_benchmark(&global_mcts, &global_permanent_arena, rollout_count, 500);
+        mcts_shutdown(&global_mcts);
+        return result;
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-spectators") == 0)
+    {
+        uint32 client_count = argc > 2 ? (uint32)atoi(argv[2]) : 4;
+        return gameplay__run_spectator_benchmark(client_count, 5000, 600);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-rollback") == 0)
+    {
+        uint32 frame_count = argc > 3 ? (uint32)atoi(argv[2]) : 100000;
+        uint32 latency_frames = argc > 3 ? (uint32)atoi(argv[3]) : 8;
+        return versus__run_rollback_benchmark(frame_count, latency_frames);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-arena") == 0)
+    {
+        uint32 snake_count = argc > 2 ? (uint32)atoi(argv[2]) : 4096;
+        uint32 tick_count = argc > 3 ? (uint32)atoi(argv[3]) : 1000;
+        return snake_arena_run_benchmark(&global_permanent_arena, 1024, 576, snake_count, tick_count);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-world") == 0)
+    {
+        uint64 step_count = argc > 2 ? (uint64)atoll(argv[2]) : 2000000;
+        return world__run_benchmark(step_count);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-particles") == 0)
+    {
+        uint32 particle_count = argc > 2 ? (uint32)atoi(argv[2]) : 100000;
+        uint32 frame_count = argc > 3 ? (uint32)atoi(argv[3]) : 600;
+        return particles_run_benchmark(particle_count, frame_count);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-log") == 0)
+    {
+        uint32 call_count = argc > 2 ? (uint32)atoi(argv[2]) : 100000;
+        return log_run_benchmark(&global_permanent_arena, call_count);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-flight-recorder") == 0)
+    {
+        uint32 frame_count = argc > 2 ? (uint32)atoi(argv[2]) : 1000000;
+        return flight_recorder_run_benchmark(&global_permanent_arena, frame_count);
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-perf-counters") == 0)
+    {
+        uint32 read_count = argc > 2 ? (uint32)atoi(argv[2]) : 100000;
+        return perf_counters_run_benchmark(read_count);
+    }
+
+    if (!flight_recorder_init(&global_flight_recorder, &global_permanent_arena))
+    {
+        return -1;
+    }
+    if (PERF_COUNTERS_ENABLED)
+    {
+        perf_counters_open(&global_perf_counters);
+    }
+
+    // --particle-stress [count] keeps count particles flying around the gameplay scene
+    if (argc > 1 && strcmp(argv[1], "--particle-stress") == 0)
+    {
+        PARTICLE_STRESS_COUNT = argc > 2 ? (uint32)atoi(argv[2]) : 100000;
+        PARTICLE_CAPACITY = SDL_max(PARTICLE_CAPACITY, PARTICLE_STRESS_COUNT);
+    }
+    if (!particles_init(&global_particles, PARTICLE_CAPACITY, 12345))
+    {
+        return -1;
+    }
+
+    // --spectators [port] turns on the spectator server, watch with tools/spectator_client
+    if (argc > 1 && strcmp(argv[1], "--spectators") == 0)
+    {
+        SPECTATOR_SERVER_PORT = argc > 2 ? (uint16)atoi(argv[2]) : 47900;
+    }
+
+    // --versus <player 0 or 1> <local port> <remote host> <remote port>, with each player's ports swapped on the other
+    bool32 is_versus = argc > 1 && strcmp(argv[1], "--versus") == 0;
+    if (is_versus)
+    {
+        if (argc < 6 || !rollback_session_init(&global_rollback_session,
+                                               &global_permanent_arena,
+                                               atoi(argv[2]) ? 1 : 0,
+                                               (uint16)atoi(argv[3]),
+                                               argv[4],
+                                               (uint16)atoi(argv[5]),
+                                               X_GRIDS,
+                                               Y_GRIDS))
+        {
+            fprintf(stderr, "Usage: --versus <player 0 or 1> <local port> <remote host> <remote port>\n");
+            return -1;
+        }
+    }
+
+    // --arena skips the start screen and goes straight to the AI snakes
+    bool32 is_snake_arena = argc > 1 && strcmp(argv[1], "--arena") == 0;
+
+    // --world [columns] [rows], which can't be smaller than the screen
+    bool32 is_world = argc > 1 && strcmp(argv[1], "--world") == 0;
+    if (is_world)
+    {
+        if (argc > 3)
+        {
+            WORLD_COLUMNS = atoi(argv[2]);
+            WORLD_ROWS = atoi(argv[3]);
+        }
+        WORLD_COLUMNS = SDL_max(WORLD_COLUMNS, (int32)X_GRIDS);
+        WORLD_ROWS = SDL_max(WORLD_ROWS, (int32)Y_GRIDS);
+        if (!world_init(&global_world, WORLD_COLUMNS, WORLD_ROWS, WORLD_BLIP_RARITY, 12345))
+        {
+            return -1;
+        }
+    }
+
     SDL_Init(SDL_INIT_EVERYTHING);
 
+    asset_pack_open();
+
     if (TTF_Init() == -1)
     {
         std::cerr << "Failed to initialize SDL_ttf: " << TTF_GetError() << std::endl;
@@ -150,11 +407,6 @@ int32 main(int32 argc, char* argv[])
         return 1;
     }
 
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
-        printf("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
-        return 1;
-    }
-
     if (!audio_init(&global_audio_context)) {
         fprintf(stderr, "Failed to initialize audio.\n");
         SDL_Quit();
@@ -215,24 +467,13 @@ int32 main(int32 argc, char* argv[])
 
     global_debug_counter = 0;
 
-    real32 accumulator_s = 0.0f;
+    // Performance counter ticks * SIMULATION_TICKS_PER_SECOND, so turning it into simulation ticks never rounds
+    uint64 simulation_accumulator = 0;
 
     global_display_debug_info = 0;
 
-#ifdef __WIN32__
-    // This looks like a function call but it's actually an intrinsic that
-    // runs the actual assembly instruction directly
-    global_last_cycle_count = __rdtsc();
-#endif
-
 #define DEBUG_TEXT_STRING_LENGTH 100
 
-#ifdef __WIN32__
-    char mega_cycles_text[DEBUG_TEXT_STRING_LENGTH] = "";
-    char actual_mega_cycles_text[DEBUG_TEXT_STRING_LENGTH] = "";
-    char render_mega_cycles_text[DEBUG_TEXT_STRING_LENGTH] = "";
-#endif
-
     SDL_Color white_text_color = { 255, 255, 255, 255 }; // White color
     real32 font_size = 16.0f;
 
@@ -250,7 +491,7 @@ int32 main(int32 argc, char* argv[])
     real32 vertical_offset = font_height + debug_padding;
     real32 y_offset = 0;
 
-    char fps_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* fps_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text fps_drawn_text = {};
     fps_drawn_text.original_value = 0.f;
     fps_drawn_text.text_string = fps_text;
@@ -260,7 +501,7 @@ int32 main(int32 argc, char* argv[])
     fps_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
-    char ms_per_frame_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* ms_per_frame_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text ms_per_frame_drawn_text = {};
     ms_per_frame_drawn_text.original_value = 0.f;
     ms_per_frame_drawn_text.text_string = ms_per_frame_text;
@@ -270,7 +511,7 @@ int32 main(int32 argc, char* argv[])
     ms_per_frame_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
-    char work_ms_per_frame_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* work_ms_per_frame_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text work_ms_per_frame_drawn_text = {};
     work_ms_per_frame_drawn_text.original_value = 0.f;
     work_ms_per_frame_drawn_text.text_string = work_ms_per_frame_text;
@@ -280,7 +521,7 @@ int32 main(int32 argc, char* argv[])
     work_ms_per_frame_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
-    char writing_buffer_ms_per_frame_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* writing_buffer_ms_per_frame_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text writing_buffer_ms_per_frame_drawn_text = {};
     writing_buffer_ms_per_frame_drawn_text.original_value = 0.f;
     writing_buffer_ms_per_frame_drawn_text.text_string = writing_buffer_ms_per_frame_text;
@@ -290,7 +531,7 @@ int32 main(int32 argc, char* argv[])
     writing_buffer_ms_per_frame_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
-    char render_ms_per_frame_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* render_ms_per_frame_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text render_ms_per_frame_drawn_text = {};
     render_ms_per_frame_drawn_text.original_value = 0.f;
     render_ms_per_frame_drawn_text.text_string = render_ms_per_frame_text;
@@ -300,7 +541,7 @@ int32 main(int32 argc, char* argv[])
     render_ms_per_frame_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
-    char sleep_ms_per_frame_text[DEBUG_TEXT_STRING_LENGTH] = "";
+    char* sleep_ms_per_frame_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
     Drawn_Text sleep_ms_per_frame_drawn_text = {};
     sleep_ms_per_frame_drawn_text.original_value = 0.f;
     sleep_ms_per_frame_drawn_text.text_string = sleep_ms_per_frame_text;
@@ -310,12 +551,191 @@ int32 main(int32 argc, char* argv[])
     sleep_ms_per_frame_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
     y_offset += vertical_offset;
 
+    // A row per phase right under its time, or just the one saying why when there's nothing to count
+    uint32 perf_counters_row_count = global_perf_counters.is_available ? PERF_PHASE_COUNT : 1;
+    char* perf_counters_texts[PERF_PHASE_COUNT] = {};
+    Drawn_Text perf_counters_drawn_texts[PERF_PHASE_COUNT] = {};
+    for (uint32 phase = 0; phase < perf_counters_row_count; phase++)
+    {
+        perf_counters_texts[phase] = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+        perf_counters_drawn_texts[phase].original_value = 0.f;
+        perf_counters_drawn_texts[phase].text_string = perf_counters_texts[phase];
+        perf_counters_drawn_texts[phase].font_size = font_size;
+        perf_counters_drawn_texts[phase].color = white_text_color;
+        perf_counters_drawn_texts[phase].text_rect.x = debug_x_start_offset;
+        perf_counters_drawn_texts[phase].text_rect.y = debug_x_start_offset + y_offset;
+        y_offset += vertical_offset;
+    }
+
+    char* capture_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text capture_drawn_text = {};
+    capture_drawn_text.original_value = 0.f;
+    capture_drawn_text.text_string = capture_text;
+    capture_drawn_text.font_size = font_size;
+    capture_drawn_text.color = white_text_color;
+    capture_drawn_text.text_rect.x = debug_x_start_offset;
+    capture_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* allocations_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text allocations_drawn_text = {};
+    allocations_drawn_text.original_value = 0.f;
+    allocations_drawn_text.text_string = allocations_text;
+    allocations_drawn_text.font_size = font_size;
+    allocations_drawn_text.color = white_text_color;
+    allocations_drawn_text.text_rect.x = debug_x_start_offset;
+    allocations_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* allocation_phases_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text allocation_phases_drawn_text = {};
+    allocation_phases_drawn_text.original_value = 0.f;
+    allocation_phases_drawn_text.text_string = allocation_phases_text;
+    allocation_phases_drawn_text.font_size = font_size;
+    allocation_phases_drawn_text.color = white_text_color;
+    allocation_phases_drawn_text.text_rect.x = debug_x_start_offset;
+    allocation_phases_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* arenas_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text arenas_drawn_text = {};
+    arenas_drawn_text.original_value = 0.f;
+    arenas_drawn_text.text_string = arenas_text;
+    arenas_drawn_text.font_size = font_size;
+    arenas_drawn_text.color = white_text_color;
+    arenas_drawn_text.text_rect.x = debug_x_start_offset;
+    arenas_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* textures_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text textures_drawn_text = {};
+    textures_drawn_text.original_value = 0.f;
+    textures_drawn_text.text_string = textures_text;
+    textures_drawn_text.font_size = font_size;
+    textures_drawn_text.color = white_text_color;
+    textures_drawn_text.text_rect.x = debug_x_start_offset;
+    textures_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* audio_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text audio_drawn_text = {};
+    audio_drawn_text.original_value = 0.f;
+    audio_drawn_text.text_string = audio_text;
+    audio_drawn_text.font_size = font_size;
+    audio_drawn_text.color = white_text_color;
+    audio_drawn_text.text_rect.x = debug_x_start_offset;
+    audio_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* mixer_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text mixer_drawn_text = {};
+    mixer_drawn_text.original_value = 0.f;
+    mixer_drawn_text.text_string = mixer_text;
+    mixer_drawn_text.font_size = font_size;
+    mixer_drawn_text.color = white_text_color;
+    mixer_drawn_text.text_rect.x = debug_x_start_offset;
+    mixer_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* autoplay_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text autoplay_drawn_text = {};
+    autoplay_drawn_text.original_value = 0.f;
+    autoplay_drawn_text.text_string = autoplay_text;
+    autoplay_drawn_text.font_size = font_size;
+    autoplay_drawn_text.color = white_text_color;
+    autoplay_drawn_text.text_rect.x = debug_x_start_offset;
+    autoplay_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* mcts_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text mcts_drawn_text = {};
+    mcts_drawn_text.original_value = 0.f;
+    mcts_drawn_text.text_string = mcts_text;
+    mcts_drawn_text.font_size = font_size;
+    mcts_drawn_text.color = white_text_color;
+    mcts_drawn_text.text_rect.x = debug_x_start_offset;
+    mcts_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* rollback_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text rollback_drawn_text = {};
+    rollback_drawn_text.original_value = 0.f;
+    rollback_drawn_text.text_string = rollback_text;
+    rollback_drawn_text.font_size = font_size;
+    rollback_drawn_text.color = white_text_color;
+    rollback_drawn_text.text_rect.x = debug_x_start_offset;
+    rollback_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* snake_arena_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text snake_arena_drawn_text = {};
+    snake_arena_drawn_text.original_value = 0.f;
+    snake_arena_drawn_text.text_string = snake_arena_text;
+    snake_arena_drawn_text.font_size = font_size;
+    snake_arena_drawn_text.color = white_text_color;
+    snake_arena_drawn_text.text_rect.x = debug_x_start_offset;
+    snake_arena_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* world_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text world_drawn_text = {};
+    world_drawn_text.original_value = 0.f;
+    world_drawn_text.text_string = world_text;
+    world_drawn_text.font_size = font_size;
+    world_drawn_text.color = white_text_color;
+    world_drawn_text.text_rect.x = debug_x_start_offset;
+    world_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* particles_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text particles_drawn_text = {};
+    particles_drawn_text.original_value = 0.f;
+    particles_drawn_text.text_string = particles_text;
+    particles_drawn_text.font_size = font_size;
+    particles_drawn_text.color = white_text_color;
+    particles_drawn_text.text_rect.x = debug_x_start_offset;
+    particles_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* log_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text log_drawn_text = {};
+    log_drawn_text.original_value = 0.f;
+    log_drawn_text.text_string = log_text;
+    log_drawn_text.font_size = font_size;
+    log_drawn_text.color = white_text_color;
+    log_drawn_text.text_rect.x = debug_x_start_offset;
+    log_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* flight_recorder_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text flight_recorder_drawn_text = {};
+    flight_recorder_drawn_text.original_value = 0.f;
+    flight_recorder_drawn_text.text_string = flight_recorder_text;
+    flight_recorder_drawn_text.font_size = font_size;
+    flight_recorder_drawn_text.color = white_text_color;
+    flight_recorder_drawn_text.text_rect.x = debug_x_start_offset;
+    flight_recorder_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    char* spectator_text = push_array(&global_permanent_arena, DEBUG_TEXT_STRING_LENGTH, char);
+    Drawn_Text spectator_drawn_text = {};
+    spectator_drawn_text.original_value = 0.f;
+    spectator_drawn_text.text_string = spectator_text;
+    spectator_drawn_text.font_size = font_size;
+    spectator_drawn_text.color = white_text_color;
+    spectator_drawn_text.text_rect.x = debug_x_start_offset;
+    spectator_drawn_text.text_rect.y = debug_x_start_offset + y_offset;
+    y_offset += vertical_offset;
+
+    timer_wheel_init(&global_simulation_timers, 0);
+
     {  // Start Screen Scene
         global_start_screen_scene = Scene();
-        Start_Screen__State start_screen_state = {};
-        Menu_Texts menu_texts = start_screen__setup_text();
-        start_screen_state.menu_texts = &menu_texts;
-        global_start_screen_scene.state = (void*)&start_screen_state;
+        Start_Screen__State* start_screen_state = push_struct(&global_permanent_arena, Start_Screen__State);
+        Menu_Texts* menu_texts = push_struct(&global_permanent_arena, Menu_Texts);
+        *menu_texts = start_screen__setup_text();
+        start_screen_state->menu_texts = menu_texts;
+        global_start_screen_scene.state = (void*)start_screen_state;
         start_screen__reset_state(&global_start_screen_scene);
         global_start_screen_scene.reset_state = &start_screen__reset_state;
         global_start_screen_scene.handle_input = &start_screen__handle_input;
@@ -325,28 +745,108 @@ int32 main(int32 argc, char* argv[])
 
     {  // Gameplay Scene
         global_gameplay_scene = Scene();
-        Gameplay__State gameplay_state = {};
-        Gameplay__Texts gameplay_texts = gameplay__setup_text();
-        gameplay_state.gameplay_texts = &gameplay_texts;
-        global_gameplay_scene.state = (void*)&gameplay_state;
+        Gameplay__State* gameplay_state = push_struct(&global_permanent_arena, Gameplay__State);
+        gameplay_state->sim = (Snake_Sim*)push_size(&global_permanent_arena, snake_sim_size(X_GRIDS, Y_GRIDS), 64);
+        snake_sim_init(gameplay_state->sim, X_GRIDS, Y_GRIDS, 12345);
+        Gameplay__Texts* gameplay_texts = push_struct(&global_permanent_arena, Gameplay__Texts);
+        *gameplay_texts = gameplay__setup_text(&global_permanent_arena);
+        gameplay_state->gameplay_texts = gameplay_texts;
+        global_gameplay_scene.state = (void*)gameplay_state;
+        if (SPECTATOR_SERVER_PORT)
+        {
+            // Before the first reset, which sends the spectators their first keyframe
+            spectator_server_start(
+                &global_spectator_server, &global_permanent_arena, SPECTATOR_SERVER_PORT, X_GRIDS, Y_GRIDS);
+        }
         gameplay__reset_state(&global_gameplay_scene);
         global_gameplay_scene.reset_state = &gameplay__reset_state;
         global_gameplay_scene.handle_input = &gameplay__handle_input;
         global_gameplay_scene.update = &gameplay__update;
         global_gameplay_scene.render = &gameplay__render;
+        gameplay__autoplayer_init(&global_permanent_arena);
+        mcts_init(&global_mcts, &global_permanent_arena, MCTS_WORKER_COUNT, X_GRIDS, Y_GRIDS);
     }
 
     global_current_scene = &global_start_screen_scene;
 
+    if (is_versus)
+    {  // Versus Scene
+        global_versus_scene = Scene();
+        Versus__State* versus_state = push_struct(&global_permanent_arena, Versus__State);
+        versus_state->session = &global_rollback_session;
+        versus__setup_text(versus_state, &global_permanent_arena);
+        global_versus_scene.state = (void*)versus_state;
+        global_versus_scene.reset_state = &versus__reset_state;
+        global_versus_scene.handle_input = &versus__handle_input;
+        global_versus_scene.update = &versus__update;
+        global_versus_scene.render = &versus__render;
+
+        timer_wheel_cancel_all(&global_simulation_timers);
+        global_current_scene = &global_versus_scene;
+        versus__reset_state(&global_versus_scene);
+    }
+
+    if (is_snake_arena)
+    {  // Snake Arena Scene
+        global_snake_arena_scene = Scene();
+        Snake_Arena__State* snake_arena_state = push_struct(&global_permanent_arena, Snake_Arena__State);
+        snake_arena_state->arena = &global_snake_arena;
+        snake_arena_state->seed = 12345;
+        snake_arena_init(&global_snake_arena,
+                         &global_permanent_arena,
+                         SNAKE_ARENA_COLUMNS,
+                         SNAKE_ARENA_ROWS,
+                         SNAKE_ARENA_SNAKE_COUNT,
+                         SNAKE_ARENA_BLIP_COUNT,
+                         SNAKE_ARENA_WORKER_COUNT,
+                         snake_arena_state->seed);
+        snake_arena__setup_palette(snake_arena_state);
+        global_snake_arena_scene.state = (void*)snake_arena_state;
+        global_snake_arena_scene.reset_state = &snake_arena__reset_state;
+        global_snake_arena_scene.handle_input = &snake_arena__handle_input;
+        global_snake_arena_scene.update = &snake_arena__update;
+        global_snake_arena_scene.render = &snake_arena__render;
+
+        timer_wheel_cancel_all(&global_simulation_timers);
+        global_current_scene = &global_snake_arena_scene;
+        snake_arena__reset_state(&global_snake_arena_scene);
+    }
+
+    if (is_world)
+    {  // World Scene
+        global_world_scene = Scene();
+        World__State* world_state = push_struct(&global_permanent_arena, World__State);
+        world_state->world = &global_world;
+        world_state->gameplay_texts = ((Gameplay__State*)global_gameplay_scene.state)->gameplay_texts;
+        minimap_init(&world_state->minimap, &global_world, &global_permanent_arena);
+        global_world_scene.state = (void*)world_state;
+        global_world_scene.reset_state = &world__reset_state;
+        global_world_scene.handle_input = &world__handle_input;
+        global_world_scene.update = &world__update;
+        global_world_scene.render = &world__render;
+
+        timer_wheel_cancel_all(&global_simulation_timers);
+        global_current_scene = &global_world_scene;
+        world__reset_state(&global_world_scene);
+    }
+
+    // From here on nothing on the game thread waits for the terminal
+    log_start(&global_logger, &global_permanent_arena, LOG_FILE_PATH);
+    if (LIVE_METRICS_ENABLED)
+    {
+        live_metrics_open(&global_live_metrics);
+    }
+
     while (global_running)
     {
+        alloc_tracker_begin_frame(global_current_scene == &global_gameplay_scene);
+        arena_reset(&global_transient_arena);
+        texture_manager_begin_frame();
 //==============================
 // TIMING
-#ifdef __WIN32__
-        uint64 global_cycle_count_now = __rdtsc();
-        global_cycles_elapsed_before_render = global_cycle_count_now - global_last_cycle_count;
-#endif
         Uint64 counter_now = SDL_GetPerformanceCounter();
+        perf_counters_begin_frame(&global_perf_counters);
+        flight_recorder_begin_frame(&global_flight_recorder, counter_now);
 //==============================
 
         real32 LAST_frame_time_elapsed_for_work__seconds = master_timer.time_elapsed_for_work__seconds;
@@ -355,13 +855,14 @@ int32 main(int32 argc, char* argv[])
         real32 LAST_frame_time_elapsed_for_sleep__seconds = master_timer.time_elapsed_for_sleep__seconds;
         real32 LAST_total_frame_time_elapsed__seconds = master_timer.total_frame_time_elapsed__seconds;
 
+        alloc_tracker_set_phase(ALLOC_PHASE_DEBUG);
         if (TEXT_DEBUGGING_ENABLED) // Displays Debug info in the console
         {
             {  // FPS
                 real32 fps = 1.0f / LAST_total_frame_time_elapsed__seconds;
                 if (global_debug_counter == 0)
                 {
-                    printf("FPS: %.1f, ", fps);
+                    log_info("FPS: %.1f, ", fps);
                 }
             }
 
@@ -369,7 +870,7 @@ int32 main(int32 argc, char* argv[])
             {  // Total Frame Time (MS)
                 if (global_debug_counter == 0)
                 {
-                    printf("Ms/frame: %.04f (Target: %.04f), ", ms_per_frame, TARGET_TIME_PER_FRAME_MS);
+                    log_info("Ms/frame: %.04f (Target: %.04f), ", ms_per_frame, TARGET_TIME_PER_FRAME_MS);
                 }
             }
 
@@ -378,7 +879,7 @@ int32 main(int32 argc, char* argv[])
 
                 if (global_debug_counter == 0)
                 {
-                    printf("Work ms: %.04f, (%.1f%%), ", work_ms_per_frame, (work_ms_per_frame / ms_per_frame) * 100);
+                    log_info("Work ms: %.04f, (%.1f%%), ", work_ms_per_frame, (work_ms_per_frame / ms_per_frame) * 100);
                 }
             }
 
@@ -386,9 +887,9 @@ int32 main(int32 argc, char* argv[])
                 real32 writing_buffer_ms_per_frame = LAST_frame_time_elapsed_for_writing_buffer__seconds * 1000.0f;
                 if (global_debug_counter == 0)
                 {
-                    printf("Buffer ms: %.04f, (%.1f%%), ",
-                           writing_buffer_ms_per_frame,
-                           (writing_buffer_ms_per_frame / ms_per_frame) * 100);
+                    log_info("Buffer ms: %.04f, (%.1f%%), ",
+                             writing_buffer_ms_per_frame,
+                             (writing_buffer_ms_per_frame / ms_per_frame) * 100);
                 }
             }
 
@@ -397,9 +898,9 @@ int32 main(int32 argc, char* argv[])
 
                 if (global_debug_counter == 0)
                 {
-                    printf("Render ms: %.04f, (%.1f%%), ",
-                           render_ms_per_frame,
-                           (render_ms_per_frame / ms_per_frame) * 100);
+                    log_info("Render ms: %.04f, (%.1f%%), ",
+                             render_ms_per_frame,
+                             (render_ms_per_frame / ms_per_frame) * 100);
                 }
             }
 
@@ -408,13 +909,176 @@ int32 main(int32 argc, char* argv[])
 
                 if (global_debug_counter == 0)
                 {
-                    printf("Sleep ms: %.04f, (%.1f%%)", sleep_ms_per_frame, (sleep_ms_per_frame / ms_per_frame) * 100);
+                    log_info("Sleep ms: %.04f, (%.1f%%)",
+                             sleep_ms_per_frame,
+                             (sleep_ms_per_frame / ms_per_frame) * 100);
+                }
+            }
+
+            if (global_perf_counters.is_available)
+            {  // Hardware counters
+                if (global_debug_counter == 0)
+                {
+                    real64 instructions_per_cycle[PERF_PHASE_COUNT];
+                    for (uint32 phase = 0; phase < PERF_PHASE_COUNT; phase++)
+                    {
+                        uint64* values = global_perf_counters.phase_values[phase];
+                        instructions_per_cycle[phase] =
+                            values[PERF_COUNTER_CYCLES]
+                                ? (real64)values[PERF_COUNTER_INSTRUCTIONS] / values[PERF_COUNTER_CYCLES]
+                                : 0.0;
+                    }
+                    log_info(", IPC work/buffer/render/sleep: %.2f/%.2f/%.2f/%.2f, work cache misses: %llu",
+                             instructions_per_cycle[PERF_PHASE_WORK],
+                             instructions_per_cycle[PERF_PHASE_WRITING_BUFFER],
+                             instructions_per_cycle[PERF_PHASE_RENDER],
+                             instructions_per_cycle[PERF_PHASE_SLEEP],
+                             (unsigned long long)global_perf_counters
+                                 .phase_values[PERF_PHASE_WORK][PERF_COUNTER_CACHE_MISSES]);
+                }
+            }
+
+            if (global_capture_context.is_capturing)
+            {  // Capture
+                if (global_debug_counter == 0)
+                {
+                    log_info(", Capture ms: %.04f (avg %.04f, max %.04f), skip: %u, dropped: %u",
+                             global_capture_context.last_frame_cost_ms,
+                             global_capture_context.average_frame_cost_ms,
+                             global_capture_context.max_frame_cost_ms,
+                             global_capture_context.frame_skip,
+                             global_capture_context.frames_dropped);
+                }
+            }
+
+            {  // Allocations
+                if (global_debug_counter == 0)
+                {
+                    char* phases = push_array(&global_transient_arena, DEBUG_TEXT_STRING_LENGTH, char);
+                    alloc_tracker_format_phases(phases, DEBUG_TEXT_STRING_LENGTH);
+                    log_info(", Allocs: %u (%llu B) [%s], other threads: %u",
+                             global_alloc_tracker.last_frame_total.allocations,
+                             (unsigned long long)global_alloc_tracker.last_frame_total.bytes,
+                             phases,
+                             global_alloc_tracker.last_frame_other_thread_allocations);
+                }
+            }
+
+            {  // Audio latency
+                if (global_debug_counter == 0)
+                {
+                    log_info(", Audio buffer: %d, latency ms: %.02f (max %.02f), underruns: %u, recommended buffer: %d",
+                             global_audio_latency_stats.buffer_samples,
+                             global_audio_latency_stats.average_latency_ms,
+                             global_audio_latency_stats.max_latency_ms,
+                             global_audio_latency_stats.underruns,
+                             audio_get_recommended_buffer_samples());
+                    log_info(", Voices: %u (max %u), stolen: %u, mix us: %.01f (max %.01f)",
+                             global_mixer.stats.active_voices,
+                             global_mixer.stats.max_active_voices,
+                             global_mixer.stats.voices_stolen,
+                             global_mixer.stats.last_mix_us,
+                             global_mixer.stats.max_mix_us);
+                }
+            }
+
+            {  // Autoplay
+                if (global_debug_counter == 0 && global_autoplayer.decision_count > 0)
+                {
+                    log_info(", Autoplay decision us: %.01f (max %.01f)",
+                             global_autoplayer.last_decision__microseconds,
+                             global_autoplayer.max_decision__microseconds);
+                }
+                if (global_debug_counter == 0 && global_mcts.stats.decision_count > 0)
+                {
+                    log_info(", MCTS rollouts/s: %.0f on %u workers, decision us: %.01f (max %.01f)",
+                             global_mcts.stats.rollouts_per_second,
+                             global_mcts.stats.worker_count,
+                             global_mcts.stats.last_decision__microseconds,
+                             global_mcts.stats.max_decision__microseconds);
+                }
+            }
+
+            if (global_rollback_session.sim)
+            {  // Rollback
+                if (global_debug_counter == 0)
+                {
+                    Rollback_Stats* stats = &global_rollback_session.stats;
+                    log_info(", Rollback frames: %u (max %u), resim us: %.01f (max %.01f), rtt ms: %.01f, stalls: %u",
+                             stats->last_rollback_frames,
+                             stats->max_rollback_frames,
+                             stats->last_resimulation__microseconds,
+                             stats->max_resimulation__microseconds,
+                             stats->round_trip__ms,
+                             stats->stall_count);
+                }
+            }
+
+            if (global_snake_arena.cells)
+            {  // Snake Arena
+                if (global_debug_counter == 0)
+                {
+                    Snake_Arena* arena = &global_snake_arena;
+                    log_info(", Arena snakes: %u/%u, tick us: %.01f (max %.01f), workers: %u",
+                             arena->alive_count,
+                             arena->snake_count,
+                             arena->last_tick__microseconds,
+                             arena->max_tick__microseconds,
+                             arena->pool.worker_count);
+                }
+            }
+
+            if (global_current_scene == &global_world_scene)
+            {  // World
+                if (global_debug_counter == 0)
+                {
+                    World__State* world_state = (World__State*)global_world_scene.state;
+                    log_info(", World chunks: %u (%zu KB), cull us: %.02f over %u chunks",
+                             global_world.chunk_count,
+                             world_get_chunk_bytes(&global_world) / 1024,
+                             world_state->last_cull__microseconds,
+                             world_state->last_visible_chunk_count);
+                }
+            }
+
+            if (global_particles.max_count > 0)
+            {  // Particles
+                if (global_debug_counter == 0)
+                {
+                    log_info(", Particles: %u (max %u), update us: %.01f (max %.01f), draw us: %.01f",
+                             global_particles.count,
+                             global_particles.max_count,
+                             global_particles.last_update__microseconds,
+                             global_particles.max_update__microseconds,
+                             global_particles.last_render__microseconds);
+                }
+            }
+
+            if (global_spectator_server.is_running)
+            {  // Spectators
+                if (global_debug_counter == 0)
+                {
+                    Spectator_Server* server = &global_spectator_server;
+                    log_info(", Spectators: %d, publish us: %.02f (max %.02f), dropped ticks: %u, resyncs: %d",
+                             SDL_AtomicGet(&server->client_count),
+                             server->publish_count ? server->total_publish__microseconds / server->publish_count : 0.0,
+                             server->max_publish__microseconds,
+                             server->ticks_dropped,
+                             SDL_AtomicGet(&server->resync_count));
+                }
+            }
+
+            {  // Logger
+                int32 records_dropped = SDL_AtomicGet(&global_logger.records_dropped);
+                if (global_debug_counter == 0 && records_dropped > 0)
+                {
+                    log_info(", Log records dropped: %d", records_dropped);
                 }
             }
 
             if (global_debug_counter == 0)
             {
-                printf("\n");
+                log_info("\n");
             }
 
 #if 0
@@ -425,44 +1089,63 @@ int32 main(int32 argc, char* argv[])
 #endif
         }
 
+        alloc_tracker_set_phase(ALLOC_PHASE_INPUT);
         {  // Input and event handling
             handle_input(&event, &input);
+            for (uint32 i = 0; i < BUTTON_COUNT; i++)
+            {
+                if (input.buttons[i].changed)
+                {
+                    flight_recorder_record_key(&global_flight_recorder, i, input.buttons[i].is_down);
+                }
+            }
             global_current_scene->handle_input(global_current_scene, &input);
         }
 
         {  // Scene Manager
             if (global_next_scene) {
+                timer_wheel_cancel_all(&global_simulation_timers);
                 global_current_scene = global_next_scene;
                 global_current_scene->reset_state(global_current_scene);
                 global_next_scene = 0;
+                particles_clear(&global_particles);
+                flight_recorder_record_marker(&global_flight_recorder, FLIGHT_MARKER_SCENE_CHANGE);
             }
         }
 
+        alloc_tracker_set_phase(ALLOC_PHASE_UPDATE);
+        uint32 simulation_steps = 0;
         { // Update Scene
             // Gameplay_State state_to_render;
             // https://gafferongames.com/post/fix_your_timestep/
-            real32 frame_time_s = master_timer.total_frame_time_elapsed__seconds;
+            Uint64 frame_counter_elapsed = master_timer.total_frame_counter_elapsed;
 
-            if (frame_time_s > 0.25f)
+            if (frame_counter_elapsed > master_timer.COUNTER_FREQUENCY / 4)
             {
                 // Prevent "spiraling" (excessive frame accumulation) in case of a big lag spike.
-                frame_time_s = 0.25f;
+                frame_counter_elapsed = master_timer.COUNTER_FREQUENCY / 4;
             }
 
-            accumulator_s += frame_time_s;
+            simulation_accumulator += frame_counter_elapsed * SIMULATION_TICKS_PER_SECOND * SIMULATION_SPEED_MULTIPLIER;
 
-            while (accumulator_s >= SIMULATION_DELTA_TIME_S)
-            {  // Simulation 'consumes' whatever time is given to it based on the render rate
-                // previous_state = current_state;
-                global_current_scene->update(global_current_scene,
-                                      master_timer.physics_simulation_elapsed_time__seconds,
-                                      SIMULATION_DELTA_TIME_S);
-                master_timer.physics_simulation_elapsed_time__seconds += SIMULATION_DELTA_TIME_S;
-                accumulator_s -= SIMULATION_DELTA_TIME_S;
+            // Simulation 'consumes' whatever time is given to it based on the render rate. Rather than stepping
+            // through every tick, jump straight from one scheduled event to the next.
+            uint64 tick_count = simulation_accumulator / master_timer.COUNTER_FREQUENCY;
+            simulation_steps = (uint32)tick_count;
+            simulation_accumulator -= tick_count * master_timer.COUNTER_FREQUENCY;
+            timer_wheel_advance(&global_simulation_timers, global_simulation_timers.current_tick + tick_count);
+
+            global_current_scene->update(global_current_scene, global_simulation_timers.current_tick);
+
+            // Particles are only for show, so they run on the frame clock rather than the simulation clock
+            if (PARTICLE_STRESS_COUNT && global_current_scene == &global_gameplay_scene)
+            {
+                particles_top_up(&global_particles, PARTICLE_STRESS_COUNT);
             }
+            particles_update(&global_particles, LAST_total_frame_time_elapsed__seconds);
 
             // TODO: we can do some interpolation here if we ever need to make the rendering a bit smoother
-            // real32 alpha = accumulator_s / SIMULATION_DELTA_TIME_S;
+            // real32 alpha = (real32)simulation_accumulator / master_timer.COUNTER_FREQUENCY;
             // Interpolate between the current state and previous state
             // NOTE: the render always lags by about a frame
 
@@ -474,6 +1157,7 @@ int32 main(int32 argc, char* argv[])
 //==============================
 // TIMING
         Uint64 counter_after_work = SDL_GetPerformanceCounter();
+        perf_counters_end_phase(&global_perf_counters, PERF_PHASE_WORK);
         master_timer.time_elapsed_for_work__seconds =
             ((real32)(counter_after_work - counter_now) / (real32)master_timer.COUNTER_FREQUENCY);
 //==============================
@@ -483,82 +1167,22 @@ int32 main(int32 argc, char* argv[])
             SDL_SetRenderDrawColor(global_renderer, 0, 0, 0, 255);  // Black background
             SDL_RenderClear(global_renderer);
 
+            alloc_tracker_set_phase(ALLOC_PHASE_RENDER);
             global_current_scene->render(global_current_scene);
 
+            // Grab the frame before the debug overlay gets drawn on top of it
+            capture_read_frame();
+            alloc_tracker_set_phase(ALLOC_PHASE_DEBUG);
+
 #if 1 // Render Debug Info
             if (global_display_debug_info)
             {
-                // TODO: remove this when changing the win32 stuff
-                SDL_Color debug_text_color = {255, 255, 255, 255};  // White color
-                real32 font_size = 16.0f;
-                int32 pt_size = (int32)(0.5f + font_size * global_text_dpi_scale_factor);
-                real32 y_offset = 0;
-                real32 padding = 5.0f;
-                real32 font_height;
-                real32 vertical_offset;
-
-#ifdef __WIN32__
-                { // Mega Cycles Per Frame
-                    real64 mega_cycles_per_frame = global_total_cycles_elapsed / (1000.0f * 1000.0f);
-
-                    if (global_debug_counter == 0)
-                    {
-                        snprintf(mega_cycles_text,
-                                 sizeof(mega_cycles_text),
-                                 "Mega cycles/Frame: %.02f",
-                                 mega_cycles_per_frame);
-                    }
-
-                    render_text_no_scaling(mega_cycles_text,
-                                           (int32)(LOGICAL_WIDTH * 0.01f),
-                                           (int32)y_offset + (int32)(LOGICAL_HEIGHT * 0.01f),
-                                           debug_text_color);
-                    y_offset += vertical_offset;
-                }
-
-                { // Work Cycles Per Frame
-                    real64 mega_cycles_for_actual_work = global_cycles_elapsed_before_render / (1000.0f * 1000.0f);
-
-                    if (global_debug_counter == 0)
-                    {
-                        snprintf(actual_mega_cycles_text,
-                                 sizeof(actual_mega_cycles_text),
-                                 "Work mega cycles/Frame: %.02f",
-                                 mega_cycles_for_actual_work);
-                    }
-
-                    render_text_no_scaling(actual_mega_cycles_text,
-                                           (int32)(LOGICAL_WIDTH * 0.01f),
-                                           (int32)y_offset + (int32)(LOGICAL_HEIGHT * 0.01f),
-                                           debug_text_color);
-                    y_offset += vertical_offset;
-                }
-
-                { // Render Cycles Per Frame
-                    real64 mega_cycles_for_render = global_cycles_elapsed_after_render / (1000.0f * 1000.0f);
-
-                    if (global_debug_counter == 0)
-                    {
-                        snprintf(render_mega_cycles_text,
-                                 sizeof(render_mega_cycles_text),
-                                 "Render mega cycles/Frame: %.02f",
-                                 mega_cycles_for_render);
-                    }
-
-                    render_text_no_scaling(render_mega_cycles_text,
-                                           (int32)(LOGICAL_WIDTH * 0.01f),
-                                           (int32)y_offset + (int32)(LOGICAL_HEIGHT * 0.01f),
-                                           debug_text_color);
-                    y_offset += vertical_offset;
-                }
-#endif
-
                 { // FPS
                     real32 fps = 1.0f / LAST_total_frame_time_elapsed__seconds;
 
                     if (global_debug_counter == 0)
                     {
-                        snprintf(fps_text, sizeof(fps_text), "FPS: %.02f", fps);
+                        snprintf(fps_text, DEBUG_TEXT_STRING_LENGTH, "FPS: %.02f", fps);
                     }
 
                     draw_text_real32(&fps_drawn_text, fps);
@@ -570,7 +1194,7 @@ int32 main(int32 argc, char* argv[])
                     if (global_debug_counter == 0)
                     {
                         snprintf(ms_per_frame_text,
-                                 sizeof(ms_per_frame_text),
+                                 DEBUG_TEXT_STRING_LENGTH,
                                  "Ms/frame: %.04f (Target: %.04f)",
                                  ms_per_frame,
                                  TARGET_TIME_PER_FRAME_MS);
@@ -585,7 +1209,7 @@ int32 main(int32 argc, char* argv[])
                     if (global_debug_counter == 0)
                     {
                         snprintf(work_ms_per_frame_text,
-                                 sizeof(work_ms_per_frame_text),
+                                 DEBUG_TEXT_STRING_LENGTH,
                                  "Work ms: %.04f, (%.1f%%)",
                                  work_ms_per_frame,
                                  (work_ms_per_frame / ms_per_frame) * 100);
@@ -600,7 +1224,7 @@ int32 main(int32 argc, char* argv[])
                     if (global_debug_counter == 0)
                     {
                         snprintf(writing_buffer_ms_per_frame_text,
-                                 sizeof(writing_buffer_ms_per_frame_text),
+                                 DEBUG_TEXT_STRING_LENGTH,
                                  "Buffer ms: %.04f, (%.1f%%)",
                                  writing_buffer_ms_per_frame,
                                  (writing_buffer_ms_per_frame / ms_per_frame) * 100);
@@ -615,7 +1239,7 @@ int32 main(int32 argc, char* argv[])
                     if (global_debug_counter == 0)
                     {
                         snprintf(render_ms_per_frame_text,
-                                 sizeof(render_ms_per_frame_text),
+                                 DEBUG_TEXT_STRING_LENGTH,
                                  "Render ms: %.04f, (%.1f%%)",
                                  render_ms_per_frame,
                                  (render_ms_per_frame / ms_per_frame) * 100);
@@ -630,7 +1254,7 @@ int32 main(int32 argc, char* argv[])
                     if (global_debug_counter == 0)
                     {
                         snprintf(sleep_ms_per_frame_text,
-                                 sizeof(sleep_ms_per_frame_text),
+                                 DEBUG_TEXT_STRING_LENGTH,
                                  "Sleep ms: %.04f, (%.1f%%)",
                                  sleep_ms_per_frame,
                                  (sleep_ms_per_frame / ms_per_frame) * 100);
@@ -638,6 +1262,337 @@ int32 main(int32 argc, char* argv[])
 
                     draw_text_real32(&sleep_ms_per_frame_drawn_text, sleep_ms_per_frame);
                 }
+
+                { // Hardware counters
+                    Perf_Counters* counters = &global_perf_counters;
+                    for (uint32 phase = 0; phase < perf_counters_row_count; phase++)
+                    {
+                        if (global_debug_counter == 0)
+                        {
+                            perf_counters_format_phase(
+                                counters, phase, perf_counters_texts[phase], DEBUG_TEXT_STRING_LENGTH);
+                        }
+
+                        draw_text_real32(&perf_counters_drawn_texts[phase],
+                                         (real32)counters->phase_values[phase][PERF_COUNTER_INSTRUCTIONS]);
+                    }
+                }
+
+                { // Capture
+                    real32 capture_ms_per_frame = global_capture_context.average_frame_cost_ms;
+
+                    if (global_debug_counter == 0)
+                    {
+                        if (global_capture_context.is_capturing)
+                        {
+                            snprintf(capture_text,
+                                     DEBUG_TEXT_STRING_LENGTH,
+                                     "Capture ms: %.04f (Budget: %.02f), skip: %u, dropped: %u",
+                                     capture_ms_per_frame,
+                                     CAPTURE_FRAME_BUDGET_MS,
+                                     global_capture_context.frame_skip,
+                                     global_capture_context.frames_dropped);
+                        }
+                        else
+                        {
+                            snprintf(capture_text, DEBUG_TEXT_STRING_LENGTH, "Capture: off (F9)");
+                        }
+                    }
+
+                    draw_text_real32(&capture_drawn_text, capture_ms_per_frame + global_capture_context.frames_dropped);
+                }
+
+                { // Allocations (last frame)
+                    Alloc_Stats* total = &global_alloc_tracker.last_frame_total;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(allocations_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Allocs/frame: %u (%llu B), frees: %u, other threads: %u%s",
+                                 total->allocations,
+                                 (unsigned long long)total->bytes,
+                                 total->frees,
+                                 global_alloc_tracker.last_frame_other_thread_allocations,
+                                 global_alloc_tracker.is_strict ? " [strict]" : "");
+                        alloc_tracker_format_phases(allocation_phases_text, DEBUG_TEXT_STRING_LENGTH);
+                    }
+
+                    draw_text_real32(&allocations_drawn_text, (real32)total->allocations);
+                    draw_text_real32(&allocation_phases_drawn_text, (real32)total->bytes);
+                }
+
+                { // Arenas
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(arenas_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Arenas KB: permanent %zu/%zu, transient peak %zu/%zu",
+                                 global_permanent_arena.used / 1024,
+                                 global_permanent_arena.size / 1024,
+                                 global_transient_arena.high_water_mark / 1024,
+                                 global_transient_arena.size / 1024);
+                    }
+
+                    draw_text_real32(&arenas_drawn_text,
+                                     (real32)(global_permanent_arena.used + global_transient_arena.high_water_mark));
+                }
+
+                { // Texture memory
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(textures_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Textures: %u, %llu/%llu KB, evicted: %u, lost: %u",
+                                 global_texture_manager.resident_count,
+                                 (unsigned long long)(global_texture_manager.resident_bytes / 1024),
+                                 (unsigned long long)(TEXTURE_MEMORY_BUDGET_BYTES / 1024),
+                                 global_texture_manager.evictions,
+                                 global_texture_manager.lost);
+                    }
+
+                    draw_text_real32(&textures_drawn_text, (real32)global_texture_manager.resident_bytes);
+                }
+
+                { // Audio latency
+                    Audio_Latency_Stats* stats = &global_audio_latency_stats;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(audio_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Audio buf: %d, latency ms: %.02f (max %.02f), underruns: %u, rec buf: %d",
+                                 stats->buffer_samples,
+                                 stats->average_latency_ms,
+                                 stats->max_latency_ms,
+                                 stats->underruns,
+                                 audio_get_recommended_buffer_samples());
+                    }
+
+                    draw_text_real32(&audio_drawn_text, stats->average_latency_ms + stats->underruns);
+                }
+
+                { // Mixer
+                    Mixer_Stats* stats = &global_mixer.stats;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(mixer_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Voices: %u (max %u), stolen: %u, dropped: %u, mix us: %.01f (max %.01f)",
+                                 stats->active_voices,
+                                 stats->max_active_voices,
+                                 stats->voices_stolen,
+                                 stats->commands_dropped,
+                                 stats->last_mix_us,
+                                 stats->max_mix_us);
+                    }
+
+                    draw_text_real32(&mixer_drawn_text, stats->last_mix_us + stats->active_voices);
+                }
+
+                { // Autoplay
+                    Gameplay__Autoplayer* autoplayer = &global_autoplayer;
+                    Gameplay__State* gameplay_state = (Gameplay__State*)global_gameplay_scene.state;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(autoplay_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Autoplay (tab): %s, decision us: %.01f (max %.01f), decisions: %llu",
+                                 gameplay_state->autopilot == gameplay__autoplay        ? "BFS"
+                                 : gameplay_state->autopilot == gameplay__mcts_autoplay ? "MCTS"
+                                                                                        : "off",
+                                 autoplayer->last_decision__microseconds,
+                                 autoplayer->max_decision__microseconds,
+                                 (unsigned long long)autoplayer->decision_count);
+                    }
+
+                    draw_text_real32(&autoplay_drawn_text,
+                                     autoplayer->last_decision__microseconds + autoplayer->decision_count);
+                }
+
+                { // MCTS
+                    Mcts_Stats* stats = &global_mcts.stats;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(mcts_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "MCTS: %u workers, %u rollouts/decision, %.0f rollouts/s, "
+                                 "decision us: %.01f (max %.01f)",
+                                 stats->worker_count,
+                                 stats->rollouts_per_decision,
+                                 stats->rollouts_per_second,
+                                 stats->last_decision__microseconds,
+                                 stats->max_decision__microseconds);
+                    }
+
+                    draw_text_real32(&mcts_drawn_text, stats->last_decision__microseconds + stats->decision_count);
+                }
+
+                if (global_rollback_session.sim)
+                { // Rollback
+                    Rollback_Session* session = &global_rollback_session;
+                    Rollback_Stats* stats = &session->stats;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(rollback_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Rollback: frame %u, %u ahead, depth %u (max %u), resim us: %.01f (max %.01f), "
+                                 "rtt ms: %.01f, stalls: %u",
+                                 session->sim->frame,
+                                 session->sim->frame - session->remote_frame_count,
+                                 stats->last_rollback_frames,
+                                 stats->max_rollback_frames,
+                                 stats->last_resimulation__microseconds,
+                                 stats->max_resimulation__microseconds,
+                                 stats->round_trip__ms,
+                                 stats->stall_count);
+                    }
+
+                    draw_text_real32(&rollback_drawn_text,
+                                     stats->last_resimulation__microseconds + session->sim->frame);
+                }
+
+                if (global_snake_arena.cells)
+                { // Snake Arena
+                    Snake_Arena* arena = &global_snake_arena;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(snake_arena_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Arena: %u/%u alive, tick us: %.01f (avg %.01f, max %.01f), %u workers, %llu eaten",
+                                 arena->alive_count,
+                                 arena->snake_count,
+                                 arena->last_tick__microseconds,
+                                 arena->tick_count ? arena->total_tick__microseconds / arena->tick_count : 0.0,
+                                 arena->max_tick__microseconds,
+                                 arena->pool.worker_count,
+                                 (unsigned long long)arena->blips_eaten);
+                    }
+
+                    draw_text_real32(&snake_arena_drawn_text, arena->last_tick__microseconds + arena->tick);
+                }
+
+                if (global_current_scene == &global_world_scene)
+                { // World
+                    World__State* world_state = (World__State*)global_world_scene.state;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(world_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "World: %dx%d, camera %d,%d, %u chunks (%zu KB), cull us: %.02f over %u chunks",
+                                 global_world.width,
+                                 global_world.height,
+                                 world_state->camera.x,
+                                 world_state->camera.y,
+                                 global_world.chunk_count,
+                                 world_get_chunk_bytes(&global_world) / 1024,
+                                 world_state->last_cull__microseconds,
+                                 world_state->last_visible_chunk_count);
+                    }
+
+                    draw_text_real32(&world_drawn_text,
+                                     world_state->last_cull__microseconds + global_world.chunk_count);
+                }
+
+                { // Particles
+                    Particles* particles = &global_particles;
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(particles_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Particles: %u/%u, dropped: %u, update us: %.01f (max %.01f), draw us: %.01f",
+                                 particles->count,
+                                 particles->capacity,
+                                 particles->dropped,
+                                 particles->last_update__microseconds,
+                                 particles->max_update__microseconds,
+                                 particles->last_render__microseconds);
+                    }
+
+                    draw_text_real32(&particles_drawn_text, particles->last_update__microseconds + particles->count);
+                }
+
+                { // Logger
+                    Logger* logger = &global_logger;
+                    int32 records_dropped = SDL_AtomicGet(&logger->records_dropped);
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(log_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Log: %u written, dropped: %d, backlog: %u/%u, drain us: %.01f (max %.01f)",
+                                 logger->records_written,
+                                 records_dropped,
+                                 logger->max_backlog,
+                                 LOG_RING_SIZE,
+                                 logger->last_drain__microseconds,
+                                 logger->max_drain__microseconds);
+                    }
+
+                    draw_text_real32(&log_drawn_text, (real32)(logger->records_written + records_dropped));
+                }
+
+                { // Flight recorder
+                    Flight_Recorder* recorder = &global_flight_recorder;
+
+                    if (global_debug_counter == 0 && recorder->records)
+                    {
+                        // The oldest record still in the ring to the frame that's running now
+                        uint64 oldest = recorder->write_index > FLIGHT_RECORDER_RECORD_COUNT
+                                            ? recorder->write_index - FLIGHT_RECORDER_RECORD_COUNT
+                                            : 0;
+                        Flight_Record* oldest_record = &recorder->records[oldest & (FLIGHT_RECORDER_RECORD_COUNT - 1)];
+                        real32 seconds_kept =
+                            recorder->write_index
+                                ? (real32)(recorder->frame_counter - oldest_record->counter) /
+                                      (real32)recorder->counter_frequency
+                                : 0.0f;
+
+                        snprintf(flight_recorder_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Flight recorder: %llu records, last %.1f s kept, dumps (F7): %u, last dump ms: %.02f",
+                                 (unsigned long long)recorder->write_index,
+                                 seconds_kept,
+                                 recorder->dump_count,
+                                 recorder->last_dump__milliseconds);
+                    }
+
+                    draw_text_real32(&flight_recorder_drawn_text,
+                                     (real32)(recorder->write_index + recorder->dump_count));
+                }
+
+                if (global_spectator_server.is_running)
+                { // Spectators
+                    Spectator_Server* server = &global_spectator_server;
+                    int32 client_count = SDL_AtomicGet(&server->client_count);
+                    int32 resync_count = SDL_AtomicGet(&server->resync_count);
+
+                    if (global_debug_counter == 0)
+                    {
+                        snprintf(spectator_text,
+                                 DEBUG_TEXT_STRING_LENGTH,
+                                 "Spectators: %d on port %u, publish us: %.02f (max %.02f), %llu KB, dropped: %u, "
+                                 "resyncs: %d",
+                                 client_count,
+                                 server->port,
+                                 server->publish_count ? server->total_publish__microseconds / server->publish_count
+                                                       : 0.0,
+                                 server->max_publish__microseconds,
+                                 (unsigned long long)(server->bytes_published / 1024),
+                                 server->ticks_dropped,
+                                 resync_count);
+                    }
+
+                    draw_text_real32(&spectator_drawn_text,
+                                     (real32)(server->ticks_published + client_count + resync_count));
+                }
             }
 #endif
 
@@ -673,10 +1628,12 @@ int32 main(int32 argc, char* argv[])
 //==============================
 // TIMING
         Uint64 counter_after_writing_buffer = SDL_GetPerformanceCounter();
+        perf_counters_end_phase(&global_perf_counters, PERF_PHASE_WRITING_BUFFER);
         master_timer.time_elapsed_for_writing_buffer__seconds =
             ((real32)(counter_after_writing_buffer - counter_after_work) / (real32)master_timer.COUNTER_FREQUENCY);
 //==============================
 
+        alloc_tracker_set_phase(ALLOC_PHASE_PRESENT);
         { // Present the rendered content (Will block for vsync)
             SDL_RenderPresent(global_renderer);
         }
@@ -684,15 +1641,13 @@ int32 main(int32 argc, char* argv[])
 //==============================
 // TIMING
 
-#ifdef __WIN32__
-        uint64 global_cycle_count_after_render = __rdtsc();
-        global_cycles_elapsed_after_render = global_cycle_count_after_render - global_cycle_count_now;
-#endif
         Uint64 counter_after_render = SDL_GetPerformanceCounter();
+        perf_counters_end_phase(&global_perf_counters, PERF_PHASE_RENDER);
         master_timer.time_elapsed_for_render__seconds =
             ((real32)(counter_after_render - counter_after_writing_buffer) / (real32)master_timer.COUNTER_FREQUENCY);
 //==============================
 
+        alloc_tracker_set_phase(ALLOC_PHASE_SLEEP);
 #if 1 // Sleep with busy-wait for precise timings
         {
             real64 TARGET_FRAME_DURATION__Millis = 1000 / TARGET_SCREEN_FPS;
@@ -733,25 +1688,68 @@ int32 main(int32 argc, char* argv[])
 //==============================
 // TIMING
 
-#ifdef __WIN32__
-        uint64 global_end_cycle_count_after_delay = __rdtsc();
-        global_total_cycles_elapsed = global_end_cycle_count_after_delay - global_last_cycle_count;
-#endif
         Uint64 counter_after_sleep = SDL_GetPerformanceCounter();
+        perf_counters_end_phase(&global_perf_counters, PERF_PHASE_SLEEP);
         master_timer.time_elapsed_for_sleep__seconds =
             ((real32)(counter_after_sleep - counter_after_render) / (real32)master_timer.COUNTER_FREQUENCY);
         master_timer.total_frame_time_elapsed__seconds =
             ((real32)(counter_after_sleep - counter_now) / (real32)master_timer.COUNTER_FREQUENCY);
+        master_timer.total_frame_counter_elapsed = counter_after_sleep - counter_now;
+        flight_recorder_record_frame(&global_flight_recorder,
+                                     counter_now,
+                                     counter_after_work,
+                                     counter_after_writing_buffer,
+                                     counter_after_render,
+                                     counter_after_sleep);
 
         // Next iteration
         master_timer.last_frame_counter = counter_after_sleep;
-#ifdef __WIN32__
-        global_last_cycle_count = global_end_cycle_count_after_delay;
-#endif
+        alloc_tracker_end_frame();
+
+        {  // Live metrics
+            Live_Metrics_Frame frame = {};
+            frame.frame_index = global_flight_recorder.frame_index;
+            frame.frame__ms = master_timer.total_frame_time_elapsed__seconds * 1000.0f;
+            frame.work__ms = master_timer.time_elapsed_for_work__seconds * 1000.0f;
+            frame.writing_buffer__ms = master_timer.time_elapsed_for_writing_buffer__seconds * 1000.0f;
+            frame.render__ms = master_timer.time_elapsed_for_render__seconds * 1000.0f;
+            frame.sleep__ms = master_timer.time_elapsed_for_sleep__seconds * 1000.0f;
+            frame.target_frame__ms = TARGET_TIME_PER_FRAME_MS;
+            frame.simulation_tick = global_simulation_timers.current_tick;
+            frame.simulation_steps = simulation_steps;
+            frame.score = -1;
+            if (global_current_scene == &global_gameplay_scene)
+            {
+                frame.score = (int32)((Gameplay__State*)global_gameplay_scene.state)->sim->length - 1;
+            }
+            else if (global_current_scene == &global_world_scene)
+            {
+                frame.score = (int32)global_world.length - 1;
+            }
+            frame.allocations = global_alloc_tracker.last_frame_total.allocations;
+            frame.other_thread_allocations = global_alloc_tracker.last_frame_other_thread_allocations;
+            frame.allocation_bytes = global_alloc_tracker.last_frame_total.bytes;
+            frame.hardware_counter_mask = global_perf_counters.is_available ? global_perf_counters.open_mask : 0;
+            frame.is_hardware_counter_multiplexed = global_perf_counters.is_multiplexed;
+            memcpy(frame.hardware_counters, global_perf_counters.phase_values, sizeof(frame.hardware_counters));
+            live_metrics_publish(&global_live_metrics, &frame);
+        }
 //==============================
     } // end while (global_running)
 
+    live_metrics_close(&global_live_metrics);
+    perf_counters_close(&global_perf_counters);
+    log_stop(&global_logger);
+    capture_stop();
+    mcts_shutdown(&global_mcts);
+    rollback_session_shutdown(&global_rollback_session);
+    spectator_server_stop(&global_spectator_server);
+    snake_arena_shutdown(&global_snake_arena);
+    texture_manager_cleanup();
     cleanup_fonts();
+    audio_cleanup(&global_audio_context);
+    // Fonts and music read from the pack, so it has to go last
+    asset_pack_close();
     SDL_DestroyRenderer(global_renderer);
     SDL_DestroyWindow(global_window);
     TTF_Quit();
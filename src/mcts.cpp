@@ -0,0 +1,385 @@
+#include <SDL2/SDL.h>
+#include <math.h>
+
+#include "snake_sim.h"
+
+// Monte Carlo tree search over Snake_Sim, root parallel: every worker grows its own tree from the same root for its
+// share of the rollouts, then the root visit counts get added up and the most visited move wins. The workers share
+// nothing while they search, so it scales with the cores.
+//
+// Nodes don't hold a sim. Each rollout clones the root into the worker's scratch sim and replays the moves down the
+// tree, which for a sim under a kilobyte is cheaper than keeping thousands of them around. The blips come out of the
+// sim's own random state, so the rollouts see the same blips the game will; only the moves are random.
+
+#define MCTS_MAX_WORKERS WORKER_POOL_MAX_WORKERS
+#define MCTS_MAX_NODES_PER_WORKER 16384
+#define MCTS_ROLLOUT_DEPTH 32
+#define MCTS_EXPLORATION 1.0f
+
+struct Mcts_Node
+{
+    int32 parent;
+    int32 first_child;  // -1 until expanded
+    uint32 visit_count;
+    real32 total_reward;
+    uint8 child_count;
+    uint8 move;  // Direction that got here from the parent
+};
+
+struct Mcts_Worker
+{
+    Mcts_Node* nodes;
+    uint32 node_count;
+    Snake_Sim* sim;
+    uint32 random_state;
+
+    uint32 rollout_count;
+    uint32 root_visit_counts[DIRECTION_WEST + 1];
+    real32 root_rewards[DIRECTION_WEST + 1];
+
+    uint8 padding[64];  // Keeps the counters of neighbouring workers off the same cache line
+};
+
+struct Mcts_Stats
+{
+    uint32 worker_count;
+    uint32 rollouts_per_decision;
+    uint64 decision_count;
+    real32 last_decision__microseconds;
+    real32 max_decision__microseconds;
+    real64 rollouts_per_second;  // Over the last decision
+};
+
+struct Mcts
+{
+    Worker_Pool pool;
+    Mcts_Worker workers[MCTS_MAX_WORKERS];
+
+    // Set for each decision
+    const Snake_Sim* root;
+    uint32 rollouts_per_worker;
+
+    Mcts_Stats stats;
+};
+
+Mcts global_mcts;
+
+// One worker per core unless worker_count says otherwise. The scratch sims are sized for width x height.
+void mcts_init(Mcts* mcts, Memory_Arena* arena, uint32 worker_count, int32 width, int32 height)
+{
+    worker_pool_init(&mcts->pool, worker_count);
+
+    uint32 sim_size = snake_sim_size(width, height);
+    for (uint32 i = 0; i < mcts->pool.worker_count; i++)
+    {
+        Mcts_Worker* worker = &mcts->workers[i];
+        *worker = {};
+        worker->nodes = push_array(arena, MCTS_MAX_NODES_PER_WORKER, Mcts_Node);
+        worker->sim = (Snake_Sim*)push_size(arena, sim_size, 64);
+        snake_sim_init(worker->sim, width, height, 0);
+        worker->random_state = 0x9E3779B9u * (i + 1);
+    }
+
+    mcts->stats = {};
+    mcts->stats.worker_count = mcts->pool.worker_count;
+}
+
+void mcts_shutdown(Mcts* mcts)
+{
+    worker_pool_shutdown(&mcts->pool);
+}
+
+local_internal uint32 mcts_random(uint32* random_state)
+{
+    // xorshift32, each worker has its own
+    uint32 x = *random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *random_state = x;
+    return x;
+}
+
+local_internal bool32 mcts_is_move_safe(Snake_Sim* sim, Direction move)
+{
+    int32 x = sim->head_x;
+    int32 y = sim->head_y;
+    snake_sim_move(move, &x, &y);
+    return snake_sim_is_inside(sim, x, y) &&
+           (!snake_sim_is_occupied(sim, x, y) || (x == sim->tail_x && y == sim->tail_y));
+}
+
+local_internal real32 mcts_get_eating_reward(uint32 depth)
+{
+    return 1.0f - 0.5f * (real32)SDL_min(depth, MCTS_ROLLOUT_DEPTH) / MCTS_ROLLOUT_DEPTH;
+}
+
+// Plays random moves from depth on, avoiding the ones that crash straight away when it can. Scores 0 for dying and
+// otherwise 0.5 to 1 depending on how soon the snake ate, or for not eating, up to 0.5 for getting closer to the blip.
+local_internal real32 mcts_rollout(Mcts_Worker* worker, Snake_Sim* sim, uint32 depth, int32 blip_distance_at_root)
+{
+    for (; depth < MCTS_ROLLOUT_DEPTH && !sim->is_game_over; depth++)
+    {
+        Direction moves[3];
+        uint32 move_count = 0;
+        for (int32 move = DIRECTION_NORTH; move <= DIRECTION_WEST; move++)
+        {
+            if (move != snake_sim_get_opposite((Direction)sim->direction) && mcts_is_move_safe(sim, (Direction)move))
+            {
+                moves[move_count++] = (Direction)move;
+            }
+        }
+
+        Direction move = (Direction)sim->direction;
+        if (move_count > 0)
+        {
+            move = moves[mcts_random(&worker->random_state) % move_count];
+        }
+
+        if (snake_sim_step(sim, move) & SNAKE_SIM_ATE)
+        {
+            return sim->is_game_over && !sim->has_filled_board ? 0.0f : mcts_get_eating_reward(depth);
+        }
+    }
+
+    if (sim->is_game_over)
+    {
+        return sim->has_filled_board ? 1.0f : 0.0f;
+    }
+
+    int32 blip_distance = abs(sim->head_x - sim->blip_x) + abs(sim->head_y - sim->blip_y);
+    real32 closer = (real32)(blip_distance_at_root - blip_distance) / (2 * MCTS_ROLLOUT_DEPTH);
+    return SDL_clamp(0.25f + closer, 0.0f, 0.5f);
+}
+
+local_internal void mcts_search(void* data, uint32 worker_index)
+{
+    Mcts* mcts = (Mcts*)data;
+    Mcts_Worker* worker = &mcts->workers[worker_index];
+    Snake_Sim* sim = worker->sim;
+
+    const Snake_Sim* root = mcts->root;
+    int32 blip_distance_at_root = abs(root->head_x - root->blip_x) + abs(root->head_y - root->blip_y);
+
+    worker->node_count = 1;
+    worker->nodes[0] = {};
+    worker->nodes[0].parent = -1;
+    worker->nodes[0].first_child = -1;
+
+    for (uint32 rollout = 0; rollout < mcts->rollouts_per_worker; rollout++)
+    {
+        snake_sim_clone(sim, root);
+        uint32 depth = 0;
+        int32 node_index = 0;
+        int32 eaten_at_depth = -1;
+
+        // Selection: walk down by UCB1 until reaching a node that hasn't been expanded
+        while (worker->nodes[node_index].first_child >= 0 && !sim->is_game_over)
+        {
+            Mcts_Node* node = &worker->nodes[node_index];
+            real32 log_visits = logf((real32)node->visit_count + 1.0f);
+
+            int32 best_child = -1;
+            real32 best_score = -1.0f;
+            for (int32 child_index = node->first_child; child_index < node->first_child + node->child_count;
+                 child_index++)
+            {
+                Mcts_Node* child = &worker->nodes[child_index];
+                if (child->visit_count == 0)
+                {
+                    best_child = child_index;
+                    break;
+                }
+                real32 score = child->total_reward / child->visit_count +
+                               MCTS_EXPLORATION * sqrtf(log_visits / child->visit_count);
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best_child = child_index;
+                }
+            }
+
+            node_index = best_child;
+            if ((snake_sim_step(sim, (Direction)worker->nodes[node_index].move) & SNAKE_SIM_ATE) && eaten_at_depth < 0)
+            {
+                eaten_at_depth = (int32)depth;
+            }
+            depth++;
+        }
+
+        // Expansion: the three ways the snake can turn (never straight back)
+        Mcts_Node* leaf = &worker->nodes[node_index];
+        if (!sim->is_game_over && leaf->visit_count > 0 && worker->node_count + 3 <= MCTS_MAX_NODES_PER_WORKER)
+        {
+            leaf->first_child = (int32)worker->node_count;
+            for (int32 move = DIRECTION_NORTH; move <= DIRECTION_WEST; move++)
+            {
+                if (move != snake_sim_get_opposite((Direction)sim->direction))
+                {
+                    Mcts_Node* child = &worker->nodes[worker->node_count++];
+                    *child = {};
+                    child->parent = node_index;
+                    child->first_child = -1;
+                    child->move = (uint8)move;
+                    leaf->child_count++;
+                }
+            }
+
+            node_index = leaf->first_child;
+            if ((snake_sim_step(sim, (Direction)worker->nodes[node_index].move) & SNAKE_SIM_ATE) && eaten_at_depth < 0)
+            {
+                eaten_at_depth = (int32)depth;
+            }
+            depth++;
+        }
+
+        // Eating on the way down the tree already decides the reward, as long as the snake lived through it
+        real32 reward;
+        if (sim->is_game_over && !sim->has_filled_board)
+        {
+            reward = 0.0f;
+        }
+        else if (eaten_at_depth >= 0)
+        {
+            reward = mcts_get_eating_reward((uint32)eaten_at_depth);
+        }
+        else
+        {
+            reward = mcts_rollout(worker, sim, depth, blip_distance_at_root);
+        }
+
+        for (int32 index = node_index; index >= 0; index = worker->nodes[index].parent)
+        {
+            worker->nodes[index].visit_count++;
+            worker->nodes[index].total_reward += reward;
+        }
+    }
+
+    worker->rollout_count = mcts->rollouts_per_worker;
+    SDL_memset(worker->root_visit_counts, 0, sizeof(worker->root_visit_counts));
+    SDL_memset(worker->root_rewards, 0, sizeof(worker->root_rewards));
+
+    Mcts_Node* root_node = &worker->nodes[0];
+    for (int32 child_index = root_node->first_child;
+         child_index >= 0 && child_index < root_node->first_child + root_node->child_count;
+         child_index++)
+    {
+        Mcts_Node* child = &worker->nodes[child_index];
+        worker->root_visit_counts[child->move] = child->visit_count;
+        worker->root_rewards[child->move] = child->total_reward;
+    }
+}
+
+// Searches with rollout_count rollouts split over active_worker_count workers (0 for all of them) and returns the
+// move to make from root
+Direction mcts_decide(Mcts* mcts, const Snake_Sim* root, uint32 rollout_count, uint32 active_worker_count)
+{
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    if (active_worker_count == 0 || active_worker_count > mcts->pool.worker_count)
+    {
+        active_worker_count = mcts->pool.worker_count;
+    }
+
+    mcts->root = root;
+    mcts->rollouts_per_worker = SDL_max(rollout_count / active_worker_count, 1);
+    worker_pool_run(&mcts->pool, mcts_search, mcts, active_worker_count);
+
+    uint32 visit_counts[DIRECTION_WEST + 1] = {};
+    real32 rewards[DIRECTION_WEST + 1] = {};
+    for (uint32 i = 0; i < active_worker_count; i++)
+    {
+        for (int32 move = DIRECTION_NORTH; move <= DIRECTION_WEST; move++)
+        {
+            visit_counts[move] += mcts->workers[i].root_visit_counts[move];
+            rewards[move] += mcts->workers[i].root_rewards[move];
+        }
+    }
+
+    // Most visited, with the better average reward breaking ties
+    Direction best_move = (Direction)root->direction;
+    for (int32 move = DIRECTION_NORTH; move <= DIRECTION_WEST; move++)
+    {
+        if (visit_counts[move] > visit_counts[best_move] ||
+            (visit_counts[move] == visit_counts[best_move] && visit_counts[move] > 0 &&
+             rewards[move] / visit_counts[move] > rewards[best_move] / visit_counts[best_move]))
+        {
+            best_move = (Direction)move;
+        }
+    }
+
+    real64 elapsed__seconds =
+        (real64)(SDL_GetPerformanceCounter() - start_counter) / (real64)SDL_GetPerformanceFrequency();
+
+    Mcts_Stats* stats = &mcts->stats;
+    stats->worker_count = active_worker_count;
+    stats->rollouts_per_decision = mcts->rollouts_per_worker * active_worker_count;
+    stats->decision_count++;
+    stats->last_decision__microseconds = (real32)(elapsed__seconds * 1000000.0);
+    stats->max_decision__microseconds = SDL_max(stats->max_decision__microseconds, stats->last_decision__microseconds);
+    stats->rollouts_per_second = elapsed__seconds > 0 ? stats->rollouts_per_decision / elapsed__seconds : 0;
+
+    return best_move;
+}
+
+// --bench-mcts: plays decision_count moves with rollout_count rollouts each on 1, 2, 4... workers up to one per core
+// and reports the rollouts per second, and the speed-up over one worker
+int32 mcts_run_benchmark(Mcts* mcts, Memory_Arena* arena, uint32 rollout_count, uint32 decision_count)
+{
+    int32 width = mcts->workers[0].sim->width;
+    int32 height = mcts->workers[0].sim->height;
+    Snake_Sim* sim = (Snake_Sim*)push_size(arena, snake_sim_size(width, height), 64);
+
+    printf("MCTS benchmark: %dx%d board, %u rollouts per decision, %u decisions, up to %u workers\n",
+           width,
+           height,
+           rollout_count,
+           decision_count,
+           mcts->pool.worker_count);
+
+    real64 single_worker_rollouts_per_second = 0;
+    for (uint32 worker_count = 1;; worker_count = SDL_min(worker_count * 2, mcts->pool.worker_count))
+    {
+        // Same seed every time, so every worker count plays the same blips
+        snake_sim_init(sim, width, height, 12345);
+        uint32 game_count = 1;
+        uint32 best_score = 0;
+
+        mcts->stats.max_decision__microseconds = 0;
+        uint64 total_rollouts = 0;
+        uint64 start_counter = SDL_GetPerformanceCounter();
+        for (uint32 decision = 0; decision < decision_count; decision++)
+        {
+            if (sim->is_game_over)
+            {
+                snake_sim_reset(sim);
+                game_count++;
+            }
+            snake_sim_step(sim, mcts_decide(mcts, sim, rollout_count, worker_count));
+            total_rollouts += mcts->stats.rollouts_per_decision;
+            best_score = SDL_max(best_score, sim->length - 1);
+        }
+        real64 elapsed__seconds =
+            (real64)(SDL_GetPerformanceCounter() - start_counter) / (real64)SDL_GetPerformanceFrequency();
+
+        real64 rollouts_per_second = elapsed__seconds > 0 ? total_rollouts / elapsed__seconds : 0;
+        if (worker_count == 1)
+        {
+            single_worker_rollouts_per_second = rollouts_per_second;
+        }
+        printf("  %2u workers: %.0f rollouts/s (%.2fx), %.1f us per decision (max %.1f), %u games, best score %u\n",
+               worker_count,
+               rollouts_per_second,
+               single_worker_rollouts_per_second > 0 ? rollouts_per_second / single_worker_rollouts_per_second : 0.0,
+               elapsed__seconds * 1000000.0 / SDL_max(decision_count, 1),
+               mcts->stats.max_decision__microseconds,
+               game_count,
+               best_score);
+
+        if (worker_count == mcts->pool.worker_count)
+        {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+// Linear allocators for everything that would otherwise live on the heap (or worse, on some function's stack). The
+// permanent arena holds data that lives as long as the program (scene state, text buffers). The transient arena is
+// cleared at the start of every frame.
+
+struct Memory_Arena
+{
+    const char* name;
+    uint8* base;
+    size_t size;
+    size_t used;
+    size_t high_water_mark;
+    bool32 has_huge_pages;
+};
+
+// Lets callers give back everything they pushed since the marker was taken
+struct Arena_Marker
+{
+    Memory_Arena* arena;
+    size_t used;
+};
+
+Memory_Arena global_permanent_arena;
+Memory_Arena global_transient_arena;
+
+#define push_struct(arena, type) (type*)push_size(arena, sizeof(type), alignof(type))
+#define push_array(arena, count, type) (type*)push_size(arena, (count) * sizeof(type), alignof(type))
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+local_internal size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Tries to get huge pages first (fewer TLB misses) and falls back to regular pages if the OS won't give us any
+local_internal void* platform_allocate_memory(size_t size, bool32 use_huge_pages, bool32* got_huge_pages)
+{
+    void* memory = NULL;
+    *got_huge_pages = false;
+
+#ifdef __WINDOWS__
+    if (use_huge_pages)
+    {
+        // NOTE: Needs the "Lock pages in memory" privilege, which most accounts don't have
+        SIZE_T large_page_size = GetLargePageMinimum();
+        if (large_page_size)
+        {
+            memory = VirtualAlloc(NULL,
+                                  align_up(size, large_page_size),
+                                  MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                  PAGE_READWRITE);
+            *got_huge_pages = memory != NULL;
+        }
+    }
+
+    if (!memory)
+    {
+        memory = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+#else
+#if defined(MAP_HUGETLB)
+    if (use_huge_pages)
+    {
+        memory = mmap(NULL,
+                      align_up(size, HUGE_PAGE_SIZE),
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                      -1,
+                      0);
+        if (memory == MAP_FAILED)
+        {
+            memory = NULL;
+        }
+        *got_huge_pages = memory != NULL;
+    }
+#elif defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+    if (use_huge_pages)
+    {
+        memory = mmap(NULL,
+                      align_up(size, HUGE_PAGE_SIZE),
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS,
+                      VM_FLAGS_SUPERPAGE_SIZE_2MB,
+                      0);
+        if (memory == MAP_FAILED)
+        {
+            memory = NULL;
+        }
+        *got_huge_pages = memory != NULL;
+    }
+#endif
+
+    if (!memory)
+    {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            memory = NULL;
+        }
+#if defined(MADV_HUGEPAGE)
+        else if (use_huge_pages)
+        {
+            // Transparent huge pages are only a hint
+            madvise(memory, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+#endif
+
+    return memory;
+}
+
+bool32 arena_init(Memory_Arena* arena, const char* name, size_t size, bool32 use_huge_pages, bool32 prefault)
+{
+    *arena = {};
+    arena->name = name;
+    arena->base = (uint8*)platform_allocate_memory(size, use_huge_pages, &arena->has_huge_pages);
+    if (!arena->base)
+    {
+        fprintf(stderr, "Failed to allocate %zu bytes for the %s arena\n", size, name);
+        return false;
+    }
+    arena->size = size;
+
+    if (prefault)
+    {
+        // Touch every page now so we never take a page fault in the middle of a frame
+        memset(arena->base, 0, size);
+    }
+
+    return true;
+}
+
+// Memory comes back zeroed
+void* push_size(Memory_Arena* arena, size_t size, size_t alignment = 16)
+{
+    size_t start = align_up(arena->used, alignment);
+    if (start + size > arena->size)
+    {
+        SDL_SetError("The %s arena is out of memory! Wanted %zu bytes, %zu of %zu are used",
+                     arena->name,
+                     size,
+                     arena->used,
+                     arena->size);
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        SDL_assert_release(start + size <= arena->size);
+        return NULL;
+    }
+
+    void* result = arena->base + start;
+    arena->used = start + size;
+    if (arena->used > arena->high_water_mark)
+    {
+        arena->high_water_mark = arena->used;
+    }
+
+    memset(result, 0, size);
+    return result;
+}
+
+void arena_reset(Memory_Arena* arena)
+{
+    arena->used = 0;
+}
+
+Arena_Marker arena_get_marker(Memory_Arena* arena)
+{
+    Arena_Marker marker = {};
+    marker.arena = arena;
+    marker.used = arena->used;
+    return marker;
+}
+
+void arena_reset_to_marker(Arena_Marker marker)
+{
+    SDL_assert(marker.used <= marker.arena->used);
+    marker.arena->used = marker.used;
+}
@@ -0,0 +1,292 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINIMAP_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define MINIMAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+// The whole world shrunk into a corner of the HUD. Every pixel covers a square of cells (8x8 at the least, more on
+// bigger worlds so the map stays under MINIMAP_MAX_SIZE) and gets brighter the more of the snake is in it.
+//
+// Only chunks on the world's dirty list get looked at, and never more than MINIMAP_MAX_CHUNKS_PER_FRAME of them, so a
+// frame costs about the same however many millions of cells there are. Each chunk's occupancy bits are counted an 8x8
+// block at a time, 16 bytes (two rows) per SIMD step, then the blocks get added up into pixels. Only the rows of the
+// texture that changed get uploaded.
+
+#define MINIMAP_MAX_SIZE 160  // Pixels along the longest side
+#define MINIMAP_MIN_SHIFT 3  // Never more than one pixel per 8x8 cells, the size of the counting blocks
+#define MINIMAP_MAX_CHUNKS_PER_FRAME 256  // The rest wait for the next frame
+#define MINIMAP_BLOCKS_PER_CHUNK (WORLD_CHUNK_SIZE / 8)
+
+#define MINIMAP_UNEXPLORED_COLOR 0xC0181818
+#define MINIMAP_EXPLORED_COLOR 0xC0303030  // Somewhere the snake has been (i.e. there's a chunk)
+
+struct Minimap
+{
+    int32 width;  // Pixels
+    int32 height;
+    int32 shift;  // Every pixel is 1 << shift cells across
+    uint32* pixels;  // ARGB, row 0 at the top like the texture
+    Texture_Id texture_id;
+
+    uint32 world_reset_count;  // Starts over when the world does
+    int32 first_changed_row;  // Rows of pixels that need uploading, first > last when there aren't any
+    int32 last_changed_row;
+
+    // Stats
+    uint32 last_chunk_count;  // Reduced in the last update
+    uint32 pending_chunk_count;  // Left over for the next one
+    real32 last_update__microseconds;
+    real32 max_update__microseconds;
+};
+
+// counts[block_y * 8 + block_x] is how much of the 8x8 block of cells is occupied
+local_internal void minimap_count_blocks(const uint64* rows, uint8* counts)
+{
+#if MINIMAP_SSE2
+    const __m128i mask_1 = _mm_set1_epi8(0x55);
+    const __m128i mask_2 = _mm_set1_epi8(0x33);
+    const __m128i mask_4 = _mm_set1_epi8(0x0F);
+    for (uint32 block_y = 0; block_y < MINIMAP_BLOCKS_PER_CHUNK; block_y++)
+    {
+        // Byte block_x of a row is the columns of block block_x, so counting bits per byte and adding up 8 rows
+        // counts 8 blocks at once. Two rows per register, folded together at the end.
+        __m128i sum = _mm_setzero_si128();
+        for (uint32 row = 0; row < 8; row += 2)
+        {
+            __m128i bits = _mm_loadu_si128((const __m128i*)(rows + block_y * 8 + row));
+            bits = _mm_sub_epi8(bits, _mm_and_si128(_mm_srli_epi16(bits, 1), mask_1));
+            bits = _mm_add_epi8(_mm_and_si128(bits, mask_2), _mm_and_si128(_mm_srli_epi16(bits, 2), mask_2));
+            bits = _mm_and_si128(_mm_add_epi8(bits, _mm_srli_epi16(bits, 4)), mask_4);
+            sum = _mm_add_epi8(sum, bits);
+        }
+        sum = _mm_add_epi8(sum, _mm_srli_si128(sum, 8));
+        _mm_storel_epi64((__m128i*)(counts + block_y * 8), sum);
+    }
+#elif MINIMAP_NEON
+    for (uint32 block_y = 0; block_y < MINIMAP_BLOCKS_PER_CHUNK; block_y++)
+    {
+        uint8x16_t sum = vdupq_n_u8(0);
+        for (uint32 row = 0; row < 8; row += 2)
+        {
+            sum = vaddq_u8(sum, vcntq_u8(vld1q_u8((const uint8*)(rows + block_y * 8 + row))));
+        }
+        vst1_u8(counts + block_y * 8, vadd_u8(vget_low_u8(sum), vget_high_u8(sum)));
+    }
+#else
+    for (uint32 block_y = 0; block_y < MINIMAP_BLOCKS_PER_CHUNK; block_y++)
+    {
+        for (uint32 block_x = 0; block_x < MINIMAP_BLOCKS_PER_CHUNK; block_x++)
+        {
+            uint32 count = 0;
+            for (uint32 row = 0; row < 8; row++)
+            {
+                count += count_set_bits((rows[block_y * 8 + row] >> (block_x * 8)) & 0xFF);
+            }
+            counts[block_y * 8 + block_x] = (uint8)count;
+        }
+    }
+#endif
+}
+
+void minimap_init(Minimap* minimap, World* world, Memory_Arena* arena)
+{
+    *minimap = {};
+    minimap->shift = MINIMAP_MIN_SHIFT;
+    while (((world->width - 1) >> minimap->shift) + 1 > MINIMAP_MAX_SIZE ||
+           ((world->height - 1) >> minimap->shift) + 1 > MINIMAP_MAX_SIZE)
+    {
+        minimap->shift++;
+    }
+    minimap->width = ((world->width - 1) >> minimap->shift) + 1;
+    minimap->height = ((world->height - 1) >> minimap->shift) + 1;
+    minimap->pixels = push_array(arena, (size_t)minimap->width * minimap->height, uint32);
+    minimap->world_reset_count = world->reset_count - 1;  // So the first update fills it in
+}
+
+local_internal void minimap_set_pixel(
+    Minimap* minimap, int32 x, int32 y, uint32 count, uint32 cell_count, bool32 is_explored)
+{
+    uint32 color = is_explored ? MINIMAP_EXPLORED_COLOR : MINIMAP_UNEXPLORED_COLOR;
+    if (count)
+    {
+        // Even one cell of snake shows up, and a pixel that's a quarter snake is as bright as it gets
+        uint32 brightness = 140 + 115 * SDL_min(count * 4, cell_count) / cell_count;
+        color = 0xFF000000 | (brightness << 16) | ((brightness * 2 / 5) << 8) | (brightness * 2 / 5);
+    }
+
+    int32 row = minimap->height - 1 - y;  // North is up
+    minimap->pixels[row * minimap->width + x] = color;
+    minimap->first_changed_row = SDL_min(minimap->first_changed_row, row);
+    minimap->last_changed_row = SDL_max(minimap->last_changed_row, row);
+}
+
+// Redoes every pixel the chunk covers. When pixels are bigger than chunks that means counting the neighbouring chunks
+// in the same pixel too.
+local_internal void minimap_reduce_chunk(Minimap* minimap, World* world, uint32 chunk_index)
+{
+    int32 chunk_x = (int32)(chunk_index % (uint32)world->chunk_columns);
+    int32 chunk_y = (int32)(chunk_index / (uint32)world->chunk_columns);
+    uint8 counts[MINIMAP_BLOCKS_PER_CHUNK * MINIMAP_BLOCKS_PER_CHUNK];
+
+    if (minimap->shift <= WORLD_CHUNK_SHIFT)
+    {
+        World_Chunk* chunk = world->chunks[chunk_index];
+        minimap_count_blocks(chunk->occupancy, counts);
+
+        int32 blocks_per_pixel = 1 << (minimap->shift - MINIMAP_MIN_SHIFT);
+        int32 pixels_per_chunk = MINIMAP_BLOCKS_PER_CHUNK / blocks_per_pixel;
+        uint32 cell_count = 1u << (minimap->shift * 2);
+        for (int32 pixel_y = 0; pixel_y < pixels_per_chunk; pixel_y++)
+        {
+            int32 y = chunk_y * pixels_per_chunk + pixel_y;
+            if (y >= minimap->height)
+            {
+                break;
+            }
+            for (int32 pixel_x = 0; pixel_x < pixels_per_chunk; pixel_x++)
+            {
+                int32 x = chunk_x * pixels_per_chunk + pixel_x;
+                if (x >= minimap->width)
+                {
+                    break;
+                }
+
+                uint32 count = 0;
+                for (int32 block_y = 0; block_y < blocks_per_pixel; block_y++)
+                {
+                    const uint8* row = counts + (pixel_y * blocks_per_pixel + block_y) * MINIMAP_BLOCKS_PER_CHUNK;
+                    for (int32 block_x = 0; block_x < blocks_per_pixel; block_x++)
+                    {
+                        count += row[pixel_x * blocks_per_pixel + block_x];
+                    }
+                }
+                minimap_set_pixel(minimap, x, y, count, cell_count, true);
+            }
+        }
+    }
+    else
+    {
+        int32 chunks_per_pixel = 1 << (minimap->shift - WORLD_CHUNK_SHIFT);
+        int32 x = chunk_x / chunks_per_pixel;
+        int32 y = chunk_y / chunks_per_pixel;
+
+        uint32 count = 0;
+        bool32 is_explored = false;
+        for (int32 neighbour_y = y * chunks_per_pixel;
+             neighbour_y < SDL_min((y + 1) * chunks_per_pixel, world->chunk_rows);
+             neighbour_y++)
+        {
+            for (int32 neighbour_x = x * chunks_per_pixel;
+                 neighbour_x < SDL_min((x + 1) * chunks_per_pixel, world->chunk_columns);
+                 neighbour_x++)
+            {
+                World_Chunk* chunk = world->chunks[neighbour_y * world->chunk_columns + neighbour_x];
+                if (chunk)
+                {
+                    is_explored = true;
+                    minimap_count_blocks(chunk->occupancy, counts);
+                    for (uint32 i = 0; i < SDL_arraysize(counts); i++)
+                    {
+                        count += counts[i];
+                    }
+                }
+            }
+        }
+        minimap_set_pixel(minimap, x, y, count, 1u << (minimap->shift * 2), is_explored);
+    }
+}
+
+// Catches up with the world's dirty chunks, as many as fit in this frame's budget
+void minimap_update(Minimap* minimap, World* world)
+{
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    if (minimap->world_reset_count != world->reset_count)
+    {
+        minimap->world_reset_count = world->reset_count;
+        for (int32 i = 0; i < minimap->width * minimap->height; i++)
+        {
+            minimap->pixels[i] = MINIMAP_UNEXPLORED_COLOR;
+        }
+        minimap->first_changed_row = 0;
+        minimap->last_changed_row = minimap->height - 1;
+    }
+
+    // Oldest last, which doesn't matter since everything on the list gets done sooner or later
+    uint32 chunk_count = 0;
+    while (world->dirty_chunk_count > 0 && chunk_count < MINIMAP_MAX_CHUNKS_PER_FRAME)
+    {
+        uint32 chunk_index = world->dirty_chunks[--world->dirty_chunk_count];
+        world->chunks[chunk_index]->is_dirty = false;
+        minimap_reduce_chunk(minimap, world, chunk_index);
+        chunk_count++;
+    }
+
+    minimap->last_chunk_count = chunk_count;
+    minimap->pending_chunk_count = world->dirty_chunk_count;
+    real32 update__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) * 1000000.0 /
+                                           (real64)SDL_GetPerformanceFrequency());
+    minimap->last_update__microseconds = update__microseconds;
+    minimap->max_update__microseconds = SDL_max(minimap->max_update__microseconds, update__microseconds);
+}
+
+// Uploads the rows that changed and draws the map at one texel per pixel with its top left at (x, y). camera is the
+// part of the world on screen, outlined on the map along with the head.
+void minimap_render(Minimap* minimap, World* world, Camera* camera, int32 columns, int32 rows, int32 x, int32 y)
+{
+    SDL_Texture* texture = texture_manager_use(minimap->texture_id);
+    if (!texture)
+    {
+        texture = SDL_CreateTexture(
+            global_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, minimap->width, minimap->height);
+        if (!texture)
+        {
+            log_error("Failed to create the minimap texture: %s\n", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        minimap->texture_id = texture_manager_set(minimap->texture_id, texture, "minimap");
+        minimap->first_changed_row = 0;
+        minimap->last_changed_row = minimap->height - 1;
+    }
+
+    if (minimap->first_changed_row <= minimap->last_changed_row)
+    {
+        SDL_Rect changed = {};
+        changed.y = minimap->first_changed_row;
+        changed.w = minimap->width;
+        changed.h = minimap->last_changed_row - minimap->first_changed_row + 1;
+        SDL_UpdateTexture(texture,
+                          &changed,
+                          minimap->pixels + (size_t)changed.y * minimap->width,
+                          minimap->width * (int32)sizeof(uint32));
+        minimap->first_changed_row = minimap->height;
+        minimap->last_changed_row = -1;
+    }
+
+    SDL_Rect map_rect = {x, y, minimap->width, minimap->height};
+    SDL_RenderCopy(global_renderer, texture, NULL, &map_rect);
+
+    // Top left of the camera on the map is its top row, since north is up
+    int32 cells_per_pixel = 1 << minimap->shift;
+    SDL_Rect view_rect = {};
+    view_rect.x = x + camera->x / cells_per_pixel;
+    view_rect.y = y + minimap->height - 1 - (camera->y + rows - 1) / cells_per_pixel;
+    view_rect.w = SDL_max(columns / cells_per_pixel, 2);
+    view_rect.h = SDL_max(rows / cells_per_pixel, 2);
+    SDL_SetRenderDrawColor(global_renderer, 200, 200, 200, 255);
+    SDL_RenderDrawRect(global_renderer, &view_rect);
+
+    SDL_Rect head_rect = {};
+    head_rect.x = x + world->head_x / cells_per_pixel - 1;
+    head_rect.y = y + minimap->height - 1 - world->head_y / cells_per_pixel - 1;
+    head_rect.w = 3;
+    head_rect.h = 3;
+    SDL_SetRenderDrawColor(global_renderer, 255, 255, 255, 255);
+    SDL_RenderFillRect(global_renderer, &head_rect);
+}
@@ -0,0 +1,423 @@
+#include "mixer.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIXER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)  // vcvtnq (round to nearest) is AArch64 only
+#define MIXER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define MIXER_COMMAND_QUEUE_SIZE 1024  // Must be a power of two
+#define MIXER_CHUNK_FRAMES 512         // Small enough that the accumulator stays in L1
+
+typedef enum
+{
+    MIXER_COMMAND_PLAY,
+    MIXER_COMMAND_STOP,
+    MIXER_COMMAND_SET_VOICE_GAIN,
+    MIXER_COMMAND_SET_MASTER_GAIN,
+} Mixer_Command_Type;
+
+struct Mixer_Command
+{
+    Mixer_Command_Type type;
+    Voice_Id voice_id;
+    Sound_Effect* effect;
+    real32 gain;
+    real32 rate;
+    Uint64 issued_counter;
+};
+
+#define MIXER_RATE_ONE ((uint64)1 << 32)
+
+struct Mixer_Voice
+{
+    Voice_Id id;
+    const int16* samples;
+    uint32 frame_count;
+    uint64 position;  // In frames, 32.32 fixed point
+    uint64 step;      // How far position moves per output frame. MIXER_RATE_ONE takes the fast path.
+    real32 gain;
+};
+
+struct Mixer
+{
+    // Single producer (game thread), single consumer (audio thread)
+    Mixer_Command commands[MIXER_COMMAND_QUEUE_SIZE];
+    SDL_atomic_t commands_produced;
+    SDL_atomic_t commands_consumed;
+    SDL_atomic_t commands_dropped;
+    Voice_Id next_voice_id;  // Game thread only
+
+    // Audio thread only. The playing voices are kept packed at the front.
+    Mixer_Voice voices[MIXER_MAX_VOICES];
+    uint32 voice_count;
+    real32 master_gain;
+    alignas(16) real32 accumulator[MIXER_CHUNK_FRAMES * 2];
+
+    Mixer_Stats stats;  // Written by the audio thread, read for the debug overlay
+};
+
+Mixer global_mixer;
+
+void mixer_init(void)
+{
+    global_mixer.master_gain = 1.0f;
+}
+
+local_internal bool32 mixer_push_command(Mixer_Command* command)
+{
+    Mixer* mixer = &global_mixer;
+
+    uint32 produced = (uint32)SDL_AtomicGet(&mixer->commands_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&mixer->commands_consumed);
+    SDL_MemoryBarrierAcquire();
+    if (produced - consumed >= MIXER_COMMAND_QUEUE_SIZE)
+    {
+        SDL_AtomicIncRef(&mixer->commands_dropped);
+        return false;
+    }
+
+    mixer->commands[produced & (MIXER_COMMAND_QUEUE_SIZE - 1)] = *command;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&mixer->commands_produced, (int)(produced + 1));
+    return true;
+}
+
+Voice_Id mixer_play(Sound_Effect* effect, real32 gain, real32 rate)
+{
+    if (!effect || !effect->samples || effect->frame_count == 0)
+    {
+        return 0;
+    }
+
+    Mixer* mixer = &global_mixer;
+    mixer->next_voice_id++;
+    if (mixer->next_voice_id == 0)
+    {
+        mixer->next_voice_id++;
+    }
+
+    Mixer_Command command = {};
+    command.type = MIXER_COMMAND_PLAY;
+    command.voice_id = mixer->next_voice_id;
+    command.effect = effect;
+    command.gain = gain;
+    command.rate = rate;
+    command.issued_counter = SDL_GetPerformanceCounter();
+    return mixer_push_command(&command) ? command.voice_id : 0;
+}
+
+void mixer_stop(Voice_Id voice_id)
+{
+    Mixer_Command command = {};
+    command.type = MIXER_COMMAND_STOP;
+    command.voice_id = voice_id;
+    mixer_push_command(&command);
+}
+
+void mixer_set_voice_gain(Voice_Id voice_id, real32 gain)
+{
+    Mixer_Command command = {};
+    command.type = MIXER_COMMAND_SET_VOICE_GAIN;
+    command.voice_id = voice_id;
+    command.gain = gain;
+    mixer_push_command(&command);
+}
+
+void mixer_set_master_gain(real32 gain)
+{
+    Mixer_Command command = {};
+    command.type = MIXER_COMMAND_SET_MASTER_GAIN;
+    command.gain = gain;
+    mixer_push_command(&command);
+}
+
+local_internal Mixer_Voice* mixer_find_voice(Voice_Id voice_id)
+{
+    Mixer* mixer = &global_mixer;
+    for (uint32 i = 0; i < mixer->voice_count; i++)
+    {
+        if (mixer->voices[i].id == voice_id)
+        {
+            return &mixer->voices[i];
+        }
+    }
+    return NULL;
+}
+
+local_internal void mixer_remove_voice(Mixer_Voice* voice)
+{
+    Mixer* mixer = &global_mixer;
+    *voice = mixer->voices[--mixer->voice_count];
+}
+
+local_internal void mixer_start_voice(Mixer_Command* command)
+{
+    Mixer* mixer = &global_mixer;
+
+    Mixer_Voice* voice;
+    if (mixer->voice_count < MIXER_MAX_VOICES)
+    {
+        voice = &mixer->voices[mixer->voice_count++];
+    }
+    else
+    {
+        // Steal whichever voice is closest to being done, it's the least likely to be missed
+        voice = &mixer->voices[0];
+        for (uint32 i = 1; i < mixer->voice_count; i++)
+        {
+            Mixer_Voice* candidate = &mixer->voices[i];
+            if (((uint64)candidate->frame_count << 32) - candidate->position <
+                ((uint64)voice->frame_count << 32) - voice->position)
+            {
+                voice = candidate;
+            }
+        }
+        mixer->stats.voices_stolen++;
+    }
+
+    voice->id = command->voice_id;
+    voice->samples = command->effect->samples;
+    voice->frame_count = command->effect->frame_count;
+    voice->position = 0;
+    voice->step = command->rate > 0 ? (uint64)(command->rate * MIXER_RATE_ONE + 0.5) : MIXER_RATE_ONE;
+    voice->gain = command->gain;
+}
+
+// Returns when the oldest play command was issued (0 if there wasn't one)
+local_internal Uint64 mixer_process_commands()
+{
+    Mixer* mixer = &global_mixer;
+    Uint64 oldest_play_counter = 0;
+
+    uint32 produced = (uint32)SDL_AtomicGet(&mixer->commands_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&mixer->commands_consumed);
+    SDL_MemoryBarrierAcquire();
+
+    while (consumed != produced)
+    {
+        Mixer_Command* command = &mixer->commands[consumed & (MIXER_COMMAND_QUEUE_SIZE - 1)];
+        switch (command->type)
+        {
+            case MIXER_COMMAND_PLAY:
+            {
+                mixer_start_voice(command);
+                if (!oldest_play_counter)
+                {
+                    oldest_play_counter = command->issued_counter;
+                }
+            }
+            break;
+
+            case MIXER_COMMAND_STOP:
+            {
+                Mixer_Voice* voice = mixer_find_voice(command->voice_id);
+                if (voice)
+                {
+                    mixer_remove_voice(voice);
+                }
+            }
+            break;
+
+            case MIXER_COMMAND_SET_VOICE_GAIN:
+            {
+                Mixer_Voice* voice = mixer_find_voice(command->voice_id);
+                if (voice)
+                {
+                    voice->gain = command->gain;
+                }
+            }
+            break;
+
+            case MIXER_COMMAND_SET_MASTER_GAIN:
+            {
+                mixer->master_gain = command->gain;
+            }
+            break;
+        }
+        consumed++;
+    }
+
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&mixer->commands_consumed, (int)consumed);
+
+    return oldest_play_counter;
+}
+
+// accumulator += samples * gain
+local_internal void mixer_accumulate(real32* accumulator, const int16* samples, uint32 sample_count, real32 gain)
+{
+    uint32 i = 0;
+
+#if MIXER_SSE2
+    __m128 gain_4x = _mm_set1_ps(gain);
+    for (; i + 8 <= sample_count; i += 8)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i*)(samples + i));
+        // Sign extend to 32 bits by putting each sample in the high half and shifting it back down
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+        __m128 sum_low = _mm_add_ps(_mm_load_ps(accumulator + i), _mm_mul_ps(_mm_cvtepi32_ps(low), gain_4x));
+        __m128 sum_high = _mm_add_ps(_mm_load_ps(accumulator + i + 4), _mm_mul_ps(_mm_cvtepi32_ps(high), gain_4x));
+        _mm_store_ps(accumulator + i, sum_low);
+        _mm_store_ps(accumulator + i + 4, sum_high);
+    }
+#elif MIXER_NEON
+    float32x4_t gain_4x = vdupq_n_f32(gain);
+    for (; i + 8 <= sample_count; i += 8)
+    {
+        int16x8_t packed = vld1q_s16(samples + i);
+        float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(packed)));
+        float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(packed)));
+
+        vst1q_f32(accumulator + i, vmlaq_f32(vld1q_f32(accumulator + i), low, gain_4x));
+        vst1q_f32(accumulator + i + 4, vmlaq_f32(vld1q_f32(accumulator + i + 4), high, gain_4x));
+    }
+#endif
+
+    for (; i < sample_count; i++)
+    {
+        accumulator[i] += samples[i] * gain;
+    }
+}
+
+// Same as above for voices that aren't played at their original rate. Linear interpolation, no SIMD since every
+// frame reads from a different fractional position. Returns how many frames were written.
+local_internal uint32 mixer_accumulate_resampled(real32* accumulator, Mixer_Voice* voice, uint32 frame_count)
+{
+    uint64 end = (uint64)voice->frame_count << 32;
+    const int16* samples = voice->samples;
+
+    uint32 frame = 0;
+    for (; frame < frame_count && voice->position < end; frame++)
+    {
+        uint32 index = (uint32)(voice->position >> 32);
+        uint32 next_index = index + 1 < voice->frame_count ? index + 1 : index;
+        real32 t = (real32)(voice->position & 0xFFFFFFFF) * (1.0f / 4294967296.0f);
+
+        for (uint32 channel = 0; channel < 2; channel++)
+        {
+            real32 a = samples[index * 2 + channel];
+            real32 b = samples[next_index * 2 + channel];
+            accumulator[frame * 2 + channel] += (a + t * (b - a)) * voice->gain;
+        }
+
+        voice->position += voice->step;
+    }
+    return frame;
+}
+
+// stream = clip(stream + accumulator * master_gain)
+local_internal void mixer_write_output(int16* stream, const real32* accumulator, uint32 sample_count, real32 master_gain)
+{
+    uint32 i = 0;
+
+#if MIXER_SSE2
+    __m128 gain_4x = _mm_set1_ps(master_gain);
+    for (; i + 8 <= sample_count; i += 8)
+    {
+        __m128i packed = _mm_loadu_si128((const __m128i*)(stream + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+        __m128 sum_low = _mm_add_ps(_mm_cvtepi32_ps(low), _mm_mul_ps(_mm_load_ps(accumulator + i), gain_4x));
+        __m128 sum_high = _mm_add_ps(_mm_cvtepi32_ps(high), _mm_mul_ps(_mm_load_ps(accumulator + i + 4), gain_4x));
+
+        // packs saturates, which is our clipping
+        __m128i result = _mm_packs_epi32(_mm_cvtps_epi32(sum_low), _mm_cvtps_epi32(sum_high));
+        _mm_storeu_si128((__m128i*)(stream + i), result);
+    }
+#elif MIXER_NEON
+    float32x4_t gain_4x = vdupq_n_f32(master_gain);
+    for (; i + 8 <= sample_count; i += 8)
+    {
+        int16x8_t packed = vld1q_s16(stream + i);
+        float32x4_t low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(packed)));
+        float32x4_t high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(packed)));
+
+        low = vmlaq_f32(low, vld1q_f32(accumulator + i), gain_4x);
+        high = vmlaq_f32(high, vld1q_f32(accumulator + i + 4), gain_4x);
+
+        // vqmovn saturates, which is our clipping
+        int16x8_t result = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(low)), vqmovn_s32(vcvtnq_s32_f32(high)));
+        vst1q_s16(stream + i, result);
+    }
+#endif
+
+    for (; i < sample_count; i++)
+    {
+        real32 value = stream[i] + accumulator[i] * master_gain;
+        if (value > 32767.0f)
+        {
+            value = 32767.0f;
+        }
+        else if (value < -32768.0f)
+        {
+            value = -32768.0f;
+        }
+        // Round to nearest like cvtps/vcvtnq above, so a sample comes out the same whichever loop it lands in
+        stream[i] = (int16)lrintf(value);
+    }
+}
+
+Uint64 mixer_mix(int16* stream, int32 frame_count)
+{
+    Mixer* mixer = &global_mixer;
+    Uint64 start_counter = SDL_GetPerformanceCounter();
+
+    Uint64 oldest_play_counter = mixer_process_commands();
+
+    if (mixer->voice_count > mixer->stats.max_active_voices)
+    {
+        mixer->stats.max_active_voices = mixer->voice_count;
+    }
+
+    for (int32 chunk_start = 0; chunk_start < frame_count && mixer->voice_count; chunk_start += MIXER_CHUNK_FRAMES)
+    {
+        uint32 chunk_frames = (uint32)SDL_min(frame_count - chunk_start, MIXER_CHUNK_FRAMES);
+        SDL_memset(mixer->accumulator, 0, chunk_frames * 2 * sizeof(real32));
+
+        for (uint32 i = 0; i < mixer->voice_count;)
+        {
+            Mixer_Voice* voice = &mixer->voices[i];
+            if (voice->step == MIXER_RATE_ONE)
+            {
+                uint32 position = (uint32)(voice->position >> 32);
+                uint32 frames = SDL_min(chunk_frames, voice->frame_count - position);
+                mixer_accumulate(mixer->accumulator, voice->samples + position * 2, frames * 2, voice->gain);
+                voice->position += (uint64)frames << 32;
+            }
+            else
+            {
+                mixer_accumulate_resampled(mixer->accumulator, voice, chunk_frames);
+            }
+
+            if (voice->position >= ((uint64)voice->frame_count << 32))
+            {
+                // Swaps the last voice in, so don't move on
+                mixer_remove_voice(voice);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        mixer_write_output(stream + chunk_start * 2, mixer->accumulator, chunk_frames * 2, mixer->master_gain);
+    }
+
+    mixer->stats.active_voices = mixer->voice_count;
+    mixer->stats.commands_dropped = (uint32)SDL_AtomicGet(&mixer->commands_dropped);
+    mixer->stats.last_mix_us =
+        (real32)(1000000.0 * (SDL_GetPerformanceCounter() - start_counter) / SDL_GetPerformanceFrequency());
+    if (mixer->stats.last_mix_us > mixer->stats.max_mix_us)
+    {
+        mixer->stats.max_mix_us = mixer->stats.last_mix_us;
+    }
+
+    return oldest_play_counter;
+}
@@ -0,0 +1,43 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <SDL2/SDL.h>
+
+// Our own sound effect mixer. The game only ever pushes commands into a lock-free queue, the audio thread picks them
+// up and mixes every playing voice on top of what SDL_mixer produced (i.e. the music).
+
+#define MIXER_MAX_VOICES 256
+
+typedef uint32 Voice_Id;  // 0 means no voice
+
+// 16-bit interleaved stereo at the device frequency
+typedef struct
+{
+    const int16* samples;
+    uint32 frame_count;
+} Sound_Effect;
+
+typedef struct
+{
+    uint32 active_voices;
+    uint32 max_active_voices;
+    uint32 voices_stolen;
+    uint32 commands_dropped;  // Queue was full, should never happen
+    real32 last_mix_us;
+    real32 max_mix_us;
+} Mixer_Stats;
+
+void mixer_init(void);
+
+// Called on the audio thread before anyone else sees the mix. Returns when the oldest play command picked up this
+// time was issued (0 if there wasn't one), so the caller can measure latency.
+Uint64 mixer_mix(int16* stream, int32 frame_count);
+
+// These never block. They're meant to be called from the game thread only (the queue has a single producer).
+// rate is the playback speed, so 2 plays it an octave up (and twice as short)
+Voice_Id mixer_play(Sound_Effect* effect, real32 gain, real32 rate);
+void mixer_stop(Voice_Id voice_id);
+void mixer_set_voice_gain(Voice_Id voice_id, real32 gain);
+void mixer_set_master_gain(real32 gain);
+
+#endif  // MIXER_H
@@ -0,0 +1,586 @@
+#include <SDL2/SDL.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define PARTICLES_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Sparks for blip pickups and the explosion when the snake dies. Every particle is a few floats spread over separate
+// arrays (structure of arrays), so the update runs four particles per SIMD step with no gathering. Dead particles get
+// swapped with the last live one, which keeps the live ones packed at the front.
+//
+// Drawing writes a quad per particle into vertex buffers that live as long as the pool, and everything goes to the GPU
+// in a single SDL_RenderGeometryRaw() call however many particles there are. That's SDL_RenderGeometry() with the
+// positions and colours in separate arrays, which saves writing (and SDL reading) the texture coordinates that an
+// SDL_Vertex would have. The indices never change, so they're only written once.
+//
+// Positions are canvas pixels with y down. Scenes with a camera emit in the canvas space of a camera at the origin and
+// pass the camera's offset when drawing.
+
+#define PARTICLE_GRAVITY 600.0f  // Pixels per second per second, downwards
+#define PARTICLE_DRAG 1.5f  // Fraction of the velocity lost per second
+#define PARTICLE_MAX_TIME_STEP__SECONDS 0.1f  // So a hitch doesn't fling everything off the screen
+
+struct Particles
+{
+    uint32 capacity;
+    uint32 count;  // Live particles, always the first count of every array
+
+    // Capacity long each and 16 byte aligned for SIMD
+    real32* x;
+    real32* y;
+    real32* velocity_x;
+    real32* velocity_y;
+    real32* life;  // Seconds left
+    real32* inverse_lifetime;  // For fading out
+    real32* size;  // Pixels across
+    SDL_Color* color;
+
+    SDL_FPoint* vertex_positions;  // 4 per particle
+    SDL_Color* vertex_colors;  // 4 per particle
+    int32* indices;  // 6 per particle
+
+    Memory_Arena memory;
+    uint32 random_state;
+
+    // Stats
+    uint32 max_count;
+    uint32 dropped;  // Emitted while the pool was full
+    uint32 last_drawn_count;  // Particles on screen last frame
+    real32 last_update__microseconds;
+    real32 max_update__microseconds;
+    real32 last_render__microseconds;  // Building the vertices and handing them to SDL
+};
+
+Particles global_particles;
+
+bool32 particles_init(Particles* particles, uint32 capacity, uint32 seed)
+{
+    *particles = {};
+
+    size_t size_per_particle =
+        7 * sizeof(real32) + sizeof(SDL_Color) + 4 * (sizeof(SDL_FPoint) + sizeof(SDL_Color)) + 6 * sizeof(int32);
+    if (!arena_init(&particles->memory,
+                    "particles",
+                    capacity * size_per_particle + 10 * 16,
+                    ARENA_USE_HUGE_PAGES,
+                    ARENA_PREFAULT))
+    {
+        return false;
+    }
+
+    particles->capacity = capacity;
+    particles->random_state = seed;
+    size_t array_size = capacity * sizeof(real32);
+    particles->x = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->y = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->velocity_x = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->velocity_y = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->life = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->inverse_lifetime = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->size = (real32*)push_size(&particles->memory, array_size, 16);
+    particles->color = (SDL_Color*)push_size(&particles->memory, capacity * sizeof(SDL_Color), 16);
+    particles->vertex_positions = (SDL_FPoint*)push_size(&particles->memory, capacity * 4 * sizeof(SDL_FPoint), 16);
+    particles->vertex_colors = (SDL_Color*)push_size(&particles->memory, capacity * 4 * sizeof(SDL_Color), 16);
+    particles->indices = push_array(&particles->memory, (size_t)capacity * 6, int32);
+
+    // Two triangles per quad
+    for (uint32 i = 0; i < capacity; i++)
+    {
+        int32 first_vertex = (int32)i * 4;
+        int32* indices = particles->indices + (size_t)i * 6;
+        indices[0] = first_vertex;
+        indices[1] = first_vertex + 1;
+        indices[2] = first_vertex + 2;
+        indices[3] = first_vertex + 2;
+        indices[4] = first_vertex + 3;
+        indices[5] = first_vertex;
+    }
+    return true;
+}
+
+void particles_clear(Particles* particles)
+{
+    particles->count = 0;
+}
+
+// Between 0 and 1
+inline real32 particles_random_fraction(Particles* particles)
+{
+    // The low bits of the generator aren't very random
+    return (real32)(snake_sim_random(&particles->random_state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// count particles flying out of (x, y) in every direction at up to speed pixels per second, lasting up to lifetime
+// seconds. Whatever doesn't fit in the pool gets dropped.
+void particles_emit_burst(Particles* particles,
+                          real32 x,
+                          real32 y,
+                          uint32 count,
+                          real32 speed,
+                          real32 lifetime,
+                          real32 size,
+                          SDL_Color color)
+{
+    uint32 emit_count = SDL_min(count, particles->capacity - particles->count);
+    particles->dropped += count - emit_count;
+
+    for (uint32 i = particles->count; i < particles->count + emit_count; i++)
+    {
+        real32 angle = particles_random_fraction(particles) * 6.2831853f;
+        real32 particle_speed = speed * (0.2f + 0.8f * particles_random_fraction(particles));
+        real32 particle_lifetime = lifetime * (0.5f + 0.5f * particles_random_fraction(particles));
+        particles->x[i] = x;
+        particles->y[i] = y;
+        particles->velocity_x[i] = SDL_cosf(angle) * particle_speed;
+        particles->velocity_y[i] = SDL_sinf(angle) * particle_speed;
+        particles->life[i] = particle_lifetime;
+        particles->inverse_lifetime[i] = 1.0f / particle_lifetime;
+        particles->size[i] = size;
+        particles->color[i] = color;
+    }
+
+    particles->count += emit_count;
+    particles->max_count = SDL_max(particles->max_count, particles->count);
+}
+
+// Moves the particles from first to end (not included) on by time_step seconds. The arrays are copied into locals
+// here and below, otherwise every store through them could be changing the Particles and it all gets loaded again.
+local_internal void particles_integrate_scalar(Particles* particles, uint32 first, uint32 end, real32 time_step)
+{
+    real32* x = particles->x;
+    real32* y = particles->y;
+    real32* velocity_x = particles->velocity_x;
+    real32* velocity_y = particles->velocity_y;
+    real32* life = particles->life;
+    real32 damping = SDL_max(0.0f, 1.0f - PARTICLE_DRAG * time_step);
+    real32 gravity_step = PARTICLE_GRAVITY * time_step;
+    for (uint32 i = first; i < end; i++)
+    {
+        real32 new_velocity_x = velocity_x[i] * damping;
+        real32 new_velocity_y = (velocity_y[i] + gravity_step) * damping;
+        x[i] += new_velocity_x * time_step;
+        y[i] += new_velocity_y * time_step;
+        velocity_x[i] = new_velocity_x;
+        velocity_y[i] = new_velocity_y;
+        life[i] -= time_step;
+    }
+}
+
+// Same as above for every live particle, four at a time. Whatever doesn't fill a last group of four goes through the
+// scalar version.
+local_internal void particles_integrate(Particles* particles, real32 time_step)
+{
+    uint32 simd_end = 0;
+
+#if PARTICLES_SSE2
+    simd_end = particles->count & ~3u;
+    real32* x = particles->x;
+    real32* y = particles->y;
+    real32* velocity_x = particles->velocity_x;
+    real32* velocity_y = particles->velocity_y;
+    real32* life = particles->life;
+    const __m128 step = _mm_set1_ps(time_step);
+    const __m128 damping = _mm_set1_ps(SDL_max(0.0f, 1.0f - PARTICLE_DRAG * time_step));
+    const __m128 gravity_step = _mm_set1_ps(PARTICLE_GRAVITY * time_step);
+    for (uint32 i = 0; i < simd_end; i += 4)
+    {
+        __m128 new_velocity_x = _mm_mul_ps(_mm_load_ps(velocity_x + i), damping);
+        __m128 new_velocity_y = _mm_mul_ps(_mm_add_ps(_mm_load_ps(velocity_y + i), gravity_step), damping);
+        _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(new_velocity_x, step)));
+        _mm_store_ps(y + i, _mm_add_ps(_mm_load_ps(y + i), _mm_mul_ps(new_velocity_y, step)));
+        _mm_store_ps(velocity_x + i, new_velocity_x);
+        _mm_store_ps(velocity_y + i, new_velocity_y);
+        _mm_store_ps(life + i, _mm_sub_ps(_mm_load_ps(life + i), step));
+    }
+#elif PARTICLES_NEON
+    simd_end = particles->count & ~3u;
+    real32* x = particles->x;
+    real32* y = particles->y;
+    real32* velocity_x = particles->velocity_x;
+    real32* velocity_y = particles->velocity_y;
+    real32* life = particles->life;
+    const float32x4_t step = vdupq_n_f32(time_step);
+    const float32x4_t damping = vdupq_n_f32(SDL_max(0.0f, 1.0f - PARTICLE_DRAG * time_step));
+    const float32x4_t gravity_step = vdupq_n_f32(PARTICLE_GRAVITY * time_step);
+    for (uint32 i = 0; i < simd_end; i += 4)
+    {
+        float32x4_t new_velocity_x = vmulq_f32(vld1q_f32(velocity_x + i), damping);
+        float32x4_t new_velocity_y = vmulq_f32(vaddq_f32(vld1q_f32(velocity_y + i), gravity_step), damping);
+        vst1q_f32(x + i, vmlaq_f32(vld1q_f32(x + i), new_velocity_x, step));
+        vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), new_velocity_y, step));
+        vst1q_f32(velocity_x + i, new_velocity_x);
+        vst1q_f32(velocity_y + i, new_velocity_y);
+        vst1q_f32(life + i, vsubq_f32(vld1q_f32(life + i), step));
+    }
+#endif
+
+    particles_integrate_scalar(particles, simd_end, particles->count, time_step);
+}
+
+// Swaps every dead particle with the last live one
+local_internal void particles_remove_dead(Particles* particles)
+{
+    real32* life = particles->life;
+    uint32 count = particles->count;
+    uint32 i = 0;
+    while (i < count)
+    {
+        if (life[i] > 0)
+        {
+            i++;
+            continue;
+        }
+
+        // The one swapped in gets checked next time round
+        uint32 last = --count;
+        particles->x[i] = particles->x[last];
+        particles->y[i] = particles->y[last];
+        particles->velocity_x[i] = particles->velocity_x[last];
+        particles->velocity_y[i] = particles->velocity_y[last];
+        life[i] = life[last];
+        particles->inverse_lifetime[i] = particles->inverse_lifetime[last];
+        particles->size[i] = particles->size[last];
+        particles->color[i] = particles->color[last];
+    }
+    particles->count = count;
+}
+
+// Called once a frame with how long the last frame took, whichever scene is up
+void particles_update(Particles* particles, real32 elapsed__seconds)
+{
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    particles_integrate(particles, SDL_min(elapsed__seconds, PARTICLE_MAX_TIME_STEP__SECONDS));
+    particles_remove_dead(particles);
+
+    real32 update__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) * 1000000.0 /
+                                           (real64)SDL_GetPerformanceFrequency());
+    particles->last_update__microseconds = update__microseconds;
+    particles->max_update__microseconds = SDL_max(particles->max_update__microseconds, update__microseconds);
+}
+
+// Writes a quad for particle i at slot drawn_count if it's on the canvas once moved by (offset_x, offset_y), fading
+// out as it gets to the end of its life. Returns 1 if it was, 0 if not.
+inline uint32 particles_build_quad(
+    Particles* particles, uint32 i, uint32 drawn_count, real32 offset_x, real32 offset_y, real32 width, real32 height)
+{
+    real32 size = particles->size[i];
+    real32 left = particles->x[i] + offset_x - size * 0.5f;
+    real32 top = particles->y[i] + offset_y - size * 0.5f;
+    real32 right = left + size;
+    real32 bottom = top + size;
+    if (right < 0 || bottom < 0 || left > width || top > height)
+    {
+        return 0;
+    }
+
+    SDL_Color color = particles->color[i];
+    color.a = (uint8)(color.a * SDL_min(particles->life[i] * particles->inverse_lifetime[i], 1.0f));
+
+    SDL_FPoint* positions = particles->vertex_positions + (size_t)drawn_count * 4;
+    positions[0].x = left;
+    positions[0].y = top;
+    positions[1].x = right;
+    positions[1].y = top;
+    positions[2].x = right;
+    positions[2].y = bottom;
+    positions[3].x = left;
+    positions[3].y = bottom;
+    SDL_Color* colors = particles->vertex_colors + (size_t)drawn_count * 4;
+    colors[0] = color;
+    colors[1] = color;
+    colors[2] = color;
+    colors[3] = color;
+    return 1;
+}
+
+// Writes the quads for every particle on the canvas, packed together, and returns how many there are. Four particles
+// at a time: every quad gets written, but the next one only moves along past it if it's on the canvas.
+local_internal uint32 particles_build_vertices(Particles* particles, real32 offset_x, real32 offset_y)
+{
+    real32 width = (real32)LOGICAL_WIDTH;
+    real32 height = (real32)LOGICAL_HEIGHT;
+    uint32 drawn_count = 0;
+    uint32 simd_end = 0;
+
+#if PARTICLES_SSE2
+    simd_end = particles->count & ~3u;
+    const real32* x = particles->x;
+    const real32* y = particles->y;
+    const real32* life = particles->life;
+    const real32* inverse_lifetime = particles->inverse_lifetime;
+    const real32* size = particles->size;
+    const SDL_Color* colors = particles->color;
+    real32* vertex_positions = &particles->vertex_positions[0].x;
+    SDL_Color* vertex_colors = particles->vertex_colors;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 canvas_width = _mm_set1_ps(width);
+    const __m128 canvas_height = _mm_set1_ps(height);
+    const __m128 offset_x4 = _mm_set1_ps(offset_x);
+    const __m128 offset_y4 = _mm_set1_ps(offset_y);
+    const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+    for (uint32 i = 0; i < simd_end; i += 4)
+    {
+        __m128 sizes = _mm_load_ps(size + i);
+        __m128 left = _mm_sub_ps(_mm_add_ps(_mm_load_ps(x + i), offset_x4), _mm_mul_ps(sizes, half));
+        __m128 top = _mm_sub_ps(_mm_add_ps(_mm_load_ps(y + i), offset_y4), _mm_mul_ps(sizes, half));
+        __m128 right = _mm_add_ps(left, sizes);
+        __m128 bottom = _mm_add_ps(top, sizes);
+        __m128 is_visible = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(right, zero), _mm_cmpge_ps(bottom, zero)),
+                                       _mm_and_ps(_mm_cmple_ps(left, canvas_width), _mm_cmple_ps(top, canvas_height)));
+        uint32 visible_mask = (uint32)_mm_movemask_ps(is_visible);
+
+        // SDL_Color is RGBA in memory, so alpha is the top byte
+        __m128 fraction = _mm_min_ps(_mm_mul_ps(_mm_load_ps(life + i), _mm_load_ps(inverse_lifetime + i)), one);
+        __m128i color = _mm_load_si128((const __m128i*)(colors + i));
+        __m128i alpha = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(color, 24)), fraction));
+        color = _mm_or_si128(_mm_and_si128(color, rgb_mask), _mm_slli_epi32(alpha, 24));
+
+        // Corners of the first two particles in the low halves and the last two in the high halves, then every
+        // particle's quad is (left, top, right, top) followed by (right, bottom, left, bottom)
+        __m128 left_top_low = _mm_unpacklo_ps(left, top);
+        __m128 right_top_low = _mm_unpacklo_ps(right, top);
+        __m128 right_bottom_low = _mm_unpacklo_ps(right, bottom);
+        __m128 left_bottom_low = _mm_unpacklo_ps(left, bottom);
+        __m128 left_top_high = _mm_unpackhi_ps(left, top);
+        __m128 right_top_high = _mm_unpackhi_ps(right, top);
+        __m128 right_bottom_high = _mm_unpackhi_ps(right, bottom);
+        __m128 left_bottom_high = _mm_unpackhi_ps(left, bottom);
+
+        __m128 quads[8] = {
+            _mm_movelh_ps(left_top_low, right_top_low),
+            _mm_movelh_ps(right_bottom_low, left_bottom_low),
+            _mm_movehl_ps(right_top_low, left_top_low),
+            _mm_movehl_ps(left_bottom_low, right_bottom_low),
+            _mm_movelh_ps(left_top_high, right_top_high),
+            _mm_movelh_ps(right_bottom_high, left_bottom_high),
+            _mm_movehl_ps(right_top_high, left_top_high),
+            _mm_movehl_ps(left_bottom_high, right_bottom_high),
+        };
+        __m128i quad_colors[4] = {
+            _mm_shuffle_epi32(color, _MM_SHUFFLE(0, 0, 0, 0)),
+            _mm_shuffle_epi32(color, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_shuffle_epi32(color, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_shuffle_epi32(color, _MM_SHUFFLE(3, 3, 3, 3)),
+        };
+        for (uint32 lane = 0; lane < 4; lane++)
+        {
+            real32* positions = vertex_positions + (size_t)drawn_count * 8;
+            _mm_store_ps(positions, quads[lane * 2]);
+            _mm_store_ps(positions + 4, quads[lane * 2 + 1]);
+            _mm_store_si128((__m128i*)(vertex_colors + (size_t)drawn_count * 4), quad_colors[lane]);
+            drawn_count += (visible_mask >> lane) & 1;
+        }
+    }
+#elif PARTICLES_NEON
+    simd_end = particles->count & ~3u;
+    const real32* x = particles->x;
+    const real32* y = particles->y;
+    const real32* life = particles->life;
+    const real32* inverse_lifetime = particles->inverse_lifetime;
+    const real32* size = particles->size;
+    const SDL_Color* colors = particles->color;
+    real32* vertex_positions = &particles->vertex_positions[0].x;
+    SDL_Color* vertex_colors = particles->vertex_colors;
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t canvas_width = vdupq_n_f32(width);
+    const float32x4_t canvas_height = vdupq_n_f32(height);
+    const float32x4_t offset_x4 = vdupq_n_f32(offset_x);
+    const float32x4_t offset_y4 = vdupq_n_f32(offset_y);
+    const uint32x4_t rgb_mask = vdupq_n_u32(0x00FFFFFF);
+    for (uint32 i = 0; i < simd_end; i += 4)
+    {
+        float32x4_t sizes = vld1q_f32(size + i);
+        float32x4_t left = vmlsq_n_f32(vaddq_f32(vld1q_f32(x + i), offset_x4), sizes, 0.5f);
+        float32x4_t top = vmlsq_n_f32(vaddq_f32(vld1q_f32(y + i), offset_y4), sizes, 0.5f);
+        float32x4_t right = vaddq_f32(left, sizes);
+        float32x4_t bottom = vaddq_f32(top, sizes);
+        uint32x4_t is_visible = vandq_u32(vandq_u32(vcgeq_f32(right, zero), vcgeq_f32(bottom, zero)),
+                                          vandq_u32(vcleq_f32(left, canvas_width), vcleq_f32(top, canvas_height)));
+        uint32 visible_mask = (vgetq_lane_u32(is_visible, 0) & 1) | (vgetq_lane_u32(is_visible, 1) & 2) |
+                              (vgetq_lane_u32(is_visible, 2) & 4) | (vgetq_lane_u32(is_visible, 3) & 8);
+
+        // SDL_Color is RGBA in memory, so alpha is the top byte
+        float32x4_t fraction = vminq_f32(vmulq_f32(vld1q_f32(life + i), vld1q_f32(inverse_lifetime + i)), one);
+        uint32x4_t color = vld1q_u32((const uint32*)(colors + i));
+        uint32x4_t alpha = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(color, 24)), fraction));
+        color = vorrq_u32(vandq_u32(color, rgb_mask), vshlq_n_u32(alpha, 24));
+
+        // Same layout as the SSE2 version: (left, top, right, top) then (right, bottom, left, bottom) per particle
+        float32x4x2_t left_top = vzipq_f32(left, top);
+        float32x4x2_t right_top = vzipq_f32(right, top);
+        float32x4x2_t right_bottom = vzipq_f32(right, bottom);
+        float32x4x2_t left_bottom = vzipq_f32(left, bottom);
+
+        float32x4_t quads[8] = {
+            vcombine_f32(vget_low_f32(left_top.val[0]), vget_low_f32(right_top.val[0])),
+            vcombine_f32(vget_low_f32(right_bottom.val[0]), vget_low_f32(left_bottom.val[0])),
+            vcombine_f32(vget_high_f32(left_top.val[0]), vget_high_f32(right_top.val[0])),
+            vcombine_f32(vget_high_f32(right_bottom.val[0]), vget_high_f32(left_bottom.val[0])),
+            vcombine_f32(vget_low_f32(left_top.val[1]), vget_low_f32(right_top.val[1])),
+            vcombine_f32(vget_low_f32(right_bottom.val[1]), vget_low_f32(left_bottom.val[1])),
+            vcombine_f32(vget_high_f32(left_top.val[1]), vget_high_f32(right_top.val[1])),
+            vcombine_f32(vget_high_f32(right_bottom.val[1]), vget_high_f32(left_bottom.val[1])),
+        };
+        uint32x4_t quad_colors[4] = {
+            vdupq_lane_u32(vget_low_u32(color), 0),
+            vdupq_lane_u32(vget_low_u32(color), 1),
+            vdupq_lane_u32(vget_high_u32(color), 0),
+            vdupq_lane_u32(vget_high_u32(color), 1),
+        };
+        for (uint32 lane = 0; lane < 4; lane++)
+        {
+            real32* positions = vertex_positions + (size_t)drawn_count * 8;
+            vst1q_f32(positions, quads[lane * 2]);
+            vst1q_f32(positions + 4, quads[lane * 2 + 1]);
+            vst1q_u32((uint32*)(vertex_colors + (size_t)drawn_count * 4), quad_colors[lane]);
+            drawn_count += (visible_mask >> lane) & 1;
+        }
+    }
+#endif
+
+    for (uint32 i = simd_end; i < particles->count; i++)
+    {
+        drawn_count += particles_build_quad(particles, i, drawn_count, offset_x, offset_y, width, height);
+    }
+    return drawn_count;
+}
+
+// Draws every particle in one go, added onto whatever is already there so overlapping sparks glow
+void particles_render(Particles* particles, real32 offset_x, real32 offset_y)
+{
+    if (particles->count == 0)
+    {
+        particles->last_drawn_count = 0;
+        particles->last_render__microseconds = 0;
+        return;
+    }
+
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    uint32 drawn_count = particles_build_vertices(particles, offset_x, offset_y);
+    if (drawn_count > 0)
+    {
+        SDL_BlendMode blend_mode;
+        SDL_GetRenderDrawBlendMode(global_renderer, &blend_mode);
+        SDL_SetRenderDrawBlendMode(global_renderer, SDL_BLENDMODE_ADD);
+        SDL_RenderGeometryRaw(global_renderer,
+                              NULL,
+                              &particles->vertex_positions[0].x,
+                              sizeof(SDL_FPoint),
+                              particles->vertex_colors,
+                              sizeof(SDL_Color),
+                              NULL,
+                              0,
+                              (int32)drawn_count * 4,
+                              particles->indices,
+                              (int32)drawn_count * 6,
+                              sizeof(int32));
+        SDL_SetRenderDrawBlendMode(global_renderer, blend_mode);
+    }
+
+    particles->last_drawn_count = drawn_count;
+    particles->last_render__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) *
+                                                    1000000.0 / (real64)SDL_GetPerformanceFrequency());
+}
+
+// Bursts at random spots on the canvas until there are target_count particles (or the pool is full), for
+// --particle-stress and the benchmark
+void particles_top_up(Particles* particles, uint32 target_count)
+{
+    SDL_Color color = {255, 180, 80, 160};
+    target_count = SDL_min(target_count, particles->capacity);
+    while (particles->count < target_count)
+    {
+        real32 x = particles_random_fraction(particles) * LOGICAL_WIDTH;
+        real32 y = particles_random_fraction(particles) * LOGICAL_HEIGHT;
+        particles_emit_burst(particles, x, y, SDL_min(target_count - particles->count, 256), 300.0f, 2.0f, 3.0f, color);
+    }
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// --bench-particles: keeps count particles alive for frame_count frames at the target frame rate, timing the update
+// (SIMD, then scalar for comparison) and building the vertices. Doesn't need a window, so it leaves out what the GPU
+// does with them.
+int32 particles_run_benchmark(uint32 count, uint32 frame_count)
+{
+    Particles* particles = &global_particles;
+    if (!particles_init(particles, count, 12345))
+    {
+        return -1;
+    }
+
+    real32 frame__seconds = TARGET_TIME_PER_FRAME_S;
+    printf("Particle benchmark: %u particles, %u frames at %.1f fps\n", count, frame_count, TARGET_SCREEN_FPS);
+
+    real64 frequency = (real64)SDL_GetPerformanceFrequency();
+    real64 simd__microseconds = 0;
+    real64 scalar__microseconds = 0;
+    real64 remove__microseconds = 0;
+    real64 build__microseconds = 0;
+    uint64 particle_count = 0;
+    uint64 drawn_count = 0;
+    for (uint32 frame = 0; frame < frame_count * 2; frame++)
+    {
+        particles_top_up(particles, count);
+        particle_count += particles->count;
+
+        // The first half of the frames use the SIMD update and the second half the scalar one
+        uint64 start_counter = SDL_GetPerformanceCounter();
+        if (frame < frame_count)
+        {
+            particles_integrate(particles, frame__seconds);
+        }
+        else
+        {
+            particles_integrate_scalar(particles, 0, particles->count, frame__seconds);
+        }
+        uint64 integrated_counter = SDL_GetPerformanceCounter();
+        particles_remove_dead(particles);
+        uint64 removed_counter = SDL_GetPerformanceCounter();
+        drawn_count += particles_build_vertices(particles, 0, 0);
+        uint64 built_counter = SDL_GetPerformanceCounter();
+
+        real64 integrate__microseconds = (real64)(integrated_counter - start_counter) * 1000000.0 / frequency;
+        if (frame < frame_count)
+        {
+            simd__microseconds += integrate__microseconds;
+        }
+        else
+        {
+            scalar__microseconds += integrate__microseconds;
+        }
+        remove__microseconds += (real64)(removed_counter - integrated_counter) * 1000000.0 / frequency;
+        build__microseconds += (real64)(built_counter - removed_counter) * 1000000.0 / frequency;
+    }
+
+    real64 average_count = (real64)particle_count / (frame_count * 2);
+    real64 simd_per_frame = simd__microseconds / frame_count;
+    real64 scalar_per_frame = scalar__microseconds / frame_count;
+    real64 remove_per_frame = remove__microseconds / (frame_count * 2);
+    real64 build_per_frame = build__microseconds / (frame_count * 2);
+    printf("  update: %.1f us per frame with SIMD (%.0f M particles/s), %.1f us scalar (%.2fx)\n",
+           simd_per_frame,
+           simd_per_frame > 0 ? average_count / simd_per_frame : 0.0,
+           scalar_per_frame,
+           simd_per_frame > 0 ? scalar_per_frame / simd_per_frame : 0.0);
+    printf("  removing dead: %.1f us per frame, %u dropped\n", remove_per_frame, particles->dropped);
+    printf("  vertices: %.1f us per frame for %.0f quads (%.0f M particles/s)\n",
+           build_per_frame,
+           (real64)drawn_count / (frame_count * 2),
+           build_per_frame > 0 ? average_count / build_per_frame : 0.0);
+    printf("  %.1f%% of a %.2f ms frame\n",
+           100.0 * (simd_per_frame + remove_per_frame + build_per_frame) / (frame__seconds * 1000000.0),
+           frame__seconds * 1000.0f);
+    return 0;
+}
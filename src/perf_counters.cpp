@@ -0,0 +1,333 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __LINUX__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters (instructions, cycles, cache misses, branch misses) for each of the phases Master_Timer splits a
+// frame into, read with perf_event_open on Linux.
+//
+// The counters are one group, so the kernel puts them on the PMU together and one read() at a phase boundary gets all
+// of them at the same instant. That's a syscall of a microsecond or so, five a frame. Only the game thread in user
+// space is counted: most distros don't allow counting the kernel without root (see
+// /proc/sys/kernel/perf_event_paranoid), so time spent in the driver or asleep in the kernel doesn't show up. On other
+// platforms, or when the kernel says no (VMs often don't expose a PMU), nothing gets counted and the overlay says why.
+
+// Same order as in live_metrics.h
+#define PERF_COUNTER_INSTRUCTIONS 0
+#define PERF_COUNTER_CYCLES 1
+#define PERF_COUNTER_CACHE_MISSES 2
+#define PERF_COUNTER_BRANCH_MISSES 3
+#define PERF_COUNTER_COUNT 4
+
+#define PERF_PHASE_WORK 0
+#define PERF_PHASE_WRITING_BUFFER 1
+#define PERF_PHASE_RENDER 2
+#define PERF_PHASE_SLEEP 3
+#define PERF_PHASE_COUNT 4
+
+static_assert(PERF_COUNTER_COUNT == LIVE_METRICS_COUNTER_COUNT, "The live metrics publish every counter");
+static_assert(PERF_PHASE_COUNT == LIVE_METRICS_PHASE_COUNT, "The live metrics publish every phase");
+
+#ifdef __LINUX__
+local_internal const uint64 PERF_COUNTER_CONFIGS[PERF_COUNTER_COUNT] = {
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+#endif
+
+struct Perf_Counters
+{
+    bool32 is_available;
+    char unavailable_reason[96];
+
+    int32 group_file;  // The group leader, -1 when nothing's open
+    int32 files[PERF_COUNTER_COUNT];
+    uint64 ids[PERF_COUNTER_COUNT];
+    uint32 open_mask;  // Bit per PERF_COUNTER_, some CPUs don't have every event
+
+    uint64 last_values[PERF_COUNTER_COUNT];                      // At the last phase boundary
+    uint64 phase_values[PERF_PHASE_COUNT][PERF_COUNTER_COUNT];  // The phases of the last frame
+
+    // Stats
+    bool32 is_multiplexed;  // Had to share the PMU with something else, so the counts are scaled up estimates
+    uint32 read_failures;
+};
+
+Perf_Counters global_perf_counters;
+
+local_internal const char* perf_phase_name(uint32 phase)
+{
+    const char* names[PERF_PHASE_COUNT] = {"Work", "Buffer", "Render", "Sleep"};
+    return phase < PERF_PHASE_COUNT ? names[phase] : "?";
+}
+
+bool32 perf_counters_open(Perf_Counters* counters)
+{
+    *counters = {};
+    counters->group_file = -1;
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        counters->files[i] = -1;
+    }
+
+#ifdef __LINUX__
+    int32 first_error = 0;
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        perf_event_attr attributes = {};
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNTER_CONFIGS[i];
+        attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                 PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        // The whole group starts at once when the leader is enabled
+        attributes.disabled = counters->group_file < 0;
+
+        int32 file =
+            (int32)syscall(SYS_perf_event_open, &attributes, 0, -1, counters->group_file, PERF_FLAG_FD_CLOEXEC);
+        if (file < 0)
+        {
+            first_error = first_error ? first_error : errno;
+            continue;
+        }
+        if (ioctl(file, PERF_EVENT_IOC_ID, &counters->ids[i]) != 0)
+        {
+            close(file);
+            continue;
+        }
+        counters->files[i] = file;
+        counters->open_mask |= 1 << i;
+        if (counters->group_file < 0)
+        {
+            counters->group_file = file;
+        }
+    }
+
+    if (counters->group_file < 0)
+    {
+        const char* hint = "";
+        if (first_error == EACCES || first_error == EPERM)
+        {
+            hint = " (check perf_event_paranoid)";
+        }
+        else if (first_error == ENOENT || first_error == EOPNOTSUPP)
+        {
+            hint = " (no PMU, in a VM?)";
+        }
+        snprintf(counters->unavailable_reason,
+                 sizeof(counters->unavailable_reason),
+                 "perf_event_open: %s%s",
+                 strerror(first_error),
+                 hint);
+        log_info("Hardware counters aren't available, %s\n", counters->unavailable_reason);
+        return false;
+    }
+
+    ioctl(counters->group_file, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->group_file, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    counters->is_available = true;
+    return true;
+#else
+    snprintf(counters->unavailable_reason, sizeof(counters->unavailable_reason), "only read on Linux");
+    return false;
+#endif
+}
+
+void perf_counters_close(Perf_Counters* counters)
+{
+#ifdef __LINUX__
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        if (counters->files[i] >= 0)
+        {
+            close(counters->files[i]);
+        }
+    }
+#endif
+    *counters = {};
+    counters->group_file = -1;
+}
+
+// Where every counter is right now, scaled up if the group only got part of the time on the PMU
+local_internal bool32 perf_counters_read(Perf_Counters* counters, uint64* values)
+{
+#ifdef __LINUX__
+    // nr, time enabled, time running, then a value and id per counter
+    uint64 data[3 + 2 * PERF_COUNTER_COUNT];
+    ssize_t bytes_read = read(counters->group_file, data, sizeof(data));
+    if (bytes_read < (ssize_t)(3 * sizeof(uint64)))
+    {
+        counters->read_failures++;
+        return false;
+    }
+
+    uint64 value_count = SDL_min(data[0], (uint64)PERF_COUNTER_COUNT);
+    uint64 time_enabled = data[1];
+    uint64 time_running = data[2];
+    bool32 is_scaled = time_running > 0 && time_running < time_enabled;
+    counters->is_multiplexed |= is_scaled;
+    for (uint64 i = 0; i < value_count; i++)
+    {
+        uint64 value = data[3 + 2 * i];
+        uint64 id = data[4 + 2 * i];
+        if (is_scaled)
+        {
+            value = (uint64)((real64)value * (real64)time_enabled / (real64)time_running);
+        }
+        for (uint32 counter = 0; counter < PERF_COUNTER_COUNT; counter++)
+        {
+            if ((counters->open_mask & (1 << counter)) && counters->ids[counter] == id)
+            {
+                values[counter] = value;
+            }
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline void perf_counters_begin_frame(Perf_Counters* counters)
+{
+    if (counters->is_available)
+    {
+        perf_counters_read(counters, counters->last_values);
+    }
+}
+
+// Call at the end of each phase, in order, after perf_counters_begin_frame
+inline void perf_counters_end_phase(Perf_Counters* counters, uint32 phase)
+{
+    if (!counters->is_available)
+    {
+        return;
+    }
+
+    uint64 values[PERF_COUNTER_COUNT] = {};
+    if (!perf_counters_read(counters, values))
+    {
+        return;
+    }
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        // Scaled estimates can go backwards a little
+        uint64 last_value = counters->last_values[i];
+        counters->phase_values[phase][i] = values[i] > last_value ? values[i] - last_value : 0;
+        counters->last_values[i] = values[i];
+    }
+}
+
+local_internal void perf_counters_format_count(char* buffer, size_t buffer_size, uint64 count)
+{
+    if (count >= 1000 * 1000)
+    {
+        snprintf(buffer, buffer_size, "%.2fM", count / 1000000.0);
+    }
+    else if (count >= 10 * 1000)
+    {
+        snprintf(buffer, buffer_size, "%.1fk", count / 1000.0);
+    }
+    else
+    {
+        snprintf(buffer, buffer_size, "%llu", (unsigned long long)count);
+    }
+}
+
+// "Work: 1.2M instr, 0.9M cycles, IPC 1.31, cache miss 12.3k, branch miss 4.5k", or why there's nothing to show
+void perf_counters_format_phase(Perf_Counters* counters, uint32 phase, char* buffer, size_t buffer_size)
+{
+    if (!counters->is_available)
+    {
+        snprintf(buffer, buffer_size, "Hardware counters: %s", counters->unavailable_reason);
+        return;
+    }
+
+    const uint64* values = counters->phase_values[phase];
+    char counts[PERF_COUNTER_COUNT][16];
+    for (uint32 i = 0; i < PERF_COUNTER_COUNT; i++)
+    {
+        if (counters->open_mask & (1 << i))
+        {
+            perf_counters_format_count(counts[i], sizeof(counts[i]), values[i]);
+        }
+        else
+        {
+            snprintf(counts[i], sizeof(counts[i]), "-");
+        }
+    }
+    real64 instructions_per_cycle =
+        values[PERF_COUNTER_CYCLES] ? (real64)values[PERF_COUNTER_INSTRUCTIONS] / values[PERF_COUNTER_CYCLES] : 0.0;
+    snprintf(buffer,
+             buffer_size,
+             "%s: %s instr, %s cycles, IPC %.2f, cache miss %s, branch miss %s%s",
+             perf_phase_name(phase),
+             counts[PERF_COUNTER_INSTRUCTIONS],
+             counts[PERF_COUNTER_CYCLES],
+             instructions_per_cycle,
+             counts[PERF_COUNTER_CACHE_MISSES],
+             counts[PERF_COUNTER_BRANCH_MISSES],
+             counters->is_multiplexed ? " (scaled)" : "");
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// What reading the group costs, and a sanity check of the counts on a loop with a known instruction mix
+int32 perf_counters_run_benchmark(uint32 read_count)
+{
+    Perf_Counters* counters = &global_perf_counters;
+    if (!perf_counters_open(counters))
+    {
+        return 1;
+    }
+
+    printf("Hardware counters benchmark: %u group reads, counters open: %s%s%s%s\n",
+           read_count,
+           (counters->open_mask & (1 << PERF_COUNTER_INSTRUCTIONS)) ? "instructions " : "",
+           (counters->open_mask & (1 << PERF_COUNTER_CYCLES)) ? "cycles " : "",
+           (counters->open_mask & (1 << PERF_COUNTER_CACHE_MISSES)) ? "cache-misses " : "",
+           (counters->open_mask & (1 << PERF_COUNTER_BRANCH_MISSES)) ? "branch-misses" : "");
+
+    // Phase 0 is a plain loop, phase 1 is the reads themselves
+    perf_counters_begin_frame(counters);
+    volatile uint64 sum = 0;
+    for (uint32 i = 0; i < 10 * 1000 * 1000; i++)
+    {
+        sum = sum + i;
+    }
+    perf_counters_end_phase(counters, 0);
+
+    Uint64 counter_start = SDL_GetPerformanceCounter();
+    uint64 values[PERF_COUNTER_COUNT] = {};
+    for (uint32 i = 0; i < read_count; i++)
+    {
+        perf_counters_read(counters, values);
+    }
+    Uint64 counter_end = SDL_GetPerformanceCounter();
+    perf_counters_end_phase(counters, 1);
+
+    real64 seconds = (real64)(counter_end - counter_start) / (real64)SDL_GetPerformanceFrequency();
+    printf("  %.0f ns per group read, %u failed\n", seconds * 1e9 / SDL_max(read_count, 1u), counters->read_failures);
+
+    char text[160];
+    perf_counters_format_phase(counters, 0, text, sizeof(text));
+    printf("  10M iteration loop, %s\n", text + strlen(perf_phase_name(0)) + 2);
+    perf_counters_format_phase(counters, 1, text, sizeof(text));
+    printf("  The reads, %s\n", text + strlen(perf_phase_name(1)) + 2);
+
+    perf_counters_close(counters);
+    return 0;
+}
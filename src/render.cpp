@@ -39,10 +39,10 @@ TTF_Font* get_font(int32 pt_size)
     }
 
     // Font not found in cache, so load it
-    TTF_Font* font = TTF_OpenFont("fonts/Share_Tech_Mono/ShareTechMono-Regular.ttf", pt_size);
+    TTF_Font* font = TTF_OpenFontRW(asset_open("fonts/Share_Tech_Mono/ShareTechMono-Regular.ttf"), 1, pt_size);
     if (!font)
     {
-        fprintf(stderr, "Failed to load font: %s\n", TTF_GetError());
+        log_error("Failed to load font: %s\n", TTF_GetError());
         return NULL;
     }
 
@@ -55,7 +55,7 @@ TTF_Font* get_font(int32 pt_size)
     }
     else
     {
-        fprintf(stderr, "Font cache is full!\n");
+        log_error("Font cache is full!\n");
     }
 
     return font;
@@ -78,9 +78,12 @@ struct Drawn_Text
     real32 font_size;
     SDL_Color color;
     SDL_Rect text_rect;
-    SDL_Texture* cached_texture;
+    Texture_Id cached_texture_id;
 };
 
+#define DIGIT_GLYPH_COUNT 10
+
+// Integer text is put together from cached digit glyphs, so a changing value never has to create new textures
 struct Drawn_Text_Int32
 {
     char* text_string;
@@ -88,7 +91,8 @@ struct Drawn_Text_Int32
     real32 font_size;
     SDL_Color color;
     SDL_Rect text_rect;
-    SDL_Texture* cached_texture;
+    Texture_Id glyph_texture_ids[DIGIT_GLYPH_COUNT];
+    SDL_Rect glyph_rects[DIGIT_GLYPH_COUNT];
 };
 
 int32 get_font_pt_size(real32 font_size)
@@ -96,35 +100,54 @@ int32 get_font_pt_size(real32 font_size)
     return (int32)(0.5f + font_size * global_text_dpi_scale_factor);
 }
 
+// Renders the text into a new texture and writes its (logical) size into text_rect
+SDL_Texture* create_text_texture(const char* text_string, real32 font_size, SDL_Color color, SDL_Rect* text_rect)
+{
+    SDL_assert(font_size > 0);
+    int32 pt_size = get_font_pt_size(font_size);
+    TTF_Font* font = get_font(pt_size);
+    SDL_Surface* surface = TTF_RenderText_Blended(font, text_string, color);
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(global_renderer, surface);
+    // Pass-through the color's alpha channel to control opacity
+    SDL_SetTextureAlphaMod(texture, color.a);
+    SDL_FreeSurface(surface);
+
+    SDL_QueryTexture(texture, NULL, NULL, &text_rect->w, &text_rect->h);
+
+    text_rect->w /= global_text_dpi_scale_factor;
+    text_rect->h /= global_text_dpi_scale_factor;
+
+    return texture;
+}
+
 struct Drawn_Text_Static
 {
     const char* text_string;
     real32 font_size;
     SDL_Color color;
     SDL_Rect text_rect;
-    SDL_Texture* cached_texture;
+    Texture_Id cached_texture_id;
 };
 
-void draw_text_static(Drawn_Text_Static* drawn_text)
+// Creates the cached texture up front so the first draw doesn't have to allocate
+SDL_Texture* prepare_text_static(Drawn_Text_Static* drawn_text)
 {
-    if (!drawn_text->cached_texture)
+    SDL_Texture* texture = texture_manager_use(drawn_text->cached_texture_id);
+    if (!texture)
     {
-        SDL_assert(drawn_text->font_size > 0);
-        int32 pt_size = get_font_pt_size(drawn_text->font_size);
-        TTF_Font* font = get_font(pt_size);
-        SDL_Surface* surface = TTF_RenderText_Blended(font, drawn_text->text_string, drawn_text->color);
-        drawn_text->cached_texture = SDL_CreateTextureFromSurface(global_renderer, surface);
-        // Pass-through the color's alpha channel to control opacity
-        SDL_SetTextureAlphaMod(drawn_text->cached_texture, drawn_text->color.a);
-        SDL_FreeSurface(surface);
-
-        SDL_QueryTexture(drawn_text->cached_texture, NULL, NULL, &drawn_text->text_rect.w, &drawn_text->text_rect.h);
-
-        drawn_text->text_rect.w /= global_text_dpi_scale_factor;
-        drawn_text->text_rect.h /= global_text_dpi_scale_factor;
+        texture = create_text_texture(
+            drawn_text->text_string, drawn_text->font_size, drawn_text->color, &drawn_text->text_rect);
+        drawn_text->cached_texture_id =
+            texture_manager_set(drawn_text->cached_texture_id, texture, drawn_text->text_string);
     }
+    return texture;
+}
+
+void draw_text_static(Drawn_Text_Static* drawn_text)
+{
+    SDL_Texture* texture = prepare_text_static(drawn_text);
 
-    SDL_RenderCopy(global_renderer, drawn_text->cached_texture, NULL, &drawn_text->text_rect);
+    SDL_RenderCopy(global_renderer, texture, NULL, &drawn_text->text_rect);
 }
 
 struct Drawn_Text_Static_2
@@ -133,101 +156,85 @@ struct Drawn_Text_Static_2
     real32 font_size;
     SDL_Color color;
     SDL_Rect text_rect;
-    SDL_Texture* cached_texture;
+    Texture_Id cached_texture_id;
     bool32 should_update;
 };
 
 void draw_text_static_2(Drawn_Text_Static_2* drawn_text)
 {
-    if (!drawn_text->cached_texture || drawn_text->should_update)
+    // NOTE: The texture can also be missing because the texture manager evicted it
+    SDL_Texture* texture = texture_manager_use(drawn_text->cached_texture_id);
+    if (!texture || drawn_text->should_update)
     {
         drawn_text->should_update = 0;
 
-        if (drawn_text->cached_texture)
-        {
-            // Cleanup
-            SDL_DestroyTexture(drawn_text->cached_texture);
-            drawn_text->cached_texture = 0;
-        }
-
-        SDL_assert(drawn_text->font_size > 0);
-        int32 pt_size = get_font_pt_size(drawn_text->font_size);
-        TTF_Font* font = get_font(pt_size);
-        SDL_Surface* surface = TTF_RenderText_Blended(font, drawn_text->text_string, drawn_text->color);
-        drawn_text->cached_texture = SDL_CreateTextureFromSurface(global_renderer, surface);
-        // Pass-through the color's alpha channel to control opacity
-        SDL_SetTextureAlphaMod(drawn_text->cached_texture, drawn_text->color.a);
-        SDL_FreeSurface(surface);
-
-        SDL_QueryTexture(drawn_text->cached_texture, NULL, NULL, &drawn_text->text_rect.w, &drawn_text->text_rect.h);
-
-        drawn_text->text_rect.w /= global_text_dpi_scale_factor;
-        drawn_text->text_rect.h /= global_text_dpi_scale_factor;
+        // Replaces (and cleans up) the old texture
+        texture = create_text_texture(
+            drawn_text->text_string, drawn_text->font_size, drawn_text->color, &drawn_text->text_rect);
+        drawn_text->cached_texture_id =
+            texture_manager_set(drawn_text->cached_texture_id, texture, drawn_text->text_string);
     }
 
-    SDL_RenderCopy(global_renderer, drawn_text->cached_texture, NULL, &drawn_text->text_rect);
+    SDL_RenderCopy(global_renderer, texture, NULL, &drawn_text->text_rect);
 }
 
 void draw_text_real32(Drawn_Text* drawn_text, real32 current_value)
 {
-    if (!drawn_text->cached_texture || current_value != drawn_text->original_value)
+    SDL_Texture* texture = texture_manager_use(drawn_text->cached_texture_id);
+    if (!texture || current_value != drawn_text->original_value)
     {
         drawn_text->original_value = current_value;
 
-        if (drawn_text->cached_texture)
-        {
-            // Cleanup
-            SDL_DestroyTexture(drawn_text->cached_texture);
-            drawn_text->cached_texture = 0;
-        }
-
-        SDL_assert(drawn_text->font_size > 0);
-        int32 pt_size = get_font_pt_size(drawn_text->font_size);
-        TTF_Font* font = get_font(pt_size);
-        SDL_Surface* surface = TTF_RenderText_Blended(font, drawn_text->text_string, drawn_text->color);
-        drawn_text->cached_texture = SDL_CreateTextureFromSurface(global_renderer, surface);
-        // Pass-through the color's alpha channel to control opacity
-        SDL_SetTextureAlphaMod(drawn_text->cached_texture, drawn_text->color.a);
-        SDL_FreeSurface(surface);
+        // Replaces (and cleans up) the old texture
+        texture = create_text_texture(
+            drawn_text->text_string, drawn_text->font_size, drawn_text->color, &drawn_text->text_rect);
+        drawn_text->cached_texture_id = texture_manager_set(drawn_text->cached_texture_id, texture, "debug text");
+    }
 
-        SDL_QueryTexture(drawn_text->cached_texture, NULL, NULL, &drawn_text->text_rect.w, &drawn_text->text_rect.h);
+    SDL_RenderCopy(global_renderer, texture, NULL, &drawn_text->text_rect);
+}
 
-        drawn_text->text_rect.w /= global_text_dpi_scale_factor;
-        drawn_text->text_rect.h /= global_text_dpi_scale_factor;
+void prepare_text_int32(Drawn_Text_Int32* drawn_text)
+{
+    for (int32 digit = 0; digit < DIGIT_GLYPH_COUNT; digit++)
+    {
+        if (!texture_manager_use(drawn_text->glyph_texture_ids[digit]))
+        {
+            char digit_string[2] = {(char)('0' + digit), '\0'};
+            SDL_Texture* texture = create_text_texture(
+                digit_string, drawn_text->font_size, drawn_text->color, &drawn_text->glyph_rects[digit]);
+            drawn_text->glyph_texture_ids[digit] =
+                texture_manager_set(drawn_text->glyph_texture_ids[digit], texture, "digit glyph");
+        }
     }
-
-    SDL_RenderCopy(global_renderer, drawn_text->cached_texture, NULL, &drawn_text->text_rect);
 }
 
+// NOTE: Only digits get drawn. text_string should already hold the formatted value.
 void draw_text_int32(Drawn_Text_Int32* drawn_text, int32 current_value)
 {
-    if (!drawn_text->cached_texture || current_value != drawn_text->original_value)
-    {
-        drawn_text->original_value = current_value;
+    prepare_text_int32(drawn_text);
+    drawn_text->original_value = current_value;
 
-        if (drawn_text->cached_texture)
+    drawn_text->text_rect.w = 0;
+    drawn_text->text_rect.h = 0;
+    for (char* c = drawn_text->text_string; *c; c++)
+    {
+        if (*c < '0' || *c > '9')
         {
-            // Cleanup
-            SDL_DestroyTexture(drawn_text->cached_texture);
-            drawn_text->cached_texture = 0;
+            continue;
         }
 
-        SDL_assert(drawn_text->font_size > 0);
-        int32 pt_size = get_font_pt_size(drawn_text->font_size);
-        TTF_Font* font = get_font(pt_size);
-        SDL_Surface* surface = TTF_RenderText_Blended(font, drawn_text->text_string, drawn_text->color);
-        drawn_text->cached_texture = SDL_CreateTextureFromSurface(global_renderer, surface);
-        // Pass-through the color's alpha channel to control opacity
-        SDL_SetTextureAlphaMod(drawn_text->cached_texture, drawn_text->color.a);
-        SDL_FreeSurface(surface);
-
-        SDL_QueryTexture(drawn_text->cached_texture, NULL, NULL, &drawn_text->text_rect.w, &drawn_text->text_rect.h);
+        SDL_Rect glyph_rect = drawn_text->glyph_rects[*c - '0'];
+        glyph_rect.x = drawn_text->text_rect.x + drawn_text->text_rect.w;
+        glyph_rect.y = drawn_text->text_rect.y;
+        SDL_RenderCopy(global_renderer, texture_manager_use(drawn_text->glyph_texture_ids[*c - '0']), NULL, &glyph_rect);
 
-        drawn_text->text_rect.w /= global_text_dpi_scale_factor;
-        drawn_text->text_rect.h /= global_text_dpi_scale_factor;
+        drawn_text->text_rect.w += glyph_rect.w;
+        if (glyph_rect.h > drawn_text->text_rect.h)
+        {
+            drawn_text->text_rect.h = glyph_rect.h;
+        }
     }
-
-    SDL_RenderCopy(global_renderer, drawn_text->cached_texture, NULL, &drawn_text->text_rect);
 }
 
 struct Screen_Space_Position
@@ -250,14 +257,49 @@ Screen_Space_Position map_world_space_position_to_screen_space_position(real32 w
     return result;
 }
 
-void draw_canvas()
+// A view onto a board bigger than the canvas, as the world cell that's at the bottom left of the canvas
+struct Camera
+{
+    int32 x;
+    int32 y;
+};
+
+// Same as above but with the camera moved over the board
+Screen_Space_Position map_world_space_position_to_camera_space_position(Camera* camera, real32 world_x, real32 world_y)
+{
+    return map_world_space_position_to_screen_space_position(world_x - camera->x, world_y - camera->y);
+}
+
+// Same as the screen space one but for a board texture where every grid cell is cell_size pixels wide
+Screen_Space_Position map_world_space_position_to_board_space_position(real32 world_x, real32 world_y, uint32 cell_size)
+{
+    Screen_Space_Position result = {};
+    result.x = world_x * cell_size;
+    // Flip Y so positive y is up and negative y is down
+    result.y = (Y_GRIDS - (world_y + 1)) * cell_size;
+    return result;
+}
+
+SDL_Rect get_canvas_rect()
 {
-     // NOTE: We need this to distinguish the 'usable canvas' from the black dead-space (due to differing aspect ratios)
     SDL_Rect drawable_canvas;
     drawable_canvas.x = 0;
     drawable_canvas.y = 0;
     drawable_canvas.w = LOGICAL_WIDTH;
     drawable_canvas.h = LOGICAL_HEIGHT;
+    return drawable_canvas;
+}
+
+void clip_to_canvas()
+{
+    SDL_Rect drawable_canvas = get_canvas_rect();
+    SDL_RenderSetClipRect(global_renderer, &drawable_canvas);
+}
+
+void draw_canvas()
+{
+     // NOTE: We need this to distinguish the 'usable canvas' from the black dead-space (due to differing aspect ratios)
+    SDL_Rect drawable_canvas = get_canvas_rect();
 
     // Set the clip rectangle to restrict rendering
     SDL_RenderSetClipRect(global_renderer, &drawable_canvas);
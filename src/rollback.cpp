@@ -0,0 +1,376 @@
+#include <SDL2/SDL.h>
+
+#include "snake_sim.h"
+
+// Rollback netcode for two player versus. The two processes only ever send each other their own directions, tagged
+// with the frame (cell) they're for. Each side runs ahead on a guess of the other's input (that they keep going
+// straight), and when the real input turns out to be different it restores the snapshot from before that frame and
+// simulates the frames since again with the right inputs, all within one update.
+//
+// That works because the whole game is a Versus_Sim: a small header and the two Snake_Sims in one block, so a snapshot
+// is one memcpy, and the rules only depend on the inputs.
+
+#define VERSUS_PLAYER_COUNT 2
+// How many frames a side can get ahead of the inputs it has from the other one before it waits
+#define VERSUS_MAX_PREDICTION_FRAMES 32
+// Inputs and snapshots kept, more than enough for the frames that can still be rolled back
+#define VERSUS_HISTORY_FRAMES 128
+// A side is at most 2 * VERSUS_MAX_PREDICTION_FRAMES ahead of what the other one has acknowledged
+#define VERSUS_PACKET_MAX_INPUTS (2 * VERSUS_MAX_PREDICTION_FRAMES)
+// Frames after a game ends before the next one starts, the same on both sides because it's part of the rules
+#define VERSUS_RESTART_FRAMES 20
+
+#define VERSUS_PACKET_MAGIC 0x53565253  // "SRVS"
+
+//=======================================================
+// VERSUS SIM
+//=======================================================
+
+struct Versus_Sim
+{
+    uint32 size;  // Bytes, counting both Snake_Sims after the header
+    uint32 snake_size;
+    uint32 frame;  // Frames simulated since the start
+    uint32 frames_since_game_over;
+    uint8 is_game_over;
+    uint8 loser_mask;  // Bit per player, both when they crash at the same time
+    uint8 padding[6];
+    uint32 wins[VERSUS_PLAYER_COUNT];
+};
+
+static_assert(sizeof(Versus_Sim) % 8 == 0, "Versus_Sim must keep the Snake_Sims after it aligned");
+
+uint32 versus_sim_size(int32 width, int32 height)
+{
+    return sizeof(Versus_Sim) + VERSUS_PLAYER_COUNT * snake_sim_size(width, height);
+}
+
+inline Snake_Sim* versus_sim_get_snake(Versus_Sim* sim, uint32 player)
+{
+    return (Snake_Sim*)((uint8*)(sim + 1) + player * sim->snake_size);
+}
+
+// Player 0 starts in the bottom left going north, player 1 in the top right going south
+local_internal void versus_sim_start_game(Versus_Sim* sim)
+{
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        Snake_Sim* snake = versus_sim_get_snake(sim, player);
+        int32 x = player == 0 ? snake->width / 4 : snake->width * 3 / 4;
+        int32 y = player == 0 ? snake->height / 4 : snake->height * 3 / 4;
+        snake_sim_reset_at(snake, x, y, player == 0 ? DIRECTION_NORTH : DIRECTION_SOUTH, x, snake->height / 2);
+    }
+    sim->is_game_over = false;
+    sim->loser_mask = 0;
+    sim->frames_since_game_over = 0;
+}
+
+// Both sides have to pass the same seed
+void versus_sim_init(Versus_Sim* sim, int32 width, int32 height, uint32 seed)
+{
+    memset(sim, 0, sizeof(Versus_Sim));
+    sim->size = versus_sim_size(width, height);
+    sim->snake_size = snake_sim_size(width, height);
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        snake_sim_init(versus_sim_get_snake(sim, player), width, height, seed + player);
+    }
+    versus_sim_start_game(sim);
+}
+
+// Both snakes move at once. Running into either snake is a crash, and so is both heads landing on the same cell.
+void versus_sim_step(Versus_Sim* sim, Direction* inputs)
+{
+    sim->frame++;
+
+    if (sim->is_game_over)
+    {
+        if (++sim->frames_since_game_over >= VERSUS_RESTART_FRAMES)
+        {
+            versus_sim_start_game(sim);
+        }
+        return;
+    }
+
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        if (snake_sim_step(versus_sim_get_snake(sim, player), inputs[player]) & SNAKE_SIM_CRASHED)
+        {
+            sim->loser_mask |= 1 << player;
+        }
+    }
+
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        Snake_Sim* snake = versus_sim_get_snake(sim, player);
+        Snake_Sim* other = versus_sim_get_snake(sim, 1 - player);
+        if (!(sim->loser_mask & (1 << player)) && snake_sim_is_occupied(other, snake->head_x, snake->head_y))
+        {
+            sim->loser_mask |= 1 << player;
+        }
+    }
+
+    if (sim->loser_mask)
+    {
+        sim->is_game_over = true;
+        for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+        {
+            // Nobody wins when both crash
+            sim->wins[player] += sim->loser_mask == (1 << (1 - player));
+        }
+    }
+}
+
+//=======================================================
+// ROLLBACK SESSION
+//=======================================================
+
+// Both sides are assumed to be little endian
+#pragma pack(push, 1)
+struct Versus_Packet
+{
+    uint32 magic;
+    uint32 first_frame;  // Frame of inputs[0]
+    uint32 ack_frame_count;  // The sender has the receiver's inputs for every frame below this
+    uint32 sent__microseconds;  // Sender's clock
+    uint32 echo__microseconds;  // The last sent__microseconds the sender got from the receiver
+    uint32 echo_delay__microseconds;  // How long the sender held on to it, so it comes off the round trip
+    uint8 player;
+    uint8 input_count;
+    uint8 inputs[VERSUS_PACKET_MAX_INPUTS];  // Directions, input_count of them
+};
+#pragma pack(pop)
+
+struct Rollback_Stats
+{
+    uint32 rollback_count;
+    uint32 last_rollback_frames;  // How many frames got simulated again
+    uint32 max_rollback_frames;
+    uint64 resimulated_frames;
+    real32 last_resimulation__microseconds;
+    real32 max_resimulation__microseconds;
+    real64 total_resimulation__microseconds;
+    uint32 stall_count;  // Frames that had to wait for the other side's inputs
+    uint32 packets_sent;
+    uint32 packets_received;
+    real32 round_trip__ms;
+};
+
+struct Rollback_Session
+{
+    Versus_Sim* sim;
+    uint8* snapshots;  // VERSUS_HISTORY_FRAMES of sim->size, the state before each frame
+
+    uint32 local_player;
+    uint8 inputs[VERSUS_PLAYER_COUNT][VERSUS_HISTORY_FRAMES];  // Real or predicted, by frame
+    uint32 remote_frame_count;  // The remote inputs are real for every frame below this
+    uint32 acked_frame_count;  // The other side has our inputs for every frame below this
+    int64 rollback_frame;  // The first frame that was simulated with a wrong guess, or -1
+
+    Udp_Socket udp_socket;
+    Udp_Address remote_address;
+    uint32 last_remote_sent__microseconds;
+    uint64 last_remote_received__microseconds;  // Our clock
+
+    Rollback_Stats stats;
+};
+
+local_internal uint64 rollback_get_time__microseconds()
+{
+    uint64 counter = SDL_GetPerformanceCounter();
+    uint64 frequency = SDL_GetPerformanceFrequency();
+    // Split up so the multiply can't overflow
+    return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
+bool32 rollback_session_init(Rollback_Session* session,
+                             Memory_Arena* arena,
+                             uint32 local_player,
+                             uint16 local_port,
+                             const char* remote_host,
+                             uint16 remote_port,
+                             int32 width,
+                             int32 height)
+{
+    *session = {};
+    session->local_player = local_player;
+    session->rollback_frame = -1;
+
+    uint32 sim_size = versus_sim_size(width, height);
+    session->sim = (Versus_Sim*)push_size(arena, sim_size, 64);
+    session->snapshots = (uint8*)push_size(arena, (size_t)sim_size * VERSUS_HISTORY_FRAMES, 64);
+    versus_sim_init(session->sim, width, height, 12345);
+
+    return udp_socket_open(&session->udp_socket, local_port) &&
+           udp_resolve(remote_host, remote_port, &session->remote_address);
+}
+
+void rollback_session_shutdown(Rollback_Session* session)
+{
+    udp_socket_close(&session->udp_socket);
+}
+
+// Simulates the next frame from whatever inputs are there for it, real or guessed
+local_internal void rollback_simulate_frame(Rollback_Session* session)
+{
+    Versus_Sim* sim = session->sim;
+    uint32 slot = sim->frame % VERSUS_HISTORY_FRAMES;
+    memcpy(session->snapshots + (size_t)slot * sim->size, sim, sim->size);
+
+    Direction inputs[VERSUS_PLAYER_COUNT];
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        inputs[player] = (Direction)session->inputs[player][slot];
+    }
+    versus_sim_step(sim, inputs);
+}
+
+// True when the next frame would be too far past the last input from the other side
+bool32 rollback_session_is_waiting(Rollback_Session* session)
+{
+    return session->sim->frame >= session->remote_frame_count + VERSUS_MAX_PREDICTION_FRAMES;
+}
+
+// Adds the local input for the next frame and simulates it. Check rollback_session_is_waiting() first.
+void rollback_session_advance(Rollback_Session* session, Direction local_input)
+{
+    Versus_Sim* sim = session->sim;
+    SDL_assert(!rollback_session_is_waiting(session));
+
+    uint32 slot = sim->frame % VERSUS_HISTORY_FRAMES;
+    session->inputs[session->local_player][slot] = (uint8)local_input;
+    if (sim->frame >= session->remote_frame_count)
+    {
+        // Guess that the other snake keeps going the way it is
+        session->inputs[1 - session->local_player][slot] = DIRECTION_NONE;
+    }
+
+    rollback_simulate_frame(session);
+}
+
+void rollback_session_send(Rollback_Session* session)
+{
+    Versus_Sim* sim = session->sim;
+
+    Versus_Packet packet = {};
+    packet.magic = VERSUS_PACKET_MAGIC;
+    packet.player = (uint8)session->local_player;
+    packet.ack_frame_count = session->remote_frame_count;
+
+    uint64 now__microseconds = rollback_get_time__microseconds();
+    packet.sent__microseconds = (uint32)now__microseconds;
+    packet.echo__microseconds = session->last_remote_sent__microseconds;
+    packet.echo_delay__microseconds = (uint32)(now__microseconds - session->last_remote_received__microseconds);
+
+    // Everything the other side hasn't acknowledged yet, so a lost packet never needs resending on its own
+    uint32 oldest_frame = sim->frame - SDL_min(sim->frame, VERSUS_PACKET_MAX_INPUTS);
+    uint32 first_frame = SDL_max(session->acked_frame_count, oldest_frame);
+    packet.first_frame = first_frame;
+    packet.input_count = (uint8)(sim->frame - first_frame);
+    for (uint32 i = 0; i < packet.input_count; i++)
+    {
+        packet.inputs[i] = session->inputs[session->local_player][(first_frame + i) % VERSUS_HISTORY_FRAMES];
+    }
+
+    int32 size = (int32)(offsetof(Versus_Packet, inputs) + packet.input_count);
+    if (udp_socket_send(&session->udp_socket, &session->remote_address, &packet, size))
+    {
+        session->stats.packets_sent++;
+    }
+}
+
+// Anything past DIRECTION_WEST would get past snake_sim_step's turn check and into the body moves
+local_internal bool32 rollback_are_inputs_valid(const Versus_Packet* packet)
+{
+    for (uint32 i = 0; i < packet->input_count; i++)
+    {
+        if (packet->inputs[i] > DIRECTION_WEST)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads every packet that's arrived. Inputs for frames that already got simulated on a wrong guess mark where to roll
+// back to.
+local_internal void rollback_session_receive(Rollback_Session* session)
+{
+    uint32 remote_player = 1 - session->local_player;
+
+    Versus_Packet packet;
+    Udp_Address from;
+    int32 size;
+    while ((size = udp_socket_receive(&session->udp_socket, &packet, sizeof(packet), &from)) > 0)
+    {
+        if (size < (int32)offsetof(Versus_Packet, inputs) || packet.magic != VERSUS_PACKET_MAGIC ||
+            packet.player != remote_player || packet.input_count > VERSUS_PACKET_MAX_INPUTS ||
+            size < (int32)offsetof(Versus_Packet, inputs) + packet.input_count || !rollback_are_inputs_valid(&packet))
+        {
+            continue;
+        }
+        session->stats.packets_received++;
+
+        uint64 now__microseconds = rollback_get_time__microseconds();
+        if (packet.echo__microseconds)
+        {
+            uint32 round_trip__microseconds =
+                (uint32)now__microseconds - packet.echo__microseconds - packet.echo_delay__microseconds;
+            session->stats.round_trip__ms = round_trip__microseconds / 1000.0f;
+        }
+        session->last_remote_sent__microseconds = packet.sent__microseconds;
+        session->last_remote_received__microseconds = now__microseconds;
+
+        session->acked_frame_count = SDL_max(session->acked_frame_count, packet.ack_frame_count);
+
+        // Only ever takes the next input in order, the packets always start at or before it
+        uint32 end_frame = packet.first_frame + packet.input_count;
+        for (uint32 frame = session->remote_frame_count; frame >= packet.first_frame && frame < end_frame; frame++)
+        {
+            uint32 slot = frame % VERSUS_HISTORY_FRAMES;
+            uint8 input = packet.inputs[frame - packet.first_frame];
+            if (frame < session->sim->frame && session->inputs[remote_player][slot] != input &&
+                (session->rollback_frame < 0 || frame < session->rollback_frame))
+            {
+                session->rollback_frame = frame;
+            }
+            session->inputs[remote_player][slot] = input;
+            session->remote_frame_count = frame + 1;
+        }
+    }
+}
+
+// Call once per update: takes in the other side's inputs and fixes up any frames that were simulated on a wrong guess
+void rollback_session_update(Rollback_Session* session)
+{
+    rollback_session_receive(session);
+
+    if (session->rollback_frame < 0)
+    {
+        return;
+    }
+
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    Versus_Sim* sim = session->sim;
+    uint32 current_frame = sim->frame;
+    uint32 rollback_frame = (uint32)session->rollback_frame;
+    memcpy(sim, session->snapshots + (size_t)(rollback_frame % VERSUS_HISTORY_FRAMES) * sim->size, sim->size);
+    while (sim->frame < current_frame)
+    {
+        rollback_simulate_frame(session);
+    }
+    session->rollback_frame = -1;
+
+    real32 elapsed__microseconds =
+        (real32)((SDL_GetPerformanceCounter() - start_counter) * 1000000.0 / (real64)SDL_GetPerformanceFrequency());
+
+    Rollback_Stats* stats = &session->stats;
+    stats->rollback_count++;
+    stats->last_rollback_frames = current_frame - rollback_frame;
+    stats->max_rollback_frames = SDL_max(stats->max_rollback_frames, stats->last_rollback_frames);
+    stats->resimulated_frames += stats->last_rollback_frames;
+    stats->last_resimulation__microseconds = elapsed__microseconds;
+    stats->max_resimulation__microseconds = SDL_max(stats->max_resimulation__microseconds, elapsed__microseconds);
+    stats->total_resimulation__microseconds += elapsed__microseconds;
+}
@@ -2,24 +2,17 @@
 
 #include "../audio.h"
 #include "../common.h"
-
-typedef enum
-{
-    DIRECTION_NONE,  // Represents no movement
-    DIRECTION_NORTH,
-    DIRECTION_EAST,
-    DIRECTION_SOUTH,
-    DIRECTION_WEST
-} Direction;
-
-struct Snake_Part
-{
-    int32 pos_x;
-    int32 pos_y;
-    Direction direction;
-};
-
-#define MAX_TAIL_LENGTH 1000
+#include "../snake_sim.h"
+
+// All in simulation time
+#define START_GRID_JUMP_INTERVAL__MICROSECONDS 100000
+#define GRID_JUMP_SPEED_UP__MICROSECONDS 500  // Taken off the interval for every blip
+#define MIN_GRID_JUMP_INTERVAL__MICROSECONDS 500  // As fast as blips can speed the snake up
+#define MIN_TURBO_GRID_JUMP_INTERVAL__MICROSECONDS 50
+#define MAX_CELLS_PER_TICK 4096  // So a huge catch-up can't stall a frame
+#define MAX_BLIP_SOUND_PITCH 2.0f
+#define PICKUP_PARTICLE_COUNT 64
+#define GAME_OVER_PARTICLE_COUNT 4096
 
 struct Gameplay__Texts
 {
@@ -30,27 +23,28 @@ struct Gameplay__Texts
     Drawn_Text_Static game_paused_drawn_text_static;
 };
 
+struct Gameplay__State;
+
+// Called before every cell the snake moves. Steers with add_input() just like the keyboard does.
+typedef void Gameplay__Autopilot(Gameplay__State* state);
+
 struct Gameplay__State
 {
     bool32 is_starting;
     bool32 game_over;
     bool32 is_paused;
 
-    int32 pos_x;
-    int32 pos_y;
-
-    Snake_Part snake_parts[MAX_TAIL_LENGTH];
-    uint32 next_snake_part_index;
-
-    Direction current_direction;
-    Direction proposed_direction;
-    bool32 direction_locked;
+    // The snake, the blip and the rules. Sized for the board, so it's allocated separately.
+    Snake_Sim* sim;
 
-    real32 time_until_grid_jump__seconds;
-    real32 set_time_until_grid_jump__seconds;
+    uint32 grid_jump_interval__microseconds;
+    uint64 next_grid_jump__microseconds;  // Simulation time, only valid while the timer is scheduled
+    uint64 microseconds_until_grid_jump;  // Only kept while the timer isn't scheduled (i.e. paused)
+    Timer_Id grid_jump_timer;
+    uint64 cells_advanced;
+    uint32 max_cells_per_tick;
 
-    int32 blip_pos_x;
-    int32 blip_pos_y;
+    Gameplay__Autopilot* autopilot;  // NULL when the player is steering
 
     Gameplay__Texts* gameplay_texts;
 
@@ -107,6 +101,40 @@ Direction get_next_input()
     return dir;
 }
 
+local_internal void gameplay__grid_jump(void* data, uint64 tick);
+void gameplay__autoplay(Gameplay__State* state);
+void gameplay__mcts_autoplay(Gameplay__State* state);
+
+local_internal void gameplay__schedule_grid_jump(Gameplay__State* state, uint64 earliest_tick)
+{
+    uint64 due_tick = get_simulation_tick_at(state->next_grid_jump__microseconds);
+    state->grid_jump_timer =
+        timer_wheel_schedule(&global_simulation_timers, SDL_max(due_tick, earliest_tick), gameplay__grid_jump, state);
+}
+
+// Pausing takes the grid jump off the timer wheel and remembers how far off it was
+local_internal void gameplay__set_paused(Gameplay__State* state, bool32 is_paused)
+{
+    Timer_Wheel* timers = &global_simulation_timers;
+
+    uint64 now__microseconds = get_simulation_time__microseconds(timers->current_tick);
+
+    if (is_paused && timer_wheel_is_scheduled(timers, state->grid_jump_timer))
+    {
+        state->microseconds_until_grid_jump = state->next_grid_jump__microseconds > now__microseconds
+                                                  ? state->next_grid_jump__microseconds - now__microseconds
+                                                  : 0;
+        timer_wheel_cancel(timers, state->grid_jump_timer);
+    }
+    else if (!is_paused && !state->game_over && !timer_wheel_is_scheduled(timers, state->grid_jump_timer))
+    {
+        state->next_grid_jump__microseconds = now__microseconds + state->microseconds_until_grid_jump;
+        gameplay__schedule_grid_jump(state, timers->current_tick + 1);
+    }
+
+    state->is_paused = is_paused;
+}
+
 void gameplay__reset_state(Scene* scene)
 {
     Gameplay__State* state = (Gameplay__State*)scene->state;
@@ -118,19 +146,21 @@ void gameplay__reset_state(Scene* scene)
     state->is_paused = 1;
     state->game_over = 0;
 
-    state->pos_x = X_GRIDS / 2;
-    state->pos_y = Y_GRIDS / 4;
-    state->current_direction = DIRECTION_NORTH;
-    state->next_snake_part_index = 0;
-
-    state->set_time_until_grid_jump__seconds = .1f;
-    state->time_until_grid_jump__seconds = state->set_time_until_grid_jump__seconds;
+    snake_sim_reset(state->sim);
+    spectator_server_publish_keyframe(&global_spectator_server, state->sim, global_simulation_timers.current_tick);
+    flight_recorder_record_marker(&global_flight_recorder, FLIGHT_MARKER_GAME_START);
 
-    state->blip_pos_x = X_GRIDS / 2;
-    state->blip_pos_y = Y_GRIDS / 2;
+    state->grid_jump_interval__microseconds = START_GRID_JUMP_INTERVAL__MICROSECONDS;
+    if (TURBO_GRID_JUMP_INTERVAL__MICROSECONDS)
+    {
+        state->grid_jump_interval__microseconds =
+            SDL_max(TURBO_GRID_JUMP_INTERVAL__MICROSECONDS, MIN_TURBO_GRID_JUMP_INTERVAL__MICROSECONDS);
+    }
+    timer_wheel_cancel(&global_simulation_timers, state->grid_jump_timer);
+    state->microseconds_until_grid_jump = state->grid_jump_interval__microseconds;
 }
 
-Gameplay__Texts gameplay__setup_text()
+Gameplay__Texts gameplay__setup_text(Memory_Arena* arena)
 {
     SDL_Color white_text_color = {255, 255, 255, 255};  // White color
     real32 font_size = 16.0f;
@@ -169,7 +199,7 @@ Gameplay__Texts gameplay__setup_text()
     restart_drawn_text_static.text_rect.x = -LOGICAL_WIDTH; // Draw off-screen initially;
 
 
-    char dynamic_score_text[DYNAMIC_SCORE_LENGTH]; // Make sure the buffer is large enough
+    char* dynamic_score_text = push_array(arena, DYNAMIC_SCORE_LENGTH, char); // Make sure the buffer is large enough
     Drawn_Text_Int32 score_drawn_text_dynamic = {};
     score_drawn_text_dynamic.original_value = -1;
     score_drawn_text_dynamic.text_string = dynamic_score_text;
@@ -184,6 +214,13 @@ Gameplay__Texts gameplay__setup_text()
     gameplay_texts.restart_drawn_text_static = restart_drawn_text_static;
     gameplay_texts.game_paused_drawn_text_static = game_paused_drawn_text_static;
 
+    // Create every texture now so playing a game never has to allocate
+    prepare_text_static(&gameplay_texts.score_drawn_text_static);
+    prepare_text_int32(&gameplay_texts.score_drawn_text_dynamic);
+    prepare_text_static(&gameplay_texts.game_over_drawn_text_static);
+    prepare_text_static(&gameplay_texts.restart_drawn_text_static);
+    prepare_text_static(&gameplay_texts.game_paused_drawn_text_static);
+
     return gameplay_texts;
 }
 
@@ -193,16 +230,34 @@ void gameplay__handle_input(Scene* scene, Input* input)
 
     if (pressed(BUTTON_ESCAPE))
     {
-        global_current_scene = &global_start_screen_scene;
+        global_next_scene = &global_start_screen_scene;
         stop_music();
     }
 
     if (pressed(BUTTON_SPACE) && !state->game_over)
     {
-        state->is_paused = !state->is_paused;
+        gameplay__set_paused(state, !state->is_paused);
     }
 
-    if (!state->is_paused)
+    // The autoplayers steer through the same input queue, so the keys are ignored while one is on. Goes from off to
+    // the BFS autoplayer to MCTS and back to off.
+    if (pressed(BUTTON_TAB))
+    {
+        if (!state->autopilot)
+        {
+            state->autopilot = gameplay__autoplay;
+        }
+        else if (state->autopilot == gameplay__autoplay)
+        {
+            state->autopilot = gameplay__mcts_autoplay;
+        }
+        else
+        {
+            state->autopilot = NULL;
+        }
+    }
+
+    if (!state->is_paused && !state->autopilot)
     {
         if (pressed(BUTTON_W) || pressed(BUTTON_UP))
         {
@@ -228,7 +283,7 @@ void gameplay__handle_input(Scene* scene, Input* input)
     if (state->game_over && pressed(BUTTON_ENTER))
     {
         gameplay__reset_state(scene);
-        state->is_paused = 0;
+        gameplay__set_paused(state, 0);
     }
 }
 
@@ -236,25 +291,28 @@ void gameplay__handle_input(Scene* scene, Input* input)
 // UPDATE
 //=======================================================
 
-// Define parameters for the LCG
-uint32 seed = 12345;  // Initial seed value
-#define LCG_A 1664525u
-#define LCG_C 1013904223u
-
-// Function to generate a pseudorandom number using LCG
-uint32 custom_rand()
+// Sparks the colour of the blip when it gets eaten, out of the middle of the cell at cell_position. The world scene
+// uses these too.
+void gameplay__emit_pickup_particles(Screen_Space_Position cell_position)
 {
-    seed = LCG_A * seed + LCG_C;
-    return seed;
+    SDL_Color blue = {52, 152, 219, 255};
+    real32 x = cell_position.x + GRID_BLOCK_SIZE * 0.5f;
+    real32 y = cell_position.y + GRID_BLOCK_SIZE * 0.5f;
+    particles_emit_burst(&global_particles, x, y, PICKUP_PARTICLE_COUNT, 250.0f, 0.6f, 3.0f, blue);
 }
 
-// Function to generate a number between 0 and max - 1 (inclusive)
-uint32 custom_rand_range(uint32 max)
+// The head blowing up, in two layers: a fast bright flash and slower embers
+void gameplay__emit_game_over_particles(Screen_Space_Position cell_position)
 {
-    return custom_rand() % (max);
+    SDL_Color flash = {255, 220, 120, 255};
+    SDL_Color embers = {171, 70, 66, 255};
+    real32 x = cell_position.x + GRID_BLOCK_SIZE * 0.5f;
+    real32 y = cell_position.y + GRID_BLOCK_SIZE * 0.5f;
+    particles_emit_burst(&global_particles, x, y, GAME_OVER_PARTICLE_COUNT / 4, 900.0f, 0.5f, 3.0f, flash);
+    particles_emit_burst(&global_particles, x, y, GAME_OVER_PARTICLE_COUNT * 3 / 4, 400.0f, 2.0f, 4.0f, embers);
 }
 
-void gameplay__update(struct Scene* scene, real64 simulation_time_elapsed, real32 dt_s)
+void gameplay__update(struct Scene* scene, uint64 simulation_tick)
 {
     Gameplay__State* state = (Gameplay__State*)scene->state;
 
@@ -264,205 +322,582 @@ void gameplay__update(struct Scene* scene, real64 simulation_time_elapsed, real3
         play_music(&global_audio_context);
         set_music_volume(10.f);
     }
+}
 
-    if (state->game_over || state->is_paused)
+// Moves the snake one cell, with the blip pickup and crash checks for that cell
+local_internal void gameplay__advance_one_cell(Gameplay__State* state)
+{
+    if (state->autopilot)
     {
-        return;
+        state->autopilot(state);
     }
 
-    state->time_until_grid_jump__seconds -= dt_s;
-
-    if (state->time_until_grid_jump__seconds <= 0)
+    Direction input = get_next_input();
+    uint32 events = snake_sim_step(state->sim, input);
+    spectator_server_record_cell(&global_spectator_server, state->sim, events);
+    flight_recorder_record_cell(&global_flight_recorder,
+                                global_simulation_timers.current_tick,
+                                input,
+                                events,
+                                state->sim->head_x,
+                                state->sim->head_y,
+                                state->sim->length);
+
+    if (events & SNAKE_SIM_ATE)
     {
-        Direction proposed_direction = get_next_input();
-
-        if (!state->direction_locked)
+        // The beep climbs in pitch as the snake speeds up
+        real32 pitch = (real32)START_GRID_JUMP_INTERVAL__MICROSECONDS / state->grid_jump_interval__microseconds;
+        play_sound_effect(&global_audio_context.effect_beep_2, 1.0f, SDL_min(pitch, MAX_BLIP_SOUND_PITCH));
+        gameplay__emit_pickup_particles(
+            map_world_space_position_to_screen_space_position(state->sim->head_x, state->sim->head_y));
+
+        // Turbo starts out below the minimum, so blips never slow it down
+        if (state->grid_jump_interval__microseconds >
+            MIN_GRID_JUMP_INTERVAL__MICROSECONDS + GRID_JUMP_SPEED_UP__MICROSECONDS)
         {
-            switch (proposed_direction)
-            {
-                case DIRECTION_NORTH:
-                {
-                    if (state->current_direction != DIRECTION_SOUTH)
-                    {
-                        state->current_direction = DIRECTION_NORTH;
-                    }
-                }
-                break;
-                case DIRECTION_EAST:
-                {
-                    if (state->current_direction != DIRECTION_WEST)
-                    {
-                        state->current_direction = DIRECTION_EAST;
-                    }
-                }
-                break;
-                case DIRECTION_SOUTH:
-                {
-                    if (state->current_direction != DIRECTION_NORTH)
-                    {
-                        state->current_direction = DIRECTION_SOUTH;
-                    }
-                }
-                break;
-                case DIRECTION_WEST:
-                {
-                    if (state->current_direction != DIRECTION_EAST)
-                    {
-                        state->current_direction = DIRECTION_WEST;
-                    }
-                }
-                break;
+            state->grid_jump_interval__microseconds -= GRID_JUMP_SPEED_UP__MICROSECONDS;
+        }
+        else if (state->grid_jump_interval__microseconds > MIN_GRID_JUMP_INTERVAL__MICROSECONDS)
+        {
+            state->grid_jump_interval__microseconds = MIN_GRID_JUMP_INTERVAL__MICROSECONDS;
+        }
+    }
 
-                    state->direction_locked = 1;
-            }
+    if (state->sim->is_game_over)
+    {
+        state->game_over = 1;
+        play_sound_effect(&global_audio_context.effect_boom);
+        gameplay__emit_game_over_particles(
+            map_world_space_position_to_screen_space_position(state->sim->head_x, state->sim->head_y));
+
+        flight_recorder_record_marker(&global_flight_recorder,
+                                      FLIGHT_MARKER_GAME_OVER,
+                                      state->sim->length - 1,
+                                      state->sim->length,
+                                      (uint32)state->cells_advanced);
+        if (FLIGHT_RECORDER_DUMP_ON_GAME_OVER)
+        {
+            flight_recorder_dump_and_report(&global_flight_recorder, FLIGHT_DUMP_GAME_OVER, "Game over");
         }
+    }
 
-        {  // Blip collision
-            if (state->pos_x == state->blip_pos_x && state->pos_y == state->blip_pos_y)
-            {
-                play_sound_effect(global_audio_context.effect_beep_2);
+    state->cells_advanced++;
+}
 
-                {  // Grow snake part
-                    Snake_Part new_snake_part = {};
-                    Snake_Part* last_snake_part = &state->snake_parts[state->next_snake_part_index];
-                    new_snake_part.pos_x = last_snake_part->pos_x;
-                    new_snake_part.pos_y = last_snake_part->pos_y;
-                    new_snake_part.direction = last_snake_part->direction;
-                    state->next_snake_part_index++;
+// Scheduled on the timer wheel while the game is running. When the snake is faster than the tick rate several cells
+// are due on the same tick, and each one gets advanced (and checked) in turn. Reschedules itself with whatever the
+// speed is after the last cell.
+local_internal void gameplay__grid_jump(void* data, uint64 tick)
+{
+    Gameplay__State* state = (Gameplay__State*)data;
 
-                    if (!(state->next_snake_part_index < MAX_TAIL_LENGTH))
-                    {
-                        SDL_SetError("Snake tail must never get this long! %d", state->next_snake_part_index);
-                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
-                        SDL_assert_release(state->next_snake_part_index < MAX_TAIL_LENGTH);
-                    }
-                }
+    uint64 now__microseconds = get_simulation_time__microseconds(tick);
+
+    uint32 cell_count = 0;
+    do
+    {
+        gameplay__advance_one_cell(state);
+        state->next_grid_jump__microseconds += state->grid_jump_interval__microseconds;
+        cell_count++;
+    } while (!state->game_over && state->next_grid_jump__microseconds <= now__microseconds &&
+             cell_count < MAX_CELLS_PER_TICK);
 
-                {  // Randomly spawn blip somewhere else
-                    uint32 random_x = custom_rand_range(X_GRIDS);
-                    state->blip_pos_x = random_x;
+    if (cell_count > state->max_cells_per_tick)
+    {
+        state->max_cells_per_tick = cell_count;
+    }
 
-                    uint32 random_y = custom_rand_range(Y_GRIDS);
-                    state->blip_pos_y = random_y;
-                }
+    // Every cell from this tick goes out to the spectators as one message
+    spectator_server_publish_tick(&global_spectator_server, state->sim, tick);
 
-                state->set_time_until_grid_jump__seconds -= 0.0005;
-            }
+    if (!state->game_over)
+    {
+        // Anything left over from hitting MAX_CELLS_PER_TICK gets caught up on the next tick
+        gameplay__schedule_grid_jump(state, tick + 1);
+    }
+}
+
+//=======================================================
+// AUTOPLAY
+//=======================================================
+
+// Plans every cell with searches over bitboards of the grid: a BFS out from the blip finds the shortest way there, and
+// a flood fill checks there's still room for the whole snake after the move. Treats the snake as a wall even though
+// most of the tail will have moved on by the time the head gets there, which is safe but a bit timid.
+//
+// The searches get AUTOPLAYER_ROWS_PER_DECISION rows of bitboard work between them each cell, since in turbo a tick
+// can hold many cells. A search that runs out gives up, and the move gets picked from what's known by then.
+struct Gameplay__Autoplayer
+{
+    Bitboard free_cells;
+    Bitboard reached;
+
+    uint64 decision_count;
+    uint64 out_of_budget_count;  // Decisions that ran out of rows before the searches finished
+    real64 total_decision__microseconds;
+    real32 last_decision__microseconds;
+    real32 max_decision__microseconds;
+};
+
+Gameplay__Autoplayer global_autoplayer;
+
+// The bitboards are sized for the current X_GRIDS and Y_GRIDS
+void gameplay__autoplayer_init(Memory_Arena* arena)
+{
+    Gameplay__Autoplayer* autoplayer = &global_autoplayer;
+    *autoplayer = {};
+    autoplayer->free_cells = bitboard_make(arena, X_GRIDS, Y_GRIDS);
+    autoplayer->reached = bitboard_make(arena, X_GRIDS, Y_GRIDS);
+}
+
+// Takes the rows the next grow or count of reached is going to go over out of rows_left. False once there are none.
+local_internal bool32 gameplay__autoplayer_spend_rows(Bitboard* reached, int64* rows_left)
+{
+    *rows_left -= reached->last_row - reached->first_row + 3;
+    return *rows_left > 0;
+}
+
+// A move is safe if the head can still get to the end of the tail afterwards (it can always follow its own tail out)
+// or if there's room for the whole snake. Flood fills from (x, y) and stops as soon as either is true. room is how many
+// cells were reached. has_tail_end false means the tail can't be followed. Running out of rows_left isn't safe.
+local_internal bool32 gameplay__autoplayer_is_safe(Gameplay__Autoplayer* autoplayer,
+                                                   int32 x,
+                                                   int32 y,
+                                                   bool32 has_tail_end,
+                                                   int32 tail_end_x,
+                                                   int32 tail_end_y,
+                                                   uint32 snake_length,
+                                                   int64* rows_left,
+                                                   uint32* room)
+{
+    Bitboard* reached = &autoplayer->reached;
+    bitboard_clear(reached);
+    bitboard_set(reached, x, y);
+
+    bool32 is_safe = false;
+    for (uint32 layer = 1; !is_safe; layer++)
+    {
+        if (has_tail_end && bitboard_get(reached, tail_end_x, tail_end_y))
+        {
+            is_safe = true;
         }
+        else if (!gameplay__autoplayer_spend_rows(reached, rows_left))
+        {
+            break;
+        }
+        // Counting is as expensive as growing, so only check every so often
+        else if (layer % 16 == 0 && bitboard_count(reached) >= snake_length)
+        {
+            is_safe = true;
+        }
+        else if (!bitboard_grow(reached, &autoplayer->free_cells))
+        {
+            is_safe = bitboard_count(reached) >= snake_length;
+            break;
+        }
+    }
+
+    // Left at 0 when the rows ran out, it wouldn't be comparable with a finished fill
+    *room = *rows_left > 0 ? bitboard_count(reached) : 0;
+    return is_safe;
+}
 
-        for (int32 i = state->next_snake_part_index - 1; i >= 0; i--)
+// How many cells next to (x, y) are free, the cheapest check there is that a move isn't into a dead end
+local_internal uint32 gameplay__autoplayer_count_exits(Bitboard* free_cells, int32 x, int32 y)
+{
+    uint32 exit_count = 0;
+    for (int32 direction = DIRECTION_NORTH; direction <= DIRECTION_WEST; direction++)
+    {
+        int32 exit_x = x;
+        int32 exit_y = y;
+        snake_sim_move((Direction)direction, &exit_x, &exit_y);
+        if (bitboard_is_inside(free_cells, exit_x, exit_y) && bitboard_get(free_cells, exit_x, exit_y))
         {
-            Snake_Part* current_snake_part = &state->snake_parts[i];
+            exit_count++;
+        }
+    }
+    return exit_count;
+}
 
-            if (i == 0)
-            {
-                current_snake_part->pos_x = state->pos_x;
-                current_snake_part->pos_y = state->pos_y;
-                current_snake_part->direction = state->current_direction;
-            }
-            else
-            {
-                Snake_Part* previous_snake_part = &state->snake_parts[i - 1];
-                current_snake_part->pos_x = previous_snake_part->pos_x;
-                current_snake_part->pos_y = previous_snake_part->pos_y;
-                current_snake_part->direction = previous_snake_part->direction;
-            }
+void gameplay__autoplay(Gameplay__State* state)
+{
+    Gameplay__Autoplayer* autoplayer = &global_autoplayer;
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    Snake_Sim* sim = state->sim;
+
+    // Walks the body from the end of the tail up to the head. The end of the tail moves out of the way this cell,
+    // unless the snake is about to grow.
+    Bitboard* free_cells = &autoplayer->free_cells;
+    bitboard_fill(free_cells);
+    bool32 is_growing = sim->head_x == sim->blip_x && sim->head_y == sim->blip_y;
+    int32 part_x = sim->tail_x;
+    int32 part_y = sim->tail_y;
+    for (uint32 i = 0; i < sim->length; i++)
+    {
+        if (i > 0 || is_growing || sim->length == 1)
+        {
+            bitboard_unset(free_cells, part_x, part_y);
         }
+        if (i + 1 < sim->length)
+        {
+            snake_sim_move(snake_sim_get_body_move(sim, i), &part_x, &part_y);
+        }
+    }
 
-        switch (state->current_direction)
+    Direction moves[4];
+    int32 move_x[4];
+    int32 move_y[4];
+    uint32 move_count = 0;
+    for (int32 direction = DIRECTION_NORTH; direction <= DIRECTION_WEST; direction++)
+    {
+        int32 x = sim->head_x;
+        int32 y = sim->head_y;
+        snake_sim_move((Direction)direction, &x, &y);
+        if (direction != snake_sim_get_opposite((Direction)sim->direction) && bitboard_is_inside(free_cells, x, y) &&
+            bitboard_get(free_cells, x, y))
         {
-            case DIRECTION_NORTH:
+            moves[move_count] = (Direction)direction;
+            move_x[move_count] = x;
+            move_y[move_count] = y;
+            move_count++;
+        }
+    }
+
+    // Nowhere to go means the snake is about to crash whatever we do
+    if (move_count > 0)
+    {
+        int64 rows_left = AUTOPLAYER_ROWS_PER_DECISION;
+        bool32 is_out_of_budget = false;
+
+        // BFS out from the blip a layer at a time until it reaches a cell next to the head. The moves onto those cells
+        // are the first step of a shortest path. Gets half the rows at most, so there are some left to check the moves
+        // are safe.
+        bool32 is_shortest[4] = {};
+        {
+            Bitboard* reached = &autoplayer->reached;
+            bitboard_clear(reached);
+            bitboard_set(reached, sim->blip_x, sim->blip_y);
+
+            int64 search_rows_left = rows_left / 2;
+            for (;;)
             {
-                if (state->current_direction != DIRECTION_SOUTH)
+                bool32 has_found_path = false;
+                for (uint32 i = 0; i < move_count; i++)
                 {
-                    state->pos_y++;
+                    is_shortest[i] = bitboard_get(reached, move_x[i], move_y[i]);
+                    has_found_path |= is_shortest[i];
                 }
-            }
-            break;
-            case DIRECTION_EAST:
-            {
-                if (state->current_direction != DIRECTION_WEST)
+                if (has_found_path)
                 {
-                    state->pos_x++;
+                    break;
                 }
-            }
-            break;
-            case DIRECTION_SOUTH:
-            {
-                if (state->current_direction != DIRECTION_NORTH)
+                if (!gameplay__autoplayer_spend_rows(reached, &search_rows_left))
                 {
-                    state->pos_y--;
+                    // Too far to find the way in time, head straight for it instead
+                    is_out_of_budget = true;
+                    int32 distance = abs(sim->blip_x - sim->head_x) + abs(sim->blip_y - sim->head_y);
+                    for (uint32 i = 0; i < move_count; i++)
+                    {
+                        int32 move_distance = abs(sim->blip_x - move_x[i]) + abs(sim->blip_y - move_y[i]);
+                        is_shortest[i] = move_distance < distance;
+                    }
+                    break;
+                }
+                if (!bitboard_grow(reached, free_cells))
+                {
+                    break;
                 }
             }
-            break;
-            case DIRECTION_WEST:
+            rows_left -= rows_left / 2 - search_rows_left;
+        }
+
+        // Take a safe shortest move, then any safe move, otherwise whichever move has the most room
+        uint32 snake_length = sim->length;
+        bool32 has_tail_end = sim->length > 1;
+        if (has_tail_end)
+        {
+            // Reaching it means following it, not landing on it
+            bitboard_set(free_cells, sim->tail_x, sim->tail_y);
+        }
+
+        uint32 room[4] = {};
+        bool32 is_unsafe[4] = {};  // Only when the fill finished, running out of rows doesn't say either way
+        int32 chosen_move = -1;
+        for (int32 pass = 0; pass < 2 && chosen_move < 0; pass++)
+        {
+            for (uint32 i = 0; i < move_count; i++)
             {
-                if (state->current_direction != DIRECTION_EAST)
+                if (is_shortest[i] == (pass == 0))
                 {
-                    state->pos_x--;
+                    // Eating holds the tail still for a cell, so it might not get out of the way in time
+                    bool32 is_eating = move_x[i] == sim->blip_x && move_y[i] == sim->blip_y;
+                    if (gameplay__autoplayer_is_safe(autoplayer,
+                                                     move_x[i],
+                                                     move_y[i],
+                                                     has_tail_end && !is_eating,
+                                                     sim->tail_x,
+                                                     sim->tail_y,
+                                                     snake_length + 1,
+                                                     &rows_left,
+                                                     &room[i]))
+                    {
+                        chosen_move = i;
+                        break;
+                    }
+                    is_unsafe[i] = rows_left > 0;
                 }
             }
-            break;
         }
 
-        {  // End Game if player crashes
-            for (int32 i = 0; i < state->next_snake_part_index; i++)
+        if (chosen_move < 0 && rows_left <= 0)
+        {
+            // Some moves didn't get checked. Of those not known to be unsafe, take the one with the most ways on from
+            // it, towards the blip if it's a tie.
+            uint32 best_exit_count = 0;
+            chosen_move = 0;
+            for (uint32 i = 0; i < move_count; i++)
             {
-                Snake_Part* current_snake_part = &state->snake_parts[i];
-                if (state->pos_x == current_snake_part->pos_x && state->pos_y == current_snake_part->pos_y)
+                uint32 exit_count =
+                    is_unsafe[i] ? 0 : 1 + gameplay__autoplayer_count_exits(free_cells, move_x[i], move_y[i]);
+                bool32 is_closer = is_shortest[i] && !is_shortest[chosen_move];
+                if (exit_count > best_exit_count || (exit_count == best_exit_count && is_closer))
                 {
-                    state->game_over = 1;
-                    break;
+                    best_exit_count = exit_count;
+                    chosen_move = i;
                 }
             }
-
-            if (state->pos_x < 0 || state->pos_x >= X_GRIDS || state->pos_y < 0 || state->pos_y >= Y_GRIDS)
+        }
+        else if (chosen_move < 0)
+        {
+            chosen_move = 0;
+            for (uint32 i = 1; i < move_count; i++)
             {
-                state->game_over = 1;
+                if (room[i] > room[chosen_move])
+                {
+                    chosen_move = i;
+                }
             }
+        }
+
+        if (is_out_of_budget || rows_left <= 0)
+        {
+            autoplayer->out_of_budget_count++;
+        }
+        add_input(moves[chosen_move]);
+    }
+
+    real32 decision__microseconds =
+        (real32)((SDL_GetPerformanceCounter() - start_counter) * 1000000.0 / (real64)SDL_GetPerformanceFrequency());
+    autoplayer->last_decision__microseconds = decision__microseconds;
+    autoplayer->max_decision__microseconds = SDL_max(autoplayer->max_decision__microseconds, decision__microseconds);
+    autoplayer->total_decision__microseconds += decision__microseconds;
+    autoplayer->decision_count++;
+}
+
+// Searches from a clone of the sim on every core (see mcts.cpp)
+void gameplay__mcts_autoplay(Gameplay__State* state)
+{
+    add_input(mcts_decide(&global_mcts, state->sim, MCTS_ROLLOUTS_PER_DECISION, 0));
+}
+
+// Follows a cycle through every cell on the board, so the snake never crashes: east and west along the rows (leaving
+// column 0 free), then back down column 0. Needs an even number of rows.
+local_internal void gameplay__follow_board_cycle(Gameplay__State* state)
+{
+    int32 x = state->sim->head_x;
+    int32 y = state->sim->head_y;
+
+    Direction direction;
+    if (x == 0)
+    {
+        direction = y > 0 ? DIRECTION_SOUTH : DIRECTION_EAST;
+    }
+    else if (y == (int32)Y_GRIDS - 1)
+    {
+        direction = DIRECTION_WEST;
+    }
+    else if (y % 2 == 0)
+    {
+        direction = x < (int32)X_GRIDS - 1 ? DIRECTION_EAST : DIRECTION_NORTH;
+    }
+    else
+    {
+        direction = x > 1 ? DIRECTION_WEST : DIRECTION_NORTH;
+    }
+    add_input(direction);
+}
+
+struct Gameplay__Headless_Run
+{
+    uint64 cells;
+    uint32 max_cells_per_tick;
+    uint32 game_count;
+    uint32 crash_count;
+    uint32 longest_snake;
+    real64 elapsed__ms;
+    Snake_Sim* sim;  // How the last game ended up
+};
+
+// Plays games back to back with no window or audio device for simulated_seconds on the normal tick rate, restarting
+// after every crash and whenever the board fills up. interval__microseconds of 0 keeps the usual starting speed.
+local_internal Gameplay__Headless_Run gameplay__run_headless(Gameplay__Autopilot* autopilot,
+                                                             uint32 interval__microseconds,
+                                                             uint32 simulated_seconds)
+{
+    Gameplay__Headless_Run run = {};
+
+    Scene scene = {};
+    Gameplay__State* state = push_struct(&global_permanent_arena, Gameplay__State);
+    state->sim = (Snake_Sim*)push_size(&global_permanent_arena, snake_sim_size(X_GRIDS, Y_GRIDS), 64);
+    snake_sim_init(state->sim, X_GRIDS, Y_GRIDS, 12345);
+    scene.state = state;
+
+    timer_wheel_init(&global_simulation_timers, 0);
 
-            if (state->game_over)
+    uint64 tick_count = (uint64)simulated_seconds * SIMULATION_TICKS_PER_SECOND;
+
+    uint64 start_counter = SDL_GetPerformanceCounter();
+    for (uint64 tick = 1; tick <= tick_count; tick++)
+    {
+        if (run.game_count == 0 || state->game_over)
+        {
+            run.crash_count += state->game_over && !state->sim->has_filled_board;
+            run.longest_snake = SDL_max(run.longest_snake, state->sim->length - 1);
+            gameplay__reset_state(&scene);
+            state->autopilot = autopilot;
+            if (interval__microseconds)
             {
-                play_sound_effect(global_audio_context.effect_boom);
+                state->grid_jump_interval__microseconds = interval__microseconds;
+                state->microseconds_until_grid_jump = interval__microseconds;
             }
+            gameplay__set_paused(state, 0);
+            run.game_count++;
         }
+        timer_wheel_advance(&global_simulation_timers, tick);
+    }
+    uint64 end_counter = SDL_GetPerformanceCounter();
+
+    run.crash_count += state->game_over && !state->sim->has_filled_board;
+    run.longest_snake = SDL_max(run.longest_snake, state->sim->length - 1);
+    run.cells = state->cells_advanced;
+    run.max_cells_per_tick = state->max_cells_per_tick;
+    run.elapsed__ms = (real64)(end_counter - start_counter) * 1000.0 / (real64)SDL_GetPerformanceFrequency();
+    run.sim = state->sim;
+
+    timer_wheel_cancel_all(&global_simulation_timers);
+    return run;
+}
+
+local_internal void gameplay__print_headless_run(Gameplay__Headless_Run* run, uint32 simulated_seconds)
+{
+    // Blips still speed up anything slower than MIN_GRID_JUMP_INTERVAL__MICROSECONDS, hence the average
+    printf("  %llu cells (%.0f/s on average, up to %u per tick) in %.2f ms, %.1f ns per cell, %.0fx real time\n",
+           (unsigned long long)run->cells,
+           (real64)run->cells / simulated_seconds,
+           run->max_cells_per_tick,
+           run->elapsed__ms,
+           run->cells ? run->elapsed__ms * 1000000.0 / (real64)run->cells : 0.0,
+           run->elapsed__ms > 0 ? simulated_seconds * 1000.0 / run->elapsed__ms : 0.0);
+    printf("  %u games, longest snake %u, %u games crashed\n", run->game_count, run->longest_snake, run->crash_count);
+}
 
-        state->direction_locked = 0;
-        state->time_until_grid_jump__seconds = state->set_time_until_grid_jump__seconds;
-        // printf("x: %d, y: %d, %d, %d\n", state->pos_x, state->pos_y, state->current_direction,
-        // state->proposed_direction);
+// --bench-turbo: times the simulation at cells_per_second, steering along the board cycle
+int32 gameplay__run_turbo_benchmark(uint32 cells_per_second, uint32 simulated_seconds)
+{
+    if (Y_GRIDS % 2 != 0)
+    {
+        fprintf(stderr, "The turbo benchmark needs an even number of rows, got %u\n", Y_GRIDS);
+        return -1;
+    }
+
+    uint32 interval__microseconds = 1000000 / SDL_max(cells_per_second, 1);
+    if (interval__microseconds < MIN_TURBO_GRID_JUMP_INTERVAL__MICROSECONDS)
+    {
+        fprintf(stderr, "The turbo benchmark goes up to %d cells per second\n",
+                1000000 / MIN_TURBO_GRID_JUMP_INTERVAL__MICROSECONDS);
+        return -1;
     }
+
+    Gameplay__Headless_Run run =
+        gameplay__run_headless(gameplay__follow_board_cycle, interval__microseconds, simulated_seconds);
+
+    printf("Turbo benchmark: %u cells/s at %u ticks/s for %u simulated seconds\n",
+           cells_per_second,
+           SIMULATION_TICKS_PER_SECOND,
+           simulated_seconds);
+    gameplay__print_headless_run(&run, simulated_seconds);
+
+    // The cycle never crashes, so a crash means a cell got skipped or checked wrong
+    return run.crash_count == 0 ? 0 : -1;
+}
+
+// --bench-autoplay: lets the autoplayer play on a columns x rows board and reports what its decisions cost
+int32 gameplay__run_autoplay_benchmark(uint32 columns, uint32 rows, uint32 simulated_seconds)
+{
+    X_GRIDS = columns;
+    Y_GRIDS = rows;
+    gameplay__autoplayer_init(&global_permanent_arena);
+
+    Gameplay__Headless_Run run = gameplay__run_headless(gameplay__autoplay, 0, simulated_seconds);
+
+    Gameplay__Autoplayer* autoplayer = &global_autoplayer;
+    uint64 tick__microseconds = 1000000 / SIMULATION_TICKS_PER_SECOND;
+
+    printf("Autoplay benchmark: %ux%u board at %u ticks/s for %u simulated seconds\n",
+           columns,
+           rows,
+           SIMULATION_TICKS_PER_SECOND,
+           simulated_seconds);
+    gameplay__print_headless_run(&run, simulated_seconds);
+    printf("  %llu decisions, %.1f us on average, %.1f us max (a tick is %llu us)\n",
+           (unsigned long long)autoplayer->decision_count,
+           autoplayer->decision_count ? autoplayer->total_decision__microseconds / autoplayer->decision_count : 0.0,
+           autoplayer->max_decision__microseconds,
+           (unsigned long long)tick__microseconds);
+    printf("  %llu decisions ran out of their %u rows\n",
+           (unsigned long long)autoplayer->out_of_budget_count,
+           AUTOPLAYER_ROWS_PER_DECISION);
+
+    if (autoplayer->max_decision__microseconds > tick__microseconds)
+    {
+        printf("  Slowest decision doesn't fit in a tick!\n");
+    }
+    return 0;
 }
 
 //=======================================================
 // RENDER
 //=======================================================
 
-SDL_Texture* grid_texture = NULL;
-int grid_texture_initialized = 0;
+Texture_Id grid_texture_id = 0;
+
+// Low resolution board that gets upscaled onto the canvas (see LOW_RES_BOARD_ENABLED)
+Texture_Id low_res_grid_texture_id = 0;
+Texture_Id low_res_board_texture_id = 0;
 
 // Function to draw the grid onto a texture for caching
-void create_grid_texture(SDL_Renderer* renderer)
+SDL_Texture* create_grid_texture(SDL_Renderer* renderer, uint32 cell_size)
 {
     uint32 border_thickness = 1;                // Thickness of the white border
     SDL_Color grey_color = {40, 40, 40, 255};   // Dark grey color
     SDL_Color white_color = {60, 60, 60, 255};  // Lighter color for borders
 
     // Calculate the grid texture size
-    int grid_width = X_GRIDS * GRID_BLOCK_SIZE;
-    int grid_height = Y_GRIDS * GRID_BLOCK_SIZE;
+    int grid_width = X_GRIDS * cell_size;
+    int grid_height = Y_GRIDS * cell_size;
 
     // Create the texture
-    grid_texture =
+    SDL_Texture* texture =
         SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, grid_width, grid_height);
-    if (!grid_texture)
+    if (!texture)
     {
-        fprintf(stderr, "Failed to create grid texture: %s\n", SDL_GetError());
-        return;
+        log_error("Failed to create grid texture: %s\n", SDL_GetError());
+        return NULL;
     }
 
     // Set the grid texture as the render target
-    SDL_SetRenderTarget(renderer, grid_texture);
+    SDL_SetRenderTarget(renderer, texture);
 
     // Draw the grid
     for (uint32 row_index = 0; row_index < Y_GRIDS; row_index++)
@@ -470,10 +905,10 @@ void create_grid_texture(SDL_Renderer* renderer)
         for (uint32 column_index = 0; column_index < X_GRIDS; column_index++)
         {
             SDL_Rect grid_block;
-            grid_block.x = (int32)(column_index * GRID_BLOCK_SIZE);
-            grid_block.y = (int32)(row_index * GRID_BLOCK_SIZE);
-            grid_block.w = (int32)(GRID_BLOCK_SIZE);
-            grid_block.h = (int32)(GRID_BLOCK_SIZE);
+            grid_block.x = (int32)(column_index * cell_size);
+            grid_block.y = (int32)(row_index * cell_size);
+            grid_block.w = (int32)(cell_size);
+            grid_block.h = (int32)(cell_size);
 
             // Draw the white border rectangle
             SDL_SetRenderDrawColor(renderer, white_color.r, white_color.g, white_color.b, white_color.a);
@@ -486,6 +921,13 @@ void create_grid_texture(SDL_Renderer* renderer)
             inner_block.w = (int32)(grid_block.w - (2 * border_thickness));
             inner_block.h = (int32)(grid_block.h - (2 * border_thickness));
 
+            if (cell_size < 8)
+            {
+                // Borders on every side would eat most of a tiny cell, so only draw the top-left edges
+                inner_block.w = (int32)(grid_block.w - border_thickness);
+                inner_block.h = (int32)(grid_block.h - border_thickness);
+            }
+
             // Draw the dark grey fill within the border
             SDL_SetRenderDrawColor(renderer, grey_color.r, grey_color.g, grey_color.b, grey_color.a);
             SDL_RenderFillRect(renderer, &inner_block);
@@ -495,77 +937,129 @@ void create_grid_texture(SDL_Renderer* renderer)
     // Reset the rendering target to the default (screen)
     SDL_SetRenderTarget(renderer, NULL);
 
-    grid_texture_initialized = 1;
+    return texture;
 }
 
 // Function to render the grid by reusing the cached texture
 void render_grid(SDL_Renderer* renderer)
 {
-    // Create the grid texture if it hasn't been created yet
-    if (!grid_texture_initialized)
+    // Create the grid texture if it hasn't been created yet (or was evicted or lost)
+    SDL_Texture* grid_texture = texture_manager_use(grid_texture_id);
+    if (!grid_texture)
     {
-        create_grid_texture(renderer);
+        grid_texture = create_grid_texture(renderer, GRID_BLOCK_SIZE);
+        grid_texture_id = texture_manager_set(grid_texture_id, grid_texture, "grid");
     }
 
     // Render the cached grid texture to the screen
     SDL_RenderCopy(renderer, grid_texture, NULL, NULL);
 }
 
-void gameplay__render(Scene* scene)
+// Draws a snake and its blip with every grid cell being cell_size pixels wide onto the current render target
+void render_snake_sim(
+    Snake_Sim* sim, uint32 cell_size, SDL_Color head_color, SDL_Color body_color, SDL_Color blip_color)
 {
-    Gameplay__State* state = (Gameplay__State*)scene->state;
-    Gameplay__Texts* gameplay_texts = state->gameplay_texts;
-
-    draw_canvas();
-
-    render_grid(global_renderer);
-
     {  // Draw Blip
         Screen_Space_Position square_screen_pos =
-            map_world_space_position_to_screen_space_position(state->blip_pos_x, state->blip_pos_y);
+            map_world_space_position_to_board_space_position(sim->blip_x, sim->blip_y, cell_size);
 
-        real32 size = GRID_BLOCK_SIZE * 0.5f;
+        real32 size = cell_size * 0.5f;
 
         SDL_Rect square = {};
-        square.x = (int32)(square_screen_pos.x + ((real32)GRID_BLOCK_SIZE / 2) - (size / 2));
-        square.y = (int32)(square_screen_pos.y + ((real32)GRID_BLOCK_SIZE / 2) - (size / 2));
+        square.x = (int32)(square_screen_pos.x + ((real32)cell_size / 2) - (size / 2));
+        square.y = (int32)(square_screen_pos.y + ((real32)cell_size / 2) - (size / 2));
         square.w = (int32)size;
         square.h = (int32)size;
 
-        SDL_Color color = {52, 152, 219, 255};
-        draw_rect(square, color);
+        draw_rect(square, blip_color);
     }
 
-    {  // Draw Player
-        Screen_Space_Position square_screen_pos =
-            map_world_space_position_to_screen_space_position(state->pos_x, state->pos_y);
-
-        SDL_Rect square = {};
-        square.x = (int32)(square_screen_pos.x);
-        square.y = (int32)(square_screen_pos.y);
-        square.w = (int32)GRID_BLOCK_SIZE;
-        square.h = (int32)GRID_BLOCK_SIZE;
-
-        SDL_Color red = {171, 70, 66, 255};
-        draw_rect(square, red);
-
-        for (uint32 i = 0; i < state->next_snake_part_index; i++)
+    {  // Draw Player, from the end of the tail up to the head
+        int32 part_x = sim->tail_x;
+        int32 part_y = sim->tail_y;
+        for (uint32 i = 0; i < sim->length; i++)
         {
-            Snake_Part* snake_part = &state->snake_parts[i];
             Screen_Space_Position screen_pos =
-                map_world_space_position_to_screen_space_position(snake_part->pos_x, snake_part->pos_y);
+                map_world_space_position_to_board_space_position(part_x, part_y, cell_size);
 
             SDL_Rect square = {};
             square.x = (int32)(screen_pos.x);
             square.y = (int32)(screen_pos.y);
-            square.w = (int32)GRID_BLOCK_SIZE;
-            square.h = (int32)GRID_BLOCK_SIZE;
+            square.w = (int32)cell_size;
+            square.h = (int32)cell_size;
 
-            SDL_Color darkened_red = {154, 63, 59, 255};
-            draw_rect(square, darkened_red);
+            if (i + 1 < sim->length)
+            {
+                draw_rect(square, body_color);
+                snake_sim_move(snake_sim_get_body_move(sim, i), &part_x, &part_y);
+            }
+            else
+            {
+                draw_rect(square, head_color);
+            }
         }
     }
+}
+
+// Draws the blip and snake with every grid cell being cell_size pixels wide onto the current render target
+void render_board(Gameplay__State* state, uint32 cell_size)
+{
+    SDL_Color red = {171, 70, 66, 255};
+    SDL_Color darkened_red = {154, 63, 59, 255};
+    SDL_Color blue = {52, 152, 219, 255};
+    render_snake_sim(state->sim, cell_size, red, darkened_red, blue);
+}
+
+// Renders the board at LOW_RES_PIXELS_PER_CELL pixels per grid cell and then upscales it onto the canvas in one copy
+void render_low_res_board(Gameplay__State* state)
+{
+    SDL_assert(GRID_BLOCK_SIZE % LOW_RES_PIXELS_PER_CELL == 0);
+    uint32 cell_size = LOW_RES_PIXELS_PER_CELL;
 
+    SDL_Texture* low_res_grid_texture = texture_manager_use(low_res_grid_texture_id);
+    if (!low_res_grid_texture)
+    {
+        low_res_grid_texture = create_grid_texture(global_renderer, cell_size);
+        low_res_grid_texture_id = texture_manager_set(low_res_grid_texture_id, low_res_grid_texture, "low res grid");
+    }
+
+    SDL_Texture* low_res_board_texture = texture_manager_use(low_res_board_texture_id);
+    if (!low_res_board_texture)
+    {
+        low_res_board_texture = SDL_CreateTexture(global_renderer,
+                                                  SDL_PIXELFORMAT_RGBA8888,
+                                                  SDL_TEXTUREACCESS_TARGET,
+                                                  X_GRIDS * cell_size,
+                                                  Y_GRIDS * cell_size);
+        if (!low_res_board_texture)
+        {
+            log_error("Failed to create low res board texture: %s\n", SDL_GetError());
+            return;
+        }
+        // Every upscaled cell stays a crisp square
+        SDL_SetTextureScaleMode(low_res_board_texture, SDL_ScaleModeNearest);
+        low_res_board_texture_id =
+            texture_manager_set(low_res_board_texture_id, low_res_board_texture, "low res board");
+    }
+
+    SDL_SetRenderTarget(global_renderer, low_res_board_texture);
+    SDL_RenderCopy(global_renderer, low_res_grid_texture, NULL, NULL);
+    render_board(state, cell_size);
+    SDL_SetRenderTarget(global_renderer, NULL);
+
+    // Switching targets resets the clip rect
+    clip_to_canvas();
+
+    SDL_Rect board_rect = {};
+    board_rect.w = (int32)(X_GRIDS * GRID_BLOCK_SIZE);
+    board_rect.h = (int32)(Y_GRIDS * GRID_BLOCK_SIZE);
+    board_rect.y = LOGICAL_HEIGHT - board_rect.h;
+    SDL_RenderCopy(global_renderer, low_res_board_texture, NULL, &board_rect);
+}
+
+// The score, and the game over and paused messages when they apply. The world scene draws its HUD with this too.
+void gameplay__render_texts(Gameplay__Texts* gameplay_texts, int32 score, bool32 game_over, bool32 is_paused)
+{
     {  // Render score
         int32 OFFSET = 40;
         gameplay_texts->score_drawn_text_static.text_rect.x =
@@ -575,23 +1069,20 @@ void gameplay__render(Scene* scene)
 
         // ==========================
 
-        if (state->next_snake_part_index != gameplay_texts->score_drawn_text_dynamic.original_value)
+        if (score != gameplay_texts->score_drawn_text_dynamic.original_value)
         {
-            snprintf(gameplay_texts->score_drawn_text_dynamic.text_string,
-                     DYNAMIC_SCORE_LENGTH,
-                     "%d",
-                     state->next_snake_part_index);
+            snprintf(gameplay_texts->score_drawn_text_dynamic.text_string, DYNAMIC_SCORE_LENGTH, "%d", score);
         }
 
         gameplay_texts->score_drawn_text_dynamic.text_rect.x = gameplay_texts->score_drawn_text_static.text_rect.x +
                                                                 5 +
                                                                 gameplay_texts->score_drawn_text_static.text_rect.w;
         gameplay_texts->score_drawn_text_dynamic.text_rect.y = 0;
-        draw_text_int32(&gameplay_texts->score_drawn_text_dynamic, state->next_snake_part_index);
+        draw_text_int32(&gameplay_texts->score_drawn_text_dynamic, score);
     }
 
     {  // Render Game Over
-        if (state->game_over)
+        if (game_over)
         {
             draw_text_static(&gameplay_texts->game_over_drawn_text_static);
             gameplay_texts->game_over_drawn_text_static.text_rect.x = LOGICAL_WIDTH / 2;
@@ -617,7 +1108,7 @@ void gameplay__render(Scene* scene)
     }
 
     {  // Render Game Paused
-        if (state->is_paused)
+        if (is_paused)
         {
             draw_text_static(&gameplay_texts->game_paused_drawn_text_static);
             gameplay_texts->game_paused_drawn_text_static.text_rect.x = LOGICAL_WIDTH / 2;
@@ -629,4 +1120,193 @@ void gameplay__render(Scene* scene)
                 gameplay_texts->game_paused_drawn_text_static.text_rect.h / 2;
         }
     }
-}
\ No newline at end of file
+}
+
+void gameplay__render(Scene* scene)
+{
+    Gameplay__State* state = (Gameplay__State*)scene->state;
+
+    if (LOW_RES_BOARD_ENABLED)
+    {
+        // The board covers the whole canvas, so there's no need to fill it first
+        clip_to_canvas();
+        render_low_res_board(state);
+    }
+    else
+    {
+        draw_canvas();
+        render_grid(global_renderer);
+        render_board(state, GRID_BLOCK_SIZE);
+    }
+
+    particles_render(&global_particles, 0, 0);
+
+    gameplay__render_texts(state->gameplay_texts, (int32)state->sim->length - 1, state->game_over, state->is_paused);
+}
+
+// Spectators for --bench-spectators, read on their own thread while the games run
+struct Gameplay__Spectator_Benchmark
+{
+    uint32 client_count;
+    Spectator_Socket_Handle handles[SPECTATOR_MAX_CLIENTS];
+    Spectator_Receiver receivers[SPECTATOR_MAX_CLIENTS];
+    Spectator_Board boards[SPECTATOR_MAX_CLIENTS];
+    uint64 bytes_received[SPECTATOR_MAX_CLIENTS];
+    bool32 is_broken[SPECTATOR_MAX_CLIENTS];
+
+    const Snake_Sim* final_sim;  // Set once the games are over
+    SDL_atomic_t is_finished;
+    bool32 is_in_sync;
+};
+
+local_internal bool32 gameplay__spectator_board_matches(const Spectator_Board* board, const Snake_Sim* sim)
+{
+    if (board->head_x != sim->head_x || board->head_y != sim->head_y || board->tail_x != sim->tail_x ||
+        board->tail_y != sim->tail_y || board->blip_x != sim->blip_x || board->blip_y != sim->blip_y ||
+        board->length != sim->length || (bool32)board->is_game_over != (bool32)sim->is_game_over)
+    {
+        return false;
+    }
+
+    uint32 cell_count = (uint32)board->width * (uint32)board->height;
+    for (uint32 i = 0; i + 1 < sim->length; i++)
+    {
+        if (board->moves[(board->moves_start + i) % cell_count] != snake_sim_get_body_move(sim, i) - DIRECTION_NORTH)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Spectator 0 only reads every 50 ms, so it keeps falling behind and has to be caught up with keyframes. Once the
+// games are over, keeps reading until every spectator has the final board or a couple of seconds have gone by.
+local_internal int gameplay__spectator_benchmark_thread(void* data)
+{
+    Gameplay__Spectator_Benchmark* benchmark = (Gameplay__Spectator_Benchmark*)data;
+
+    uint32 slow_read_time__ms = SDL_GetTicks();
+    uint32 finish_time__ms = 0;
+    for (;;)
+    {
+        bool32 has_received = false;
+        for (uint32 i = 0; i < benchmark->client_count; i++)
+        {
+            if (benchmark->is_broken[i] || (i == 0 && SDL_GetTicks() - slow_read_time__ms < 50))
+            {
+                continue;
+            }
+            slow_read_time__ms = i == 0 ? SDL_GetTicks() : slow_read_time__ms;
+
+            int32 received = spectator_receive(benchmark->handles[i], &benchmark->receivers[i], &benchmark->boards[i]);
+            if (received < 0)
+            {
+                benchmark->is_broken[i] = true;
+            }
+            else if (received > 0)
+            {
+                benchmark->bytes_received[i] += received;
+                has_received = true;
+            }
+        }
+
+        if (SDL_AtomicGet(&benchmark->is_finished))
+        {
+            finish_time__ms = finish_time__ms ? finish_time__ms : SDL_GetTicks();
+
+            bool32 is_in_sync = true;
+            for (uint32 i = 0; i < benchmark->client_count && is_in_sync; i++)
+            {
+                is_in_sync = !benchmark->is_broken[i] &&
+                             gameplay__spectator_board_matches(&benchmark->boards[i], benchmark->final_sim);
+            }
+            if (is_in_sync || SDL_GetTicks() - finish_time__ms > 2000)
+            {
+                benchmark->is_in_sync = is_in_sync;
+                break;
+            }
+        }
+
+        if (!has_received)
+        {
+            SDL_Delay(1);
+        }
+    }
+    return 0;
+}
+
+// --bench-spectators: the turbo benchmark with client_count spectators watching over loopback. Reports what streaming
+// cost the gameplay thread and checks every spectator ends up with exactly the board the game did.
+int32 gameplay__run_spectator_benchmark(uint32 client_count, uint32 cells_per_second, uint32 simulated_seconds)
+{
+    uint16 port = 47900;
+    Spectator_Server* server = &global_spectator_server;
+    if (!spectator_server_start(server, &global_permanent_arena, port, X_GRIDS, Y_GRIDS))
+    {
+        return -1;
+    }
+
+    Gameplay__Spectator_Benchmark* benchmark = push_struct(&global_permanent_arena, Gameplay__Spectator_Benchmark);
+    *benchmark = {};
+    benchmark->client_count = SDL_clamp(client_count, 1, SPECTATOR_MAX_CLIENTS);
+    for (uint32 i = 0; i < benchmark->client_count; i++)
+    {
+        benchmark->handles[i] = spectator_connect_loopback(port);
+        if (benchmark->handles[i] == SPECTATOR_INVALID_SOCKET)
+        {
+            fprintf(stderr, "Failed to connect spectator %u\n", i);
+            return -1;
+        }
+        benchmark->receivers[i].buffer = push_array(&global_permanent_arena, SPECTATOR_MAX_MESSAGE_SIZE, uint8);
+        benchmark->receivers[i].capacity = SPECTATOR_MAX_MESSAGE_SIZE;
+        benchmark->boards[i].moves = push_array(&global_permanent_arena, X_GRIDS * Y_GRIDS, uint8);
+        benchmark->boards[i].capacity = X_GRIDS * Y_GRIDS;
+    }
+    SDL_Thread* thread = SDL_CreateThread(gameplay__spectator_benchmark_thread, "spectator_benchmark", benchmark);
+
+    // Give the server a moment to take everyone in, so they're all watching from the first game
+    while (SDL_AtomicGet(&server->client_count) < (int32)benchmark->client_count)
+    {
+        SDL_Delay(1);
+    }
+
+    uint32 interval__microseconds = 1000000 / SDL_max(cells_per_second, 1);
+    Gameplay__Headless_Run run =
+        gameplay__run_headless(gameplay__follow_board_cycle, interval__microseconds, simulated_seconds);
+
+    benchmark->final_sim = run.sim;
+    SDL_AtomicSet(&benchmark->is_finished, 1);
+    SDL_WaitThread(thread, NULL);
+
+    printf("Spectator benchmark: %u spectators, %u cells/s at %u ticks/s for %u simulated seconds\n",
+           benchmark->client_count,
+           cells_per_second,
+           SIMULATION_TICKS_PER_SECOND,
+           simulated_seconds);
+    gameplay__print_headless_run(&run, simulated_seconds);
+    printf("  Publishing: %.3f us per tick on average, %.3f us max, %llu ticks and %u keyframes in %llu KB, "
+           "%u ticks dropped\n",
+           server->publish_count ? server->total_publish__microseconds / server->publish_count : 0.0,
+           server->max_publish__microseconds,
+           (unsigned long long)server->ticks_published,
+           server->keyframes_published,
+           (unsigned long long)(server->bytes_published / 1024),
+           server->ticks_dropped);
+    uint64 total_bytes_received = 0;
+    for (uint32 i = 0; i < benchmark->client_count; i++)
+    {
+        total_bytes_received += benchmark->bytes_received[i];
+    }
+    printf("  Spectators got %llu KB between them (%llu KB for the slow one), %d resyncs\n",
+           (unsigned long long)(total_bytes_received / 1024),
+           (unsigned long long)(benchmark->bytes_received[0] / 1024),
+           SDL_AtomicGet(&server->resync_count));
+    printf("  %s\n", benchmark->is_in_sync ? "Every spectator ended up with the same board" : "Out of sync!");
+
+    for (uint32 i = 0; i < benchmark->client_count; i++)
+    {
+        spectator_close_socket(benchmark->handles[i]);
+    }
+    spectator_server_stop(server);
+    return benchmark->is_in_sync ? 0 : -1;
+}
@@ -0,0 +1,168 @@
+#include <SDL2/SDL.h>
+
+#include "../common.h"
+#include "../snake_sim.h"
+
+// Watches the AI snakes in the arena (see snake_arena.cpp). Started with --arena, which skips the start screen. Arena
+// ticks are scheduled on the simulation timers like gameplay's grid jumps. The board is a pixel per cell in a
+// streaming texture that gets scaled up onto the canvas, since there can be far too many snakes to draw a rect each.
+
+struct Snake_Arena__State
+{
+    Snake_Arena* arena;
+    uint32 palette[256];  // ARGB for every kind of cell
+    uint32 seed;
+
+    bool32 is_paused;
+    Timer_Id tick_timer;
+    uint64 next_tick__microseconds;  // Simulation time
+};
+
+Texture_Id snake_arena_texture_id = 0;
+
+local_internal void snake_arena__tick(void* data, uint64 tick)
+{
+    Snake_Arena__State* state = (Snake_Arena__State*)data;
+    snake_arena_tick(state->arena);
+
+    state->next_tick__microseconds += SNAKE_ARENA_TICK_INTERVAL__MICROSECONDS;
+    uint64 due_tick = get_simulation_tick_at(state->next_tick__microseconds);
+    state->tick_timer =
+        timer_wheel_schedule(&global_simulation_timers, SDL_max(due_tick, tick + 1), snake_arena__tick, state);
+}
+
+local_internal void snake_arena__schedule(Snake_Arena__State* state)
+{
+    timer_wheel_cancel(&global_simulation_timers, state->tick_timer);
+    uint64 now__microseconds = get_simulation_time__microseconds(global_simulation_timers.current_tick);
+    state->next_tick__microseconds = now__microseconds + SNAKE_ARENA_TICK_INTERVAL__MICROSECONDS;
+    state->tick_timer = timer_wheel_schedule(
+        &global_simulation_timers, get_simulation_tick_at(state->next_tick__microseconds), snake_arena__tick, state);
+}
+
+// Background, blips, then a spread of hues for the snakes
+void snake_arena__setup_palette(Snake_Arena__State* state)
+{
+    state->palette[SNAKE_ARENA_CELL_EMPTY] = 0xFF282828;
+    state->palette[SNAKE_ARENA_CELL_BLIP] = 0xFF3498DB;
+    for (uint32 i = SNAKE_ARENA_CELL_SNAKE; i < 256; i++)
+    {
+        // Steps round the colour wheel by the golden ratio so neighbouring indices don't look alike
+        real32 hue = (real32)((i * 0.618034) - (uint32)(i * 0.618034)) * 6.0f;
+        real32 fraction = hue - (int32)hue;
+        uint32 high = 220;
+        uint32 low = 70;
+        uint32 rising = (uint32)(low + (high - low) * fraction);
+        uint32 falling = (uint32)(high - (high - low) * fraction);
+        uint32 r, g, b;
+        switch ((int32)hue)
+        {
+            case 0: r = high, g = rising, b = low; break;
+            case 1: r = falling, g = high, b = low; break;
+            case 2: r = low, g = high, b = rising; break;
+            case 3: r = low, g = falling, b = high; break;
+            case 4: r = rising, g = low, b = high; break;
+            default: r = high, g = low, b = falling; break;
+        }
+        state->palette[i] = 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+}
+
+void snake_arena__reset_state(Scene* scene)
+{
+    Snake_Arena__State* state = (Snake_Arena__State*)scene->state;
+    state->is_paused = false;
+    snake_arena__schedule(state);
+}
+
+void snake_arena__handle_input(Scene* scene, Input* input)
+{
+    Snake_Arena__State* state = (Snake_Arena__State*)scene->state;
+
+    if (pressed(BUTTON_ESCAPE))
+    {
+        global_next_scene = &global_start_screen_scene;
+    }
+
+    if (pressed(BUTTON_SPACE))
+    {
+        state->is_paused = !state->is_paused;
+        if (state->is_paused)
+        {
+            timer_wheel_cancel(&global_simulation_timers, state->tick_timer);
+        }
+        else
+        {
+            snake_arena__schedule(state);
+        }
+    }
+
+    // A different arena
+    if (pressed(BUTTON_ENTER))
+    {
+        state->seed++;
+        snake_arena_reset(state->arena, state->seed);
+    }
+}
+
+void snake_arena__update(Scene* scene, uint64 simulation_tick)
+{
+}
+
+void snake_arena__render(Scene* scene)
+{
+    Snake_Arena__State* state = (Snake_Arena__State*)scene->state;
+    Snake_Arena* arena = state->arena;
+
+    draw_canvas();
+
+    SDL_Texture* texture = texture_manager_use(snake_arena_texture_id);
+    if (!texture)
+    {
+        texture = SDL_CreateTexture(
+            global_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, arena->width, arena->height);
+        if (!texture)
+        {
+            log_error("Failed to create the arena texture: %s\n", SDL_GetError());
+            return;
+        }
+        SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+        snake_arena_texture_id = texture_manager_set(snake_arena_texture_id, texture, "snake arena");
+    }
+
+    void* pixels;
+    int32 pitch;
+    if (SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0)
+    {
+        return;
+    }
+
+    // North is up, so the rows go in upside down
+    for (int32 y = 0; y < arena->height; y++)
+    {
+        uint32* row = (uint32*)((uint8*)pixels + (size_t)(arena->height - 1 - y) * pitch);
+        const uint8* cells = arena->cells + (size_t)y * arena->width;
+        for (int32 x = 0; x < arena->width; x++)
+        {
+            row[x] = state->palette[cells[x]];
+        }
+    }
+    for (uint32 snake = 0; snake < arena->snake_count; snake++)
+    {
+        if (arena->is_alive[snake])
+        {
+            uint32* row = (uint32*)((uint8*)pixels + (size_t)(arena->height - 1 - arena->head_y[snake]) * pitch);
+            row[arena->head_x[snake]] = 0xFFFFFFFF;
+        }
+    }
+    SDL_UnlockTexture(texture);
+
+    // As big as it'll go without stretching
+    real32 scale = SDL_min((real32)LOGICAL_WIDTH / arena->width, (real32)LOGICAL_HEIGHT / arena->height);
+    SDL_Rect board_rect = {};
+    board_rect.w = (int32)(arena->width * scale);
+    board_rect.h = (int32)(arena->height * scale);
+    board_rect.x = (LOGICAL_WIDTH - board_rect.w) / 2;
+    board_rect.y = (LOGICAL_HEIGHT - board_rect.h) / 2;
+    SDL_RenderCopy(global_renderer, texture, NULL, &board_rect);
+}
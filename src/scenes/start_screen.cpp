@@ -30,13 +30,48 @@ struct Start_Screen__State
     Menu_Texts* menu_texts;
     SDL_Color blink_color;
     Start_Screen__Option current_option;
+    Timer_Id blink_timer;
+    uint64 next_blink__microseconds;  // Simulation time
 };
 
+uint64 BLINK_EVERY__MICROSECONDS = 150000;
+int32 global_marker;
+int32 global_next_marker;
+
+local_internal void start_screen__blink(void* data, uint64 tick)
+{
+    Start_Screen__State* state = (Start_Screen__State*)data;
+
+    SDL_Color yellow = {196, 160, 3, 255};   // Yellow
+    SDL_Color white = {255, 255, 255, 255};  // White
+
+    if (global_marker == 0)
+    {
+        state->blink_color = white;
+        global_next_marker = 1;
+    }
+    else if (global_marker == 1)
+    {
+        state->blink_color = yellow;
+        global_next_marker = 0;
+    }
+
+    state->next_blink__microseconds += BLINK_EVERY__MICROSECONDS;
+    state->blink_timer = timer_wheel_schedule(
+        &global_simulation_timers, get_simulation_tick_at(state->next_blink__microseconds), start_screen__blink, state);
+}
+
 void start_screen__reset_state(Scene* scene)
 {
     Start_Screen__State* state = (Start_Screen__State*)scene->state;
     state->blink_color = white;
     state->current_option = Start_Screen_Option__Start_Game;
+
+    timer_wheel_cancel(&global_simulation_timers, state->blink_timer);
+    state->next_blink__microseconds =
+        get_simulation_time__microseconds(global_simulation_timers.current_tick) + BLINK_EVERY__MICROSECONDS;
+    state->blink_timer = timer_wheel_schedule(
+        &global_simulation_timers, get_simulation_tick_at(state->next_blink__microseconds), start_screen__blink, state);
 }
 
 Menu_Texts start_screen__setup_text()
@@ -91,7 +126,7 @@ void start_screen__handle_input(Scene* scene, Input* input)
 
     if (pressed(BUTTON_D) || pressed(BUTTON_A))
     {
-        play_sound_effect(global_audio_context.effect_beep);
+        play_sound_effect(&global_audio_context.effect_beep);
     }
 
     if (pressed(BUTTON_D))
@@ -119,40 +154,13 @@ void start_screen__handle_input(Scene* scene, Input* input)
     }
 }
 
-real32 TICK_EVERY__SECONDS = 0.15f;
-real32 global_tick_time_remaining = TICK_EVERY__SECONDS;
-int32 global_marker;
-int32 global_next_marker;
-
-void start_screen__update(struct Scene* scene,
-                          real64 simulation_time_elapsed,
-                          real32 dt_s)
+// The blinking itself is scheduled (see start_screen__blink), this just keeps the texts in sync with it
+void start_screen__update(struct Scene* scene, uint64 simulation_tick)
 {
     Start_Screen__State* state = (Start_Screen__State*)scene->state;
 
-    SDL_Color yellow = {196, 160, 3, 255};   // Yellow
     SDL_Color white = {255, 255, 255, 255};  // White
 
-    if (global_tick_time_remaining <= 0)
-    {
-        global_tick_time_remaining = TICK_EVERY__SECONDS;
-
-        uint32 seconds = (uint32)simulation_time_elapsed;
-
-        if (global_marker == 0)
-        {
-            state->blink_color = white;
-            global_next_marker = 1;
-        }
-        else if (global_marker == 1)
-        {
-            state->blink_color = yellow;
-            global_next_marker = 0;
-        }
-    }
-
-    global_tick_time_remaining -= dt_s;
-
     Menu_Texts* menu_texts = state->menu_texts;
 
     if (state->current_option == Start_Screen_Option__Start_Game)
@@ -0,0 +1,284 @@
+#include <SDL2/SDL.h>
+
+#include "../common.h"
+#include "../snake_sim.h"
+
+// Two players, one process each, over UDP (see rollback.cpp). Started with --versus, which skips the start screen.
+// Every frame of the versus sim is one grid jump at a fixed speed, scheduled on the simulation timers like gameplay.
+
+#define VERSUS_WINS_TEXT_LENGTH 8
+
+struct Versus__State
+{
+    Rollback_Session* session;
+
+    Drawn_Text_Int32 wins_drawn_texts[VERSUS_PLAYER_COUNT];
+
+    Timer_Id frame_timer;
+    uint64 next_frame__microseconds;  // Simulation time
+};
+
+Rollback_Session global_rollback_session;
+
+local_internal void versus__frame(void* data, uint64 tick)
+{
+    Versus__State* state = (Versus__State*)data;
+    Rollback_Session* session = state->session;
+
+    // Waiting on the other side keeps the local input queued up for the next frame
+    if (rollback_session_is_waiting(session))
+    {
+        session->stats.stall_count++;
+    }
+    else
+    {
+        rollback_session_advance(session, get_next_input());
+        rollback_session_send(session);
+    }
+
+    state->next_frame__microseconds += VERSUS_GRID_JUMP_INTERVAL__MICROSECONDS;
+    uint64 due_tick = get_simulation_tick_at(state->next_frame__microseconds);
+    state->frame_timer =
+        timer_wheel_schedule(&global_simulation_timers, SDL_max(due_tick, tick + 1), versus__frame, state);
+}
+
+void versus__reset_state(Scene* scene)
+{
+    Versus__State* state = (Versus__State*)scene->state;
+
+    // The input queue is shared with gameplay
+    head = 0;
+    tail = 0;
+
+    timer_wheel_cancel(&global_simulation_timers, state->frame_timer);
+    uint64 now__microseconds = get_simulation_time__microseconds(global_simulation_timers.current_tick);
+    state->next_frame__microseconds = now__microseconds + VERSUS_GRID_JUMP_INTERVAL__MICROSECONDS;
+    state->frame_timer = timer_wheel_schedule(
+        &global_simulation_timers, get_simulation_tick_at(state->next_frame__microseconds), versus__frame, state);
+}
+
+void versus__setup_text(Versus__State* state, Memory_Arena* arena)
+{
+    SDL_Color white_text_color = {255, 255, 255, 255};
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        Drawn_Text_Int32* wins_drawn_text = &state->wins_drawn_texts[player];
+        *wins_drawn_text = {};
+        wins_drawn_text->original_value = -1;
+        wins_drawn_text->text_string = push_array(arena, VERSUS_WINS_TEXT_LENGTH, char);
+        wins_drawn_text->font_size = 16.0f * 2.f;
+        wins_drawn_text->color = white_text_color;
+        prepare_text_int32(wins_drawn_text);
+    }
+}
+
+void versus__handle_input(Scene* scene, Input* input)
+{
+    if (pressed(BUTTON_ESCAPE))
+    {
+        global_next_scene = &global_start_screen_scene;
+    }
+
+    if (pressed(BUTTON_W) || pressed(BUTTON_UP))
+    {
+        add_input(DIRECTION_NORTH);
+    }
+
+    if (pressed(BUTTON_A) || pressed(BUTTON_LEFT))
+    {
+        add_input(DIRECTION_WEST);
+    }
+
+    if (pressed(BUTTON_S) || pressed(BUTTON_DOWN))
+    {
+        add_input(DIRECTION_SOUTH);
+    }
+
+    if (pressed(BUTTON_D) || pressed(BUTTON_RIGHT))
+    {
+        add_input(DIRECTION_EAST);
+    }
+}
+
+// Takes in the other side's inputs (rolling back if a guess was wrong) and keeps sending ours, so a lost packet gets
+// made up for on the next frame even while the game is waiting
+void versus__update(Scene* scene, uint64 simulation_tick)
+{
+    Versus__State* state = (Versus__State*)scene->state;
+    rollback_session_update(state->session);
+    rollback_session_send(state->session);
+}
+
+void versus__render(Scene* scene)
+{
+    Versus__State* state = (Versus__State*)scene->state;
+    Versus_Sim* sim = state->session->sim;
+
+    draw_canvas();
+    render_grid(global_renderer);
+
+    // You're always red
+    SDL_Color red = {171, 70, 66, 255};
+    SDL_Color darkened_red = {154, 63, 59, 255};
+    SDL_Color green = {88, 166, 72, 255};
+    SDL_Color darkened_green = {72, 140, 59, 255};
+    SDL_Color blue = {52, 152, 219, 255};
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        bool32 is_local = player == state->session->local_player;
+        render_snake_sim(versus_sim_get_snake(sim, player),
+                         GRID_BLOCK_SIZE,
+                         is_local ? red : green,
+                         is_local ? darkened_red : darkened_green,
+                         blue);
+    }
+
+    {  // Render wins, the local player's on the left
+        int32 OFFSET = 40;
+        for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+        {
+            Drawn_Text_Int32* wins_drawn_text = &state->wins_drawn_texts[player];
+            int32 wins = (int32)sim->wins[player];
+            if (wins != wins_drawn_text->original_value)
+            {
+                snprintf(wins_drawn_text->text_string, VERSUS_WINS_TEXT_LENGTH, "%d", wins);
+            }
+
+            bool32 is_local = player == state->session->local_player;
+            wins_drawn_text->text_rect.x = is_local ? OFFSET : LOGICAL_WIDTH - wins_drawn_text->text_rect.w - OFFSET;
+            wins_drawn_text->text_rect.y = 0;
+            draw_text_int32(wins_drawn_text, wins);
+        }
+    }
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// --bench-rollback: two sessions in one process talking over loopback, each only reading its socket every
+// latency_frames frames so its guesses are always that far behind. Both play random turns. Checks they end up with
+// exactly the same game and reports what the rollbacks cost.
+int32 versus__run_rollback_benchmark(uint32 frame_count, uint32 latency_frames)
+{
+    uint16 ports[VERSUS_PLAYER_COUNT] = {47801, 47802};
+    Rollback_Session* sessions = push_array(&global_permanent_arena, VERSUS_PLAYER_COUNT, Rollback_Session);
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        if (!rollback_session_init(&sessions[player],
+                                   &global_permanent_arena,
+                                   player,
+                                   ports[player],
+                                   "127.0.0.1",
+                                   ports[1 - player],
+                                   X_GRIDS,
+                                   Y_GRIDS))
+        {
+            return -1;
+        }
+    }
+
+    latency_frames = SDL_clamp(latency_frames, 1, VERSUS_MAX_PREDICTION_FRAMES - 1);
+
+    uint32 random_state = 0x9E3779B9u;
+    uint64 start_counter = SDL_GetPerformanceCounter();
+    for (uint32 frame = 0; frame < frame_count; frame++)
+    {
+        for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+        {
+            Rollback_Session* session = &sessions[player];
+
+            // Player 1 reads its socket half a latency later, so both sides roll back by different amounts
+            if ((frame + player * latency_frames / 2) % latency_frames == 0)
+            {
+                rollback_session_update(session);
+            }
+
+            if (rollback_session_is_waiting(session))
+            {
+                session->stats.stall_count++;
+                continue;
+            }
+
+            // Turns about one frame in four
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            Direction input = DIRECTION_NONE;
+            if ((random_state & 3) == 0)
+            {
+                input = (Direction)(DIRECTION_NORTH + (random_state >> 2) % 4);
+            }
+            rollback_session_advance(session, input);
+            rollback_session_send(session);
+        }
+    }
+
+    // Let both sides catch up on every input and then compare
+    for (uint32 round = 0; round < 1000; round++)
+    {
+        for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+        {
+            rollback_session_update(&sessions[player]);
+        }
+        for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+        {
+            Rollback_Session* session = &sessions[player];
+            Rollback_Session* other = &sessions[1 - player];
+            // The side that's behind plays on without turning until they're level
+            if (session->sim->frame < other->sim->frame && !rollback_session_is_waiting(session))
+            {
+                rollback_session_advance(session, DIRECTION_NONE);
+            }
+            rollback_session_send(session);
+        }
+        if (sessions[0].sim->frame == sessions[1].sim->frame &&
+            sessions[0].remote_frame_count == sessions[0].sim->frame &&
+            sessions[1].remote_frame_count == sessions[1].sim->frame)
+        {
+            rollback_session_update(&sessions[0]);
+            rollback_session_update(&sessions[1]);
+            break;
+        }
+    }
+    real64 elapsed__ms =
+        (real64)(SDL_GetPerformanceCounter() - start_counter) * 1000.0 / (real64)SDL_GetPerformanceFrequency();
+
+    bool32 is_in_sync = sessions[0].sim->frame == sessions[1].sim->frame &&
+                        memcmp(sessions[0].sim, sessions[1].sim, sessions[0].sim->size) == 0;
+
+    printf("Rollback benchmark: %ux%u board, %u frames, inputs %u frames late, %.2f ms\n",
+           X_GRIDS,
+           Y_GRIDS,
+           frame_count,
+           latency_frames,
+           elapsed__ms);
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        Rollback_Stats* stats = &sessions[player].stats;
+        real64 per_frame__microseconds =
+            stats->resimulated_frames ? stats->total_resimulation__microseconds / stats->resimulated_frames : 0.0;
+        printf("  Player %u: frame %u, %u wins, %u rollbacks, up to %u frames deep, %llu frames resimulated\n",
+               player,
+               sessions[player].sim->frame,
+               sessions[player].sim->wins[player],
+               stats->rollback_count,
+               stats->max_rollback_frames,
+               (unsigned long long)stats->resimulated_frames);
+        printf("    %.3f us per resimulated frame (%.0fx real time), worst rollback %.1f us, %u stalls, "
+               "%u/%u packets\n",
+               per_frame__microseconds,
+               per_frame__microseconds > 0 ? VERSUS_GRID_JUMP_INTERVAL__MICROSECONDS / per_frame__microseconds : 0.0,
+               stats->max_resimulation__microseconds,
+               stats->stall_count,
+               stats->packets_received,
+               stats->packets_sent);
+    }
+    printf("  %s\n", is_in_sync ? "Both sides ended up with the same game" : "Out of sync!");
+
+    for (uint32 player = 0; player < VERSUS_PLAYER_COUNT; player++)
+    {
+        rollback_session_shutdown(&sessions[player]);
+    }
+    return is_in_sync ? 0 : -1;
+}
@@ -0,0 +1,396 @@
+#include <SDL2/SDL.h>
+
+#include "../audio.h"
+#include "../common.h"
+#include "../snake_sim.h"
+
+// One snake on a board much bigger than the screen (see world.cpp). Started with --world, which skips the start
+// screen. The camera keeps the head in the middle of the canvas and only the chunks under it get looked at, so a
+// frame costs the same on a 10000x10000 world as on one the size of the screen.
+
+struct World__State
+{
+    World* world;
+    Camera camera;
+    Gameplay__Texts* gameplay_texts;  // Same HUD as gameplay
+    Minimap minimap;
+
+    bool32 game_over;
+    bool32 is_paused;
+    Timer_Id grid_jump_timer;
+    uint64 next_grid_jump__microseconds;  // Simulation time
+
+    // Finding what's on screen, not drawing it
+    real32 last_cull__microseconds;
+    uint32 last_visible_chunk_count;
+};
+
+// Everything on screen as rects ready to fill, gathered a visible chunk at a time
+struct World__Visible
+{
+    SDL_Rect* heads;
+    SDL_Rect* bodies;
+    SDL_Rect* blips;
+    uint32 head_count;
+    uint32 body_count;
+    uint32 blip_count;
+    uint32 chunk_count;  // Chunks under the camera, allocated or not
+};
+
+// Keeps the head in the middle of a columns x rows view without showing anything past the edge of the world
+local_internal void world__follow_head(World* world, Camera* camera, int32 columns, int32 rows)
+{
+    camera->x = SDL_max(0, SDL_min(world->head_x - columns / 2, world->width - columns));
+    camera->y = SDL_max(0, SDL_min(world->head_y - rows / 2, world->height - rows));
+}
+
+// Looks at the cells under the camera and nothing else, so the cost only depends on columns and rows. Chunks that
+// were never allocated are empty apart from their blips, which come from the hash.
+local_internal void world__cull(
+    World* world, Camera* camera, int32 columns, int32 rows, Memory_Arena* memory, World__Visible* visible)
+{
+    *visible = {};
+    uint32 capacity = (uint32)columns * (uint32)rows;
+    visible->heads = push_array(memory, 1, SDL_Rect);
+    visible->bodies = push_array(memory, capacity, SDL_Rect);
+    visible->blips = push_array(memory, capacity, SDL_Rect);
+
+    int32 min_x = SDL_max(camera->x, 0);
+    int32 min_y = SDL_max(camera->y, 0);
+    int32 end_x = SDL_min(camera->x + columns, world->width);
+    int32 end_y = SDL_min(camera->y + rows, world->height);
+    if (min_x >= end_x || min_y >= end_y)
+    {
+        return;
+    }
+
+    real32 blip_size = GRID_BLOCK_SIZE * 0.5f;
+    for (int32 chunk_y = min_y >> WORLD_CHUNK_SHIFT; chunk_y <= (end_y - 1) >> WORLD_CHUNK_SHIFT; chunk_y++)
+    {
+        for (int32 chunk_x = min_x >> WORLD_CHUNK_SHIFT; chunk_x <= (end_x - 1) >> WORLD_CHUNK_SHIFT; chunk_x++)
+        {
+            World_Chunk* chunk = world->chunks[chunk_y * world->chunk_columns + chunk_x];
+            visible->chunk_count++;
+
+            int32 chunk_min_x = SDL_max(min_x, chunk_x << WORLD_CHUNK_SHIFT);
+            int32 chunk_min_y = SDL_max(min_y, chunk_y << WORLD_CHUNK_SHIFT);
+            int32 chunk_end_x = SDL_min(end_x, (chunk_x + 1) << WORLD_CHUNK_SHIFT);
+            int32 chunk_end_y = SDL_min(end_y, (chunk_y + 1) << WORLD_CHUNK_SHIFT);
+            for (int32 y = chunk_min_y; y < chunk_end_y; y++)
+            {
+                for (int32 x = chunk_min_x; x < chunk_end_x; x++)
+                {
+                    uint32 index = (uint32)((y & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (x & WORLD_CHUNK_MASK));
+                    uint8 cell = chunk ? chunk->cells[index] : WORLD_CELL_EMPTY;
+                    uint8 snake = cell & WORLD_CELL_SNAKE_MASK;
+                    if (!snake && !world_has_blip(world, x, y, cell))
+                    {
+                        continue;
+                    }
+
+                    Screen_Space_Position screen_pos =
+                        map_world_space_position_to_camera_space_position(camera, (real32)x, (real32)y);
+                    SDL_Rect square = {};
+                    square.x = (int32)screen_pos.x;
+                    square.y = (int32)screen_pos.y;
+                    square.w = (int32)GRID_BLOCK_SIZE;
+                    square.h = (int32)GRID_BLOCK_SIZE;
+
+                    if (snake == WORLD_CELL_HEAD)
+                    {
+                        visible->heads[visible->head_count++] = square;
+                    }
+                    else if (snake)
+                    {
+                        visible->bodies[visible->body_count++] = square;
+                    }
+                    else
+                    {
+                        square.x = (int32)(screen_pos.x + ((real32)GRID_BLOCK_SIZE / 2) - (blip_size / 2));
+                        square.y = (int32)(screen_pos.y + ((real32)GRID_BLOCK_SIZE / 2) - (blip_size / 2));
+                        square.w = (int32)blip_size;
+                        square.h = (int32)blip_size;
+                        visible->blips[visible->blip_count++] = square;
+                    }
+                }
+            }
+        }
+    }
+}
+
+local_internal void world__grid_jump(void* data, uint64 tick)
+{
+    World__State* state = (World__State*)data;
+
+    // Particles go where the head would be on screen with the camera at the bottom left of the world
+    World* world = state->world;
+    uint32 events = world_step(world, get_next_input());
+    if (events & SNAKE_SIM_ATE)
+    {
+        play_sound_effect(&global_audio_context.effect_beep_2);
+        gameplay__emit_pickup_particles(
+            map_world_space_position_to_screen_space_position(world->head_x, world->head_y));
+    }
+    if (world->is_game_over)
+    {
+        state->game_over = 1;
+        play_sound_effect(&global_audio_context.effect_boom);
+        gameplay__emit_game_over_particles(
+            map_world_space_position_to_screen_space_position(world->head_x, world->head_y));
+        return;
+    }
+
+    state->next_grid_jump__microseconds += WORLD_GRID_JUMP_INTERVAL__MICROSECONDS;
+    uint64 due_tick = get_simulation_tick_at(state->next_grid_jump__microseconds);
+    state->grid_jump_timer =
+        timer_wheel_schedule(&global_simulation_timers, SDL_max(due_tick, tick + 1), world__grid_jump, state);
+}
+
+local_internal void world__schedule_grid_jump(World__State* state)
+{
+    timer_wheel_cancel(&global_simulation_timers, state->grid_jump_timer);
+    uint64 now__microseconds = get_simulation_time__microseconds(global_simulation_timers.current_tick);
+    state->next_grid_jump__microseconds = now__microseconds + WORLD_GRID_JUMP_INTERVAL__MICROSECONDS;
+    state->grid_jump_timer = timer_wheel_schedule(&global_simulation_timers,
+                                                  get_simulation_tick_at(state->next_grid_jump__microseconds),
+                                                  world__grid_jump,
+                                                  state);
+}
+
+void world__reset_state(Scene* scene)
+{
+    World__State* state = (World__State*)scene->state;
+
+    // The input queue is shared with gameplay
+    head = 0;
+    tail = 0;
+
+    world_reset(state->world);
+    state->game_over = 0;
+    state->is_paused = 0;
+    world__schedule_grid_jump(state);
+}
+
+void world__handle_input(Scene* scene, Input* input)
+{
+    World__State* state = (World__State*)scene->state;
+
+    if (pressed(BUTTON_ESCAPE))
+    {
+        global_next_scene = &global_start_screen_scene;
+    }
+
+    if (pressed(BUTTON_SPACE) && !state->game_over)
+    {
+        state->is_paused = !state->is_paused;
+        if (state->is_paused)
+        {
+            timer_wheel_cancel(&global_simulation_timers, state->grid_jump_timer);
+        }
+        else
+        {
+            world__schedule_grid_jump(state);
+        }
+    }
+
+    if (!state->is_paused)
+    {
+        if (pressed(BUTTON_W) || pressed(BUTTON_UP))
+        {
+            add_input(DIRECTION_NORTH);
+        }
+
+        if (pressed(BUTTON_A) || pressed(BUTTON_LEFT))
+        {
+            add_input(DIRECTION_WEST);
+        }
+
+        if (pressed(BUTTON_S) || pressed(BUTTON_DOWN))
+        {
+            add_input(DIRECTION_SOUTH);
+        }
+
+        if (pressed(BUTTON_D) || pressed(BUTTON_RIGHT))
+        {
+            add_input(DIRECTION_EAST);
+        }
+    }
+
+    if (state->game_over && pressed(BUTTON_ENTER))
+    {
+        world__reset_state(scene);
+    }
+}
+
+void world__update(Scene* scene, uint64 simulation_tick)
+{
+    World__State* state = (World__State*)scene->state;
+    minimap_update(&state->minimap, state->world);
+}
+
+void world__render(Scene* scene)
+{
+    World__State* state = (World__State*)scene->state;
+    World* world = state->world;
+
+    draw_canvas();
+    render_grid(global_renderer);
+
+    uint64 start_counter = SDL_GetPerformanceCounter();
+    world__follow_head(world, &state->camera, (int32)X_GRIDS, (int32)Y_GRIDS);
+    World__Visible visible;
+    world__cull(world, &state->camera, (int32)X_GRIDS, (int32)Y_GRIDS, &global_transient_arena, &visible);
+    state->last_cull__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) * 1000000.0 /
+                                              (real64)SDL_GetPerformanceFrequency());
+    state->last_visible_chunk_count = visible.chunk_count;
+
+    SDL_SetRenderDrawColor(global_renderer, 52, 152, 219, 255);
+    SDL_RenderFillRects(global_renderer, visible.blips, (int32)visible.blip_count);
+    SDL_SetRenderDrawColor(global_renderer, 154, 63, 59, 255);
+    SDL_RenderFillRects(global_renderer, visible.bodies, (int32)visible.body_count);
+    SDL_SetRenderDrawColor(global_renderer, 171, 70, 66, 255);
+    SDL_RenderFillRects(global_renderer, visible.heads, (int32)visible.head_count);
+
+    particles_render(&global_particles,
+                     -(real32)state->camera.x * GRID_BLOCK_SIZE,
+                     (real32)state->camera.y * GRID_BLOCK_SIZE);
+
+    gameplay__render_texts(state->gameplay_texts, (int32)world->length - 1, state->game_over, state->is_paused);
+
+    // Under the score
+    minimap_render(&state->minimap,
+                   world,
+                   &state->camera,
+                   (int32)X_GRIDS,
+                   (int32)Y_GRIDS,
+                   LOGICAL_WIDTH - state->minimap.width - 10,
+                   30);
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// Goes straight on, turning now and then and whenever it has to
+local_internal Direction world__wander(World* world, uint32* random_state)
+{
+    Direction direction = (Direction)world->direction;
+    Direction left = (Direction)(DIRECTION_NORTH + (direction - DIRECTION_NORTH + 3) % 4);
+    Direction right = (Direction)(DIRECTION_NORTH + (direction - DIRECTION_NORTH + 1) % 4);
+    uint32 random = snake_sim_random(random_state) >> 16;
+
+    Direction candidates[3] = {direction, left, right};
+    if (random % 16 == 0)
+    {
+        candidates[0] = random & 16 ? left : right;
+        candidates[1] = direction;
+        candidates[2] = random & 16 ? right : left;
+    }
+
+    for (uint32 c = 0; c < 3; c++)
+    {
+        int32 x = world->head_x;
+        int32 y = world->head_y;
+        snake_sim_move(candidates[c], &x, &y);
+        if (world_is_inside(world, x, y) && !(world_get_cell(world, x, y) & WORLD_CELL_SNAKE_MASK))
+        {
+            return candidates[c];
+        }
+    }
+    return direction;
+}
+
+// --bench-world: wanders round worlds of each size for step_count cells, culling a screen's worth around the head
+// every few cells. Culling should cost the same whatever the size of the world, and memory should only grow with
+// the chunks the snake has been through.
+int32 world__run_benchmark(uint64 step_count)
+{
+    int32 sizes[] = {1000, 10000, 30000};
+    printf("World benchmark: %llu cells on each world, culling a %ux%u view every 64 cells\n",
+           (unsigned long long)step_count,
+           X_GRIDS,
+           Y_GRIDS);
+
+    for (uint32 i = 0; i < SDL_arraysize(sizes); i++)
+    {
+        World* world = &global_world;
+        if (!world_init(world, sizes[i], sizes[i], WORLD_BLIP_RARITY, 12345))
+        {
+            return -1;
+        }
+
+        uint32 random_state = 12345;
+        uint32 game_count = 1;
+        uint32 longest_snake = 0;
+        size_t max_chunk_bytes = 0;
+        uint64 cull_count = 0;
+        uint64 visible_chunk_total = 0;
+        real64 total_cull__microseconds = 0;
+        real32 max_cull__microseconds = 0;
+        uint64 step_counter = 0;
+        Minimap minimap;
+        Arena_Marker minimap_marker = arena_get_marker(&global_permanent_arena);
+        minimap_init(&minimap, world, &global_permanent_arena);
+        real64 total_minimap__microseconds = 0;
+
+        for (uint64 step = 0; step < step_count; step++)
+        {
+            uint64 start_counter = SDL_GetPerformanceCounter();
+            world_step(world, world__wander(world, &random_state));
+            step_counter += SDL_GetPerformanceCounter() - start_counter;
+
+            if (world->is_game_over)
+            {
+                longest_snake = SDL_max(longest_snake, world->length - 1);
+                max_chunk_bytes = SDL_max(max_chunk_bytes, world_get_chunk_bytes(world));
+                world_reset(world);
+                game_count++;
+            }
+
+            if (step % 64 == 0)
+            {
+                Arena_Marker marker = arena_get_marker(&global_transient_arena);
+                start_counter = SDL_GetPerformanceCounter();
+                Camera camera = {};
+                World__Visible visible;
+                world__follow_head(world, &camera, (int32)X_GRIDS, (int32)Y_GRIDS);
+                world__cull(world, &camera, (int32)X_GRIDS, (int32)Y_GRIDS, &global_transient_arena, &visible);
+                real32 cull__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) *
+                                                     1000000.0 / (real64)SDL_GetPerformanceFrequency());
+                arena_reset_to_marker(marker);
+
+                total_cull__microseconds += cull__microseconds;
+                max_cull__microseconds = SDL_max(max_cull__microseconds, cull__microseconds);
+                visible_chunk_total += visible.chunk_count;
+                cull_count++;
+
+                minimap_update(&minimap, world);
+                total_minimap__microseconds += minimap.last_update__microseconds;
+            }
+        }
+        longest_snake = SDL_max(longest_snake, world->length - 1);
+        max_chunk_bytes = SDL_max(max_chunk_bytes, world_get_chunk_bytes(world));
+
+        arena_reset_to_marker(minimap_marker);
+
+        real64 full_world__mb = (real64)sizes[i] * sizes[i] / (1024.0 * 1024.0);
+        printf("  %5dx%-5d %.1f ns per cell, cull %.1f us (max %.1f) over %.1f chunks, "
+               "chunks up to %.1f MB of %.1f MB, %u games, longest snake %u\n"
+               "               %dx%d minimap: %.2f us per update (max %.1f)\n",
+               sizes[i],
+               sizes[i],
+               (real64)step_counter * 1000000000.0 / (real64)SDL_GetPerformanceFrequency() / (real64)step_count,
+               total_cull__microseconds / cull_count,
+               max_cull__microseconds,
+               (real64)visible_chunk_total / cull_count,
+               (real64)max_chunk_bytes / (1024.0 * 1024.0),
+               full_world__mb,
+               game_count,
+               longest_snake,
+               minimap.width,
+               minimap.height,
+               total_minimap__microseconds / cull_count,
+               minimap.max_update__microseconds);
+    }
+    return 0;
+}
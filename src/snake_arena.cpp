@@ -0,0 +1,553 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#include "common.h"
+#include "snake_sim.h"
+
+// Hundreds to thousands of AI snakes on one big board. Every snake's state is kept as structure of arrays, and each
+// tick is two passes over them split across the worker pool, with a join in between:
+//
+// 1. Move: every snake looks at the board as it was at the start of the tick, picks a direction and claims the cell
+//    its head is going to. When several heads go for the same cell the lowest snake index gets it (an atomic min), so
+//    the outcome doesn't depend on which worker got there first.
+// 2. Apply: the winners move (eating any blip they land on), everyone else that went for a taken or blocked cell dies
+//    and takes its body off the board.
+//
+// Then a short serial step puts eaten blips back and brings dead snakes back. Heads only ever go into cells that were
+// empty (or a blip) at the start of the tick, so no two snakes ever write the same cell in a pass, which is why the
+// board is a byte per cell rather than a bitmap. Tails count as walls even when they're about to move. The result is
+// the same for any number of workers.
+
+#define SNAKE_ARENA_MAX_LENGTH 64  // Snakes stop growing here, so every body fits in a few bytes
+#define SNAKE_ARENA_BODY_BYTES (SNAKE_ARENA_MAX_LENGTH / 4)
+#define SNAKE_ARENA_RESPAWN_TICKS 20
+#define SNAKE_ARENA_SIGHT 8  // How many cells ahead a snake can see a blip
+#define SNAKE_ARENA_CRASHED 0xFFFFFFFFu  // In next_cells
+
+// What's in a cell. Anything from SNAKE_ARENA_CELL_SNAKE up is a snake, offset by its index so neighbouring snakes
+// come out in different colours.
+#define SNAKE_ARENA_CELL_EMPTY 0
+#define SNAKE_ARENA_CELL_BLIP 1
+#define SNAKE_ARENA_CELL_SNAKE 2
+
+// Each worker counts on its own cache line
+struct alignas(64) Snake_Arena_Worker_Stats
+{
+    uint32 blips_eaten;
+    uint32 crashes;
+};
+
+struct Snake_Arena
+{
+    int32 width;
+    int32 height;
+    uint32 snake_count;
+    uint32 blip_count;  // Always this many on the board
+
+    uint8* cells;  // width * height, SNAKE_ARENA_CELL_
+    SDL_atomic_t* claims;  // width * height, the lowest index + 1 of the snakes moving there this tick, or 0
+
+    // snake_count of each
+    int16* head_x;
+    int16* head_y;
+    int16* tail_x;
+    int16* tail_y;
+    uint8* directions;
+    uint8* is_alive;
+    uint16* lengths;
+    uint16* body_starts;
+    uint32* random_states;
+    uint32* respawn_ticks;  // When a dead snake comes back
+    uint32* scores;
+    uint8* bodies;  // SNAKE_ARENA_BODY_BYTES each, 2 bit moves tail first like Snake_Sim
+    uint32* next_cells;  // Handed from the move pass to the apply pass
+
+    uint32 tick;
+    uint32 random_state;  // Respawns and new blips, on the serial step
+
+    Worker_Pool pool;
+    uint32 active_worker_count;  // 0 is all of them
+    Snake_Arena_Worker_Stats worker_stats[WORKER_POOL_MAX_WORKERS];
+
+    // Stats
+    uint32 alive_count;
+    uint64 blips_eaten;
+    uint64 crashes;
+    uint64 tick_count;
+    real64 total_tick__microseconds;
+    real32 last_tick__microseconds;
+    real32 max_tick__microseconds;
+};
+
+Snake_Arena global_snake_arena;
+
+// The snakes worker_index works on
+local_internal void snake_arena_get_range(Snake_Arena* arena, uint32 worker_index, uint32* first, uint32* end)
+{
+    uint32 worker_count = arena->active_worker_count ? arena->active_worker_count : arena->pool.worker_count;
+    *first = (uint32)((uint64)arena->snake_count * worker_index / worker_count);
+    *end = (uint32)((uint64)arena->snake_count * (worker_index + 1) / worker_count);
+}
+
+local_internal uint8 snake_arena_get_snake_cell(uint32 snake)
+{
+    return (uint8)(SNAKE_ARENA_CELL_SNAKE + snake % (256 - SNAKE_ARENA_CELL_SNAKE));
+}
+
+local_internal bool32 snake_arena_is_free(Snake_Arena* arena, int32 x, int32 y)
+{
+    return x >= 0 && x < arena->width && y >= 0 && y < arena->height &&
+           arena->cells[y * arena->width + x] < SNAKE_ARENA_CELL_SNAKE;
+}
+
+// Somewhere empty, or false if a few tries didn't find anywhere
+local_internal bool32 snake_arena_find_empty_cell(Snake_Arena* arena, int32* x, int32* y)
+{
+    for (uint32 attempt = 0; attempt < 64; attempt++)
+    {
+        *x = (int32)(snake_sim_random(&arena->random_state) % (uint32)arena->width);
+        *y = (int32)(snake_sim_random(&arena->random_state) % (uint32)arena->height);
+        if (arena->cells[*y * arena->width + *x] == SNAKE_ARENA_CELL_EMPTY)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+local_internal void snake_arena_place_blip(Snake_Arena* arena)
+{
+    int32 x, y;
+    if (snake_arena_find_empty_cell(arena, &x, &y))
+    {
+        arena->cells[y * arena->width + x] = SNAKE_ARENA_CELL_BLIP;
+    }
+}
+
+local_internal void snake_arena_spawn(Snake_Arena* arena, uint32 snake)
+{
+    int32 x, y;
+    if (!snake_arena_find_empty_cell(arena, &x, &y))
+    {
+        // Try again next tick
+        arena->respawn_ticks[snake] = arena->tick + 1;
+        return;
+    }
+
+    arena->head_x[snake] = (int16)x;
+    arena->head_y[snake] = (int16)y;
+    arena->tail_x[snake] = (int16)x;
+    arena->tail_y[snake] = (int16)y;
+    arena->directions[snake] = (uint8)(DIRECTION_NORTH + snake_sim_random(&arena->random_state) % 4);
+    arena->lengths[snake] = 1;
+    arena->body_starts[snake] = 0;
+    arena->scores[snake] = 0;
+    arena->is_alive[snake] = true;
+    arena->cells[y * arena->width + x] = snake_arena_get_snake_cell(snake);
+}
+
+local_internal Direction snake_arena_get_body_move(Snake_Arena* arena, uint32 snake, uint32 i)
+{
+    uint32 index = (arena->body_starts[snake] + i) % SNAKE_ARENA_MAX_LENGTH;
+    uint8* body = arena->bodies + (size_t)snake * SNAKE_ARENA_BODY_BYTES;
+    return (Direction)(DIRECTION_NORTH + ((body[index / 4] >> (index % 4 * 2)) & 3));
+}
+
+local_internal void snake_arena_set_body_move(Snake_Arena* arena, uint32 snake, uint32 i, Direction direction)
+{
+    uint32 index = (arena->body_starts[snake] + i) % SNAKE_ARENA_MAX_LENGTH;
+    uint8* body = arena->bodies + (size_t)snake * SNAKE_ARENA_BODY_BYTES;
+    body[index / 4] =
+        (uint8)((body[index / 4] & ~(3 << (index % 4 * 2))) | ((direction - DIRECTION_NORTH) << (index % 4 * 2)));
+}
+
+//=======================================================
+// MOVE PASS
+//=======================================================
+
+// Straight on, left or right: whichever is free and has a blip on it or closest ahead, preferring straight on with a
+// bit of randomness so the snakes don't all move in lockstep
+local_internal Direction snake_arena_decide(Snake_Arena* arena, uint32 snake)
+{
+    Direction direction = (Direction)arena->directions[snake];
+    Direction candidates[3] = {direction,
+                               (Direction)(DIRECTION_NORTH + (direction - DIRECTION_NORTH + 3) % 4),
+                               (Direction)(DIRECTION_NORTH + (direction - DIRECTION_NORTH + 1) % 4)};
+    // The low bits of the generator repeat quickly, so the jitter comes from the top ones
+    uint32 random = snake_sim_random(&arena->random_states[snake]) >> 16;
+
+    Direction best = direction;
+    int32 best_score = -1;
+    for (uint32 c = 0; c < 3; c++)
+    {
+        int32 x = arena->head_x[snake];
+        int32 y = arena->head_y[snake];
+        snake_sim_move(candidates[c], &x, &y);
+        if (!snake_arena_is_free(arena, x, y))
+        {
+            continue;
+        }
+
+        int32 score = (c == 0 ? 4 : 0) + (int32)((random >> (c * 3)) & 7);
+        for (int32 distance = 0; distance < SNAKE_ARENA_SIGHT && snake_arena_is_free(arena, x, y); distance++)
+        {
+            if (arena->cells[y * arena->width + x] == SNAKE_ARENA_CELL_BLIP)
+            {
+                score += 100 - distance * 10;
+                break;
+            }
+            snake_sim_move(candidates[c], &x, &y);
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best = candidates[c];
+        }
+    }
+    return best;
+}
+
+local_internal void snake_arena_move_job(void* data, uint32 worker_index)
+{
+    Snake_Arena* arena = (Snake_Arena*)data;
+    uint32 first, end;
+    snake_arena_get_range(arena, worker_index, &first, &end);
+
+    for (uint32 snake = first; snake < end; snake++)
+    {
+        if (!arena->is_alive[snake])
+        {
+            continue;
+        }
+
+        Direction direction = snake_arena_decide(arena, snake);
+        arena->directions[snake] = (uint8)direction;
+
+        int32 x = arena->head_x[snake];
+        int32 y = arena->head_y[snake];
+        snake_sim_move(direction, &x, &y);
+        if (!snake_arena_is_free(arena, x, y))
+        {
+            arena->next_cells[snake] = SNAKE_ARENA_CRASHED;
+            continue;
+        }
+
+        uint32 cell = (uint32)(y * arena->width + x);
+        arena->next_cells[snake] = cell;
+
+        // Lowest index wins
+        int32 claim = (int32)snake + 1;
+        for (;;)
+        {
+            int32 current = SDL_AtomicGet(&arena->claims[cell]);
+            if ((current != 0 && current <= claim) || SDL_AtomicCAS(&arena->claims[cell], current, claim))
+            {
+                break;
+            }
+        }
+    }
+}
+
+//=======================================================
+// APPLY PASS
+//=======================================================
+
+local_internal void snake_arena_kill(Snake_Arena* arena, uint32 snake)
+{
+    int32 x = arena->tail_x[snake];
+    int32 y = arena->tail_y[snake];
+    for (uint32 i = 0; i < arena->lengths[snake]; i++)
+    {
+        arena->cells[y * arena->width + x] = SNAKE_ARENA_CELL_EMPTY;
+        if (i + 1 < arena->lengths[snake])
+        {
+            snake_sim_move(snake_arena_get_body_move(arena, snake, i), &x, &y);
+        }
+    }
+    arena->is_alive[snake] = false;
+    arena->respawn_ticks[snake] = arena->tick + SNAKE_ARENA_RESPAWN_TICKS;
+}
+
+local_internal void snake_arena_apply_job(void* data, uint32 worker_index)
+{
+    Snake_Arena* arena = (Snake_Arena*)data;
+    Snake_Arena_Worker_Stats* stats = &arena->worker_stats[worker_index];
+    uint32 first, end;
+    snake_arena_get_range(arena, worker_index, &first, &end);
+
+    for (uint32 snake = first; snake < end; snake++)
+    {
+        if (!arena->is_alive[snake])
+        {
+            continue;
+        }
+
+        uint32 cell = arena->next_cells[snake];
+        if (cell == SNAKE_ARENA_CRASHED || SDL_AtomicGet(&arena->claims[cell]) != (int32)snake + 1)
+        {
+            snake_arena_kill(arena, snake);
+            stats->crashes++;
+            continue;
+        }
+
+        // Only the winner gets here, so it can clear the claim for next tick. The losers see 0 and still lose.
+        SDL_AtomicSet(&arena->claims[cell], 0);
+
+        bool32 is_growing = false;
+        if (arena->cells[cell] == SNAKE_ARENA_CELL_BLIP)
+        {
+            stats->blips_eaten++;
+            arena->scores[snake]++;
+            is_growing = arena->lengths[snake] < SNAKE_ARENA_MAX_LENGTH;
+        }
+
+        Direction direction = (Direction)arena->directions[snake];
+        uint32 length = arena->lengths[snake];
+        if (!is_growing)
+        {
+            int32 tail_x = arena->tail_x[snake];
+            int32 tail_y = arena->tail_y[snake];
+            arena->cells[tail_y * arena->width + tail_x] = SNAKE_ARENA_CELL_EMPTY;
+            if (length > 1)
+            {
+                snake_sim_move(snake_arena_get_body_move(arena, snake, 0), &tail_x, &tail_y);
+                arena->body_starts[snake] = (uint16)((arena->body_starts[snake] + 1) % SNAKE_ARENA_MAX_LENGTH);
+            }
+            else
+            {
+                tail_x = (int32)(cell % (uint32)arena->width);
+                tail_y = (int32)(cell / (uint32)arena->width);
+            }
+            arena->tail_x[snake] = (int16)tail_x;
+            arena->tail_y[snake] = (int16)tail_y;
+        }
+        else
+        {
+            length++;
+            arena->lengths[snake] = (uint16)length;
+        }
+
+        if (length > 1)
+        {
+            snake_arena_set_body_move(arena, snake, length - 2, direction);
+        }
+        arena->head_x[snake] = (int16)(cell % (uint32)arena->width);
+        arena->head_y[snake] = (int16)(cell / (uint32)arena->width);
+        arena->cells[cell] = snake_arena_get_snake_cell(snake);
+    }
+}
+
+//=======================================================
+// TICK
+//=======================================================
+
+void snake_arena_tick(Snake_Arena* arena)
+{
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    uint32 worker_count = arena->active_worker_count ? arena->active_worker_count : arena->pool.worker_count;
+    memset(arena->worker_stats, 0, sizeof(arena->worker_stats));
+    worker_pool_run(&arena->pool, snake_arena_move_job, arena, worker_count);
+    worker_pool_run(&arena->pool, snake_arena_apply_job, arena, worker_count);
+    arena->tick++;
+
+    uint32 blips_eaten = 0;
+    for (uint32 i = 0; i < worker_count; i++)
+    {
+        blips_eaten += arena->worker_stats[i].blips_eaten;
+        arena->crashes += arena->worker_stats[i].crashes;
+    }
+    arena->blips_eaten += blips_eaten;
+    for (uint32 i = 0; i < blips_eaten; i++)
+    {
+        snake_arena_place_blip(arena);
+    }
+
+    uint32 alive_count = 0;
+    for (uint32 snake = 0; snake < arena->snake_count; snake++)
+    {
+        if (!arena->is_alive[snake] && arena->respawn_ticks[snake] <= arena->tick)
+        {
+            snake_arena_spawn(arena, snake);
+        }
+        alive_count += arena->is_alive[snake];
+    }
+    arena->alive_count = alive_count;
+
+    real32 tick__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) * 1000000.0 /
+                                         (real64)SDL_GetPerformanceFrequency());
+    arena->last_tick__microseconds = tick__microseconds;
+    arena->max_tick__microseconds = SDL_max(arena->max_tick__microseconds, tick__microseconds);
+    arena->total_tick__microseconds += tick__microseconds;
+    arena->tick_count++;
+}
+
+// Puts everyone back where a fresh arena with this seed would have them, keeping the workers
+void snake_arena_reset(Snake_Arena* arena, uint32 seed)
+{
+    uint32 cell_count = (uint32)arena->width * (uint32)arena->height;
+    memset(arena->cells, 0, cell_count);
+    memset(arena->claims, 0, cell_count * sizeof(SDL_atomic_t));
+    memset(arena->bodies, 0, (size_t)arena->snake_count * SNAKE_ARENA_BODY_BYTES);
+
+    arena->tick = 0;
+    arena->random_state = seed;
+    arena->blips_eaten = 0;
+    arena->crashes = 0;
+    arena->tick_count = 0;
+    arena->total_tick__microseconds = 0;
+    arena->last_tick__microseconds = 0;
+    arena->max_tick__microseconds = 0;
+
+    for (uint32 snake = 0; snake < arena->snake_count; snake++)
+    {
+        arena->random_states[snake] = seed ^ (snake * 0x9E3779B9u);
+        arena->is_alive[snake] = false;
+        snake_arena_spawn(arena, snake);
+    }
+    for (uint32 i = 0; i < arena->blip_count; i++)
+    {
+        snake_arena_place_blip(arena);
+    }
+
+    arena->alive_count = 0;
+    for (uint32 snake = 0; snake < arena->snake_count; snake++)
+    {
+        arena->alive_count += arena->is_alive[snake];
+    }
+}
+
+// 0 workers is one per core
+void snake_arena_init(Snake_Arena* arena,
+                      Memory_Arena* memory,
+                      int32 width,
+                      int32 height,
+                      uint32 snake_count,
+                      uint32 blip_count,
+                      uint32 worker_count,
+                      uint32 seed)
+{
+    *arena = {};
+    arena->width = width;
+    arena->height = height;
+    arena->snake_count = snake_count;
+    arena->blip_count = blip_count;
+
+    uint32 cell_count = (uint32)width * (uint32)height;
+    arena->cells = push_array(memory, cell_count, uint8);
+    arena->claims = (SDL_atomic_t*)push_size(memory, cell_count * sizeof(SDL_atomic_t), 64);
+
+    arena->head_x = push_array(memory, snake_count, int16);
+    arena->head_y = push_array(memory, snake_count, int16);
+    arena->tail_x = push_array(memory, snake_count, int16);
+    arena->tail_y = push_array(memory, snake_count, int16);
+    arena->directions = push_array(memory, snake_count, uint8);
+    arena->is_alive = push_array(memory, snake_count, uint8);
+    arena->lengths = push_array(memory, snake_count, uint16);
+    arena->body_starts = push_array(memory, snake_count, uint16);
+    arena->random_states = push_array(memory, snake_count, uint32);
+    arena->respawn_ticks = push_array(memory, snake_count, uint32);
+    arena->scores = push_array(memory, snake_count, uint32);
+    arena->bodies = push_array(memory, (size_t)snake_count * SNAKE_ARENA_BODY_BYTES, uint8);
+    arena->next_cells = push_array(memory, snake_count, uint32);
+
+    worker_pool_init(&arena->pool, worker_count);
+    snake_arena_reset(arena, seed);
+}
+
+void snake_arena_shutdown(Snake_Arena* arena)
+{
+    if (arena->cells)
+    {
+        worker_pool_shutdown(&arena->pool);
+    }
+    *arena = {};
+}
+
+//=======================================================
+// BENCHMARK
+//=======================================================
+
+// FNV-1a over the board and the scores, to check every worker count plays out the same
+local_internal uint64 snake_arena_checksum(Snake_Arena* arena)
+{
+    uint64 hash = 14695981039346656037ull;
+    uint32 cell_count = (uint32)arena->width * (uint32)arena->height;
+    for (uint32 i = 0; i < cell_count; i++)
+    {
+        hash = (hash ^ arena->cells[i]) * 1099511628211ull;
+    }
+    for (uint32 snake = 0; snake < arena->snake_count; snake++)
+    {
+        hash = (hash ^ arena->scores[snake]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// --bench-arena: snake_count snakes on a width x height board for tick_count ticks, with 1, 2, 4... workers up to one
+// per core. Reports snake ticks per second and checks they all end up with the same board.
+int32 snake_arena_run_benchmark(Memory_Arena* memory,
+                                int32 width,
+                                int32 height,
+                                uint32 snake_count,
+                                uint32 tick_count)
+{
+    Snake_Arena* arena = &global_snake_arena;
+    snake_arena_init(arena, memory, width, height, snake_count, snake_count, 0, 12345);
+
+    printf("Arena benchmark: %u snakes on a %dx%d board, %u ticks\n", snake_count, width, height, tick_count);
+
+    uint64 first_checksum = 0;
+    real64 single_worker_rate = 0;
+    bool32 is_same_everywhere = true;
+    for (uint32 worker_count = 1;; worker_count = SDL_min(worker_count * 2, arena->pool.worker_count))
+    {
+        arena->active_worker_count = worker_count;
+        snake_arena_reset(arena, 12345);
+
+        uint64 alive_total = 0;
+        for (uint32 tick = 0; tick < tick_count; tick++)
+        {
+            snake_arena_tick(arena);
+            alive_total += arena->alive_count;
+        }
+
+        real64 elapsed__seconds = arena->total_tick__microseconds / 1000000.0;
+        real64 snake_ticks_per_second = elapsed__seconds > 0 ? (real64)snake_count * tick_count / elapsed__seconds : 0;
+        if (worker_count == 1)
+        {
+            single_worker_rate = snake_ticks_per_second;
+        }
+
+        uint64 checksum = snake_arena_checksum(arena);
+        if (worker_count == 1)
+        {
+            first_checksum = checksum;
+        }
+        else if (checksum != first_checksum)
+        {
+            is_same_everywhere = false;
+        }
+
+        printf("  %2u workers: %.0f snake ticks/s (%.2fx), %.1f us per tick (max %.1f), %.0f alive on average, "
+               "%llu blips eaten, %llu crashes\n",
+               worker_count,
+               snake_ticks_per_second,
+               single_worker_rate > 0 ? snake_ticks_per_second / single_worker_rate : 0.0,
+               arena->total_tick__microseconds / tick_count,
+               arena->max_tick__microseconds,
+               (real64)alive_total / tick_count,
+               (unsigned long long)arena->blips_eaten,
+               (unsigned long long)arena->crashes);
+
+        if (worker_count == arena->pool.worker_count)
+        {
+            break;
+        }
+    }
+    printf("  %s\n", is_same_everywhere ? "Every worker count played out the same" : "Worker counts disagree!");
+
+    snake_arena_shutdown(arena);
+    return is_same_everywhere ? 0 : -1;
+}
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_batch_env.h"
+#include "snake_sim.h"
+
+// Each step goes over the games twice. The first pass does the turning, works out where every head goes and whether
+// it's on a blip, one field at a time across all of them with no branches, so the compiler can vectorize it. The
+// second pass does what depends on the board (crashes, moving the tail, new blips, restarts) a game at a time.
+
+static_assert(SNAKE_BATCH_ENV_ACTION_NORTH == DIRECTION_NORTH && SNAKE_BATCH_ENV_ACTION_WEST == DIRECTION_WEST,
+              "Actions are Directions");
+
+#define SNAKE_BATCH_ENV_MAX_SIDE 32767
+
+struct Snake_Batch_Env
+{
+    uint32 env_count;
+    int32 width;
+    int32 height;
+    uint32 cell_count;
+    uint32 occupancy_words_per_env;
+    uint32 body_bytes_per_env;
+
+    Snake_Batch_Buffers buffers;
+
+    // env_count of each
+    int16* tail_x;
+    int16* tail_y;
+    uint8* directions;
+    uint32* lengths;
+    uint32* body_starts;
+    uint32* random_states;
+    uint8* bodies;  // body_bytes_per_env each, 2 bit moves tail first like Snake_Sim
+
+    // Handed from the first pass to the second
+    int16* next_head_x;
+    int16* next_head_y;
+    uint8* is_growing;
+};
+
+uint32_t snake_batch_env_occupancy_words_per_env(int32_t width, int32_t height)
+{
+    uint32 words = ((uint32)width * (uint32)height + 63) / 64;
+    return (words + 7) & ~7u;
+}
+
+local_internal void snake_batch_env_set_occupied(uint64* occupancy, uint32 cell, bool32 is_occupied)
+{
+    uint64 bit = (uint64)1 << (cell % 64);
+    occupancy[cell / 64] = is_occupied ? occupancy[cell / 64] | bit : occupancy[cell / 64] & ~bit;
+}
+
+// Same start as snake_sim_reset
+local_internal void snake_batch_env_reset_game(Snake_Batch_Env* env, uint32 i)
+{
+    Snake_Batch_Buffers* buffers = &env->buffers;
+    uint64* occupancy = buffers->occupancy + (size_t)i * env->occupancy_words_per_env;
+    memset(occupancy, 0, env->occupancy_words_per_env * sizeof(uint64));
+
+    int16 head_x = (int16)(env->width / 2);
+    int16 head_y = (int16)(env->height / 4);
+    buffers->head_x[i] = head_x;
+    buffers->head_y[i] = head_y;
+    buffers->blip_x[i] = (int16)(env->width / 2);
+    buffers->blip_y[i] = (int16)(env->height / 2);
+
+    env->tail_x[i] = head_x;
+    env->tail_y[i] = head_y;
+    env->directions[i] = DIRECTION_NORTH;
+    env->lengths[i] = 1;
+    env->body_starts[i] = 0;
+
+    snake_batch_env_set_occupied(occupancy, (uint32)head_y * env->width + head_x, true);
+}
+
+void snake_batch_env_reset(Snake_Batch_Env* env)
+{
+    for (uint32 i = 0; i < env->env_count; i++)
+    {
+        snake_batch_env_reset_game(env, i);
+        env->buffers.rewards[i] = 0.0f;
+        env->buffers.dones[i] = 0;
+    }
+}
+
+void snake_batch_env_destroy(Snake_Batch_Env* env)
+{
+    if (!env)
+    {
+        return;
+    }
+    free(env->tail_x);
+    free(env->tail_y);
+    free(env->directions);
+    free(env->lengths);
+    free(env->body_starts);
+    free(env->random_states);
+    free(env->bodies);
+    free(env->next_head_x);
+    free(env->next_head_y);
+    free(env->is_growing);
+    free(env);
+}
+
+Snake_Batch_Env* snake_batch_env_create(
+    uint32_t env_count, int32_t width, int32_t height, uint64_t seed, const Snake_Batch_Buffers* buffers)
+{
+    if (env_count == 0 || width <= 0 || height <= 0 || width > SNAKE_BATCH_ENV_MAX_SIDE ||
+        height > SNAKE_BATCH_ENV_MAX_SIDE)
+    {
+        return NULL;
+    }
+
+    Snake_Batch_Env* env = (Snake_Batch_Env*)calloc(1, sizeof(Snake_Batch_Env));
+    if (!env)
+    {
+        return NULL;
+    }
+
+    env->env_count = env_count;
+    env->width = width;
+    env->height = height;
+    env->cell_count = (uint32)width * (uint32)height;
+    env->occupancy_words_per_env = snake_batch_env_occupancy_words_per_env(width, height);
+    env->body_bytes_per_env = (env->cell_count + 3) / 4;
+    env->buffers = *buffers;
+
+    env->tail_x = (int16*)calloc(env_count, sizeof(int16));
+    env->tail_y = (int16*)calloc(env_count, sizeof(int16));
+    env->directions = (uint8*)calloc(env_count, sizeof(uint8));
+    env->lengths = (uint32*)calloc(env_count, sizeof(uint32));
+    env->body_starts = (uint32*)calloc(env_count, sizeof(uint32));
+    env->random_states = (uint32*)calloc(env_count, sizeof(uint32));
+    env->bodies = (uint8*)calloc((size_t)env_count * env->body_bytes_per_env, 1);
+    env->next_head_x = (int16*)calloc(env_count, sizeof(int16));
+    env->next_head_y = (int16*)calloc(env_count, sizeof(int16));
+    env->is_growing = (uint8*)calloc(env_count, sizeof(uint8));
+    if (!env->tail_x || !env->tail_y || !env->directions || !env->lengths || !env->body_starts ||
+        !env->random_states || !env->bodies || !env->next_head_x || !env->next_head_y || !env->is_growing)
+    {
+        snake_batch_env_destroy(env);
+        return NULL;
+    }
+
+    // Every game gets its own blips
+    uint32 random_state = (uint32)(seed ^ (seed >> 32));
+    for (uint32 i = 0; i < env_count; i++)
+    {
+        env->random_states[i] = snake_sim_random(&random_state);
+    }
+
+    snake_batch_env_reset(env);
+    return env;
+}
+
+void snake_batch_env_step(Snake_Batch_Env* env, const uint8_t* actions)
+{
+    Snake_Batch_Buffers* buffers = &env->buffers;
+    uint32 env_count = env->env_count;
+
+    {  // Turn, move the heads and check for blips
+        int16* head_x = buffers->head_x;
+        int16* head_y = buffers->head_y;
+        int16* blip_x = buffers->blip_x;
+        int16* blip_y = buffers->blip_y;
+        uint8* directions = env->directions;
+        int16* next_head_x = env->next_head_x;
+        int16* next_head_y = env->next_head_y;
+        uint8* is_growing = env->is_growing;
+        float* rewards = buffers->rewards;
+        uint8* dones = buffers->dones;
+
+        for (uint32 i = 0; i < env_count; i++)
+        {
+            uint8 action = actions[i];
+            uint8 direction = directions[i];
+            // North and south are 1 and 3, east and west 2 and 4
+            uint8 opposite = (uint8)(((direction + 1) & 3) + 1);
+            bool32 does_turn = action >= DIRECTION_NORTH && action <= DIRECTION_WEST && action != opposite;
+            direction = does_turn ? action : direction;
+            directions[i] = direction;
+
+            int16 x = head_x[i];
+            int16 y = head_y[i];
+            uint8 grows = x == blip_x[i] && y == blip_y[i];
+            is_growing[i] = grows;
+            rewards[i] = grows ? SNAKE_BATCH_ENV_REWARD_BLIP : 0.0f;
+            dones[i] = 0;
+
+            next_head_x[i] = (int16)(x + (direction == DIRECTION_EAST) - (direction == DIRECTION_WEST));
+            next_head_y[i] = (int16)(y + (direction == DIRECTION_NORTH) - (direction == DIRECTION_SOUTH));
+        }
+    }
+
+    // Everything else, in the same order as snake_sim_step
+    uint32 cell_count = env->cell_count;
+    for (uint32 i = 0; i < env_count; i++)
+    {
+        uint64* occupancy = buffers->occupancy + (size_t)i * env->occupancy_words_per_env;
+        uint8* body = env->bodies + (size_t)i * env->body_bytes_per_env;
+        bool32 is_growing = env->is_growing[i];
+
+        if (is_growing)
+        {
+            if (env->lengths[i] == cell_count)
+            {
+                // Filled the board
+                buffers->dones[i] = 1;
+                snake_batch_env_reset_game(env, i);
+                continue;
+            }
+            buffers->blip_x[i] = (int16)(snake_sim_random(&env->random_states[i]) % (uint32)env->width);
+            buffers->blip_y[i] = (int16)(snake_sim_random(&env->random_states[i]) % (uint32)env->height);
+        }
+
+        int32 x = env->next_head_x[i];
+        int32 y = env->next_head_y[i];
+        int32 tail_x = env->tail_x[i];
+        int32 tail_y = env->tail_y[i];
+        uint32 cell = (uint32)y * env->width + x;
+        bool32 is_inside = x >= 0 && x < env->width && y >= 0 && y < env->height;
+        // The tail moves out of the way at the same time, so the head can follow right behind it
+        bool32 is_onto_tail = !is_growing && x == tail_x && y == tail_y;
+        if (!is_inside || (((occupancy[cell / 64] >> (cell % 64)) & 1) && !is_onto_tail))
+        {
+            buffers->rewards[i] = SNAKE_BATCH_ENV_REWARD_CRASH;
+            buffers->dones[i] = 1;
+            snake_batch_env_reset_game(env, i);
+            continue;
+        }
+
+        uint32 length = env->lengths[i];
+        uint32 body_start = env->body_starts[i];
+        if (!is_growing)
+        {
+            snake_batch_env_set_occupied(occupancy, (uint32)tail_y * env->width + tail_x, false);
+            if (length > 1)
+            {
+                uint32 move = (body[body_start / 4] >> (body_start % 4 * 2)) & 3;
+                snake_sim_move((Direction)(DIRECTION_NORTH + move), &tail_x, &tail_y);
+                env->tail_x[i] = (int16)tail_x;
+                env->tail_y[i] = (int16)tail_y;
+                body_start = (body_start + 1) % cell_count;
+                env->body_starts[i] = body_start;
+            }
+        }
+        else
+        {
+            length++;
+            env->lengths[i] = length;
+        }
+
+        if (length > 1)
+        {
+            uint32 index = (body_start + length - 2) % cell_count;
+            body[index / 4] = (uint8)((body[index / 4] & ~(3 << (index % 4 * 2))) |
+                                      ((env->directions[i] - DIRECTION_NORTH) << (index % 4 * 2)));
+        }
+        else
+        {
+            env->tail_x[i] = (int16)x;
+            env->tail_y[i] = (int16)y;
+        }
+
+        buffers->head_x[i] = (int16)x;
+        buffers->head_y[i] = (int16)y;
+        snake_batch_env_set_occupied(occupancy, cell, true);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SNAKE_BATCH_ENV_H
+#define SNAKE_BATCH_ENV_H
+
+// N independent games of snake stepped together, for training bots. Built as a shared library with a C API (see
+// build-macos.sh and build-windows.bat) so it can be loaded from anywhere, e.g. Python's ctypes.
+//
+// The rules are the game's (the same as snake_sim_step), but the state is stored a field at a time across all the
+// games, and the observations are the state: the occupancy bitmaps, heads, blips, rewards and done flags live in
+// buffers the caller owns, and stepping writes straight into them. Nothing gets copied out.
+//
+// A game that ends is started again on the same step, so the observation after a done is the first one of the next
+// game. Actions are 0 to keep going straight, or 1 to 4 for north, east, south and west (turning straight back is
+// ignored, like in the game).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SNAKE_BATCH_ENV_EXPORTS)
+#define SNAKE_BATCH_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define SNAKE_BATCH_ENV_API __declspec(dllimport)
+#else
+#define SNAKE_BATCH_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNAKE_BATCH_ENV_ACTION_NONE 0
+#define SNAKE_BATCH_ENV_ACTION_NORTH 1
+#define SNAKE_BATCH_ENV_ACTION_EAST 2
+#define SNAKE_BATCH_ENV_ACTION_SOUTH 3
+#define SNAKE_BATCH_ENV_ACTION_WEST 4
+
+#define SNAKE_BATCH_ENV_REWARD_BLIP 1.0f
+#define SNAKE_BATCH_ENV_REWARD_CRASH -1.0f
+
+// Caller owned, env_count entries each (occupancy is env_count * occupancy_words_per_env words). Every game's bitmap
+// starts on a 64 byte boundary if the buffer does. Cell (x, y) is bit (y * width + x) of its game's bitmap, with y = 0
+// at the bottom like in the game.
+typedef struct Snake_Batch_Buffers
+{
+    uint64_t* occupancy;  // The whole snake, head included
+    int16_t* head_x;
+    int16_t* head_y;
+    int16_t* blip_x;
+    int16_t* blip_y;
+    float* rewards;  // From the last step
+    uint8_t* dones;  // 1 if the last step ended the game (and started a new one)
+} Snake_Batch_Buffers;
+
+typedef struct Snake_Batch_Env Snake_Batch_Env;
+
+// Words of occupancy per game, a whole number of cache lines
+SNAKE_BATCH_ENV_API uint32_t snake_batch_env_occupancy_words_per_env(int32_t width, int32_t height);
+
+// Starts every game. The buffers have to stay valid until snake_batch_env_destroy(). Returns NULL if the board is
+// bigger than 32767 cells a side or allocating fails.
+SNAKE_BATCH_ENV_API Snake_Batch_Env* snake_batch_env_create(
+    uint32_t env_count, int32_t width, int32_t height, uint64_t seed, const Snake_Batch_Buffers* buffers);
+SNAKE_BATCH_ENV_API void snake_batch_env_destroy(Snake_Batch_Env* env);
+
+// Starts every game again
+SNAKE_BATCH_ENV_API void snake_batch_env_reset(Snake_Batch_Env* env);
+
+// Moves every game one cell. actions has env_count entries.
+SNAKE_BATCH_ENV_API void snake_batch_env_step(Snake_Batch_Env* env, const uint8_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SNAKE_BATCH_ENV_H
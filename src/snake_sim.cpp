@@ -0,0 +1,143 @@
+#include "snake_sim.h"
+
+uint32 snake_sim_size(int32 width, int32 height)
+{
+    uint32 cell_count = (uint32)width * (uint32)height;
+    uint32 occupancy_size = (cell_count + 63) / 64 * 8;
+    uint32 body_size = (cell_count + 3) / 4;
+    return (sizeof(Snake_Sim) + occupancy_size + body_size + 7) & ~7u;
+}
+
+void snake_sim_init(Snake_Sim* sim, int32 width, int32 height, uint32 seed)
+{
+    uint32 size = snake_sim_size(width, height);
+    memset(sim, 0, size);
+    sim->size = size;
+    sim->width = (int16)width;
+    sim->height = (int16)height;
+    sim->random_state = seed;
+    snake_sim_reset(sim);
+}
+
+void snake_sim_reset(Snake_Sim* sim)
+{
+    snake_sim_reset_at(sim, sim->width / 2, sim->height / 4, DIRECTION_NORTH, sim->width / 2, sim->height / 2);
+}
+
+void snake_sim_reset_at(Snake_Sim* sim, int32 head_x, int32 head_y, Direction direction, int32 blip_x, int32 blip_y)
+{
+    uint32 cell_count = (uint32)sim->width * (uint32)sim->height;
+    memset(snake_sim_get_occupancy(sim), 0, (cell_count + 63) / 64 * 8);
+
+    sim->head_x = (int16)head_x;
+    sim->head_y = (int16)head_y;
+    sim->tail_x = sim->head_x;
+    sim->tail_y = sim->head_y;
+    sim->direction = (uint8)direction;
+    sim->length = 1;
+    sim->body_start = 0;
+    sim->is_game_over = false;
+    sim->has_filled_board = false;
+    sim->step_count = 0;
+
+    sim->blip_x = (int16)blip_x;
+    sim->blip_y = (int16)blip_y;
+
+    uint32 head_cell = (uint32)sim->head_y * sim->width + sim->head_x;
+    snake_sim_get_occupancy(sim)[head_cell / 64] |= (uint64)1 << (head_cell % 64);
+}
+
+local_internal void snake_sim_set_occupied(Snake_Sim* sim, int32 x, int32 y, bool32 is_occupied)
+{
+    uint32 cell = (uint32)y * (uint32)sim->width + (uint32)x;
+    uint64 bit = (uint64)1 << (cell % 64);
+    uint64* word = &snake_sim_get_occupancy(sim)[cell / 64];
+    *word = is_occupied ? *word | bit : *word & ~bit;
+}
+
+// Same order as the game always had: eat whatever the head is on, then move, then check for a crash
+uint32 snake_sim_step(Snake_Sim* sim, Direction proposed_direction)
+{
+    if (sim->is_game_over)
+    {
+        return 0;
+    }
+
+    uint32 events = 0;
+    uint32 capacity = (uint32)sim->width * (uint32)sim->height;
+
+    if (proposed_direction != DIRECTION_NONE && proposed_direction != snake_sim_get_opposite((Direction)sim->direction))
+    {
+        sim->direction = (uint8)proposed_direction;
+    }
+
+    bool32 is_growing = false;
+    if (sim->head_x == sim->blip_x && sim->head_y == sim->blip_y)
+    {
+        if (sim->length == capacity)
+        {
+            sim->is_game_over = true;
+            sim->has_filled_board = true;
+            return SNAKE_SIM_ATE | SNAKE_SIM_FILLED_BOARD;
+        }
+
+        is_growing = true;
+        events |= SNAKE_SIM_ATE;
+
+        // Can land on the snake, in which case it gets eaten when the head gets there
+        sim->blip_x = (int16)(snake_sim_random(&sim->random_state) % (uint32)sim->width);
+        sim->blip_y = (int16)(snake_sim_random(&sim->random_state) % (uint32)sim->height);
+    }
+
+    int32 head_x = sim->head_x;
+    int32 head_y = sim->head_y;
+    snake_sim_move((Direction)sim->direction, &head_x, &head_y);
+    sim->step_count++;
+
+    // The tail moves out of the way at the same time, so the head can follow right behind it
+    bool32 is_onto_tail = !is_growing && head_x == sim->tail_x && head_y == sim->tail_y;
+    if (!snake_sim_is_inside(sim, head_x, head_y) || (snake_sim_is_occupied(sim, head_x, head_y) && !is_onto_tail))
+    {
+        sim->is_game_over = true;
+        return events | SNAKE_SIM_CRASHED;
+    }
+
+    if (!is_growing)
+    {
+        snake_sim_set_occupied(sim, sim->tail_x, sim->tail_y, false);
+        if (sim->length > 1)
+        {
+            int32 tail_x = sim->tail_x;
+            int32 tail_y = sim->tail_y;
+            snake_sim_move(snake_sim_get_body_move(sim, 0), &tail_x, &tail_y);
+            sim->tail_x = (int16)tail_x;
+            sim->tail_y = (int16)tail_y;
+            sim->body_start = (sim->body_start + 1) % capacity;
+        }
+    }
+
+    if (is_growing)
+    {
+        sim->length++;
+    }
+
+    if (sim->length > 1)
+    {
+        // Record the move that got the head here, after the ones already in the body
+        uint32 index = (sim->body_start + sim->length - 2) % capacity;
+        uint8* body = snake_sim_get_body(sim);
+        body[index / 4] = (uint8)((body[index / 4] & ~(3 << (index % 4 * 2))) |
+                                  (((sim->direction - DIRECTION_NORTH) & 3) << (index % 4 * 2)));
+    }
+    else
+    {
+        sim->tail_x = (int16)head_x;
+        sim->tail_y = (int16)head_y;
+    }
+
+    sim->head_x = (int16)head_x;
+    sim->head_y = (int16)head_y;
+    snake_sim_set_occupied(sim, head_x, head_y, true);
+
+    return events;
+}
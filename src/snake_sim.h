@@ -0,0 +1,132 @@
+#ifndef SNAKE_SIM_H
+#define SNAKE_SIM_H
+
+// The rules of the game on their own: no SDL, no globals, no timing. Gameplay, the autoplayers and the benchmarks all
+// step the same Snake_Sim.
+//
+// A sim is one block of memory (the struct, then the occupancy bitmap, then the body) so cloning it is a single
+// memcpy of sim->size bytes, under a kilobyte on the usual 64x36 board. The body is stored as the 2 bit move from each
+// cell to the next one, tail first, in a ring buffer, so moving the snake never touches more than its two ends.
+
+#include <string.h>
+
+#include "common.h"
+
+typedef enum
+{
+    DIRECTION_NONE,  // Represents no movement
+    DIRECTION_NORTH,
+    DIRECTION_EAST,
+    DIRECTION_SOUTH,
+    DIRECTION_WEST
+} Direction;
+
+// What happened during a step
+#define SNAKE_SIM_ATE 0x1
+#define SNAKE_SIM_CRASHED 0x2
+#define SNAKE_SIM_FILLED_BOARD 0x4  // Ate with nowhere left to grow. Ends the game like a crash.
+
+struct Snake_Sim
+{
+    uint32 size;  // Bytes, counting the occupancy bitmap and the body after the struct
+    int16 width;
+    int16 height;
+
+    int16 head_x;
+    int16 head_y;
+    int16 tail_x;
+    int16 tail_y;
+    int16 blip_x;
+    int16 blip_y;
+
+    uint8 direction;  // Direction
+    uint8 is_game_over;
+    uint8 has_filled_board;
+
+    uint32 length;  // Cells covered, head included
+    uint32 body_start;  // Where the move out of the tail cell is in the body ring
+    uint32 random_state;  // Where the next blip goes. Cloned along with everything else.
+    uint32 step_count;  // Cells moved this game
+};
+
+// The occupancy bitmap starts right after the struct
+static_assert(sizeof(Snake_Sim) % 8 == 0, "Snake_Sim must keep the bitmap after it aligned");
+
+uint32 snake_sim_size(int32 width, int32 height);
+// sim must point at snake_sim_size() bytes
+void snake_sim_init(Snake_Sim* sim, int32 width, int32 height, uint32 seed);
+// Starts a new game. Keeps the random state going so every game gets different blips.
+void snake_sim_reset(Snake_Sim* sim);
+// Same, but starting somewhere else
+void snake_sim_reset_at(Snake_Sim* sim, int32 head_x, int32 head_y, Direction direction, int32 blip_x, int32 blip_y);
+// Turns towards proposed_direction (unless it's DIRECTION_NONE or straight back) and moves one cell. Returns
+// SNAKE_SIM_ flags.
+uint32 snake_sim_step(Snake_Sim* sim, Direction proposed_direction);
+
+// destination must have room for source->size bytes
+inline void snake_sim_clone(Snake_Sim* destination, const Snake_Sim* source)
+{
+    memcpy(destination, source, source->size);
+}
+
+inline uint32 snake_sim_random(uint32* random_state)
+{
+    *random_state = 1664525u * *random_state + 1013904223u;
+    return *random_state;
+}
+
+inline uint64* snake_sim_get_occupancy(const Snake_Sim* sim)
+{
+    return (uint64*)(sim + 1);
+}
+
+inline uint8* snake_sim_get_body(const Snake_Sim* sim)
+{
+    uint32 cell_count = (uint32)sim->width * (uint32)sim->height;
+    return (uint8*)(snake_sim_get_occupancy(sim) + (cell_count + 63) / 64);
+}
+
+inline bool32 snake_sim_is_inside(const Snake_Sim* sim, int32 x, int32 y)
+{
+    return x >= 0 && x < sim->width && y >= 0 && y < sim->height;
+}
+
+inline bool32 snake_sim_is_occupied(const Snake_Sim* sim, int32 x, int32 y)
+{
+    uint32 cell = (uint32)y * (uint32)sim->width + (uint32)x;
+    return (snake_sim_get_occupancy(sim)[cell / 64] >> (cell % 64)) & 1;
+}
+
+// The move from body cell i (0 is the tail) to cell i + 1. There are length - 1 of them.
+inline Direction snake_sim_get_body_move(const Snake_Sim* sim, uint32 i)
+{
+    uint32 capacity = (uint32)sim->width * (uint32)sim->height;
+    uint32 index = (sim->body_start + i) % capacity;
+    return (Direction)(DIRECTION_NORTH + ((snake_sim_get_body(sim)[index / 4] >> (index % 4 * 2)) & 3));
+}
+
+inline void snake_sim_move(Direction direction, int32* x, int32* y)
+{
+    switch (direction)
+    {
+        case DIRECTION_NORTH: (*y)++; break;
+        case DIRECTION_EAST: (*x)++; break;
+        case DIRECTION_SOUTH: (*y)--; break;
+        case DIRECTION_WEST: (*x)--; break;
+        default: break;
+    }
+}
+
+inline Direction snake_sim_get_opposite(Direction direction)
+{
+    switch (direction)
+    {
+        case DIRECTION_NORTH: return DIRECTION_SOUTH;
+        case DIRECTION_EAST: return DIRECTION_WEST;
+        case DIRECTION_SOUTH: return DIRECTION_NORTH;
+        case DIRECTION_WEST: return DIRECTION_EAST;
+        default: return DIRECTION_NONE;
+    }
+}
+
+#endif  // SNAKE_SIM_H
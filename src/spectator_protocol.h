@@ -0,0 +1,304 @@
+#ifndef SPECTATOR_PROTOCOL_H
+#define SPECTATOR_PROTOCOL_H
+
+// What the spectator server streams, shared by the game and tools/spectator_client.cpp.
+//
+// A stream of messages, each one [uint32 size][uint8 type][payload], size counting the type and payload. Everything is
+// little endian. A client gets a keyframe first, then a tick message for every simulation tick the snake moved on.
+//
+// Keyframe: [uint64 tick][int16 width, height, head_x, head_y, tail_x, tail_y, blip_x, blip_y][uint32 length]
+//           [uint8 is_game_over][the length - 1 moves from the tail to the head, 2 bits each, 4 to a byte]
+// Tick:     [uint64 tick][one byte per cell the snake moved (or crashed on), see SPECTATOR_CELL_, followed by int16
+//           x, y if the blip moved]
+//
+// Spectator_Board follows along from the messages, for the server's copy and for clients.
+
+#include <string.h>
+
+#include "common.h"
+
+#define SPECTATOR_MESSAGE_KEYFRAME 1
+#define SPECTATOR_MESSAGE_TICK 2
+
+#define SPECTATOR_MESSAGE_HEADER_SIZE 5  // Size and type
+#define SPECTATOR_KEYFRAME_FIXED_SIZE (8 + 8 * 2 + 4 + 1)
+#define SPECTATOR_TICK_FIXED_SIZE 8
+
+// A cell is the move the head made (0 to 3 for north, east, south and west) and these flags
+#define SPECTATOR_CELL_MOVE_MASK 0x03
+#define SPECTATOR_CELL_TAIL_MOVED 0x04  // Otherwise the snake grew
+#define SPECTATOR_CELL_BLIP_MOVED 0x08  // The blip's new cell follows
+#define SPECTATOR_CELL_GAME_OVER 0x10  // Crashed instead of moving, so the move and tail bits mean nothing
+
+struct Spectator_Board
+{
+    uint64 tick;
+    int16 width;
+    int16 height;
+    int16 head_x;
+    int16 head_y;
+    int16 tail_x;
+    int16 tail_y;
+    int16 blip_x;
+    int16 blip_y;
+    uint32 length;
+    bool32 is_game_over;
+
+    // Moves from the tail to the head, one byte each, in a ring of width * height of them
+    uint8* moves;
+    uint32 capacity;  // Biggest board the moves have room for
+    uint32 moves_start;
+};
+
+inline uint32 spectator_read_uint32(const uint8* bytes)
+{
+    uint32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+inline int16 spectator_read_int16(const uint8* bytes)
+{
+    int16 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+inline uint8* spectator_write(uint8* at, const void* value, uint32 size)
+{
+    memcpy(at, value, size);
+    return at + size;
+}
+
+inline uint32 spectator_get_keyframe_size(uint32 length)
+{
+    return SPECTATOR_MESSAGE_HEADER_SIZE + SPECTATOR_KEYFRAME_FIXED_SIZE + (length - 1 + 3) / 4;
+}
+
+// Moves come from get_move(i) with i = 0 the move out of the tail cell. Returns the bytes written,
+// spectator_get_keyframe_size() of them.
+template <typename Get_Move>
+uint32 spectator_write_keyframe(uint8* at,
+                                uint64 tick,
+                                int16 width,
+                                int16 height,
+                                int16 head_x,
+                                int16 head_y,
+                                int16 tail_x,
+                                int16 tail_y,
+                                int16 blip_x,
+                                int16 blip_y,
+                                uint32 length,
+                                bool32 is_game_over,
+                                Get_Move get_move)
+{
+    uint8* start = at;
+    uint32 size = spectator_get_keyframe_size(length) - 4;
+    uint8 type = SPECTATOR_MESSAGE_KEYFRAME;
+    uint8 game_over = is_game_over ? 1 : 0;
+    at = spectator_write(at, &size, 4);
+    at = spectator_write(at, &type, 1);
+    at = spectator_write(at, &tick, 8);
+    int16 fields[] = {width, height, head_x, head_y, tail_x, tail_y, blip_x, blip_y};
+    at = spectator_write(at, fields, sizeof(fields));
+    at = spectator_write(at, &length, 4);
+    at = spectator_write(at, &game_over, 1);
+
+    uint32 move_count = length - 1;
+    for (uint32 i = 0; i < move_count; i += 4)
+    {
+        uint8 packed = 0;
+        for (uint32 j = 0; j < 4 && i + j < move_count; j++)
+        {
+            packed |= (uint8)(get_move(i + j) << (j * 2));
+        }
+        *at++ = packed;
+    }
+    return (uint32)(at - start);
+}
+
+inline void spectator_board_move(int32 move, int32* x, int32* y)
+{
+    // Same order as Direction, starting from north
+    *x += (move == 1) - (move == 3);
+    *y += (move == 0) - (move == 2);
+}
+
+// Writes the board as a keyframe, returns the bytes written
+inline uint32 spectator_board_write_keyframe(Spectator_Board* board, uint8* at)
+{
+    uint32 cell_count = (uint32)board->width * (uint32)board->height;
+    auto get_move = [board, cell_count](uint32 i) { return board->moves[(board->moves_start + i) % cell_count]; };
+    return spectator_write_keyframe(at,
+                                    board->tick,
+                                    board->width,
+                                    board->height,
+                                    board->head_x,
+                                    board->head_y,
+                                    board->tail_x,
+                                    board->tail_y,
+                                    board->blip_x,
+                                    board->blip_y,
+                                    board->length,
+                                    board->is_game_over,
+                                    get_move);
+}
+
+// Applies one message (starting at its size field). Returns false if it doesn't make sense, e.g. a tick before any
+// keyframe or a board too big for moves. moves has to be able to hold width * height moves.
+inline bool32 spectator_board_apply(Spectator_Board* board, const uint8* message, uint32 message_size)
+{
+    if (message_size < SPECTATOR_MESSAGE_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    uint8 type = message[4];
+    const uint8* at = message + SPECTATOR_MESSAGE_HEADER_SIZE;
+    const uint8* end = message + message_size;
+
+    if (type == SPECTATOR_MESSAGE_KEYFRAME)
+    {
+        if (end - at < SPECTATOR_KEYFRAME_FIXED_SIZE)
+        {
+            return false;
+        }
+        memcpy(&board->tick, at, 8);
+        int16 fields[8];
+        memcpy(fields, at + 8, sizeof(fields));
+        uint32 length = spectator_read_uint32(at + 24);
+        uint32 cell_count = fields[0] > 0 && fields[1] > 0 ? (uint32)fields[0] * (uint32)fields[1] : 0;
+        if (cell_count == 0 || cell_count > board->capacity || length == 0 || length > cell_count ||
+            end - at < (int64)(SPECTATOR_KEYFRAME_FIXED_SIZE + (length - 1 + 3) / 4))
+        {
+            return false;
+        }
+
+        board->width = fields[0];
+        board->height = fields[1];
+        board->head_x = fields[2];
+        board->head_y = fields[3];
+        board->tail_x = fields[4];
+        board->tail_y = fields[5];
+        board->blip_x = fields[6];
+        board->blip_y = fields[7];
+        board->length = length;
+        board->is_game_over = at[28];
+        board->moves_start = 0;
+
+        const uint8* packed = at + SPECTATOR_KEYFRAME_FIXED_SIZE;
+        for (uint32 i = 0; i < length - 1; i++)
+        {
+            board->moves[i] = (packed[i / 4] >> (i % 4 * 2)) & 3;
+        }
+        return true;
+    }
+
+    if (type != SPECTATOR_MESSAGE_TICK || end - at < SPECTATOR_TICK_FIXED_SIZE || board->width == 0)
+    {
+        return false;
+    }
+
+    memcpy(&board->tick, at, 8);
+    at += SPECTATOR_TICK_FIXED_SIZE;
+    uint32 cell_count = (uint32)board->width * (uint32)board->height;
+    while (at < end)
+    {
+        uint8 cell = *at++;
+        if (cell & SPECTATOR_CELL_GAME_OVER)
+        {
+            board->is_game_over = true;
+        }
+        else
+        {
+            uint8 move = cell & SPECTATOR_CELL_MOVE_MASK;
+            int32 x = board->head_x;
+            int32 y = board->head_y;
+            spectator_board_move(move, &x, &y);
+            board->head_x = (int16)x;
+            board->head_y = (int16)y;
+
+            if (!(cell & SPECTATOR_CELL_TAIL_MOVED))
+            {
+                board->length++;
+                board->moves[(board->moves_start + board->length - 2) % cell_count] = move;
+            }
+            else if (board->length > 1)
+            {
+                int32 tail_x = board->tail_x;
+                int32 tail_y = board->tail_y;
+                spectator_board_move(board->moves[board->moves_start], &tail_x, &tail_y);
+                board->tail_x = (int16)tail_x;
+                board->tail_y = (int16)tail_y;
+                board->moves_start = (board->moves_start + 1) % cell_count;
+                board->moves[(board->moves_start + board->length - 2) % cell_count] = move;
+            }
+            else
+            {
+                board->tail_x = board->head_x;
+                board->tail_y = board->head_y;
+            }
+        }
+
+        if (cell & SPECTATOR_CELL_BLIP_MOVED)
+        {
+            if (end - at < 4)
+            {
+                return false;
+            }
+            board->blip_x = spectator_read_int16(at);
+            board->blip_y = spectator_read_int16(at + 2);
+            at += 4;
+        }
+    }
+    return true;
+}
+
+// Collects a stream into whole messages for spectator_board_apply(). buffer has to hold the biggest message.
+struct Spectator_Receiver
+{
+    uint8* buffer;
+    uint32 capacity;
+    uint32 size;
+};
+
+// Where to put the next bytes off the socket, spectator_receiver_get_room() of them
+inline uint8* spectator_receiver_get_free(Spectator_Receiver* receiver)
+{
+    return receiver->buffer + receiver->size;
+}
+
+inline uint32 spectator_receiver_get_room(Spectator_Receiver* receiver)
+{
+    return receiver->capacity - receiver->size;
+}
+
+// Applies every whole message received so far, after receiver->size was bumped by what came in. Returns false if the
+// stream is broken.
+inline bool32 spectator_receiver_apply(Spectator_Receiver* receiver, Spectator_Board* board)
+{
+    uint32 start = 0;
+    while (receiver->size - start >= 4)
+    {
+        uint32 message_size = spectator_read_uint32(receiver->buffer + start) + 4;
+        if (message_size > receiver->capacity)
+        {
+            return false;
+        }
+        if (receiver->size - start < message_size)
+        {
+            break;
+        }
+        if (!spectator_board_apply(board, receiver->buffer + start, message_size))
+        {
+            return false;
+        }
+        start += message_size;
+    }
+
+    memmove(receiver->buffer, receiver->buffer + start, receiver->size - start);
+    receiver->size -= start;
+    return true;
+}
+
+#endif  // SPECTATOR_PROTOCOL_H
@@ -0,0 +1,611 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#ifdef __WINDOWS__
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "common.h"
+#include "snake_sim.h"
+#include "spectator_protocol.h"
+
+// Streams the game to spectators on localhost over TCP, see spectator_protocol.h for what they get (and
+// tools/spectator_client.cpp for something to watch with).
+//
+// Gameplay encodes each tick once, into a ring buffer, however many spectators there are, and never waits on anything:
+// if the ring is full the tick gets dropped and a keyframe goes in instead once there's room. The server thread keeps
+// its own copy of the board from what comes out of the ring, copies every message into each client's send buffer and
+// sends without blocking. A client whose buffer fills up stops getting ticks until it has drained, then catches up
+// with a keyframe of the server's board.
+
+#define SPECTATOR_MAX_CLIENTS 32  // Any more get turned away
+#define SPECTATOR_RING_SIZE (256 * 1024)  // Must be a power of two
+#define SPECTATOR_MAX_MESSAGE_SIZE (32 * 1024)  // A tick of MAX_CELLS_PER_TICK cells, or a keyframe
+#define SPECTATOR_CLIENT_BUFFER_SIZE (64 * 1024)
+#define SPECTATOR_MAX_CELL_SIZE 5  // The cell and where the blip went
+#define SPECTATOR_POLL_INTERVAL__MS 5  // How often slow clients get another go when nothing new is coming in
+
+#ifdef MSG_NOSIGNAL
+#define SPECTATOR_SEND_FLAGS MSG_NOSIGNAL  // A client going away shouldn't SIGPIPE the game
+#else
+#define SPECTATOR_SEND_FLAGS 0
+#endif
+
+#ifdef __WINDOWS__
+typedef SOCKET Spectator_Socket_Handle;
+#define SPECTATOR_INVALID_SOCKET INVALID_SOCKET
+#else
+typedef int Spectator_Socket_Handle;
+#define SPECTATOR_INVALID_SOCKET -1
+#endif
+
+struct Spectator_Client
+{
+    Spectator_Socket_Handle handle;
+    bool32 is_connected;
+    bool32 needs_keyframe;  // Skipping ticks until the buffer drains
+
+    uint8* buffer;  // Whole messages waiting to go out
+    uint32 buffer_start;
+    uint32 buffer_end;
+};
+
+struct Spectator_Server
+{
+    bool32 is_running;
+    Spectator_Socket_Handle listen_handle;
+    uint16 port;
+
+    // Messages on their way from gameplay to the server thread
+    uint8* ring;
+    SDL_atomic_t bytes_produced;  // Only written by gameplay
+    SDL_atomic_t bytes_consumed;  // Only written by the server thread
+
+    SDL_Thread* thread;
+    SDL_sem* work_available;
+    SDL_atomic_t stop_requested;
+
+    // Gameplay only. The tick being recorded, already laid out as a message.
+    uint8* staging;
+    uint32 staging_size;
+    bool32 needs_keyframe;
+
+    // Server thread only
+    Spectator_Board board;
+    uint8* message;
+    Spectator_Client clients[SPECTATOR_MAX_CLIENTS];
+
+    // Stats (gameplay)
+    uint64 publish_count;
+    uint64 ticks_published;
+    uint64 bytes_published;
+    uint32 ticks_dropped;
+    uint32 keyframes_published;
+    real64 total_publish__microseconds;
+    real32 max_publish__microseconds;
+
+    // Stats (server thread)
+    SDL_atomic_t client_count;
+    SDL_atomic_t resync_count;
+};
+
+Spectator_Server global_spectator_server;
+
+local_internal void spectator_close_socket(Spectator_Socket_Handle handle)
+{
+#ifdef __WINDOWS__
+    closesocket(handle);
+#else
+    close(handle);
+#endif
+}
+
+local_internal void spectator_set_non_blocking(Spectator_Socket_Handle handle)
+{
+#ifdef __WINDOWS__
+    u_long is_non_blocking = 1;
+    ioctlsocket(handle, FIONBIO, &is_non_blocking);
+#else
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+// After a send or receive failed, whether it was only because it would have had to wait
+local_internal bool32 spectator_would_block()
+{
+#ifdef __WINDOWS__
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+local_internal void spectator_ring_write(uint8* ring, uint32 position, const uint8* data, uint32 size)
+{
+    uint32 offset = position & (SPECTATOR_RING_SIZE - 1);
+    uint32 first_part = SDL_min(size, SPECTATOR_RING_SIZE - offset);
+    memcpy(ring + offset, data, first_part);
+    memcpy(ring, data + first_part, size - first_part);
+}
+
+local_internal void spectator_ring_read(const uint8* ring, uint32 position, uint8* data, uint32 size)
+{
+    uint32 offset = position & (SPECTATOR_RING_SIZE - 1);
+    uint32 first_part = SDL_min(size, SPECTATOR_RING_SIZE - offset);
+    memcpy(data, ring + offset, first_part);
+    memcpy(data + first_part, ring, size - first_part);
+}
+
+//=======================================================
+// GAMEPLAY SIDE
+//=======================================================
+
+// Never waits: false means there wasn't room
+local_internal bool32 spectator_server_push(Spectator_Server* server, const uint8* message, uint32 size)
+{
+    uint32 produced = (uint32)SDL_AtomicGet(&server->bytes_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&server->bytes_consumed);
+    SDL_MemoryBarrierAcquire();
+    if (size > SPECTATOR_RING_SIZE - (produced - consumed))
+    {
+        return false;
+    }
+
+    spectator_ring_write(server->ring, produced, message, size);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&server->bytes_produced, (int)(produced + size));
+    SDL_SemPost(server->work_available);
+    return true;
+}
+
+local_internal void spectator_server_clear_staging(Spectator_Server* server)
+{
+    server->staging_size = SPECTATOR_MESSAGE_HEADER_SIZE + SPECTATOR_TICK_FIXED_SIZE;
+}
+
+// Sends the whole board, e.g. when a new game starts. Anything recorded since the last tick is in it already.
+void spectator_server_publish_keyframe(Spectator_Server* server, const Snake_Sim* sim, uint64 tick)
+{
+    if (!server->is_running)
+    {
+        return;
+    }
+
+    auto get_move = [sim](uint32 i) { return snake_sim_get_body_move(sim, i) - DIRECTION_NORTH; };
+    uint32 size = spectator_write_keyframe(server->staging,
+                                           tick,
+                                           sim->width,
+                                           sim->height,
+                                           sim->head_x,
+                                           sim->head_y,
+                                           sim->tail_x,
+                                           sim->tail_y,
+                                           sim->blip_x,
+                                           sim->blip_y,
+                                           sim->length,
+                                           sim->is_game_over,
+                                           get_move);
+    server->needs_keyframe = !spectator_server_push(server, server->staging, size);
+    if (!server->needs_keyframe)
+    {
+        server->keyframes_published++;
+        server->bytes_published += size;
+    }
+    spectator_server_clear_staging(server);
+}
+
+// Call after every snake_sim_step() with what it returned
+void spectator_server_record_cell(Spectator_Server* server, const Snake_Sim* sim, uint32 events)
+{
+    // A keyframe is going out instead
+    if (!server->is_running || server->needs_keyframe)
+    {
+        return;
+    }
+
+    if (server->staging_size + SPECTATOR_MAX_CELL_SIZE > SPECTATOR_MAX_MESSAGE_SIZE)
+    {
+        server->needs_keyframe = true;
+        return;
+    }
+
+    uint8 cell = (uint8)(sim->direction - DIRECTION_NORTH);
+    if (events & (SNAKE_SIM_CRASHED | SNAKE_SIM_FILLED_BOARD))
+    {
+        cell = SPECTATOR_CELL_GAME_OVER;
+    }
+    else if (!(events & SNAKE_SIM_ATE))
+    {
+        cell |= SPECTATOR_CELL_TAIL_MOVED;
+    }
+
+    uint8* at = server->staging + server->staging_size;
+    if ((events & SNAKE_SIM_ATE) && !(events & SNAKE_SIM_FILLED_BOARD))
+    {
+        *at++ = cell | SPECTATOR_CELL_BLIP_MOVED;
+        at = spectator_write(at, &sim->blip_x, 2);
+        at = spectator_write(at, &sim->blip_y, 2);
+    }
+    else
+    {
+        *at++ = cell;
+    }
+    server->staging_size = (uint32)(at - server->staging);
+}
+
+// Call once a tick, after the last cell. Sends what was recorded as one message.
+void spectator_server_publish_tick(Spectator_Server* server, const Snake_Sim* sim, uint64 tick)
+{
+    if (!server->is_running)
+    {
+        return;
+    }
+
+    uint64 start_counter = SDL_GetPerformanceCounter();
+
+    if (server->needs_keyframe)
+    {
+        spectator_server_publish_keyframe(server, sim, tick);
+    }
+    else if (server->staging_size > SPECTATOR_MESSAGE_HEADER_SIZE + SPECTATOR_TICK_FIXED_SIZE)
+    {
+        uint32 size = server->staging_size - 4;
+        uint8 type = SPECTATOR_MESSAGE_TICK;
+        uint8* at = spectator_write(server->staging, &size, 4);
+        at = spectator_write(at, &type, 1);
+        spectator_write(at, &tick, 8);
+
+        if (spectator_server_push(server, server->staging, server->staging_size))
+        {
+            server->ticks_published++;
+            server->bytes_published += server->staging_size;
+        }
+        else
+        {
+            server->ticks_dropped++;
+            server->needs_keyframe = true;
+        }
+        spectator_server_clear_staging(server);
+    }
+
+    real32 publish__microseconds = (real32)((real64)(SDL_GetPerformanceCounter() - start_counter) * 1000000.0 /
+                                            (real64)SDL_GetPerformanceFrequency());
+    server->publish_count++;
+    server->total_publish__microseconds += publish__microseconds;
+    server->max_publish__microseconds = SDL_max(server->max_publish__microseconds, publish__microseconds);
+}
+
+//=======================================================
+// SERVER THREAD
+//=======================================================
+
+local_internal void spectator_server_disconnect(Spectator_Server* server, Spectator_Client* client)
+{
+    spectator_close_socket(client->handle);
+    client->is_connected = false;
+    SDL_AtomicAdd(&server->client_count, -1);
+}
+
+local_internal void spectator_server_accept(Spectator_Server* server)
+{
+    for (;;)
+    {
+        Spectator_Socket_Handle handle = accept(server->listen_handle, NULL, NULL);
+        if (handle == SPECTATOR_INVALID_SOCKET)
+        {
+            break;
+        }
+
+        Spectator_Client* client = NULL;
+        for (uint32 i = 0; i < SPECTATOR_MAX_CLIENTS && !client; i++)
+        {
+            if (!server->clients[i].is_connected)
+            {
+                client = &server->clients[i];
+            }
+        }
+        if (!client)
+        {
+            spectator_close_socket(handle);
+            continue;
+        }
+
+        spectator_set_non_blocking(handle);
+        // Ticks are small and go out one at a time, so don't hold them back to batch them up
+        int is_no_delay = 1;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&is_no_delay, sizeof(is_no_delay));
+#ifdef SO_NOSIGPIPE
+        int is_no_sigpipe = 1;
+        setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &is_no_sigpipe, sizeof(is_no_sigpipe));
+#endif
+
+        client->handle = handle;
+        client->is_connected = true;
+        client->needs_keyframe = true;
+        client->buffer_start = 0;
+        client->buffer_end = 0;
+        SDL_AtomicAdd(&server->client_count, 1);
+    }
+}
+
+// Either the whole message fits or none of it goes in
+local_internal bool32 spectator_client_queue(Spectator_Client* client, const uint8* message, uint32 size)
+{
+    if (client->buffer_end + size > SPECTATOR_CLIENT_BUFFER_SIZE)
+    {
+        memmove(client->buffer, client->buffer + client->buffer_start, client->buffer_end - client->buffer_start);
+        client->buffer_end -= client->buffer_start;
+        client->buffer_start = 0;
+        if (client->buffer_end + size > SPECTATOR_CLIENT_BUFFER_SIZE)
+        {
+            return false;
+        }
+    }
+
+    memcpy(client->buffer + client->buffer_end, message, size);
+    client->buffer_end += size;
+    return true;
+}
+
+// Takes everything gameplay has published, keeps the board up to date and queues each message for every client
+local_internal void spectator_server_drain(Spectator_Server* server)
+{
+    uint32 produced = (uint32)SDL_AtomicGet(&server->bytes_produced);
+    uint32 consumed = (uint32)SDL_AtomicGet(&server->bytes_consumed);
+    SDL_MemoryBarrierAcquire();
+
+    while (consumed != produced)
+    {
+        uint8* message = server->message;
+        spectator_ring_read(server->ring, consumed, message, 4);
+        uint32 size = spectator_read_uint32(message) + 4;
+        spectator_ring_read(server->ring, consumed, message, size);
+        consumed += size;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&server->bytes_consumed, (int)consumed);
+
+        // Only ever fails for ticks before the first keyframe
+        if (!spectator_board_apply(&server->board, message, size))
+        {
+            continue;
+        }
+
+        for (uint32 i = 0; i < SPECTATOR_MAX_CLIENTS; i++)
+        {
+            Spectator_Client* client = &server->clients[i];
+            if (client->is_connected && !client->needs_keyframe && !spectator_client_queue(client, message, size))
+            {
+                client->needs_keyframe = true;
+                SDL_AtomicAdd(&server->resync_count, 1);
+            }
+        }
+    }
+}
+
+local_internal void spectator_server_service(Spectator_Server* server, Spectator_Client* client)
+{
+    if (client->needs_keyframe && client->buffer_start == client->buffer_end && server->board.width)
+    {
+        client->buffer_start = 0;
+        client->buffer_end = spectator_board_write_keyframe(&server->board, client->buffer);
+        client->needs_keyframe = false;
+    }
+
+    while (client->buffer_start < client->buffer_end)
+    {
+        int32 sent = (int32)send(client->handle,
+                                 (const char*)client->buffer + client->buffer_start,
+                                 (int32)(client->buffer_end - client->buffer_start),
+                                 SPECTATOR_SEND_FLAGS);
+        if (sent <= 0)
+        {
+            if (!spectator_would_block())
+            {
+                spectator_server_disconnect(server, client);
+                return;
+            }
+            break;
+        }
+        client->buffer_start += sent;
+    }
+    if (client->buffer_start == client->buffer_end)
+    {
+        client->buffer_start = 0;
+        client->buffer_end = 0;
+    }
+
+    // Spectators never send anything, but reading is how a closed connection shows up
+    char discard[256];
+    int32 received = (int32)recv(client->handle, discard, sizeof(discard), 0);
+    if (received == 0 || (received < 0 && !spectator_would_block()))
+    {
+        spectator_server_disconnect(server, client);
+    }
+}
+
+local_internal int spectator_server_thread(void* data)
+{
+    Spectator_Server* server = (Spectator_Server*)data;
+
+    while (!SDL_AtomicGet(&server->stop_requested))
+    {
+        SDL_SemWaitTimeout(server->work_available, SPECTATOR_POLL_INTERVAL__MS);
+
+        spectator_server_accept(server);
+        spectator_server_drain(server);
+        for (uint32 i = 0; i < SPECTATOR_MAX_CLIENTS; i++)
+        {
+            if (server->clients[i].is_connected)
+            {
+                spectator_server_service(server, &server->clients[i]);
+            }
+        }
+    }
+
+    for (uint32 i = 0; i < SPECTATOR_MAX_CLIENTS; i++)
+    {
+        if (server->clients[i].is_connected)
+        {
+            spectator_server_disconnect(server, &server->clients[i]);
+        }
+    }
+    return 0;
+}
+
+//=======================================================
+// LOOPBACK SPECTATORS
+//=======================================================
+
+// A spectator in the same process, for --bench-spectators. Returns a non-blocking socket, or SPECTATOR_INVALID_SOCKET.
+local_internal Spectator_Socket_Handle spectator_connect_loopback(uint16 port)
+{
+    Spectator_Socket_Handle handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == SPECTATOR_INVALID_SOCKET)
+    {
+        return SPECTATOR_INVALID_SOCKET;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(handle, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        spectator_close_socket(handle);
+        return SPECTATOR_INVALID_SOCKET;
+    }
+    spectator_set_non_blocking(handle);
+    return handle;
+}
+
+// Takes whatever has arrived and applies it. Returns the bytes received, or -1 if the stream broke or closed.
+local_internal int32 spectator_receive(Spectator_Socket_Handle handle,
+                                       Spectator_Receiver* receiver,
+                                       Spectator_Board* board)
+{
+    int32 total = 0;
+    for (;;)
+    {
+        int32 received = (int32)recv(handle,
+                                     (char*)spectator_receiver_get_free(receiver),
+                                     (int32)spectator_receiver_get_room(receiver),
+                                     0);
+        if (received == 0 || (received < 0 && !spectator_would_block()))
+        {
+            return -1;
+        }
+        if (received < 0)
+        {
+            return total;
+        }
+
+        receiver->size += received;
+        total += received;
+        if (!spectator_receiver_apply(receiver, board))
+        {
+            return -1;
+        }
+    }
+}
+
+//=======================================================
+// START AND STOP
+//=======================================================
+
+// Listens on 127.0.0.1:port for a width x height board. Buffers come out of the arena, so start it once.
+bool32 spectator_server_start(Spectator_Server* server, Memory_Arena* arena, uint16 port, int32 width, int32 height)
+{
+    *server = {};
+
+    uint32 cell_count = (uint32)width * (uint32)height;
+    if (spectator_get_keyframe_size(cell_count) > SPECTATOR_MAX_MESSAGE_SIZE)
+    {
+        fprintf(stderr, "The board is too big to spectate, %dx%d\n", width, height);
+        return false;
+    }
+
+    if (!net_startup())
+    {
+        return false;
+    }
+
+    Spectator_Socket_Handle handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == SPECTATOR_INVALID_SOCKET)
+    {
+        fprintf(stderr, "Failed to create the spectator socket\n");
+        return false;
+    }
+    int is_reusable = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&is_reusable, sizeof(is_reusable));
+
+    // Localhost only
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(handle, (sockaddr*)&address, sizeof(address)) != 0 || listen(handle, SPECTATOR_MAX_CLIENTS) != 0)
+    {
+        fprintf(stderr, "Failed to listen for spectators on port %u\n", port);
+        spectator_close_socket(handle);
+        return false;
+    }
+    spectator_set_non_blocking(handle);
+
+    server->listen_handle = handle;
+    server->port = port;
+    server->ring = push_array(arena, SPECTATOR_RING_SIZE, uint8);
+    server->staging = push_array(arena, SPECTATOR_MAX_MESSAGE_SIZE, uint8);
+    server->message = push_array(arena, SPECTATOR_MAX_MESSAGE_SIZE, uint8);
+    server->board.moves = push_array(arena, cell_count, uint8);
+    server->board.capacity = cell_count;
+    for (uint32 i = 0; i < SPECTATOR_MAX_CLIENTS; i++)
+    {
+        server->clients[i].buffer = push_array(arena, SPECTATOR_CLIENT_BUFFER_SIZE, uint8);
+    }
+
+    // Nothing makes sense to the server thread until the first keyframe
+    spectator_server_clear_staging(server);
+    server->needs_keyframe = true;
+
+    server->work_available = SDL_CreateSemaphore(0);
+    server->thread = SDL_CreateThread(spectator_server_thread, "spectator_server", server);
+    server->is_running = true;
+
+    printf("Spectator server listening on 127.0.0.1:%u\n", port);
+    return true;
+}
+
+void spectator_server_stop(Spectator_Server* server)
+{
+    if (!server->is_running)
+    {
+        return;
+    }
+
+    SDL_AtomicSet(&server->stop_requested, 1);
+    SDL_SemPost(server->work_available);
+    SDL_WaitThread(server->thread, NULL);
+    SDL_DestroySemaphore(server->work_available);
+    spectator_close_socket(server->listen_handle);
+
+    printf("Spectator server stopped: %llu ticks (%llu KB) published, %u dropped, %u keyframes, %d resyncs, %.2f us "
+           "per publish on average (max %.2f)\n",
+           (unsigned long long)server->ticks_published,
+           (unsigned long long)(server->bytes_published / 1024),
+           server->ticks_dropped,
+           server->keyframes_published,
+           SDL_AtomicGet(&server->resync_count),
+           server->publish_count ? server->total_publish__microseconds / server->publish_count : 0.0,
+           server->max_publish__microseconds);
+
+    server->is_running = false;
+}
@@ -0,0 +1,151 @@
+#include <math.h>
+
+#include "mixer.h"
+
+// Makes the sound effects out of an oscillator, an envelope and a noise burst instead of decoding audio files. They
+// are rendered once at startup into the permanent arena, straight in the mixer's format.
+
+typedef enum
+{
+    SYNTH_WAVEFORM_SINE,
+    SYNTH_WAVEFORM_SQUARE,
+    SYNTH_WAVEFORM_TRIANGLE,
+} Synth_Waveform;
+
+struct Synth_Envelope
+{
+    real32 attack__seconds;
+    real32 decay__seconds;
+    real32 sustain_level;
+    real32 sustain__seconds;
+    real32 release__seconds;
+};
+
+struct Synth_Patch
+{
+    Synth_Waveform waveform;
+    real32 start_frequency;
+    real32 end_frequency;  // The pitch sweeps (exponentially) from start to end over the whole sound
+    real32 tone_gain;
+
+    real32 noise_gain;
+    real32 noise_cutoff_frequency;  // Low-passed so it rumbles instead of hisses
+    real32 noise_decay__seconds;    // The noise fades out on its own on top of the envelope
+
+    Synth_Envelope envelope;
+};
+
+// Menu selection
+Synth_Patch synth_patch_beep = {
+    SYNTH_WAVEFORM_SQUARE, 880.0f, 880.0f, 0.25f, 0, 0, 0, {0.002f, 0.03f, 0.6f, 0.05f, 0.05f}};
+
+// Eating a blip. Short and rising.
+Synth_Patch synth_patch_beep_2 = {
+    SYNTH_WAVEFORM_TRIANGLE, 660.0f, 1320.0f, 0.5f, 0, 0, 0, {0.002f, 0.02f, 0.7f, 0.04f, 0.04f}};
+
+// Game over
+Synth_Patch synth_patch_boom = {
+    SYNTH_WAVEFORM_SINE, 110.0f, 35.0f, 0.6f, 2.0f, 900.0f, 0.35f, {0.005f, 0.15f, 0.5f, 0.2f, 0.9f}};
+
+local_internal real32 synth_get_duration__seconds(Synth_Envelope* envelope)
+{
+    return envelope->attack__seconds + envelope->decay__seconds + envelope->sustain__seconds +
+           envelope->release__seconds;
+}
+
+local_internal real32 synth_get_envelope_level(Synth_Envelope* envelope, real32 time__seconds)
+{
+    real32 t = time__seconds;
+    if (t < envelope->attack__seconds)
+    {
+        return t / envelope->attack__seconds;
+    }
+    t -= envelope->attack__seconds;
+
+    if (t < envelope->decay__seconds)
+    {
+        return 1.0f - (1.0f - envelope->sustain_level) * (t / envelope->decay__seconds);
+    }
+    t -= envelope->decay__seconds;
+
+    if (t < envelope->sustain__seconds)
+    {
+        return envelope->sustain_level;
+    }
+    t -= envelope->sustain__seconds;
+
+    if (t < envelope->release__seconds)
+    {
+        return envelope->sustain_level * (1.0f - t / envelope->release__seconds);
+    }
+    return 0.0f;
+}
+
+// phase is in cycles (0 to 1)
+local_internal real32 synth_oscillate(Synth_Waveform waveform, real32 phase)
+{
+    switch (waveform)
+    {
+        case SYNTH_WAVEFORM_SINE:
+        {
+            return sinf(2.0f * (real32)M_PI * phase);
+        }
+        case SYNTH_WAVEFORM_SQUARE:
+        {
+            return phase < 0.5f ? 1.0f : -1.0f;
+        }
+        case SYNTH_WAVEFORM_TRIANGLE:
+        {
+            return phase < 0.5f ? 4.0f * phase - 1.0f : 3.0f - 4.0f * phase;
+        }
+    }
+    return 0.0f;
+}
+
+// Renders the patch into 16-bit stereo. The samples live as long as the arena does.
+void synth_render(Memory_Arena* arena, Synth_Patch* patch, int32 frequency, Sound_Effect* effect)
+{
+    uint32 frame_count = (uint32)(synth_get_duration__seconds(&patch->envelope) * frequency);
+    int16* samples = push_array(arena, frame_count * 2, int16);
+
+    real32 phase = 0.0f;
+    real32 tone_frequency = patch->start_frequency;
+    // Multiplying by this every frame gives an exponential sweep, which sounds linear in pitch
+    real32 sweep_per_frame = powf(patch->end_frequency / patch->start_frequency, 1.0f / frame_count);
+
+    uint32 noise_state = 0x9E3779B9;
+    real32 noise_filtered = 0.0f;
+    real32 noise_smoothing = 1.0f - expf(-2.0f * (real32)M_PI * patch->noise_cutoff_frequency / frequency);
+
+    for (uint32 frame = 0; frame < frame_count; frame++)
+    {
+        real32 time__seconds = (real32)frame / frequency;
+        real32 value = patch->tone_gain * synth_oscillate(patch->waveform, phase);
+
+        if (patch->noise_gain > 0)
+        {
+            // xorshift32
+            noise_state ^= noise_state << 13;
+            noise_state ^= noise_state >> 17;
+            noise_state ^= noise_state << 5;
+            real32 noise = (real32)noise_state / 2147483648.0f - 1.0f;
+
+            noise_filtered += noise_smoothing * (noise - noise_filtered);
+            value += patch->noise_gain * noise_filtered * expf(-time__seconds / patch->noise_decay__seconds);
+        }
+
+        value *= synth_get_envelope_level(&patch->envelope, time__seconds);
+        value = SDL_clamp(value, -1.0f, 1.0f);
+
+        int16 sample = (int16)(value * 32767.0f);
+        samples[frame * 2] = sample;
+        samples[frame * 2 + 1] = sample;
+
+        phase += tone_frequency / frequency;
+        phase -= (int32)phase;
+        tone_frequency *= sweep_per_frame;
+    }
+
+    effect->samples = samples;
+    effect->frame_count = frame_count;
+}
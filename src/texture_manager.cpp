@@ -0,0 +1,219 @@
+#include <SDL2/SDL.h>
+
+// Every long-lived texture goes through here so we know how much texture memory is in use. Owners hold a Texture_Id
+// instead of an SDL_Texture*. texture_manager_use() hands back NULL when the texture was evicted to stay under budget
+// or lost to a render target/device reset, and the owner simply recreates it (the same way it created it the first
+// time) and hands it back with texture_manager_set().
+
+#define MAX_MANAGED_TEXTURES 256
+
+typedef uint32 Texture_Id;  // 0 means no texture
+
+struct Managed_Texture
+{
+    const char* debug_name;
+    SDL_Texture* texture;  // NULL when evicted or lost
+    uint64 bytes;
+    uint64 last_used_frame;
+    bool32 is_render_target;
+    bool32 is_allocated;  // Whether the slot belongs to someone
+};
+
+struct Texture_Manager
+{
+    Managed_Texture textures[MAX_MANAGED_TEXTURES];
+    uint32 slot_count;
+
+    uint64 frame_index;
+    uint64 resident_bytes;
+    uint32 resident_count;
+
+    uint32 evictions;
+    uint32 lost;
+    bool32 warned_over_budget;
+};
+
+Texture_Manager global_texture_manager;
+
+local_internal uint64 get_texture_bytes(SDL_Texture* texture, bool32* is_render_target)
+{
+    Uint32 format;
+    int access, width, height;
+    SDL_QueryTexture(texture, &format, &access, &width, &height);
+    *is_render_target = access == SDL_TEXTUREACCESS_TARGET;
+
+    uint32 bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+    if (SDL_ISPIXELFORMAT_FOURCC(format) || bytes_per_pixel == 0)
+    {
+        // Planar YUV etc. Close enough for budgeting.
+        bytes_per_pixel = 2;
+    }
+    return (uint64)width * (uint64)height * bytes_per_pixel;
+}
+
+local_internal void texture_manager_unload(Managed_Texture* managed)
+{
+    if (managed->texture)
+    {
+        SDL_DestroyTexture(managed->texture);
+        managed->texture = NULL;
+        global_texture_manager.resident_bytes -= managed->bytes;
+        global_texture_manager.resident_count--;
+        managed->bytes = 0;
+    }
+}
+
+// Evicts the least recently used textures (never ones drawn this frame) until the new bytes fit under the budget
+local_internal void texture_manager_make_room(uint64 new_bytes)
+{
+    Texture_Manager* manager = &global_texture_manager;
+
+    while (manager->resident_bytes + new_bytes > TEXTURE_MEMORY_BUDGET_BYTES)
+    {
+        Managed_Texture* least_recently_used = NULL;
+        for (uint32 i = 0; i < manager->slot_count; i++)
+        {
+            Managed_Texture* managed = &manager->textures[i];
+            if (managed->texture && managed->last_used_frame < manager->frame_index &&
+                (!least_recently_used || managed->last_used_frame < least_recently_used->last_used_frame))
+            {
+                least_recently_used = managed;
+            }
+        }
+
+        if (!least_recently_used)
+        {
+            if (!manager->warned_over_budget)
+            {
+                log_error("Texture memory is over budget (%llu KB) with nothing left to evict\n",
+                          (unsigned long long)(TEXTURE_MEMORY_BUDGET_BYTES / 1024));
+                manager->warned_over_budget = true;
+            }
+            return;
+        }
+
+        texture_manager_unload(least_recently_used);
+        manager->evictions++;
+    }
+}
+
+void texture_manager_begin_frame()
+{
+    global_texture_manager.frame_index++;
+}
+
+// Returns the texture (and marks it as used this frame), or NULL if the owner needs to (re)create it
+SDL_Texture* texture_manager_use(Texture_Id id)
+{
+    if (id == 0)
+    {
+        return NULL;
+    }
+
+    Managed_Texture* managed = &global_texture_manager.textures[id - 1];
+    managed->last_used_frame = global_texture_manager.frame_index;
+    return managed->texture;
+}
+
+// Takes ownership of the texture. Pass the id the owner already has (or 0 for a new one). Any texture that was
+// already there gets destroyed.
+Texture_Id texture_manager_set(Texture_Id id, SDL_Texture* texture, const char* debug_name)
+{
+    Texture_Manager* manager = &global_texture_manager;
+
+    if (id == 0)
+    {
+        for (uint32 i = 0; i < MAX_MANAGED_TEXTURES; i++)
+        {
+            if (!manager->textures[i].is_allocated)
+            {
+                id = i + 1;
+                if (i >= manager->slot_count)
+                {
+                    manager->slot_count = i + 1;
+                }
+                break;
+            }
+        }
+
+        if (id == 0)
+        {
+            SDL_SetError("Texture manager is full! %d", MAX_MANAGED_TEXTURES);
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            SDL_assert_release(id != 0);
+            SDL_DestroyTexture(texture);
+            return 0;
+        }
+    }
+
+    Managed_Texture* managed = &manager->textures[id - 1];
+    texture_manager_unload(managed);
+    managed->is_allocated = true;
+    managed->debug_name = debug_name;
+
+    if (texture)
+    {
+        uint64 bytes = get_texture_bytes(texture, &managed->is_render_target);
+        texture_manager_make_room(bytes);
+
+        managed->texture = texture;
+        managed->bytes = bytes;
+        managed->last_used_frame = manager->frame_index;
+        manager->resident_bytes += bytes;
+        manager->resident_count++;
+    }
+
+    return id;
+}
+
+void texture_manager_release(Texture_Id id)
+{
+    if (id == 0)
+    {
+        return;
+    }
+
+    Managed_Texture* managed = &global_texture_manager.textures[id - 1];
+    texture_manager_unload(managed);
+    *managed = {};
+}
+
+// SDL_RENDER_TARGETS_RESET: render targets lost their contents, so drop them and let the owners redraw them
+void texture_manager_on_render_targets_reset()
+{
+    Texture_Manager* manager = &global_texture_manager;
+    for (uint32 i = 0; i < manager->slot_count; i++)
+    {
+        Managed_Texture* managed = &manager->textures[i];
+        if (managed->texture && managed->is_render_target)
+        {
+            texture_manager_unload(managed);
+            manager->lost++;
+        }
+    }
+}
+
+// SDL_RENDER_DEVICE_RESET: every texture is gone
+void texture_manager_on_device_reset()
+{
+    Texture_Manager* manager = &global_texture_manager;
+    for (uint32 i = 0; i < manager->slot_count; i++)
+    {
+        Managed_Texture* managed = &manager->textures[i];
+        if (managed->texture)
+        {
+            texture_manager_unload(managed);
+            manager->lost++;
+        }
+    }
+}
+
+void texture_manager_cleanup()
+{
+    Texture_Manager* manager = &global_texture_manager;
+    for (uint32 i = 0; i < manager->slot_count; i++)
+    {
+        texture_manager_unload(&manager->textures[i]);
+    }
+    *manager = {};
+}
@@ -0,0 +1,282 @@
+#include <SDL2/SDL.h>
+
+// Schedules simulation events (grid jumps, menu blinks, ...) by tick. Advancing the clock only touches the ticks
+// something is due on, so simulating a lot of ticks where nothing happens is free.
+//
+// Timers due within TIMER_WHEEL_SLOT_COUNT ticks sit in the slot for their tick (tick % slot count), with a bitmap of
+// occupied slots so finding the next due tick is a handful of bit scans. Anything further out waits on an overflow
+// list until it comes within range.
+
+#define TIMER_WHEEL_SLOT_COUNT 256  // Must be a multiple of 64
+#define TIMER_WHEEL_MAX_TIMERS 64
+#define TIMER_WHEEL_NO_TIMER -1
+
+typedef uint32 Timer_Id;  // 0 means no timer
+
+// tick is the tick the timer was due on (i.e. the current simulation tick)
+typedef void Timer_Callback(void* data, uint64 tick);
+
+struct Timer
+{
+    uint64 due_tick;
+    Timer_Callback* callback;
+    void* data;
+    int32 next;  // Next timer in the same slot (or on the overflow list)
+    uint16 generation;  // Bumped every time the timer is reused so stale ids can't cancel someone else's timer
+    bool32 is_scheduled;
+};
+
+struct Timer_Wheel
+{
+    uint64 current_tick;  // Everything due before this has fired
+
+    Timer timers[TIMER_WHEEL_MAX_TIMERS];
+    int32 slot_heads[TIMER_WHEEL_SLOT_COUNT];
+    uint64 occupied_slots[TIMER_WHEEL_SLOT_COUNT / 64];
+    int32 overflow_head;
+
+    uint32 scheduled_count;
+    uint64 fired_count;
+};
+
+local_internal uint32 find_lowest_set_bit(uint64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32)index;
+#else
+    return (uint32)__builtin_ctzll(value);
+#endif
+}
+
+local_internal Timer_Id timer_wheel_get_id(Timer_Wheel* wheel, int32 index)
+{
+    return ((Timer_Id)wheel->timers[index].generation << 16) | (Timer_Id)(index + 1);
+}
+
+// Returns TIMER_WHEEL_NO_TIMER if the id is stale or was never scheduled
+local_internal int32 timer_wheel_get_index(Timer_Wheel* wheel, Timer_Id id)
+{
+    int32 index = (int32)(id & 0xFFFF) - 1;
+    if (index < 0 || index >= TIMER_WHEEL_MAX_TIMERS)
+    {
+        return TIMER_WHEEL_NO_TIMER;
+    }
+
+    Timer* timer = &wheel->timers[index];
+    if (!timer->is_scheduled || timer->generation != (uint16)(id >> 16))
+    {
+        return TIMER_WHEEL_NO_TIMER;
+    }
+    return index;
+}
+
+void timer_wheel_init(Timer_Wheel* wheel, uint64 start_tick)
+{
+    *wheel = {};
+    wheel->current_tick = start_tick;
+    wheel->overflow_head = TIMER_WHEEL_NO_TIMER;
+    for (uint32 i = 0; i < TIMER_WHEEL_SLOT_COUNT; i++)
+    {
+        wheel->slot_heads[i] = TIMER_WHEEL_NO_TIMER;
+    }
+}
+
+local_internal void timer_wheel_link(Timer_Wheel* wheel, int32 index)
+{
+    Timer* timer = &wheel->timers[index];
+
+    if (timer->due_tick - wheel->current_tick < TIMER_WHEEL_SLOT_COUNT)
+    {
+        uint32 slot = (uint32)(timer->due_tick & (TIMER_WHEEL_SLOT_COUNT - 1));
+        timer->next = wheel->slot_heads[slot];
+        wheel->slot_heads[slot] = index;
+        wheel->occupied_slots[slot / 64] |= (uint64)1 << (slot % 64);
+    }
+    else
+    {
+        timer->next = wheel->overflow_head;
+        wheel->overflow_head = index;
+    }
+}
+
+local_internal void timer_wheel_unlink(Timer_Wheel* wheel, int32 index)
+{
+    Timer* timer = &wheel->timers[index];
+
+    int32* link = &wheel->overflow_head;
+    uint32 slot = (uint32)(timer->due_tick & (TIMER_WHEEL_SLOT_COUNT - 1));
+    if (timer->due_tick - wheel->current_tick < TIMER_WHEEL_SLOT_COUNT)
+    {
+        link = &wheel->slot_heads[slot];
+    }
+
+    while (*link != index)
+    {
+        SDL_assert(*link != TIMER_WHEEL_NO_TIMER);
+        link = &wheel->timers[*link].next;
+    }
+    *link = timer->next;
+
+    if (link == &wheel->slot_heads[slot] && wheel->slot_heads[slot] == TIMER_WHEEL_NO_TIMER)
+    {
+        wheel->occupied_slots[slot / 64] &= ~((uint64)1 << (slot % 64));
+    }
+}
+
+// Due ticks in the past fire on the next advance
+Timer_Id timer_wheel_schedule(Timer_Wheel* wheel, uint64 due_tick, Timer_Callback* callback, void* data)
+{
+    int32 index = TIMER_WHEEL_NO_TIMER;
+    for (int32 i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++)
+    {
+        if (!wheel->timers[i].is_scheduled)
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == TIMER_WHEEL_NO_TIMER)
+    {
+        SDL_SetError("Timer wheel is full! %d", TIMER_WHEEL_MAX_TIMERS);
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        SDL_assert_release(index != TIMER_WHEEL_NO_TIMER);
+        return 0;
+    }
+
+    Timer* timer = &wheel->timers[index];
+    timer->due_tick = due_tick < wheel->current_tick ? wheel->current_tick : due_tick;
+    timer->callback = callback;
+    timer->data = data;
+    timer->generation++;
+    timer->is_scheduled = true;
+    timer_wheel_link(wheel, index);
+    wheel->scheduled_count++;
+
+    return timer_wheel_get_id(wheel, index);
+}
+
+void timer_wheel_cancel(Timer_Wheel* wheel, Timer_Id id)
+{
+    int32 index = timer_wheel_get_index(wheel, id);
+    if (index != TIMER_WHEEL_NO_TIMER)
+    {
+        timer_wheel_unlink(wheel, index);
+        wheel->timers[index].is_scheduled = false;
+        wheel->scheduled_count--;
+    }
+}
+
+void timer_wheel_cancel_all(Timer_Wheel* wheel)
+{
+    for (int32 i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++)
+    {
+        if (wheel->timers[i].is_scheduled)
+        {
+            timer_wheel_cancel(wheel, timer_wheel_get_id(wheel, i));
+        }
+    }
+}
+
+bool32 timer_wheel_is_scheduled(Timer_Wheel* wheel, Timer_Id id)
+{
+    return timer_wheel_get_index(wheel, id) != TIMER_WHEEL_NO_TIMER;
+}
+
+// Only valid while the timer is scheduled
+uint64 timer_wheel_get_due_tick(Timer_Wheel* wheel, Timer_Id id)
+{
+    int32 index = timer_wheel_get_index(wheel, id);
+    SDL_assert(index != TIMER_WHEEL_NO_TIMER);
+    return wheel->timers[index].due_tick;
+}
+
+// Returns UINT64_MAX when nothing is scheduled
+uint64 timer_wheel_get_next_due_tick(Timer_Wheel* wheel)
+{
+    uint64 next_due_tick = UINT64_MAX;
+
+    // Walk the bitmap a word at a time starting from the current tick's slot
+    uint32 distance = 0;
+    while (distance < TIMER_WHEEL_SLOT_COUNT)
+    {
+        uint32 slot = (uint32)((wheel->current_tick + distance) & (TIMER_WHEEL_SLOT_COUNT - 1));
+        uint64 bits = wheel->occupied_slots[slot / 64] >> (slot % 64);
+        if (bits)
+        {
+            next_due_tick = wheel->current_tick + distance + find_lowest_set_bit(bits);
+            break;
+        }
+        distance += 64 - (slot % 64);
+    }
+
+    for (int32 index = wheel->overflow_head; index != TIMER_WHEEL_NO_TIMER; index = wheel->timers[index].next)
+    {
+        if (wheel->timers[index].due_tick < next_due_tick)
+        {
+            next_due_tick = wheel->timers[index].due_tick;
+        }
+    }
+
+    return next_due_tick;
+}
+
+// Moves overflow timers onto the wheel once they're close enough
+local_internal void timer_wheel_cascade(Timer_Wheel* wheel)
+{
+    int32 index = wheel->overflow_head;
+    wheel->overflow_head = TIMER_WHEEL_NO_TIMER;
+    while (index != TIMER_WHEEL_NO_TIMER)
+    {
+        int32 next = wheel->timers[index].next;
+        timer_wheel_link(wheel, index);
+        index = next;
+    }
+}
+
+// Fires everything due up to and including target_tick, in tick order. Callbacks are free to schedule and cancel
+// timers (including ones due on the same tick, which fire before this returns).
+void timer_wheel_advance(Timer_Wheel* wheel, uint64 target_tick)
+{
+    for (;;)
+    {
+        uint64 next_due_tick = timer_wheel_get_next_due_tick(wheel);
+        if (next_due_tick > target_tick)
+        {
+            break;
+        }
+
+        if (next_due_tick != wheel->current_tick)
+        {
+            wheel->current_tick = next_due_tick;
+            timer_wheel_cascade(wheel);
+        }
+
+        // Pop one at a time so callbacks can cancel the other timers on this tick
+        uint32 slot = (uint32)(next_due_tick & (TIMER_WHEEL_SLOT_COUNT - 1));
+        while (wheel->slot_heads[slot] != TIMER_WHEEL_NO_TIMER)
+        {
+            int32 index = wheel->slot_heads[slot];
+            Timer* timer = &wheel->timers[index];
+
+            wheel->slot_heads[slot] = timer->next;
+            if (wheel->slot_heads[slot] == TIMER_WHEEL_NO_TIMER)
+            {
+                wheel->occupied_slots[slot / 64] &= ~((uint64)1 << (slot % 64));
+            }
+
+            timer->is_scheduled = false;
+            wheel->scheduled_count--;
+            wheel->fired_count++;
+            timer->callback(timer->data, next_due_tick);
+        }
+    }
+
+    if (target_tick > wheel->current_tick)
+    {
+        wheel->current_tick = target_tick;
+        timer_wheel_cascade(wheel);
+    }
+}
@@ -0,0 +1,159 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#ifdef __WINDOWS__
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Non-blocking UDP over plain BSD sockets (Winsock on Windows), IPv4 only. Receiving never waits, it just says when
+// there's nothing there.
+
+struct Udp_Address
+{
+    uint32 ip;  // Network byte order, like the port
+    uint16 port;
+};
+
+struct Udp_Socket
+{
+#ifdef __WINDOWS__
+    SOCKET handle;
+#else
+    int handle;
+#endif
+    bool32 is_open;
+};
+
+// Winsock has to be started before any socket gets made. Does nothing anywhere else.
+bool32 net_startup()
+{
+#ifdef __WINDOWS__
+    local_persist bool32 is_winsock_started;
+    if (!is_winsock_started)
+    {
+        WSADATA wsa_data;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+        {
+            fprintf(stderr, "Failed to start Winsock\n");
+            return false;
+        }
+        is_winsock_started = true;
+    }
+#endif
+    return true;
+}
+
+// Binds to port on every interface (0 lets the OS pick)
+bool32 udp_socket_open(Udp_Socket* udp_socket, uint16 port)
+{
+    *udp_socket = {};
+
+    if (!net_startup())
+    {
+        return false;
+    }
+
+#ifdef __WINDOWS__
+    SOCKET handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID_SOCKET)
+    {
+        fprintf(stderr, "Failed to create a UDP socket: %d\n", WSAGetLastError());
+        return false;
+    }
+    u_long is_non_blocking = 1;
+    ioctlsocket(handle, FIONBIO, &is_non_blocking);
+#else
+    int handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle < 0)
+    {
+        fprintf(stderr, "Failed to create a UDP socket: %s\n", strerror(errno));
+        return false;
+    }
+    fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(handle, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        fprintf(stderr, "Failed to bind UDP port %u\n", port);
+#ifdef __WINDOWS__
+        closesocket(handle);
+#else
+        close(handle);
+#endif
+        return false;
+    }
+
+    udp_socket->handle = handle;
+    udp_socket->is_open = true;
+    return true;
+}
+
+void udp_socket_close(Udp_Socket* udp_socket)
+{
+    if (udp_socket->is_open)
+    {
+#ifdef __WINDOWS__
+        closesocket(udp_socket->handle);
+#else
+        close(udp_socket->handle);
+#endif
+    }
+    *udp_socket = {};
+}
+
+bool32 udp_resolve(const char* host, uint16 port, Udp_Address* address)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* result = NULL;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || !result)
+    {
+        fprintf(stderr, "Failed to resolve %s\n", host);
+        return false;
+    }
+
+    address->ip = ((sockaddr_in*)result->ai_addr)->sin_addr.s_addr;
+    address->port = htons(port);
+    freeaddrinfo(result);
+    return true;
+}
+
+bool32 udp_socket_send(Udp_Socket* udp_socket, Udp_Address* to, const void* data, int32 size)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = to->ip;
+    address.sin_port = to->port;
+    return sendto(udp_socket->handle, (const char*)data, size, 0, (sockaddr*)&address, sizeof(address)) == size;
+}
+
+// Returns the size of the datagram, or 0 if nothing has arrived. Datagrams bigger than capacity get cut short.
+int32 udp_socket_receive(Udp_Socket* udp_socket, void* data, int32 capacity, Udp_Address* from)
+{
+    sockaddr_in address = {};
+    socklen_t address_size = sizeof(address);
+    int32 size = (int32)recvfrom(udp_socket->handle, (char*)data, capacity, 0, (sockaddr*)&address, &address_size);
+    if (size <= 0)
+    {
+        return 0;
+    }
+
+    from->ip = address.sin_addr.s_addr;
+    from->port = address.sin_port;
+    return size;
+}
@@ -0,0 +1,121 @@
+#include <SDL2/SDL.h>
+
+// A few long lived threads that all run the same job together, fork/join style. The calling thread joins in as
+// worker 0, so a pool of one is just a function call.
+
+#define WORKER_POOL_MAX_WORKERS 16
+
+typedef void Worker_Job(void* data, uint32 worker_index);
+
+struct Worker_Pool;
+
+struct Worker_Thread
+{
+    Worker_Pool* pool;
+    uint32 worker_index;
+    SDL_Thread* thread;
+    SDL_sem* start;  // Each worker waits on its own so it's known which ones run
+};
+
+struct Worker_Pool
+{
+    Worker_Thread threads[WORKER_POOL_MAX_WORKERS];
+    uint32 worker_count;  // Including the calling thread
+    SDL_sem* done;
+
+    Worker_Job* job;
+    void* job_data;
+    SDL_atomic_t is_quitting;
+};
+
+local_internal int worker_pool_thread(void* data)
+{
+    Worker_Thread* thread = (Worker_Thread*)data;
+    Worker_Pool* pool = thread->pool;
+
+    for (;;)
+    {
+        SDL_SemWait(thread->start);
+        if (SDL_AtomicGet(&pool->is_quitting))
+        {
+            break;
+        }
+        pool->job(pool->job_data, thread->worker_index);
+        SDL_SemPost(pool->done);
+    }
+    return 0;
+}
+
+// 0 means one worker per core. Falls back to fewer workers if threads can't be created.
+void worker_pool_init(Worker_Pool* pool, uint32 worker_count)
+{
+    *pool = {};
+    if (worker_count == 0)
+    {
+        worker_count = (uint32)SDL_GetCPUCount();
+    }
+    worker_count = SDL_clamp(worker_count, 1, WORKER_POOL_MAX_WORKERS);
+
+    pool->done = SDL_CreateSemaphore(0);
+    pool->worker_count = 1;
+
+    for (uint32 i = 1; i < worker_count; i++)
+    {
+        Worker_Thread* thread = &pool->threads[i];
+        thread->pool = pool;
+        thread->worker_index = i;
+        thread->start = SDL_CreateSemaphore(0);
+
+        char name[32];
+        snprintf(name, sizeof(name), "worker %u", i);
+        thread->thread = SDL_CreateThread(worker_pool_thread, name, thread);
+        if (!thread->thread)
+        {
+            fprintf(stderr, "Failed to create worker thread %u: %s\n", i, SDL_GetError());
+            SDL_DestroySemaphore(thread->start);
+            break;
+        }
+        pool->worker_count++;
+    }
+}
+
+void worker_pool_shutdown(Worker_Pool* pool)
+{
+    SDL_AtomicSet(&pool->is_quitting, 1);
+    for (uint32 i = 1; i < pool->worker_count; i++)
+    {
+        SDL_SemPost(pool->threads[i].start);
+        SDL_WaitThread(pool->threads[i].thread, NULL);
+        SDL_DestroySemaphore(pool->threads[i].start);
+    }
+    if (pool->done)
+    {
+        SDL_DestroySemaphore(pool->done);
+    }
+    *pool = {};
+}
+
+// Runs job on workers 0 to active_count - 1 (all of them if active_count is 0) and waits for them to finish
+void worker_pool_run(Worker_Pool* pool, Worker_Job* job, void* data, uint32 active_count)
+{
+    if (active_count == 0 || active_count > pool->worker_count)
+    {
+        active_count = pool->worker_count;
+    }
+
+    pool->job = job;
+    pool->job_data = data;
+
+    // The semaphores order these writes before the workers read them
+    for (uint32 i = 1; i < active_count; i++)
+    {
+        SDL_SemPost(pool->threads[i].start);
+    }
+
+    job(data, 0);
+
+    for (uint32 i = 1; i < active_count; i++)
+    {
+        SDL_SemWait(pool->done);
+    }
+}
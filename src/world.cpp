@@ -0,0 +1,256 @@
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#include "common.h"
+#include "snake_sim.h"
+
+// One snake on a board far bigger than the screen (--world). The board is cut into square chunks that only get
+// allocated the first time something is written to them, so memory grows with where the snake has been rather than
+// with the size of the world, and drawing only has to look at the chunks that are on screen.
+//
+// There's no body buffer: every snake cell holds the direction to the next cell towards the head, so the tail just
+// follows the trail the head left. Blips are scattered by a hash of the cell's position, with a bit in the cell once
+// one has been eaten, so a chunk nobody has been to doesn't need any memory to have blips on it.
+//
+// Every chunk also keeps a bit per cell for the snake, and goes on the dirty list whenever one changes, so the minimap
+// (see minimap.cpp) only has to look at chunks that changed since the last frame.
+
+#define WORLD_CHUNK_SHIFT 6
+#define WORLD_CHUNK_SIZE (1 << WORLD_CHUNK_SHIFT)  // Cells along each side
+#define WORLD_CHUNK_MASK (WORLD_CHUNK_SIZE - 1)
+
+// What's in a cell. The low bits are the snake: the direction to the next cell for the body, or the head.
+#define WORLD_CELL_EMPTY 0
+#define WORLD_CELL_HEAD 5
+#define WORLD_CELL_SNAKE_MASK 0x07
+#define WORLD_CELL_BLIP_EATEN 0x80
+
+struct World_Chunk
+{
+    uint8 cells[WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE];
+    uint64 occupancy[WORLD_CHUNK_SIZE];  // A row each, bit x is set when the snake is in column x
+    bool32 is_dirty;  // Already on the dirty list
+};
+
+struct World
+{
+    int32 width;
+    int32 height;
+    int32 chunk_columns;
+    int32 chunk_rows;
+    World_Chunk** chunks;  // chunk_columns * chunk_rows, NULL until something gets written there
+    uint32 chunk_count;
+    uint32* dirty_chunks;  // Indices into chunks that changed since the minimap last looked
+    uint32 dirty_chunk_count;
+    uint32 reset_count;  // Goes up with every new game, when every chunk gets thrown away
+
+    // Has room for every chunk, but the OS only hands over pages once a chunk is actually used
+    Memory_Arena memory;
+    Arena_Marker first_chunk;  // Just after the directory
+
+    uint32 blip_rarity;  // One cell in this many starts with a blip
+    uint32 blip_seed;
+    uint32 random_state;  // A new blip seed every game
+
+    int32 head_x;
+    int32 head_y;
+    int32 tail_x;
+    int32 tail_y;
+    uint8 direction;  // Direction
+    uint8 is_game_over;
+    uint32 length;  // Cells covered, head included
+    uint64 step_count;  // Cells moved this game
+};
+
+World global_world;
+
+inline uint32 world_get_chunk_index(const World* world, int32 x, int32 y)
+{
+    return (uint32)((y >> WORLD_CHUNK_SHIFT) * world->chunk_columns + (x >> WORLD_CHUNK_SHIFT));
+}
+
+local_internal World_Chunk** world_get_chunk_slot(const World* world, int32 x, int32 y)
+{
+    return &world->chunks[world_get_chunk_index(world, x, y)];
+}
+
+local_internal void world_mark_dirty(World* world, uint32 chunk_index)
+{
+    World_Chunk* chunk = world->chunks[chunk_index];
+    if (!chunk->is_dirty)
+    {
+        chunk->is_dirty = true;
+        world->dirty_chunks[world->dirty_chunk_count++] = chunk_index;
+    }
+}
+
+inline bool32 world_is_inside(const World* world, int32 x, int32 y)
+{
+    return x >= 0 && x < world->width && y >= 0 && y < world->height;
+}
+
+// Empty anywhere that hasn't been written to yet
+inline uint8 world_get_cell(const World* world, int32 x, int32 y)
+{
+    World_Chunk* chunk = *world_get_chunk_slot(world, x, y);
+    return chunk ? chunk->cells[(y & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (x & WORLD_CHUNK_MASK)] : WORLD_CELL_EMPTY;
+}
+
+// Allocates the chunk if this is the first write to it
+local_internal uint8* world_touch_cell(World* world, int32 x, int32 y)
+{
+    World_Chunk** chunk = world_get_chunk_slot(world, x, y);
+    if (!*chunk)
+    {
+        *chunk = push_struct(&world->memory, World_Chunk);
+        world->chunk_count++;
+        world_mark_dirty(world, world_get_chunk_index(world, x, y));
+    }
+    return &(*chunk)->cells[(y & WORLD_CHUNK_MASK) * WORLD_CHUNK_SIZE + (x & WORLD_CHUNK_MASK)];
+}
+
+// The chunk has to be there already
+local_internal void world_set_occupied(World* world, int32 x, int32 y, bool32 is_occupied)
+{
+    uint32 chunk_index = world_get_chunk_index(world, x, y);
+    uint64 bit = (uint64)1 << (x & WORLD_CHUNK_MASK);
+    uint64* row = &world->chunks[chunk_index]->occupancy[y & WORLD_CHUNK_MASK];
+    *row = is_occupied ? *row | bit : *row & ~bit;
+    world_mark_dirty(world, chunk_index);
+}
+
+inline uint32 world_hash(uint32 seed, int32 x, int32 y)
+{
+    uint32 hash = seed ^ ((uint32)x * 0x9E3779B1u) ^ ((uint32)y * 0x85EBCA77u);
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    hash *= 0x297A2D39u;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+// cell is whatever world_get_cell() gave for (x, y)
+inline bool32 world_has_blip(const World* world, int32 x, int32 y, uint8 cell)
+{
+    return !(cell & (WORLD_CELL_BLIP_EATEN | WORLD_CELL_SNAKE_MASK)) &&
+           world_hash(world->blip_seed, x, y) % world->blip_rarity == 0;
+}
+
+// Starts a new game in the middle of the world with new blips, throwing every chunk away
+void world_reset(World* world)
+{
+    arena_reset_to_marker(world->first_chunk);
+    memset(world->chunks, 0, (size_t)world->chunk_columns * world->chunk_rows * sizeof(World_Chunk*));
+    world->chunk_count = 0;
+    world->dirty_chunk_count = 0;
+    world->reset_count++;
+    world->blip_seed = snake_sim_random(&world->random_state);
+
+    world->head_x = world->width / 2;
+    world->head_y = world->height / 2;
+    world->tail_x = world->head_x;
+    world->tail_y = world->head_y;
+    world->direction = DIRECTION_NORTH;
+    world->is_game_over = false;
+    world->length = 1;
+    world->step_count = 0;
+    *world_touch_cell(world, world->head_x, world->head_y) = WORLD_CELL_HEAD | WORLD_CELL_BLIP_EATEN;
+    world_set_occupied(world, world->head_x, world->head_y, true);
+}
+
+bool32 world_init(World* world, int32 width, int32 height, uint32 blip_rarity, uint32 seed)
+{
+    *world = {};
+    world->width = width;
+    world->height = height;
+    world->chunk_columns = (width + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+    world->chunk_rows = (height + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+    world->blip_rarity = SDL_max(blip_rarity, 1);
+    world->random_state = seed;
+
+    // Never prefaulted, that would touch every chunk
+    size_t chunk_slot_count = (size_t)world->chunk_columns * world->chunk_rows;
+    size_t size = chunk_slot_count * (sizeof(World_Chunk*) + sizeof(uint32) + sizeof(World_Chunk)) + 64;
+    if (!arena_init(&world->memory, "world", size, false, false))
+    {
+        return false;
+    }
+    world->chunks = push_array(&world->memory, chunk_slot_count, World_Chunk*);
+    world->dirty_chunks = push_array(&world->memory, chunk_slot_count, uint32);
+    world->first_chunk = arena_get_marker(&world->memory);
+
+    world_reset(world);
+    return true;
+}
+
+// Turns towards proposed_direction (unless it's DIRECTION_NONE or straight back) and moves one cell, eating any blip
+// the head lands on. Returns SNAKE_SIM_ flags, same as snake_sim_step().
+uint32 world_step(World* world, Direction proposed_direction)
+{
+    if (world->is_game_over)
+    {
+        return 0;
+    }
+
+    if (proposed_direction != DIRECTION_NONE &&
+        proposed_direction != snake_sim_get_opposite((Direction)world->direction))
+    {
+        world->direction = (uint8)proposed_direction;
+    }
+
+    int32 x = world->head_x;
+    int32 y = world->head_y;
+    snake_sim_move((Direction)world->direction, &x, &y);
+    world->step_count++;
+
+    if (!world_is_inside(world, x, y))
+    {
+        world->is_game_over = true;
+        return SNAKE_SIM_CRASHED;
+    }
+
+    // The tail moves out of the way at the same time, so the head can follow right behind it
+    uint8 cell = world_get_cell(world, x, y);
+    bool32 is_growing = world_has_blip(world, x, y, cell);
+    bool32 is_onto_tail = !is_growing && x == world->tail_x && y == world->tail_y;
+    if ((cell & WORLD_CELL_SNAKE_MASK) && !is_onto_tail)
+    {
+        world->is_game_over = true;
+        return SNAKE_SIM_CRASHED;
+    }
+
+    // The old head points at the new one. Done before moving the tail so a snake of one follows itself.
+    uint8* head_cell = world_touch_cell(world, world->head_x, world->head_y);
+    *head_cell = (uint8)((*head_cell & ~WORLD_CELL_SNAKE_MASK) | world->direction);
+
+    if (is_growing)
+    {
+        world->length++;
+    }
+    else
+    {
+        uint8* tail_cell = world_touch_cell(world, world->tail_x, world->tail_y);
+        Direction next = (Direction)(*tail_cell & WORLD_CELL_SNAKE_MASK);
+        *tail_cell = (uint8)(*tail_cell & ~WORLD_CELL_SNAKE_MASK);
+        if (!is_onto_tail)
+        {
+            world_set_occupied(world, world->tail_x, world->tail_y, false);
+        }
+        snake_sim_move(next, &world->tail_x, &world->tail_y);
+    }
+
+    head_cell = world_touch_cell(world, x, y);
+    *head_cell = (uint8)((*head_cell & ~WORLD_CELL_SNAKE_MASK) | WORLD_CELL_HEAD | WORLD_CELL_BLIP_EATEN);
+    world_set_occupied(world, x, y, true);
+    world->head_x = x;
+    world->head_y = y;
+
+    return is_growing ? SNAKE_SIM_ATE : 0;
+}
+
+// Only counts chunks, the directory is tiny next to them
+inline size_t world_get_chunk_bytes(const World* world)
+{
+    return (size_t)world->chunk_count * sizeof(World_Chunk);
+}
@@ -0,0 +1,145 @@
+// Builds the asset pack the game maps at startup (see src/asset_pack.h for the format).
+//
+// Usage: asset_packer <output pack> <asset path>...
+//
+// Asset paths are stored exactly as given, so run it from the directory the game loads loose files from, e.g.
+//     build/asset_packer build/assets.pack fonts/Share_Tech_Mono/ShareTechMono-Regular.ttf sounds/boom.mp3
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/common.h"
+#include "../src/asset_pack.h"
+
+struct Packed_Asset
+{
+    Asset_Pack_Entry entry;
+    uint8* data;
+};
+
+local_internal uint64 align_up(uint64 value, uint64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+local_internal int compare_assets(const void* a, const void* b)
+{
+    uint64 hash_a = ((Packed_Asset*)a)->entry.name_hash;
+    uint64 hash_b = ((Packed_Asset*)b)->entry.name_hash;
+    return hash_a < hash_b ? -1 : hash_a > hash_b ? 1 : 0;
+}
+
+local_internal bool32 read_entire_file(const char* file_path, uint8** data, uint64* size)
+{
+    FILE* file = fopen(file_path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *size = (uint64)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *data = (uint8*)malloc(*size ? *size : 1);
+    bool32 result = fread(*data, 1, *size, file) == *size;
+    fclose(file);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output pack> <asset path>...\n", argv[0]);
+        return 1;
+    }
+
+    uint32 asset_count = (uint32)(argc - 2);
+    Packed_Asset* assets = (Packed_Asset*)calloc(asset_count, sizeof(Packed_Asset));
+
+    for (uint32 i = 0; i < asset_count; i++)
+    {
+        const char* name = argv[i + 2];
+        Packed_Asset* asset = &assets[i];
+
+        if (strlen(name) >= ASSET_PACK_MAX_NAME_LENGTH)
+        {
+            fprintf(stderr, "Asset path is too long (max %d): %s\n", ASSET_PACK_MAX_NAME_LENGTH - 1, name);
+            return 1;
+        }
+
+        if (!read_entire_file(name, &asset->data, &asset->entry.size))
+        {
+            fprintf(stderr, "Failed to read %s\n", name);
+            return 1;
+        }
+
+        strcpy(asset->entry.name, name);
+        asset->entry.name_hash = asset_pack_hash_name(name);
+        asset->entry.content_hash = asset_pack_hash(asset->data, asset->entry.size);
+    }
+
+    // The game binary searches the index by name hash
+    qsort(assets, asset_count, sizeof(Packed_Asset), compare_assets);
+
+    for (uint32 i = 1; i < asset_count; i++)
+    {
+        if (assets[i].entry.name_hash == assets[i - 1].entry.name_hash &&
+            strcmp(assets[i].entry.name, assets[i - 1].entry.name) == 0)
+        {
+            fprintf(stderr, "%s was given twice\n", assets[i].entry.name);
+            return 1;
+        }
+    }
+
+    Asset_Pack_Header header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = asset_count;
+    header.index_offset = sizeof(Asset_Pack_Header);
+
+    uint64 offset = header.index_offset + asset_count * sizeof(Asset_Pack_Entry);
+    for (uint32 i = 0; i < asset_count; i++)
+    {
+        offset = align_up(offset, ASSET_PACK_ALIGNMENT);
+        assets[i].entry.offset = offset;
+        offset += assets[i].entry.size;
+    }
+
+    FILE* output = fopen(argv[1], "wb");
+    if (!output)
+    {
+        fprintf(stderr, "Failed to open %s for writing\n", argv[1]);
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, output);
+    for (uint32 i = 0; i < asset_count; i++)
+    {
+        fwrite(&assets[i].entry, sizeof(Asset_Pack_Entry), 1, output);
+    }
+
+    uint64 written = header.index_offset + asset_count * sizeof(Asset_Pack_Entry);
+    for (uint32 i = 0; i < asset_count; i++)
+    {
+        // Pad up to the asset's page
+        while (written < assets[i].entry.offset)
+        {
+            fputc(0, output);
+            written++;
+        }
+        fwrite(assets[i].data, 1, assets[i].entry.size, output);
+        written += assets[i].entry.size;
+    }
+
+    if (fclose(output) != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("Packed %u assets into %s (%llu KB)\n", asset_count, argv[1], (unsigned long long)(written / 1024));
+    return 0;
+}
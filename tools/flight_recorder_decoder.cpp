@@ -0,0 +1,228 @@
+// Turns a flight recorder dump (flight_<time>_<reason>.bin, written on asserts, crashes, game overs and F7) into text.
+//
+// Usage: flight_recorder_decoder <dump> [--summary] [--last <seconds>]
+//
+// Follows flight_recorder.h. Prints what caused the dump and the frame time stats, then every record, oldest first,
+// timed relative to the dump. Frames more than 1.5x over the target are marked as hitches. --summary stops after the
+// stats, --last only prints the records from the last few seconds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/common.h"
+#include "../src/flight_recorder.h"
+#include "../src/snake_sim.h"
+
+#define HITCH_FACTOR 1.5
+
+local_internal const char* get_direction_name(uint32 direction)
+{
+    switch (direction)
+    {
+        case DIRECTION_NORTH: return "North";
+        case DIRECTION_EAST: return "East";
+        case DIRECTION_SOUTH: return "South";
+        case DIRECTION_WEST: return "West";
+        default: return "straight on";
+    }
+}
+
+local_internal uint32 get_frame__microseconds(const Flight_Record* record)
+{
+    return record->frame.work + record->frame.writing_buffer + record->frame.render + record->frame.sleep;
+}
+
+local_internal void print_record(const Flight_Record* record, real64 seconds, uint32 hitch__microseconds)
+{
+    printf("%10.4f s  frame %8u  ", seconds, record->frame_index);
+    switch (record->type)
+    {
+        case FLIGHT_RECORD_FRAME:
+        {
+            uint32 total__microseconds = get_frame__microseconds(record);
+            printf("FRAME   %.2f ms: work %.2f, buffer %.2f, render %.2f, sleep %.2f%s\n",
+                   total__microseconds / 1000.0,
+                   record->frame.work / 1000.0,
+                   record->frame.writing_buffer / 1000.0,
+                   record->frame.render / 1000.0,
+                   record->frame.sleep / 1000.0,
+                   total__microseconds > hitch__microseconds ? "  <-- HITCH" : "");
+            break;
+        }
+        case FLIGHT_RECORD_CELL:
+        {
+            printf("CELL    tick %llu, %s to (%d, %d), length %u%s%s%s\n",
+                   (unsigned long long)record->cell.tick,
+                   get_direction_name(record->code),
+                   record->cell.head_x,
+                   record->cell.head_y,
+                   record->cell.length,
+                   (record->flags & SNAKE_SIM_ATE) ? ", ate" : "",
+                   (record->flags & SNAKE_SIM_CRASHED) ? ", CRASHED" : "",
+                   (record->flags & SNAKE_SIM_FILLED_BOARD) ? ", filled the board" : "");
+            break;
+        }
+        case FLIGHT_RECORD_KEY:
+        {
+            printf("KEY     %s %s\n", flight_button_name(record->code), record->flags ? "down" : "up");
+            break;
+        }
+        case FLIGHT_RECORD_MARKER:
+        {
+            switch (record->code)
+            {
+                case FLIGHT_MARKER_GAME_START: printf("MARKER  game start\n"); break;
+                case FLIGHT_MARKER_GAME_OVER:
+                    printf("MARKER  game over, score %u, length %u, %u cells since startup\n",
+                           record->values[0],
+                           record->values[1],
+                           record->values[2]);
+                    break;
+                case FLIGHT_MARKER_SCENE_CHANGE: printf("MARKER  scene change\n"); break;
+                default: printf("MARKER  %u\n", record->code); break;
+            }
+            break;
+        }
+        default:
+        {
+            printf("unknown record type %u\n", record->type);
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = NULL;
+    bool32 is_summary_only = false;
+    real64 last_seconds = 0.0;
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--summary") == 0)
+        {
+            is_summary_only = true;
+        }
+        else if (strcmp(argv[i], "--last") == 0 && i + 1 < argc)
+        {
+            last_seconds = atof(argv[++i]);
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (!path)
+    {
+        fprintf(stderr, "Usage: flight_recorder_decoder <dump> [--summary] [--last <seconds>]\n");
+        return 1;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+
+    Flight_Recorder_Header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != FLIGHT_RECORDER_MAGIC)
+    {
+        fprintf(stderr, "%s isn't a flight recorder dump\n", path);
+        fclose(file);
+        return 1;
+    }
+    if (header.version != FLIGHT_RECORDER_VERSION || header.record_size != sizeof(Flight_Record))
+    {
+        fprintf(stderr,
+                "%s is version %u with %u byte records, this decoder reads version %u with %u byte records\n",
+                path,
+                header.version,
+                header.record_size,
+                FLIGHT_RECORDER_VERSION,
+                (uint32)sizeof(Flight_Record));
+        fclose(file);
+        return 1;
+    }
+
+    Flight_Record* records = (Flight_Record*)malloc((size_t)header.record_count * sizeof(Flight_Record));
+    uint32 record_count = records ? (uint32)fread(records, sizeof(Flight_Record), header.record_count, file) : 0;
+    fclose(file);
+    if (record_count < header.record_count)
+    {
+        fprintf(stderr, "%s is cut short, %u of %u records\n", path, record_count, header.record_count);
+    }
+
+    real64 frequency = (real64)header.counter_frequency;
+    header.message[FLIGHT_RECORDER_MESSAGE_LENGTH - 1] = 0;
+    printf("Flight recorder dump: %s", flight_dump_reason_name(header.reason));
+    if (header.reason == FLIGHT_DUMP_CRASH)
+    {
+        printf(" (signal or exception %d)", header.signal_number);
+    }
+    printf(", \"%s\"\n", header.message);
+    printf("  %u records (%llu since startup)",
+           record_count,
+           (unsigned long long)header.records_recorded);
+    if (record_count > 0)
+    {
+        printf(", going back %.2f s", (real64)(int64)(header.dump_counter - records[0].counter) / frequency);
+    }
+    printf(", %.2f ms frame target, %u ticks/s\n",
+           header.target_frame__microseconds / 1000.0,
+           header.simulation_ticks_per_second);
+
+    // Frame stats
+    uint32 hitch__microseconds = (uint32)(header.target_frame__microseconds * HITCH_FACTOR);
+    uint32 frame_count = 0;
+    uint32 hitch_count = 0;
+    uint64 total_frame__microseconds = 0;
+    const Flight_Record* worst_frame = NULL;
+    uint32 cell_count = 0;
+    uint32 key_count = 0;
+    for (uint32 i = 0; i < record_count; i++)
+    {
+        const Flight_Record* record = &records[i];
+        if (record->type == FLIGHT_RECORD_FRAME)
+        {
+            uint32 frame__microseconds = get_frame__microseconds(record);
+            frame_count++;
+            total_frame__microseconds += frame__microseconds;
+            hitch_count += frame__microseconds > hitch__microseconds;
+            if (!worst_frame || frame__microseconds > get_frame__microseconds(worst_frame))
+            {
+                worst_frame = record;
+            }
+        }
+        cell_count += record->type == FLIGHT_RECORD_CELL;
+        key_count += record->type == FLIGHT_RECORD_KEY;
+    }
+    printf("  %u frames, %u cells, %u key changes\n", frame_count, cell_count, key_count);
+    if (worst_frame)
+    {
+        printf("  %.2f ms per frame on average, worst %.2f ms (frame %u, %.4f s before the dump), %u hitches\n",
+               total_frame__microseconds / 1000.0 / frame_count,
+               get_frame__microseconds(worst_frame) / 1000.0,
+               worst_frame->frame_index,
+               (real64)(int64)(header.dump_counter - worst_frame->counter) / frequency,
+               hitch_count);
+    }
+
+    if (!is_summary_only)
+    {
+        printf("\n");
+        for (uint32 i = 0; i < record_count; i++)
+        {
+            // Negative, counting up to the dump
+            real64 seconds = -(real64)(int64)(header.dump_counter - records[i].counter) / frequency;
+            if (last_seconds > 0.0 && -seconds > last_seconds)
+            {
+                continue;
+            }
+            print_record(&records[i], seconds, hitch__microseconds);
+        }
+    }
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,271 @@
+// Watches a running game's frame stats through the shared memory it publishes them to (LIVE_METRICS_ENABLED).
+//
+// Usage: metrics_top [--interval <ms>] [--once]
+//
+// Follows live_metrics.h. Maps the segment read only and redraws a top-style summary every interval (500 ms by
+// default): the last frame split into its phases, the worst frame and hitch count since startup, a histogram of the
+// last 128 frame times, the hardware counters for each phase (Linux), the simulation and the allocations. --once prints
+// a single snapshot as key=value lines instead, for scripts and scrapers.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../src/common.h"
+#include "../src/live_metrics.h"
+
+#define HISTOGRAM_BUCKET_COUNT 8
+
+// Same order as live_metrics.h
+local_internal const char* PHASE_NAMES[LIVE_METRICS_PHASE_COUNT] = {"work", "writing_buffer", "render", "sleep"};
+local_internal const char* COUNTER_NAMES[LIVE_METRICS_COUNTER_COUNT] = {
+    "instructions", "cycles", "cache_misses", "branch_misses"};
+
+local_internal const Live_Metrics_Shared* map_metrics()
+{
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, LIVE_METRICS_NAME);
+    if (!mapping)
+    {
+        return NULL;
+    }
+    return (const Live_Metrics_Shared*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(Live_Metrics_Shared));
+#else
+    int file = shm_open(LIVE_METRICS_NAME, O_RDONLY, 0);
+    if (file < 0)
+    {
+        return NULL;
+    }
+    void* memory = mmap(NULL, sizeof(Live_Metrics_Shared), PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    return memory == MAP_FAILED ? NULL : (const Live_Metrics_Shared*)memory;
+#endif
+}
+
+local_internal bool32 is_process_alive(int32 process_id)
+{
+#ifdef _WIN32
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)process_id);
+    if (!process)
+    {
+        return false;
+    }
+    bool32 is_alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return is_alive;
+#else
+    return kill(process_id, 0) == 0;
+#endif
+}
+
+local_internal void sleep__ms(uint32 milliseconds)
+{
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    usleep(milliseconds * 1000);
+#endif
+}
+
+local_internal void print_key_values(const Live_Metrics_Shared* metrics)
+{
+    const Live_Metrics_Frame* frame = &metrics->frame;
+    printf("process_id=%d\n", metrics->process_id);
+    printf("frame_index=%llu\n", (unsigned long long)frame->frame_index);
+    printf("frame_ms=%.3f\n", frame->frame__ms);
+    printf("work_ms=%.3f\n", frame->work__ms);
+    printf("writing_buffer_ms=%.3f\n", frame->writing_buffer__ms);
+    printf("render_ms=%.3f\n", frame->render__ms);
+    printf("sleep_ms=%.3f\n", frame->sleep__ms);
+    printf("target_frame_ms=%.3f\n", frame->target_frame__ms);
+    printf("max_frame_ms=%.3f\n", metrics->max_frame__ms);
+    printf("hitch_count=%u\n", metrics->hitch_count);
+    printf("simulation_tick=%llu\n", (unsigned long long)frame->simulation_tick);
+    printf("simulation_steps=%u\n", frame->simulation_steps);
+    printf("score=%d\n", frame->score);
+    printf("allocations=%u\n", frame->allocations);
+    printf("other_thread_allocations=%u\n", frame->other_thread_allocations);
+    printf("allocation_bytes=%llu\n", (unsigned long long)frame->allocation_bytes);
+    printf("hardware_counters_multiplexed=%d\n", frame->is_hardware_counter_multiplexed ? 1 : 0);
+    for (uint32 phase = 0; phase < LIVE_METRICS_PHASE_COUNT; phase++)
+    {
+        for (uint32 counter = 0; counter < LIVE_METRICS_COUNTER_COUNT; counter++)
+        {
+            // Left out when they aren't counted, rather than looking like zeroes
+            if (frame->hardware_counter_mask & (1 << counter))
+            {
+                printf("%s_%s=%llu\n",
+                       PHASE_NAMES[phase],
+                       COUNTER_NAMES[counter],
+                       (unsigned long long)frame->hardware_counters[phase][counter]);
+            }
+        }
+    }
+}
+
+local_internal void print_top(const Live_Metrics_Shared* metrics, real32 frames_per_second)
+{
+    const Live_Metrics_Frame* frame = &metrics->frame;
+
+    // Clear the screen and go home
+    printf("\x1b[2J\x1b[H");
+    printf("sdl_snake_game (pid %d), frame %llu, %.1f fps\n\n",
+           metrics->process_id,
+           (unsigned long long)frame->frame_index,
+           frames_per_second);
+    printf("Frame    %7.2f ms (target %.2f ms, worst %.2f ms, %u hitches)\n",
+           frame->frame__ms,
+           frame->target_frame__ms,
+           metrics->max_frame__ms,
+           metrics->hitch_count);
+    printf("  work   %7.2f ms\n", frame->work__ms);
+    printf("  buffer %7.2f ms\n", frame->writing_buffer__ms);
+    printf("  render %7.2f ms\n", frame->render__ms);
+    printf("  sleep  %7.2f ms\n\n", frame->sleep__ms);
+
+    // Buckets of a quarter of the target each, the last one catches everything at twice the target and over
+    uint32 buckets[HISTOGRAM_BUCKET_COUNT] = {};
+    real32 bucket_width__ms = (frame->target_frame__ms > 1.0f ? frame->target_frame__ms : 1.0f) / 4.0f;
+    uint32 history_count =
+        frame->frame_index < LIVE_METRICS_HISTORY_SIZE ? (uint32)frame->frame_index : LIVE_METRICS_HISTORY_SIZE;
+    for (uint32 i = 0; i < history_count; i++)
+    {
+        uint32 bucket = (uint32)(metrics->frame_history__ms[i] / bucket_width__ms);
+        buckets[bucket < HISTOGRAM_BUCKET_COUNT ? bucket : HISTOGRAM_BUCKET_COUNT - 1]++;
+    }
+    printf("Last %u frames\n", history_count);
+    for (uint32 i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        char bar[LIVE_METRICS_HISTORY_SIZE + 1];
+        uint32 bar_length = buckets[i] / 2 + (buckets[i] & 1);
+        memset(bar, '#', bar_length);
+        bar[bar_length] = 0;
+        if (i < HISTOGRAM_BUCKET_COUNT - 1)
+        {
+            printf("  %5.1f - %5.1f ms %4u %s\n", i * bucket_width__ms, (i + 1) * bucket_width__ms, buckets[i], bar);
+        }
+        else
+        {
+            printf("  %5.1f ms and up  %4u %s\n", i * bucket_width__ms, buckets[i], bar);
+        }
+    }
+
+    if (frame->hardware_counter_mask)
+    {
+        printf("\nHardware counters, last frame%s\n",
+               frame->is_hardware_counter_multiplexed ? " (multiplexed, scaled up)" : "");
+        printf("                 instructions       cycles   IPC  cache misses  branch misses\n");
+        for (uint32 phase = 0; phase < LIVE_METRICS_PHASE_COUNT; phase++)
+        {
+            const uint64* values = frame->hardware_counters[phase];
+            printf("  %-14s %12llu %12llu %5.2f %13llu %14llu\n",
+                   PHASE_NAMES[phase],
+                   (unsigned long long)values[0],
+                   (unsigned long long)values[1],
+                   values[1] ? (real64)values[0] / (real64)values[1] : 0.0,
+                   (unsigned long long)values[2],
+                   (unsigned long long)values[3]);
+        }
+    }
+    else
+    {
+        printf("\nNo hardware counters (Linux only, and the kernel has to allow them)\n");
+    }
+
+    printf("\nSimulation tick %llu, %u steps last frame",
+           (unsigned long long)frame->simulation_tick,
+           frame->simulation_steps);
+    if (frame->score >= 0)
+    {
+        printf(", score %d", frame->score);
+    }
+    printf("\nAllocations last frame: %u (%llu bytes), %u on other threads\n",
+           frame->allocations,
+           (unsigned long long)frame->allocation_bytes,
+           frame->other_thread_allocations);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    uint32 interval__ms = 500;
+    bool32 is_once = false;
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+        {
+            int32 requested__ms = atoi(argv[++i]);
+            interval__ms = requested__ms > 10 ? (uint32)requested__ms : 10;
+        }
+        else if (strcmp(argv[i], "--once") == 0)
+        {
+            is_once = true;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: metrics_top [--interval <ms>] [--once]\n");
+            return 1;
+        }
+    }
+
+    const Live_Metrics_Shared* shared = map_metrics();
+    if (!shared)
+    {
+        fprintf(stderr, "No game to watch, %s doesn't exist (is the game running with LIVE_METRICS_ENABLED?)\n",
+                LIVE_METRICS_NAME);
+        return 1;
+    }
+
+    Live_Metrics_Shared metrics;
+    uint64 last_frame_index = 0;
+    for (;;)
+    {
+        if (!live_metrics_read(shared, &metrics))
+        {
+            sleep__ms(1);
+            continue;
+        }
+        if (metrics.magic != LIVE_METRICS_MAGIC || metrics.version != LIVE_METRICS_VERSION ||
+            metrics.size != sizeof(Live_Metrics_Shared))
+        {
+            fprintf(stderr,
+                    "%s is version %u and %u bytes, this tool reads version %u and %u bytes\n",
+                    LIVE_METRICS_NAME,
+                    metrics.version,
+                    metrics.size,
+                    LIVE_METRICS_VERSION,
+                    (uint32)sizeof(Live_Metrics_Shared));
+            return 1;
+        }
+        if (!is_process_alive(metrics.process_id))
+        {
+            fprintf(stderr,
+                    "The game that published %s (pid %d) isn't running\n",
+                    LIVE_METRICS_NAME,
+                    metrics.process_id);
+            return 1;
+        }
+
+        if (is_once)
+        {
+            print_key_values(&metrics);
+            return 0;
+        }
+
+        real32 frames_per_second = last_frame_index
+            ? (real32)(metrics.frame.frame_index - last_frame_index) * 1000.0f / (real32)interval__ms
+            : 0.0f;
+        last_frame_index = metrics.frame.frame_index;
+        print_top(&metrics, frames_per_second);
+        sleep__ms(interval__ms);
+    }
+}
@@ -0,0 +1,108 @@
+// Times the batch environment (src/snake_batch_env.h) through its C API, the way a trainer would use it.
+//
+// Usage: snake_batch_bench [env count] [steps] [width height]
+//
+// Steps every game with random actions (which crash a lot, so restarts get timed too) and prints the environment
+// steps per second.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/common.h"
+#include "../src/snake_batch_env.h"
+
+local_internal void* allocate_aligned(size_t size)
+{
+    size = (size + 63) & ~(size_t)63;
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, 64);
+#else
+    return aligned_alloc(64, size);
+#endif
+}
+
+local_internal void free_aligned(void* memory)
+{
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    uint32 env_count = argc > 1 ? (uint32)atoi(argv[1]) : 4096;
+    uint32 step_count = argc > 2 ? (uint32)atoi(argv[2]) : 2000;
+    int32 width = argc > 4 ? atoi(argv[3]) : 64;
+    int32 height = argc > 4 ? atoi(argv[4]) : 36;
+
+    uint32 occupancy_words_per_env = snake_batch_env_occupancy_words_per_env(width, height);
+
+    Snake_Batch_Buffers buffers = {};
+    buffers.occupancy = (uint64*)allocate_aligned((size_t)env_count * occupancy_words_per_env * sizeof(uint64));
+    buffers.head_x = (int16*)allocate_aligned(env_count * sizeof(int16));
+    buffers.head_y = (int16*)allocate_aligned(env_count * sizeof(int16));
+    buffers.blip_x = (int16*)allocate_aligned(env_count * sizeof(int16));
+    buffers.blip_y = (int16*)allocate_aligned(env_count * sizeof(int16));
+    buffers.rewards = (float*)allocate_aligned(env_count * sizeof(float));
+    buffers.dones = (uint8*)allocate_aligned(env_count);
+    uint8* actions = (uint8*)allocate_aligned(env_count);
+
+    Snake_Batch_Env* env = snake_batch_env_create(env_count, width, height, 12345, &buffers);
+    if (!env)
+    {
+        fprintf(stderr, "Failed to create %u games on a %dx%d board\n", env_count, width, height);
+        return 1;
+    }
+
+    // Mostly straight on, turning now and then, so games last long enough for the snakes to grow
+    uint32 random_state = 0x9E3779B9u;
+    uint64 game_count = 0;
+    real64 total_reward = 0;
+    real64 step__seconds = 0;
+    for (uint32 step = 0; step < step_count; step++)
+    {
+        for (uint32 i = 0; i < env_count; i++)
+        {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            actions[i] = (random_state & 7) < 5 ? 0 : (uint8)((random_state >> 3) % 4 + 1);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        snake_batch_env_step(env, actions);
+        step__seconds += std::chrono::duration<real64>(std::chrono::steady_clock::now() - start).count();
+
+        for (uint32 i = 0; i < env_count; i++)
+        {
+            game_count += buffers.dones[i];
+            total_reward += buffers.rewards[i];
+        }
+    }
+
+    real64 env_steps = (real64)env_count * step_count;
+    printf("Batch env: %u games on a %dx%d board, %u steps\n", env_count, width, height, step_count);
+    printf("  %.0f env steps in %.2f ms, %.0f env steps/s, %.2f ns per env step\n",
+           env_steps,
+           step__seconds * 1000.0,
+           step__seconds > 0 ? env_steps / step__seconds : 0.0,
+           step__seconds * 1000000000.0 / env_steps);
+    printf("  %llu games finished, %.1f steps per game, total reward %.0f\n",
+           (unsigned long long)game_count,
+           game_count ? env_steps / game_count : 0.0,
+           total_reward);
+
+    snake_batch_env_destroy(env);
+    free_aligned(buffers.occupancy);
+    free_aligned(buffers.head_x);
+    free_aligned(buffers.head_y);
+    free_aligned(buffers.blip_x);
+    free_aligned(buffers.blip_y);
+    free_aligned(buffers.rewards);
+    free_aligned(buffers.dones);
+    free_aligned(actions);
+    return 0;
+}
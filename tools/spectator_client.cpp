@@ -0,0 +1,150 @@
+// Watches a game streamed by the spectator server (run the game with --spectators [port]).
+//
+// Usage: spectator_client [port] [--board]
+//
+// Follows along with spectator_protocol.h and prints the game once a second: the tick, the snake and how much came
+// over the wire. --board draws the whole board too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "../src/common.h"
+#include "../src/spectator_protocol.h"
+
+#define MAX_MESSAGE_SIZE (32 * 1024)  // Same as the server
+#define MAX_CELLS (256 * 1024)
+
+local_internal void print_board(Spectator_Board* board, char* rows)
+{
+    uint32 cell_count = (uint32)board->width * (uint32)board->height;
+    memset(rows, '.', cell_count);
+
+    int32 x = board->tail_x;
+    int32 y = board->tail_y;
+    for (uint32 i = 0; i < board->length; i++)
+    {
+        if (x >= 0 && x < board->width && y >= 0 && y < board->height)
+        {
+            rows[y * board->width + x] = 'o';
+        }
+        if (i + 1 < board->length)
+        {
+            spectator_board_move(board->moves[(board->moves_start + i) % cell_count], &x, &y);
+        }
+    }
+    rows[board->head_y * board->width + board->head_x] = board->is_game_over ? 'X' : '@';
+    rows[board->blip_y * board->width + board->blip_x] = '*';
+
+    // North is up
+    for (int32 row = board->height - 1; row >= 0; row--)
+    {
+        printf("%.*s\n", board->width, rows + row * board->width);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint16 port = 47900;
+    bool32 is_drawing_board = false;
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--board") == 0)
+        {
+            is_drawing_board = true;
+        }
+        else
+        {
+            port = (uint16)atoi(argv[i]);
+        }
+    }
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+#ifdef _WIN32
+    SOCKET handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#else
+    int handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#endif
+    if (connect(handle, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        fprintf(stderr, "Nothing to watch on port %u, is the game running with --spectators?\n", port);
+        return 1;
+    }
+
+    Spectator_Receiver receiver = {};
+    receiver.buffer = (uint8*)malloc(MAX_MESSAGE_SIZE);
+    receiver.capacity = MAX_MESSAGE_SIZE;
+    Spectator_Board board = {};
+    board.moves = (uint8*)malloc(MAX_CELLS);
+    board.capacity = MAX_CELLS;
+    char* rows = (char*)malloc(MAX_CELLS);
+
+    uint64 bytes_received = 0;
+    uint64 bytes_at_last_print = 0;
+    time_t last_print_time = time(NULL);
+    for (;;)
+    {
+        int32 received = (int32)recv(handle,
+                                     (char*)spectator_receiver_get_free(&receiver),
+                                     (int32)spectator_receiver_get_room(&receiver),
+                                     0);
+        if (received <= 0)
+        {
+            printf("The game went away\n");
+            break;
+        }
+        receiver.size += received;
+        bytes_received += received;
+        if (!spectator_receiver_apply(&receiver, &board))
+        {
+            fprintf(stderr, "Got something that isn't the spectator protocol\n");
+            return 1;
+        }
+
+        time_t now = time(NULL);
+        if (now != last_print_time && board.width)
+        {
+            if (is_drawing_board)
+            {
+                print_board(&board, rows);
+            }
+            printf("Tick %llu: score %u%s, head %d,%d, blip %d,%d, %.1f KB/s\n",
+                   (unsigned long long)board.tick,
+                   board.length - 1,
+                   board.is_game_over ? " (game over)" : "",
+                   board.head_x,
+                   board.head_y,
+                   board.blip_x,
+                   board.blip_y,
+                   (real64)(bytes_received - bytes_at_last_print) / 1024.0 / (real64)(now - last_print_time));
+            last_print_time = now;
+            bytes_at_last_print = bytes_received;
+        }
+    }
+
+#ifdef _WIN32
+    closesocket(handle);
+    WSACleanup();
+#else
+    close(handle);
+#endif
+    return 0;
+}